@@ -0,0 +1,198 @@
+/*
+ * alloc_profiler.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_ALLOC_PROFILER_INCLUDE_ALLOC_PROFILER_H_
+#define LIB_ALLOC_PROFILER_INCLUDE_ALLOC_PROFILER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef ENABLE_ALLOCATION_PROFILER
+#define ENABLE_ALLOCATION_PROFILER 0
+#endif
+
+#ifndef ALLOC_PROFILER_WRAP_MALLOC
+#define ALLOC_PROFILER_WRAP_MALLOC 0
+#endif
+
+namespace alloc {
+
+/**
+ * The max number of call sites of which the allocations are counted separately.
+ */
+static constexpr size_t MAX_SITES = 64;
+
+/**
+ * The max number of scopes of which the allocations are counted separately.
+ */
+static constexpr size_t MAX_SCOPES = 32;
+
+/**
+ * The number and total size of a set of allocations.
+ */
+struct Counts {
+	/**
+	 * The number of allocations.
+	 */
+	uint32_t allocations;
+
+	/**
+	 * The total number of bytes allocated.
+	 */
+	uint32_t bytes;
+};
+
+/**
+ * Attributes all allocations of the current thread to a tag, for as long as this object exists.
+ * Scopes can be nested, in which case the innermost one is used.
+ */
+class Scope {
+private:
+	/**
+	 * The tag of the scope that was active before this one.
+	 */
+	const char *const _previous;
+public:
+	/**
+	 * Starts a new scope.
+	 *
+	 * @param tag	The tag to attribute the allocations to.
+	 * 				Has to live forever, since it is used as the key of the scope.
+	 */
+	Scope(const char *tag);
+
+	Scope(const Scope &other) = delete;
+
+	Scope& operator=(const Scope &other) = delete;
+
+	/**
+	 * Ends this scope, and restores the previous one.
+	 */
+	~Scope();
+};
+
+/**
+ * Gets the tag of the innermost scope of the current thread.
+ *
+ * @return	The tag of the current scope, or NULL if there is none.
+ */
+const char* getCurrentScope();
+
+/**
+ * Counts an allocation for the given call site, and the current scope.
+ * Never allocates memory itself.
+ *
+ * @param site	The address of the code that made the allocation.
+ * @param size	The number of bytes allocated.
+ */
+void recordAllocation(const void *site, const size_t size);
+
+/**
+ * Counts a freed allocation.
+ */
+void recordFree();
+
+/**
+ * Gets the counts of all allocations since startup, or the last reset.
+ *
+ * @return	The total allocation counts.
+ */
+Counts getTotal();
+
+/**
+ * Gets the number of freed allocations since startup, or the last reset.
+ *
+ * @return	The number of freed allocations.
+ */
+uint32_t getFrees();
+
+/**
+ * Gets the counts of the allocations made by the given call site.
+ *
+ * @param site	The address of the code that made the allocations.
+ * @return	The counts of the call site. Zero if it wasn't counted.
+ */
+Counts getSite(const void *site);
+
+/**
+ * Gets the counts of the allocations made in scopes with the given tag.
+ *
+ * @param tag	The tag of the scopes.
+ * @return	The counts of the scope. Zero if it wasn't counted.
+ */
+Counts getScope(const char *tag);
+
+/**
+ * Resets all counts, and forgets all call sites and scopes.
+ * Must not be called while allocations are counted by other threads.
+ */
+void reset();
+
+/**
+ * A pull based writer for a plain text report of all counts.
+ *
+ * Writes one line with the totals, followed by a line for each scope, and a line for each call site.
+ */
+class ReportWriter {
+public:
+	/**
+	 * The max length of a single line, including the trailing newline.
+	 * Lines for longer scope tags are skipped.
+	 */
+	static constexpr size_t MAX_LINE_LEN = 127;
+private:
+	/**
+	 * The index of the next line to write.
+	 * The totals line, then the scopes, then the call sites.
+	 */
+	size_t _line = 0;
+
+	/**
+	 * The buffer for the line that is currently being written.
+	 */
+	char _buffer[MAX_LINE_LEN + 1];
+
+	/**
+	 * The length of the current line.
+	 */
+	size_t _line_len = 0;
+
+	/**
+	 * The number of bytes of the current line that were already copied.
+	 */
+	size_t _line_pos = 0;
+
+	/**
+	 * Writes the next line to the buffer.
+	 *
+	 * @return	False if there are no more lines to write.
+	 */
+	bool nextLine();
+public:
+	/**
+	 * Writes the next part of the report to the given buffer.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The max number of bytes to write.
+	 * @return	The number of bytes written. Zero once the report is complete.
+	 */
+	size_t read(uint8_t *buffer, const size_t max_len);
+
+	/**
+	 * Checks whether the entire report was written.
+	 *
+	 * @return	True if there is nothing left to write.
+	 */
+	bool done() const;
+};
+
+} /* namespace alloc */
+
+#endif /* LIB_ALLOC_PROFILER_INCLUDE_ALLOC_PROFILER_H_ */
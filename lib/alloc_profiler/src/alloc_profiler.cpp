@@ -0,0 +1,396 @@
+/*
+ * alloc_profiler.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "alloc_profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+/**
+ * A single entry of a table of allocation counts.
+ */
+struct Entry {
+	/**
+	 * The call site or scope tag counted by this entry.
+	 * NULL if this entry is unused.
+	 */
+	std::atomic<const void*> key { NULL };
+
+	/**
+	 * The number of allocations counted by this entry.
+	 */
+	std::atomic<uint32_t> allocations { 0 };
+
+	/**
+	 * The number of bytes allocated by the allocations counted by this entry.
+	 */
+	std::atomic<uint32_t> bytes { 0 };
+};
+
+/**
+ * The allocation counts of each call site.
+ */
+static Entry sites[alloc::MAX_SITES];
+
+/**
+ * The allocation counts of each scope tag.
+ */
+static Entry scopes[alloc::MAX_SCOPES];
+
+/**
+ * The counts of all allocations.
+ */
+static Entry total;
+
+/**
+ * The number of freed allocations.
+ */
+static std::atomic<uint32_t> frees { 0 };
+
+// The ESP8266 has no threads, and doesn't support thread local variables.
+#ifdef ESP8266
+/**
+ * The tag of the innermost scope.
+ */
+static const char *current_scope = NULL;
+#else
+/**
+ * The tag of the innermost scope of the current thread.
+ */
+static thread_local const char *current_scope = NULL;
+#endif
+
+/**
+ * Adds an allocation to the entry for the given key.
+ * Uses the first free entry after the hash of the key, if there is no entry for it yet.
+ *
+ * @param table	The table containing the entry.
+ * @param size	The number of entries in the table.
+ * @param key	The call site or scope tag to count the allocation for.
+ * @param bytes	The size of the allocation.
+ */
+static void count(Entry *table, const size_t size, const void *key,
+		const size_t bytes) {
+	const size_t start = ((uintptr_t) key >> 2) % size;
+	for (size_t i = 0; i < size; i++) {
+		Entry &entry = table[(start + i) % size];
+		const void *current = entry.key.load(std::memory_order_acquire);
+		if (current == NULL) {
+			// Sets current to the actual key if another thread claimed the entry first.
+			if (entry.key.compare_exchange_strong(current, key,
+					std::memory_order_acq_rel)) {
+				current = key;
+			}
+		}
+
+		if (current == key) {
+			entry.allocations.fetch_add(1, std::memory_order_relaxed);
+			entry.bytes.fetch_add(bytes, std::memory_order_relaxed);
+			return;
+		}
+	}
+}
+
+/**
+ * Gets the counts of the entry for the given key.
+ *
+ * @param table	The table containing the entry.
+ * @param size	The number of entries in the table.
+ * @param key	The call site or scope tag to get the counts of.
+ * @return	The counts for the key. Zero if it has no entry.
+ */
+static alloc::Counts find(const Entry *table, const size_t size,
+		const void *key) {
+	const size_t start = ((uintptr_t) key >> 2) % size;
+	for (size_t i = 0; i < size; i++) {
+		const Entry &entry = table[(start + i) % size];
+		const void *current = entry.key.load(std::memory_order_acquire);
+		if (current == key) {
+			return {entry.allocations.load(std::memory_order_relaxed),
+				entry.bytes.load(std::memory_order_relaxed)};
+		} else if (current == NULL) {
+			break;
+		}
+	}
+	return {0, 0};
+}
+
+alloc::Scope::Scope(const char *tag) :
+		_previous(current_scope) {
+	current_scope = tag;
+}
+
+alloc::Scope::~Scope() {
+	current_scope = _previous;
+}
+
+const char* alloc::getCurrentScope() {
+	return current_scope;
+}
+
+void alloc::recordAllocation(const void *site, const size_t size) {
+	total.allocations.fetch_add(1, std::memory_order_relaxed);
+	total.bytes.fetch_add(size, std::memory_order_relaxed);
+	count(sites, MAX_SITES, site, size);
+	if (current_scope) {
+		count(scopes, MAX_SCOPES, current_scope, size);
+	}
+}
+
+void alloc::recordFree() {
+	frees.fetch_add(1, std::memory_order_relaxed);
+}
+
+alloc::Counts alloc::getTotal() {
+	return {total.allocations.load(std::memory_order_relaxed),
+		total.bytes.load(std::memory_order_relaxed)};
+}
+
+uint32_t alloc::getFrees() {
+	return frees.load(std::memory_order_relaxed);
+}
+
+alloc::Counts alloc::getSite(const void *site) {
+	return find(sites, MAX_SITES, site);
+}
+
+alloc::Counts alloc::getScope(const char *tag) {
+	return find(scopes, MAX_SCOPES, tag);
+}
+
+/**
+ * Resets the given entries.
+ *
+ * @param table	The entries to reset.
+ * @param size	The number of entries to reset.
+ */
+static void clear(Entry *table, const size_t size) {
+	for (size_t i = 0; i < size; i++) {
+		table[i].key.store(NULL, std::memory_order_relaxed);
+		table[i].allocations.store(0, std::memory_order_relaxed);
+		table[i].bytes.store(0, std::memory_order_relaxed);
+	}
+}
+
+void alloc::reset() {
+	clear(sites, MAX_SITES);
+	clear(scopes, MAX_SCOPES);
+	clear(&total, 1);
+	frees.store(0, std::memory_order_relaxed);
+}
+
+bool alloc::ReportWriter::nextLine() {
+	while (_line < 1 + MAX_SCOPES + MAX_SITES) {
+		const size_t line = _line++;
+		if (line == 0) {
+			const Counts counts = getTotal();
+			_line_len = snprintf(_buffer, sizeof(_buffer),
+					"total allocations=%u bytes=%u frees=%u\n",
+					(unsigned int) counts.allocations,
+					(unsigned int) counts.bytes, (unsigned int) getFrees());
+		} else {
+			const bool scope = line <= MAX_SCOPES;
+			const Entry &entry =
+					scope ? scopes[line - 1] : sites[line - 1 - MAX_SCOPES];
+			const void *key = entry.key.load(std::memory_order_acquire);
+			if (key == NULL) {
+				continue;
+			}
+
+			const unsigned int allocations = entry.allocations.load(
+					std::memory_order_relaxed);
+			const unsigned int bytes = entry.bytes.load(
+					std::memory_order_relaxed);
+			if (scope) {
+				_line_len = snprintf(_buffer, sizeof(_buffer),
+						"scope=%s allocations=%u bytes=%u\n",
+						(const char*) key, allocations, bytes);
+			} else {
+				_line_len = snprintf(_buffer, sizeof(_buffer),
+						"site=0x%llx allocations=%u bytes=%u\n",
+						(long long unsigned int) (uintptr_t) key, allocations,
+						bytes);
+			}
+		}
+
+		if (_line_len > MAX_LINE_LEN) {
+			continue;
+		}
+		_line_pos = 0;
+		return true;
+	}
+	return false;
+}
+
+size_t alloc::ReportWriter::read(uint8_t *buffer, const size_t max_len) {
+	size_t written = 0;
+	while (written < max_len) {
+		if (_line_pos >= _line_len && !nextLine()) {
+			break;
+		}
+
+		const size_t len = std::min(_line_len - _line_pos, max_len - written);
+		memcpy(buffer + written, _buffer + _line_pos, len);
+		_line_pos += len;
+		written += len;
+	}
+	return written;
+}
+
+bool alloc::ReportWriter::done() const {
+	return _line >= 1 + MAX_SCOPES + MAX_SITES && _line_pos >= _line_len;
+}
+
+#if ENABLE_ALLOCATION_PROFILER == 1
+#if ALLOC_PROFILER_WRAP_MALLOC == 1
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void *ptr, size_t size);
+void __real_free(void *ptr);
+
+void* __wrap_malloc(size_t size) {
+	void *ptr = __real_malloc(size);
+	if (ptr) {
+		alloc::recordAllocation(__builtin_return_address(0), size);
+	}
+	return ptr;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+	void *ptr = __real_calloc(count, size);
+	if (ptr) {
+		alloc::recordAllocation(__builtin_return_address(0), count * size);
+	}
+	return ptr;
+}
+
+void* __wrap_realloc(void *ptr, size_t size) {
+	void *result = __real_realloc(ptr, size);
+	if (ptr && (result || size == 0)) {
+		alloc::recordFree();
+	}
+	if (result && size > 0) {
+		alloc::recordAllocation(__builtin_return_address(0), size);
+	}
+	return result;
+}
+
+void __wrap_free(void *ptr) {
+	if (ptr) {
+		alloc::recordFree();
+	}
+	__real_free(ptr);
+}
+}
+
+/**
+ * The function used to allocate memory for operator new.
+ * Uses the real malloc, so allocations aren't counted twice.
+ */
+#define PROFILER_MALLOC __real_malloc
+
+/**
+ * The function used to free memory for operator delete.
+ */
+#define PROFILER_FREE __real_free
+#else
+/**
+ * The function used to allocate memory for operator new.
+ */
+#define PROFILER_MALLOC malloc
+
+/**
+ * The function used to free memory for operator delete.
+ */
+#define PROFILER_FREE free
+#endif
+
+/**
+ * Allocates memory, and counts the allocation.
+ *
+ * @param size	The number of bytes to allocate.
+ * @param site	The address of the code making the allocation.
+ * @return	The allocated memory, or NULL if the allocation failed.
+ */
+static void* allocate(const size_t size, const void *site) {
+	void *ptr = PROFILER_MALLOC(size == 0 ? 1 : size);
+	if (ptr) {
+		alloc::recordAllocation(site, size);
+	}
+	return ptr;
+}
+
+/**
+ * Allocates memory, counts the allocation, and handles allocation failures like operator new.
+ *
+ * @param size	The number of bytes to allocate.
+ * @param site	The address of the code making the allocation.
+ * @return	The allocated memory.
+ */
+static void* allocateOrFail(const size_t size, const void *site) {
+	void *ptr = allocate(size, site);
+	if (!ptr) {
+#ifdef __cpp_exceptions
+		throw std::bad_alloc();
+#else
+		abort();
+#endif
+	}
+	return ptr;
+}
+
+/**
+ * Frees memory allocated by operator new, and counts it.
+ *
+ * @param ptr	The memory to free.
+ */
+static void deallocate(void *ptr) {
+	if (ptr) {
+		alloc::recordFree();
+		PROFILER_FREE(ptr);
+	}
+}
+
+void* operator new(size_t size) {
+	return allocateOrFail(size, __builtin_return_address(0));
+}
+
+void* operator new[](size_t size) {
+	return allocateOrFail(size, __builtin_return_address(0));
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	return allocate(size, __builtin_return_address(0));
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return allocate(size, __builtin_return_address(0));
+}
+
+void operator delete(void *ptr) noexcept {
+	deallocate(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+	deallocate(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t&) noexcept {
+	deallocate(ptr);
+}
+
+void operator delete[](void *ptr, const std::nothrow_t&) noexcept {
+	deallocate(ptr);
+}
+#endif /* ENABLE_ALLOCATION_PROFILER == 1 */
@@ -0,0 +1,447 @@
+/*
+ * async_log.h
+ *
+ * This file contains an asynchronous logging backend for the log_X macros.
+ * Log messages are stored as compact binary records, and only formatted once they are drained.
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_FALLBACK_LOG_INCLUDE_ASYNC_LOG_H_
+#define LIB_FALLBACK_LOG_INCLUDE_ASYNC_LOG_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#ifndef ENABLE_ASYNC_LOG
+#define ENABLE_ASYNC_LOG 0
+#endif
+
+#ifndef ASYNC_LOG_CAPACITY
+#define ASYNC_LOG_CAPACITY 32
+#endif
+
+namespace logging {
+
+/**
+ * The log levels, in the same order as the CORE_DEBUG_LEVEL values.
+ */
+enum Level : uint8_t {
+	LEVEL_NONE, LEVEL_ERROR, LEVEL_WARN, LEVEL_INFO, LEVEL_DEBUG, LEVEL_VERBOSE
+};
+
+/**
+ * A multi producer, single consumer ring buffer of log records.
+ *
+ * Logging a message only copies its format string pointer and raw arguments into a free slot.
+ * Strings are copied into the record, since they may not live until the record is formatted.
+ * If there is no free slot the message is dropped and counted, so logging never blocks.
+ *
+ * Records are formatted by a single consumer, using the same output format as the esp32 arduino log macros.
+ */
+class AsyncLog {
+public:
+	/**
+	 * A function returning the current time in milliseconds.
+	 */
+	typedef uint32_t (*clock_function)();
+
+	/**
+	 * The max number of arguments of a single message.
+	 * Conversion specifiers without an argument are written as is.
+	 */
+	static constexpr size_t MAX_ARGS = 6;
+
+	/**
+	 * The max total length of the string arguments of a single message, including their null terminators.
+	 * Longer strings are truncated.
+	 */
+	static constexpr size_t MAX_STRING_LEN = 48;
+private:
+	/**
+	 * The C type to give an argument to snprintf as.
+	 */
+	enum ArgType : uint8_t {
+		INT, UINT, LONG, ULONG, LLONG, ULLONG, DOUBLE, POINTER, STRING
+	};
+
+	/**
+	 * The raw value of a single argument.
+	 */
+	union Arg {
+		long long int ll;
+		unsigned long long int ull;
+		double d;
+		const void *p;
+	};
+
+	/**
+	 * A single log message, with its unformatted arguments.
+	 */
+	struct Record {
+		/**
+		 * The time the message was logged at, in milliseconds.
+		 */
+		uint32_t timestamp;
+
+		/**
+		 * The format string of the message. Has to be a string literal.
+		 */
+		const char *format;
+
+		/**
+		 * The base name of the file the message was logged in.
+		 */
+		const char *file;
+
+		/**
+		 * The name of the function the message was logged in.
+		 */
+		const char *function;
+
+		/**
+		 * The line the message was logged in.
+		 */
+		uint16_t line;
+
+		/**
+		 * The log level of the message.
+		 */
+		Level level;
+
+		/**
+		 * The number of arguments of the message.
+		 */
+		uint8_t arg_count;
+
+		/**
+		 * The number of bytes of the string buffer that are used.
+		 */
+		uint8_t string_len;
+
+		/**
+		 * The types of the arguments.
+		 */
+		ArgType types[MAX_ARGS];
+
+		/**
+		 * The raw arguments. String arguments store their offset in the string buffer.
+		 */
+		Arg args[MAX_ARGS];
+
+		/**
+		 * The buffer for copies of the string arguments.
+		 */
+		char strings[MAX_STRING_LEN];
+	};
+
+	/**
+	 * A single slot of the ring buffer.
+	 */
+	struct Slot {
+		/**
+		 * The position the slot is ready to be written at, or one more than the position it is ready to be read at.
+		 */
+		std::atomic<uint32_t> sequence { 0 };
+
+		/**
+		 * The record in this slot.
+		 */
+		Record record;
+	};
+
+	/**
+	 * The ring buffer of log records.
+	 */
+	Slot *const _slots;
+
+	/**
+	 * The number of slots in the ring buffer.
+	 */
+	const uint32_t _capacity;
+
+	/**
+	 * The function returning the current time.
+	 */
+	const clock_function _clock;
+
+	/**
+	 * The position of the next record to write.
+	 */
+	std::atomic<uint32_t> _head { 0 };
+
+	/**
+	 * The position of the next record to read.
+	 * Only used by the consumer.
+	 */
+	uint32_t _tail = 0;
+
+	/**
+	 * The max level of messages to log.
+	 */
+	std::atomic<uint8_t> _level;
+
+	/**
+	 * The number of messages that were dropped because the ring buffer was full.
+	 */
+	std::atomic<uint32_t> _dropped { 0 };
+
+	/**
+	 * Claims the next free slot, and fills in the fixed fields of its record.
+	 *
+	 * @param level		The log level of the message.
+	 * @param file		The base name of the file the message was logged in.
+	 * @param line		The line the message was logged in.
+	 * @param function	The name of the function the message was logged in.
+	 * @param format	The format string of the message.
+	 * @return	The claimed slot, or NULL if the ring buffer is full.
+	 */
+	Slot* claim(const Level level, const char *file, const uint16_t line,
+			const char *function, const char *format);
+
+	/**
+	 * Makes the record of a claimed slot available to the consumer.
+	 *
+	 * @param slot	The slot to publish.
+	 */
+	void publish(Slot *slot);
+
+	/**
+	 * Gets the type to give an integer argument to snprintf as, after the default argument promotions.
+	 *
+	 * @tparam T	The type of the integer argument.
+	 * @return	The argument type to use.
+	 */
+	template<typename T>
+	static constexpr ArgType getIntegerType() {
+		return sizeof(T) < sizeof(int) || std::is_same<T, int>::value ?
+				INT : std::is_same<T, unsigned int>::value ?
+				UINT : std::is_same<T, long>::value ?
+				LONG : std::is_same<T, unsigned long>::value ?
+				ULONG : std::is_signed<T>::value ? LLONG : ULLONG;
+	}
+
+	/**
+	 * Adds a raw argument to the record.
+	 * Arguments exceeding MAX_ARGS are ignored.
+	 *
+	 * @param record	The record to add the argument to.
+	 * @param type		The type of the argument.
+	 * @param value		The raw value of the argument.
+	 */
+	static void addArg(Record &record, const ArgType type, const Arg &value);
+
+	/**
+	 * Adds an integer argument, including bools and chars.
+	 *
+	 * @tparam T		The type of the integer.
+	 * @param record	The record to add the argument to.
+	 * @param value		The integer to add.
+	 */
+	template<typename T>
+	static typename std::enable_if<std::is_integral<T>::value>::type addArg(
+			Record &record, const T value) {
+		Arg arg;
+		arg.ull = (unsigned long long int) value;
+		addArg(record, getIntegerType<T>(), arg);
+	}
+
+	/**
+	 * Adds an enum argument as its underlying type.
+	 *
+	 * @tparam T		The type of the enum.
+	 * @param record	The record to add the argument to.
+	 * @param value		The enum value to add.
+	 */
+	template<typename T>
+	static typename std::enable_if<std::is_enum<T>::value>::type addArg(
+			Record &record, const T value) {
+		addArg(record,
+				static_cast<typename std::underlying_type<T>::type>(value));
+	}
+
+	/**
+	 * Adds a floating point argument.
+	 *
+	 * @tparam T		The type of the floating point number.
+	 * @param record	The record to add the argument to.
+	 * @param value		The number to add.
+	 */
+	template<typename T>
+	static typename std::enable_if<std::is_floating_point<T>::value>::type addArg(
+			Record &record, const T value) {
+		Arg arg;
+		arg.d = value;
+		addArg(record, DOUBLE, arg);
+	}
+
+	/**
+	 * Copies a string argument into the string buffer of the record.
+	 * Strings that don't fit are truncated.
+	 *
+	 * @param record	The record to add the argument to.
+	 * @param value		The string to copy.
+	 */
+	static void addArg(Record &record, const char *value);
+
+	/**
+	 * Adds a pointer argument that isn't a string.
+	 *
+	 * @tparam T		The type the pointer points to.
+	 * @param record	The record to add the argument to.
+	 * @param value		The pointer to add.
+	 */
+	template<typename T>
+	static typename std::enable_if<
+			!std::is_same<typename std::remove_cv<T>::type, char>::value>::type addArg(
+			Record &record, T *value) {
+		Arg arg;
+		arg.p = (const void*) value;
+		addArg(record, POINTER, arg);
+	}
+
+	/**
+	 * Does nothing, ends the recursion of addArgs.
+	 *
+	 * @param record	The record to add the arguments to.
+	 */
+	static void addArgs(Record &record) {
+
+	}
+
+	/**
+	 * Adds all the given arguments to the record.
+	 *
+	 * @tparam T		The type of the first argument.
+	 * @tparam Args		The types of the remaining arguments.
+	 * @param record	The record to add the arguments to.
+	 * @param value		The first argument to add.
+	 * @param args		The remaining arguments to add.
+	 */
+	template<typename T, typename ... Args>
+	static void addArgs(Record &record, const T value, const Args ... args) {
+		addArg(record, value);
+		addArgs(record, args...);
+	}
+
+	/**
+	 * Writes a single argument using the given conversion specifier.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The size of the buffer.
+	 * @param spec		The conversion specifier, including the percent sign.
+	 * @param record	The record containing the argument.
+	 * @param index		The index of the argument.
+	 * @return	The number of characters that would have been written, like snprintf.
+	 */
+	static int formatArg(char *buffer, const size_t max_len, const char *spec,
+			const Record &record, const uint8_t index);
+
+	/**
+	 * Writes the formatted message of a record, without its prefix.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The size of the buffer.
+	 * @param record	The record to format.
+	 * @return	The number of characters written, excluding the null terminator.
+	 */
+	static size_t formatMessage(char *buffer, const size_t max_len,
+			const Record &record);
+public:
+	/**
+	 * Creates a new asynchronous log, and allocates its ring buffer.
+	 *
+	 * @param capacity	The max number of records to keep. Has to be a power of two.
+	 * @param clock		The function returning the current time in milliseconds.
+	 * @param level		The initial max level of messages to log.
+	 */
+	AsyncLog(const uint32_t capacity, const clock_function clock,
+			const Level level);
+
+	AsyncLog(const AsyncLog &other) = delete;
+
+	AsyncLog& operator=(const AsyncLog &other) = delete;
+
+	/**
+	 * Destroys this log, and frees its ring buffer.
+	 */
+	~AsyncLog();
+
+	/**
+	 * Stores a message to be formatted later.
+	 * Never blocks, and never allocates memory.
+	 *
+	 * @tparam Args		The types of the format arguments.
+	 * @param level		The log level of the message.
+	 * @param file		The base name of the file the message was logged in. Has to be a string literal.
+	 * @param line		The line the message was logged in.
+	 * @param function	The name of the function the message was logged in. Has to be a string literal.
+	 * @param format	The printf format string of the message. Has to be a string literal.
+	 * @param args		The format arguments.
+	 * @return	False if the message was dropped, or its level is disabled.
+	 */
+	template<typename ... Args>
+	bool log(const Level level, const char *file, const uint16_t line,
+			const char *function, const char *format, const Args ... args) {
+		if (level > _level.load(std::memory_order_relaxed)) {
+			return false;
+		}
+
+		Slot *slot = claim(level, file, line, function, format);
+		if (!slot) {
+			return false;
+		}
+		addArgs(slot->record, args...);
+		publish(slot);
+		return true;
+	}
+
+	/**
+	 * Formats the oldest record as a single line, and removes it.
+	 * Has to be called by a single consumer only.
+	 * Lines that don't fit into the buffer are truncated, but always end with a newline.
+	 *
+	 * @param buffer	The buffer to write to. Has to be at least three bytes long.
+	 * @param max_len	The size of the buffer.
+	 * @return	The length of the line, excluding the null terminator. Zero if there is no record.
+	 */
+	size_t pop(char *buffer, const size_t max_len);
+
+	/**
+	 * Changes the max level of messages to log.
+	 *
+	 * @param level	The new max log level.
+	 */
+	void setLevel(const Level level);
+
+	/**
+	 * Gets the max level of messages to log.
+	 *
+	 * @return	The current max log level.
+	 */
+	Level getLevel() const;
+
+	/**
+	 * Gets the number of messages that were dropped because the ring buffer was full.
+	 *
+	 * @return	The number of dropped messages.
+	 */
+	uint32_t getDropped() const;
+};
+
+#if ENABLE_ASYNC_LOG == 1
+/**
+ * The log used by the log_X macros.
+ */
+extern AsyncLog async_log;
+#endif
+
+} /* namespace logging */
+
+#endif /* LIB_FALLBACK_LOG_INCLUDE_ASYNC_LOG_H_ */
@@ -7,6 +7,9 @@
  * Just like with the esp32 arduino logging macros, the format strings for these macros have to be known at compile time.
  * Otherwise the program will crash at run time.
  *
+ * If ENABLE_ASYNC_LOG is set to 1, these macros replace the framework ones, and store the messages in the async log instead.
+ * If ENABLE_TOKENIZED_LOG is set to 1, they replace the framework ones, and write binary frames with a token instead of the format string.
+ *
  *  Created on: Aug 22, 2023
  *
  * Copyright (C) 2023 ToMe25.
@@ -17,6 +20,8 @@
 #ifndef LIB_FALLBACK_TIMER_INCLUDE_FALLBACK_LOG_H_
 #define LIB_FALLBACK_TIMER_INCLUDE_FALLBACK_LOG_H_
 
+#include "async_log.h"
+#include "tokenized_log.h"
 #include <cstdio>
 #include <utils.h>
 
@@ -25,6 +30,37 @@
  */
 #define GET_BASE_FORMAT_STRING(letter, ln) "[" #letter "][%s:" EXPAND_MACRO(ln) "] %s(): "
 
+#if ENABLE_ASYNC_LOG == 1 && ENABLE_TOKENIZED_LOG == 1
+#error "The async log and the tokenized log can't be enabled at the same time."
+#endif
+
+#if ENABLE_ASYNC_LOG == 1
+/**
+ * The async log levels matching the letters used by the log_X macros.
+ */
+#define ASYNC_LOG_LEVEL_E logging::LEVEL_ERROR
+#define ASYNC_LOG_LEVEL_W logging::LEVEL_WARN
+#define ASYNC_LOG_LEVEL_I logging::LEVEL_INFO
+#define ASYNC_LOG_LEVEL_D logging::LEVEL_DEBUG
+#define ASYNC_LOG_LEVEL_V logging::LEVEL_VERBOSE
+
+/**
+ * An internal utility macro storing a message in the async log, to be formatted and printed later.
+ *
+ * @param letter	The letter representing the log level of the message.
+ * @param format	The format string to print. Has to be known at compile time.
+ */
+#define LOG_PRINTF(letter, format, ...) logging::async_log.log(ASYNC_LOG_LEVEL_ ## letter, FILE_BASE_NAME, __LINE__, __FUNCTION__, format, ##__VA_ARGS__);
+#elif ENABLE_TOKENIZED_LOG == 1
+/**
+ * An internal utility macro writing a binary frame with the token of the message, instead of the message itself.
+ * The token is calculated at compile time, so the format string isn't stored in flash.
+ *
+ * @param letter	The letter representing the log level of the message.
+ * @param format	The format string of the message. Has to be a string literal.
+ */
+#define LOG_PRINTF(letter, format, ...) logging::logTokenized(CONST_EXPR_VALUE(logging::hashToken(#letter "|", FILE_BASE_NAME, "|" format)), __LINE__, ##__VA_ARGS__);
+#else
 /**
  * An internal utility macro adding some debug info, and giving the strings to printf.
  *
@@ -32,6 +68,16 @@
  * @param format	The format string to print. Has to be known at compile time.
  */
 #define LOG_PRINTF(letter, format, ...) printf(GET_BASE_FORMAT_STRING(letter, __LINE__) format "\r\n", FILE_BASE_NAME, __FUNCTION__, ##__VA_ARGS__);
+#endif
+
+#if ENABLE_ASYNC_LOG == 1 || ENABLE_TOKENIZED_LOG == 1
+// Replace the framework logging macros, so all messages use the same backend.
+#undef log_v
+#undef log_d
+#undef log_i
+#undef log_w
+#undef log_e
+#endif
 
 /**
  * Below are fallback definitions for the arduino logging macros.
@@ -0,0 +1,295 @@
+/*
+ * tokenized_log.h
+ *
+ * This file contains a tokenized logging backend for the log_X macros.
+ * Instead of the formatted message, a binary frame with a token identifying the format string and the raw arguments is written.
+ * The tokens are generated from the format strings at compile time, so the format strings aren't stored on the device at all.
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_FALLBACK_LOG_INCLUDE_TOKENIZED_LOG_H_
+#define LIB_FALLBACK_LOG_INCLUDE_TOKENIZED_LOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#ifndef ENABLE_TOKENIZED_LOG
+#define ENABLE_TOKENIZED_LOG 0
+#endif
+
+namespace logging {
+
+/**
+ * The byte starting each tokenized log frame.
+ * The ASCII record separator, which never occurs in regular serial output.
+ */
+static constexpr uint8_t TOKEN_FRAME_START = 0x1E;
+
+/**
+ * The FNV-1a offset basis, the initial value of a token hash.
+ */
+static constexpr uint32_t TOKEN_HASH_OFFSET = 2166136261u;
+
+/**
+ * The FNV-1a prime, used to combine each character with the hash.
+ */
+static constexpr uint32_t TOKEN_HASH_PRIME = 16777619u;
+
+/**
+ * Calculates the 32 bit FNV-1a hash of a string as a constant expression.
+ *
+ * @param str	The string to hash.
+ * @param hash	The hash of the previous strings to combine with this one.
+ * @return	The hash of the string.
+ */
+constexpr uint32_t hashString(const char *str, const uint32_t hash =
+		TOKEN_HASH_OFFSET) {
+	return *str == 0 ?
+			hash : hashString(str + 1, (hash ^ (uint8_t) *str) * TOKEN_HASH_PRIME);
+}
+
+/**
+ * Calculates the token of a log message.
+ * The token is the hash of "<level letter>|<file base name>|<format>".
+ *
+ * @param level		The level letter, followed by a separator.
+ * @param file		The base name of the file the message is logged in.
+ * @param format	The format string, preceded by a separator.
+ * @return	The token of the log message.
+ */
+constexpr uint32_t hashToken(const char *level, const char *file,
+		const char *format) {
+	return hashString(format, hashString(file, hashString(level)));
+}
+
+/**
+ * A function writing an encoded frame.
+ */
+typedef void (*token_output_function)(const uint8_t *data, const size_t len);
+
+/**
+ * A builder for a single tokenized log frame.
+ *
+ * A frame consists of the start byte, the length of the rest of the frame, the little endian 32 bit token,
+ * the little endian 16 bit line, and the little endian 32 bit timestamp in milliseconds.
+ * It is followed by the arguments, each starting with a byte for its type.
+ * Signed integers are zigzag varints, unsigned integers and pointers are varints, floating point numbers are
+ * little endian doubles, and strings are a length byte followed by the characters.
+ * Arguments that don't fit into the frame are left out.
+ */
+class TokenFrame {
+public:
+	/**
+	 * The max length of a frame, including the start and length bytes.
+	 */
+	static constexpr size_t MAX_FRAME_LEN = 96;
+
+	/**
+	 * The types of the arguments in a frame.
+	 */
+	enum ArgType : uint8_t {
+		INT, UINT, DOUBLE, STRING, POINTER
+	};
+private:
+	/**
+	 * The encoded frame.
+	 */
+	uint8_t _buffer[MAX_FRAME_LEN];
+
+	/**
+	 * The current length of the frame.
+	 */
+	size_t _len = 0;
+
+	/**
+	 * Whether an argument didn't fit, so no further arguments are added.
+	 */
+	bool _full = false;
+
+	/**
+	 * Appends a little endian integer to the frame.
+	 *
+	 * @param value	The value to append.
+	 * @param bytes	The number of bytes to append.
+	 */
+	void writeLittleEndian(const uint64_t value, const uint8_t bytes);
+
+	/**
+	 * Appends an argument to the frame, if it fits.
+	 *
+	 * @param type	The type of the argument.
+	 * @param data	The encoded value of the argument.
+	 * @param len	The length of the encoded value.
+	 */
+	void addArg(const ArgType type, const uint8_t *data, const size_t len);
+
+	/**
+	 * Appends an unsigned integer argument as a varint.
+	 *
+	 * @param type	The type of the argument.
+	 * @param value	The value to append.
+	 */
+	void addVarint(const ArgType type, uint64_t value);
+
+	/**
+	 * Adds an integer argument, including bools and chars.
+	 *
+	 * @tparam T	The type of the integer.
+	 * @param value	The integer to add.
+	 */
+	template<typename T>
+	typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value>::type add(
+			const T value) {
+		const int64_t extended = value;
+		addVarint(INT,
+				((uint64_t) extended << 1) ^ (uint64_t) (extended >> 63));
+	}
+
+	/**
+	 * Adds an unsigned integer argument.
+	 *
+	 * @tparam T	The type of the integer.
+	 * @param value	The integer to add.
+	 */
+	template<typename T>
+	typename std::enable_if<std::is_integral<T>::value && !std::is_signed<T>::value>::type add(
+			const T value) {
+		addVarint(UINT, value);
+	}
+
+	/**
+	 * Adds an enum argument as its underlying type.
+	 *
+	 * @tparam T	The type of the enum.
+	 * @param value	The enum value to add.
+	 */
+	template<typename T>
+	typename std::enable_if<std::is_enum<T>::value>::type add(const T value) {
+		add(static_cast<typename std::underlying_type<T>::type>(value));
+	}
+
+	/**
+	 * Adds a floating point argument.
+	 *
+	 * @param value	The number to add.
+	 */
+	void add(const double value);
+
+	/**
+	 * Adds a string argument, truncated to the remaining space.
+	 *
+	 * @param value	The string to add.
+	 */
+	void add(const char *value);
+
+	/**
+	 * Adds a pointer argument that isn't a string.
+	 *
+	 * @tparam T	The type the pointer points to.
+	 * @param value	The pointer to add.
+	 */
+	template<typename T>
+	typename std::enable_if<
+			!std::is_same<typename std::remove_cv<T>::type, char>::value>::type add(
+			T *value) {
+		addVarint(POINTER, (uintptr_t) value);
+	}
+
+	/**
+	 * Does nothing, ends the recursion of addArgs.
+	 */
+	void addArgs() {
+
+	}
+
+	/**
+	 * Adds all the given arguments to the frame.
+	 *
+	 * @tparam T		The type of the first argument.
+	 * @tparam Args		The types of the remaining arguments.
+	 * @param value		The first argument to add.
+	 * @param args		The remaining arguments to add.
+	 */
+	template<typename T, typename ... Args>
+	void addArgs(const T value, const Args ... args) {
+		add(value);
+		addArgs(args...);
+	}
+public:
+	/**
+	 * Creates a new frame, and writes its header.
+	 *
+	 * @tparam Args		The types of the format arguments.
+	 * @param token		The token of the log message.
+	 * @param line		The line the message was logged in.
+	 * @param timestamp	The time the message was logged at, in milliseconds.
+	 * @param args		The format arguments.
+	 */
+	template<typename ... Args>
+	TokenFrame(const uint32_t token, const uint16_t line,
+			const uint32_t timestamp, const Args ... args) {
+		_buffer[_len++] = TOKEN_FRAME_START;
+		_buffer[_len++] = 0;
+		writeLittleEndian(token, 4);
+		writeLittleEndian(line, 2);
+		writeLittleEndian(timestamp, 4);
+		addArgs(args...);
+		_buffer[1] = _len - 2;
+	}
+
+	/**
+	 * @return	The encoded frame.
+	 */
+	const uint8_t* data() const;
+
+	/**
+	 * @return	The length of the encoded frame.
+	 */
+	size_t size() const;
+};
+
+/**
+ * Changes the function the frames are written with.
+ * By default they are written to stdout.
+ *
+ * @param output	The new output function. NULL to write to stdout.
+ */
+void setTokenOutput(const token_output_function output);
+
+/**
+ * Writes a frame with the given output function.
+ *
+ * @param frame	The frame to write.
+ */
+void writeTokenFrame(const TokenFrame &frame);
+
+/**
+ * Gets the current time for tokenized log frames.
+ *
+ * @return	The time in milliseconds since startup.
+ */
+uint32_t getTokenTimestamp();
+
+/**
+ * Writes a tokenized log frame.
+ *
+ * @tparam Args	The types of the format arguments.
+ * @param token	The token of the log message.
+ * @param line	The line the message was logged in.
+ * @param args	The format arguments.
+ */
+template<typename ... Args>
+void logTokenized(const uint32_t token, const uint16_t line,
+		const Args ... args) {
+	writeTokenFrame(TokenFrame(token, line, getTokenTimestamp(), args...));
+}
+
+} /* namespace logging */
+
+#endif /* LIB_FALLBACK_LOG_INCLUDE_TOKENIZED_LOG_H_ */
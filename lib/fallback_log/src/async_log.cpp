@@ -0,0 +1,252 @@
+/*
+ * async_log.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "async_log.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#if ENABLE_ASYNC_LOG == 1
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+#endif
+
+/**
+ * The letters representing the log levels in the output.
+ */
+static constexpr char LEVEL_LETTERS[] = "NEWIDV";
+
+/**
+ * The max length of a single conversion specifier, including the percent sign.
+ */
+static constexpr size_t MAX_SPEC_LEN = 15;
+
+/**
+ * The characters ending a conversion specifier.
+ */
+static constexpr char CONVERSIONS[] = "diouxXeEfFgGaAcspn";
+
+logging::AsyncLog::AsyncLog(const uint32_t capacity,
+		const clock_function clock, const Level level) :
+		_slots(new Slot[capacity]), _capacity(capacity), _clock(clock), _level(
+				level) {
+	for (uint32_t i = 0; i < _capacity; i++) {
+		_slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+logging::AsyncLog::~AsyncLog() {
+	delete[] _slots;
+}
+
+logging::AsyncLog::Slot* logging::AsyncLog::claim(const Level level,
+		const char *file, const uint16_t line, const char *function,
+		const char *format) {
+	uint32_t position = _head.load(std::memory_order_relaxed);
+	Slot *slot = NULL;
+	while (true) {
+		slot = &_slots[position & (_capacity - 1)];
+		const int32_t diff = (int32_t) (slot->sequence.load(
+				std::memory_order_acquire) - position);
+		if (diff == 0) {
+			if (_head.compare_exchange_weak(position, position + 1,
+					std::memory_order_relaxed)) {
+				break;
+			}
+		} else if (diff < 0) {
+			// The consumer didn't read this slot yet, so the ring buffer is full.
+			_dropped.fetch_add(1, std::memory_order_relaxed);
+			return NULL;
+		} else {
+			position = _head.load(std::memory_order_relaxed);
+		}
+	}
+
+	Record &record = slot->record;
+	record.timestamp = _clock();
+	record.format = format;
+	record.file = file;
+	record.function = function;
+	record.line = line;
+	record.level = level;
+	record.arg_count = 0;
+	record.string_len = 0;
+	return slot;
+}
+
+void logging::AsyncLog::publish(Slot *slot) {
+	const uint32_t position = slot->sequence.load(std::memory_order_relaxed);
+	slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+void logging::AsyncLog::addArg(Record &record, const ArgType type,
+		const Arg &value) {
+	if (record.arg_count < MAX_ARGS) {
+		record.types[record.arg_count] = type;
+		record.args[record.arg_count] = value;
+		record.arg_count++;
+	}
+}
+
+void logging::AsyncLog::addArg(Record &record, const char *value) {
+	Arg arg;
+	if (record.string_len < MAX_STRING_LEN) {
+		size_t len = value ? strlen(value) : 0;
+		if (len >= MAX_STRING_LEN - record.string_len) {
+			len = MAX_STRING_LEN - record.string_len - 1;
+		}
+		arg.ull = record.string_len;
+		memcpy(record.strings + record.string_len, value, len);
+		record.strings[record.string_len + len] = 0;
+		record.string_len += len + 1;
+	} else {
+		// The string buffer is full, so use the null terminator of the last string.
+		arg.ull = MAX_STRING_LEN - 1;
+	}
+	addArg(record, STRING, arg);
+}
+
+int logging::AsyncLog::formatArg(char *buffer, const size_t max_len,
+		const char *spec, const Record &record, const uint8_t index) {
+	const Arg &arg = record.args[index];
+	switch (record.types[index]) {
+	case INT:
+		return snprintf(buffer, max_len, spec, (int) arg.ull);
+	case UINT:
+		return snprintf(buffer, max_len, spec, (unsigned int) arg.ull);
+	case LONG:
+		return snprintf(buffer, max_len, spec, (long int) arg.ull);
+	case ULONG:
+		return snprintf(buffer, max_len, spec, (unsigned long int) arg.ull);
+	case LLONG:
+		return snprintf(buffer, max_len, spec, arg.ll);
+	case ULLONG:
+		return snprintf(buffer, max_len, spec, arg.ull);
+	case DOUBLE:
+		return snprintf(buffer, max_len, spec, arg.d);
+	case POINTER:
+		return snprintf(buffer, max_len, spec, arg.p);
+	case STRING:
+		return snprintf(buffer, max_len, spec, record.strings + arg.ull);
+	}
+	return 0;
+}
+
+size_t logging::AsyncLog::formatMessage(char *buffer, const size_t max_len,
+		const Record &record) {
+	size_t len = 0;
+	uint8_t index = 0;
+	const char *c = record.format;
+	while (*c && len + 1 < max_len) {
+		if (*c != '%') {
+			buffer[len++] = *c++;
+			continue;
+		} else if (c[1] == '%') {
+			buffer[len++] = '%';
+			c += 2;
+			continue;
+		}
+
+		// Copy the conversion specifier, up to and including the conversion character.
+		char spec[MAX_SPEC_LEN + 1];
+		size_t spec_len = 0;
+		do {
+			spec[spec_len++] = *c++;
+		} while (*c && spec_len < MAX_SPEC_LEN
+				&& !strchr(CONVERSIONS, c[-1]));
+		spec[spec_len] = 0;
+
+		int written = 0;
+		// Specifiers with a variable width or precision aren't supported, and %n is ignored for safety.
+		// Strings are only written for string arguments, so a wrong argument can't crash the consumer.
+		const char conversion = spec[spec_len - 1];
+		if (index < record.arg_count && spec_len > 1
+				&& strchr(CONVERSIONS, conversion) && conversion != 'n'
+				&& !strchr(spec, '*')
+				&& (conversion == 's') == (record.types[index] == STRING)) {
+			written = formatArg(buffer + len, max_len - len, spec, record,
+					index++);
+		} else {
+			written = snprintf(buffer + len, max_len - len, "%s", spec);
+		}
+
+		if (written > 0) {
+			len += std::min((size_t) written, max_len - len - 1);
+		}
+	}
+	buffer[len] = 0;
+	return len;
+}
+
+size_t logging::AsyncLog::pop(char *buffer, const size_t max_len) {
+	Slot &slot = _slots[_tail & (_capacity - 1)];
+	if (slot.sequence.load(std::memory_order_acquire) != _tail + 1) {
+		return 0;
+	}
+
+	const Record &record = slot.record;
+	// Leave space for the line ending.
+	const size_t line_len = max_len - 2;
+	size_t len = snprintf(buffer, line_len, "[%6u][%c][%s:%u] %s(): ",
+			(unsigned int) record.timestamp, LEVEL_LETTERS[record.level],
+			record.file, (unsigned int) record.line, record.function);
+	if (len >= line_len) {
+		len = line_len - 1;
+	} else {
+		len += formatMessage(buffer + len, line_len - len, record);
+	}
+	buffer[len++] = '\r';
+	buffer[len++] = '\n';
+	buffer[len] = 0;
+
+	slot.sequence.store(_tail + _capacity, std::memory_order_release);
+	_tail++;
+	return len;
+}
+
+void logging::AsyncLog::setLevel(const Level level) {
+	_level.store(level, std::memory_order_relaxed);
+}
+
+logging::Level logging::AsyncLog::getLevel() const {
+	return (Level) _level.load(std::memory_order_relaxed);
+}
+
+uint32_t logging::AsyncLog::getDropped() const {
+	return _dropped.load(std::memory_order_relaxed);
+}
+
+#if ENABLE_ASYNC_LOG == 1
+#ifndef CORE_DEBUG_LEVEL
+#define CORE_DEBUG_LEVEL 0
+#endif
+
+static_assert(ASYNC_LOG_CAPACITY > 0 && (ASYNC_LOG_CAPACITY & (ASYNC_LOG_CAPACITY - 1)) == 0,
+		"ASYNC_LOG_CAPACITY has to be a power of two.");
+
+/**
+ * @return	The current time in milliseconds since startup.
+ */
+static uint32_t getTime() {
+#ifdef ARDUINO
+	return millis();
+#else
+	static const std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start).count();
+#endif
+}
+
+logging::AsyncLog logging::async_log(ASYNC_LOG_CAPACITY, getTime,
+		(logging::Level) CORE_DEBUG_LEVEL);
+#endif
@@ -0,0 +1,115 @@
+/*
+ * tokenized_log.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "tokenized_log.h"
+#include <cstdio>
+#include <cstring>
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+#include <chrono>
+#endif
+
+/**
+ * The function used to write the frames.
+ * NULL to write them to stdout.
+ */
+static logging::token_output_function token_output = NULL;
+
+void logging::TokenFrame::writeLittleEndian(const uint64_t value,
+		const uint8_t bytes) {
+	for (uint8_t i = 0; i < bytes; i++) {
+		_buffer[_len++] = value >> (i * 8);
+	}
+}
+
+void logging::TokenFrame::addArg(const ArgType type, const uint8_t *data,
+		const size_t len) {
+	if (_full || _len + 1 + len > MAX_FRAME_LEN) {
+		_full = true;
+		return;
+	}
+	_buffer[_len++] = type;
+	memcpy(_buffer + _len, data, len);
+	_len += len;
+}
+
+void logging::TokenFrame::addVarint(const ArgType type, uint64_t value) {
+	uint8_t data[10];
+	size_t len = 0;
+	do {
+		data[len] = value & 0x7F;
+		value >>= 7;
+		if (value) {
+			data[len] |= 0x80;
+		}
+		len++;
+	} while (value);
+	addArg(type, data, len);
+}
+
+void logging::TokenFrame::add(const double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint8_t data[8];
+	for (uint8_t i = 0; i < 8; i++) {
+		data[i] = bits >> (i * 8);
+	}
+	addArg(DOUBLE, data, sizeof(data));
+}
+
+void logging::TokenFrame::add(const char *value) {
+	if (_full || _len + 2 > MAX_FRAME_LEN) {
+		_full = true;
+		return;
+	}
+
+	size_t len = value ? strlen(value) : 0;
+	if (len > MAX_FRAME_LEN - _len - 2) {
+		len = MAX_FRAME_LEN - _len - 2;
+	}
+	_buffer[_len++] = STRING;
+	_buffer[_len++] = len;
+	if (len > 0) {
+		memcpy(_buffer + _len, value, len);
+		_len += len;
+	}
+}
+
+const uint8_t* logging::TokenFrame::data() const {
+	return _buffer;
+}
+
+size_t logging::TokenFrame::size() const {
+	return _len;
+}
+
+void logging::setTokenOutput(const token_output_function output) {
+	token_output = output;
+}
+
+void logging::writeTokenFrame(const TokenFrame &frame) {
+	if (token_output) {
+		token_output(frame.data(), frame.size());
+	} else {
+		fwrite(frame.data(), 1, frame.size(), stdout);
+	}
+}
+
+uint32_t logging::getTokenTimestamp() {
+#ifdef ARDUINO
+	return millis();
+#else
+	static const std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+	return std::chrono::duration_cast<std::chrono::milliseconds>(
+			std::chrono::steady_clock::now() - start).count();
+#endif
+}
@@ -0,0 +1,180 @@
+/*
+ * http_response_parser.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_HTTP_RESPONSE_PARSER_INCLUDE_HTTP_RESPONSE_PARSER_H_
+#define LIB_HTTP_RESPONSE_PARSER_INCLUDE_HTTP_RESPONSE_PARSER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace http {
+
+/**
+ * An incremental parser for HTTP/1.x responses.
+ *
+ * The response can be given to the parser in arbitrarily split parts, as they are received.
+ * The parser stops at the end of each response, so multiple responses on the same connection can be parsed one after the other.
+ * Response bodies are skipped, using the Content-Length header, chunked transfer encoding, or the end of the connection.
+ *
+ * Only the status code and the headers required to find the end of the response are stored.
+ * The memory use is constant, and lines longer than MAX_LINE_LEN are truncated.
+ */
+class ResponseParser {
+public:
+	/**
+	 * The max length of a status or header line to store.
+	 * The rest of longer lines is ignored.
+	 */
+	static constexpr size_t MAX_LINE_LEN = 127;
+private:
+	/**
+	 * The part of the response that is currently being parsed.
+	 */
+	enum State : uint8_t {
+		STATUS_LINE,
+		HEADER_LINE,
+		BODY,
+		BODY_UNTIL_CLOSE,
+		CHUNK_SIZE_LINE,
+		CHUNK_DATA,
+		CHUNK_DATA_END,
+		TRAILER_LINE,
+		COMPLETE,
+		ERROR
+	};
+
+	/**
+	 * The part of the response that is currently being parsed.
+	 */
+	State _state = STATUS_LINE;
+
+	/**
+	 * The buffer for the current line.
+	 */
+	char _line[MAX_LINE_LEN + 1];
+
+	/**
+	 * The length of the current line, up to MAX_LINE_LEN.
+	 */
+	size_t _line_len = 0;
+
+	/**
+	 * The HTTP status code of the current response.
+	 */
+	uint16_t _status = 0;
+
+	/**
+	 * The minor version of the HTTP protocol of the current response.
+	 */
+	uint8_t _minor_version = 1;
+
+	/**
+	 * Whether the response has a Content-Length header.
+	 */
+	bool _has_content_length = false;
+
+	/**
+	 * Whether the response uses chunked transfer encoding.
+	 */
+	bool _chunked = false;
+
+	/**
+	 * Whether the connection can be reused after this response.
+	 */
+	bool _keep_alive = true;
+
+	/**
+	 * The number of body or chunk bytes left to skip.
+	 */
+	uint64_t _remaining = 0;
+
+	/**
+	 * Handles a complete line.
+	 *
+	 * @return	False if the line is invalid.
+	 */
+	bool handleLine();
+
+	/**
+	 * Handles a complete header line.
+	 */
+	void handleHeader();
+
+	/**
+	 * Handles the end of the headers, and sets the state for the body.
+	 */
+	void handleHeadersEnd();
+public:
+	/**
+	 * Parses the given response data, until the end of the data or the end of the current response.
+	 *
+	 * If the response is complete after this call, the remaining data belongs to the next response,
+	 * and should be parsed after calling reset.
+	 *
+	 * @param data	The response data to parse.
+	 * @param len	The length of the data.
+	 * @return	The number of bytes that were parsed.
+	 */
+	size_t parse(const uint8_t *data, const size_t len);
+
+	/**
+	 * Handles the end of the connection.
+	 * Completes responses whose body ends with the connection.
+	 *
+	 * @return	True if the current response is complete.
+	 */
+	bool finish();
+
+	/**
+	 * Resets this parser for the next response.
+	 */
+	void reset();
+
+	/**
+	 * Checks whether the current response was parsed completely.
+	 *
+	 * @return	True if the response is complete.
+	 */
+	bool isComplete() const;
+
+	/**
+	 * Checks whether the response is invalid.
+	 * Nothing can be parsed after an error, until the parser is reset.
+	 *
+	 * @return	True if the parser encountered an error.
+	 */
+	bool hasError() const;
+
+	/**
+	 * Checks whether no part of a response was parsed since the last reset.
+	 *
+	 * @return	True if no response data was parsed.
+	 */
+	bool isIdle() const;
+
+	/**
+	 * Gets the HTTP status code of the current response.
+	 *
+	 * @return	The status code, or zero if the status line wasn't parsed yet.
+	 */
+	uint16_t getStatus() const;
+
+	/**
+	 * Checks whether the connection can be used for another request after the current response.
+	 * Only valid once the headers were parsed.
+	 *
+	 * @return	True if the connection can be reused.
+	 */
+	bool isKeepAlive() const;
+};
+
+}
+
+#endif /* LIB_HTTP_RESPONSE_PARSER_INCLUDE_HTTP_RESPONSE_PARSER_H_ */
@@ -0,0 +1,229 @@
+/*
+ * http_response_parser.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "http_response_parser.h"
+#include <cctype>
+#include <cstring>
+
+/**
+ * Compares the given string to a lower case string, ignoring the case of the first string.
+ *
+ * @param str	The string to compare.
+ * @param len	The length of the string to compare.
+ * @param lower	The lower case string to compare to.
+ * @return	True if the strings are equal.
+ */
+static bool equalsIgnoreCase(const char *str, const size_t len,
+		const char *lower) {
+	if (strlen(lower) != len) {
+		return false;
+	}
+	for (size_t i = 0; i < len; i++) {
+		if (tolower((unsigned char) str[i]) != lower[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Checks whether the given string contains the given lower case token, ignoring the case of the string.
+ *
+ * @param str	The string to search.
+ * @param len	The length of the string to search.
+ * @param token	The lower case token to search for.
+ * @return	True if the string contains the token.
+ */
+static bool containsIgnoreCase(const char *str, const size_t len,
+		const char *token) {
+	const size_t token_len = strlen(token);
+	for (size_t i = 0; i + token_len <= len; i++) {
+		if (equalsIgnoreCase(str + i, token_len, token)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t http::ResponseParser::parse(const uint8_t *data, const size_t len) {
+	size_t pos = 0;
+	while (pos < len && _state != COMPLETE && _state != ERROR) {
+		if (_state == BODY || _state == CHUNK_DATA) {
+			const size_t skip =
+					_remaining < len - pos ? (size_t) _remaining : len - pos;
+			pos += skip;
+			_remaining -= skip;
+			if (_remaining == 0) {
+				_state = _state == BODY ? COMPLETE : CHUNK_DATA_END;
+			}
+		} else if (_state == BODY_UNTIL_CLOSE) {
+			pos = len;
+		} else {
+			const char c = data[pos++];
+			if (c == '\n') {
+				if (_line_len > 0 && _line[_line_len - 1] == '\r') {
+					_line_len--;
+				}
+				_line[_line_len] = 0;
+				if (!handleLine()) {
+					_state = ERROR;
+				}
+				_line_len = 0;
+			} else if (_line_len < MAX_LINE_LEN) {
+				_line[_line_len++] = c;
+			}
+		}
+	}
+	return pos;
+}
+
+bool http::ResponseParser::handleLine() {
+	switch (_state) {
+	case STATUS_LINE:
+		// Some servers send empty lines between responses.
+		if (_line_len == 0) {
+			return true;
+		}
+		if (_line_len < 12 || memcmp(_line, "HTTP/1.", 7) != 0
+				|| !isdigit((unsigned char) _line[7]) || _line[8] != ' '
+				|| !isdigit((unsigned char) _line[9])
+				|| !isdigit((unsigned char) _line[10])
+				|| !isdigit((unsigned char) _line[11])) {
+			return false;
+		}
+		_minor_version = _line[7] - '0';
+		_keep_alive = _minor_version >= 1;
+		_status = (_line[9] - '0') * 100 + (_line[10] - '0') * 10 + _line[11]
+				- '0';
+		_state = HEADER_LINE;
+		return true;
+	case HEADER_LINE:
+		if (_line_len == 0) {
+			handleHeadersEnd();
+		} else {
+			handleHeader();
+		}
+		return true;
+	case CHUNK_SIZE_LINE: {
+		uint64_t size = 0;
+		size_t i = 0;
+		while (i < _line_len && isxdigit((unsigned char) _line[i])) {
+			const char c = tolower((unsigned char) _line[i]);
+			size = size * 16 + (c <= '9' ? c - '0' : c - 'a' + 10);
+			i++;
+		}
+		if (i == 0) {
+			return false;
+		}
+		if (size == 0) {
+			_state = TRAILER_LINE;
+		} else {
+			_remaining = size;
+			_state = CHUNK_DATA;
+		}
+		return true;
+	}
+	case CHUNK_DATA_END:
+		_state = CHUNK_SIZE_LINE;
+		return _line_len == 0;
+	case TRAILER_LINE:
+		if (_line_len == 0) {
+			_state = COMPLETE;
+		}
+		return true;
+	default:
+		return false;
+	}
+}
+
+void http::ResponseParser::handleHeader() {
+	const char *colon = (const char*) memchr(_line, ':', _line_len);
+	if (!colon) {
+		return;
+	}
+
+	const size_t name_len = colon - _line;
+	const char *value = colon + 1;
+	while (*value == ' ' || *value == '\t') {
+		value++;
+	}
+	const size_t value_len = _line + _line_len - value;
+
+	if (equalsIgnoreCase(_line, name_len, "content-length")) {
+		_remaining = 0;
+		for (size_t i = 0; i < value_len && isdigit((unsigned char) value[i]);
+				i++) {
+			_remaining = _remaining * 10 + value[i] - '0';
+		}
+		_has_content_length = true;
+	} else if (equalsIgnoreCase(_line, name_len, "transfer-encoding")) {
+		_chunked = containsIgnoreCase(value, value_len, "chunked");
+	} else if (equalsIgnoreCase(_line, name_len, "connection")) {
+		if (containsIgnoreCase(value, value_len, "close")) {
+			_keep_alive = false;
+		} else if (containsIgnoreCase(value, value_len, "keep-alive")) {
+			_keep_alive = true;
+		}
+	}
+}
+
+void http::ResponseParser::handleHeadersEnd() {
+	if (_status >= 100 && _status < 200) {
+		// Interim responses are followed by the actual response.
+		reset();
+	} else if (_status == 204 || _status == 304) {
+		_state = COMPLETE;
+	} else if (_chunked) {
+		_state = CHUNK_SIZE_LINE;
+	} else if (_has_content_length) {
+		_state = _remaining == 0 ? COMPLETE : BODY;
+	} else {
+		_state = BODY_UNTIL_CLOSE;
+		_keep_alive = false;
+	}
+}
+
+bool http::ResponseParser::finish() {
+	if (_state == BODY_UNTIL_CLOSE) {
+		_state = COMPLETE;
+	}
+	return _state == COMPLETE;
+}
+
+void http::ResponseParser::reset() {
+	_state = STATUS_LINE;
+	_line_len = 0;
+	_status = 0;
+	_minor_version = 1;
+	_has_content_length = false;
+	_chunked = false;
+	_keep_alive = true;
+	_remaining = 0;
+}
+
+bool http::ResponseParser::isComplete() const {
+	return _state == COMPLETE;
+}
+
+bool http::ResponseParser::hasError() const {
+	return _state == ERROR;
+}
+
+bool http::ResponseParser::isIdle() const {
+	return _state == STATUS_LINE && _line_len == 0;
+}
+
+uint16_t http::ResponseParser::getStatus() const {
+	return _status;
+}
+
+bool http::ResponseParser::isKeepAlive() const {
+	return _keep_alive;
+}
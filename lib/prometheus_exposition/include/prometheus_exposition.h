@@ -0,0 +1,465 @@
+/*
+ * prometheus_exposition.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROMETHEUS_EXPOSITION_INCLUDE_PROMETHEUS_EXPOSITION_H_
+#define LIB_PROMETHEUS_EXPOSITION_INCLUDE_PROMETHEUS_EXPOSITION_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace prom {
+
+class MetricEncoder;
+
+/**
+ * A single metric family, which can be written by an ExpositionWriter.
+ *
+ * Metric families only describe how to write their current values.
+ * They don't store any state about an ongoing write, so a single instance can be used by multiple writers.
+ *
+ * The full name is rendered when the metric family is created.
+ * The metadata lines can be pre-rendered once using prerender, so writers only have to copy them.
+ */
+class MetricFamily {
+protected:
+	/**
+	 * The full name of this metric family, including its namespace and unit.
+	 */
+	const std::string _full_name;
+
+	/**
+	 * The pre-rendered metadata lines of this metric family.
+	 * Empty if prerender wasn't called yet.
+	 */
+	std::string _metadata;
+
+	/**
+	 * The offset of the metadata lines of the Prometheus 0.0.4 and OpenMetrics formats in the metadata string.
+	 */
+	size_t _metadata_offset[2] { 0, 0 };
+
+	/**
+	 * The length of the metadata lines of the Prometheus 0.0.4 and OpenMetrics formats.
+	 */
+	size_t _metadata_len[2] { 0, 0 };
+public:
+	/**
+	 * The namespace of the metric family. May be empty.
+	 */
+	const char *const metric_namespace;
+
+	/**
+	 * The name of the metric family, without the namespace and unit.
+	 */
+	const char *const name;
+
+	/**
+	 * The unit of the metric family. May be empty.
+	 */
+	const char *const unit;
+
+	/**
+	 * The description text of the metric family.
+	 */
+	const char *const help;
+
+	/**
+	 * Creates a new metric family.
+	 * All the strings have to remain valid for the lifetime of this object.
+	 *
+	 * @param metric_namespace	The namespace of the metric family. May be empty.
+	 * @param name				The name of the metric family, without the namespace and unit.
+	 * @param unit				The unit of the metric family. May be empty.
+	 * @param help				The description text of the metric family.
+	 */
+	MetricFamily(const char *metric_namespace, const char *name,
+			const char *unit, const char *help);
+
+	/**
+	 * Destroys this metric family.
+	 */
+	virtual ~MetricFamily();
+
+	/**
+	 * Gets the type of this metric family, as written to the TYPE metadata line.
+	 *
+	 * @param openmetrics	Whether the OpenMetrics format is written, rather than the Prometheus 0.0.4 format.
+	 * @return	The type of this metric family.
+	 */
+	virtual const char* getType(const bool openmetrics) const = 0;
+
+	/**
+	 * Writes a single sample line of this metric family, including the trailing newline.
+	 *
+	 * Works like snprintf, meaning the return value is the length of the full line,
+	 * even if it didn't fit into the buffer.
+	 *
+	 * @param buffer		The buffer to write the line to.
+	 * @param max_len		The size of the buffer, including the terminating NUL byte.
+	 * @param index			The index of the sample to write.
+	 * @param openmetrics	Whether to write the OpenMetrics format, rather than the Prometheus 0.0.4 format.
+	 * @param consumer		The consumer the exposition is written for.
+	 * 						Only used by metric families tracking which samples each consumer received.
+	 * @return	The length of the sample line, or zero if there is no sample with the given index.
+	 */
+	virtual size_t writeSample(char *buffer, const size_t max_len,
+			const size_t index, const bool openmetrics,
+			const uint8_t consumer) const = 0;
+
+	/**
+	 * Writes the fields of a single io.prometheus.client.Metric message of this metric family,
+	 * for the protobuf exposition format.
+	 *
+	 * Metrics are indexed separately from sample lines,
+	 * so for example a histogram series is a single metric, but multiple sample lines.
+	 *
+	 * @param encoder	The encoder to write the metric fields to.
+	 * @param index		The index of the metric to write.
+	 * @param consumer	The consumer the output is written for.
+	 * 					Only used by metric families tracking which samples each consumer received.
+	 * @return	False if there is no metric with the given index.
+	 */
+	virtual bool writeMetric(MetricEncoder &encoder, const size_t index,
+			const uint8_t consumer) const = 0;
+
+	/**
+	 * Renders the HELP, TYPE, and UNIT lines of both exposition formats, so they don't have to be formatted by every writer.
+	 * If the Prometheus 0.0.4 lines are a prefix of the OpenMetrics lines, they are only stored once.
+	 *
+	 * This is **NOT** thread safe, and should only be called during startup.
+	 * Called by the registry when a metric family is added.
+	 */
+	void prerender();
+
+	/**
+	 * Gets the pre-rendered metadata lines of this metric family.
+	 *
+	 * @param openmetrics	Whether to get the OpenMetrics lines, rather than the Prometheus 0.0.4 lines.
+	 * @param len			Set to the length of the metadata lines.
+	 * @return	The metadata lines, or NULL if they weren't pre-rendered.
+	 */
+	const char* getMetadata(const bool openmetrics, size_t &len) const;
+
+	/**
+	 * Writes the full name of this metric family, including its namespace and unit.
+	 * Works like snprintf, but only copies the pre-rendered name.
+	 *
+	 * @param buffer	The buffer to write the name to.
+	 * @param max_len	The size of the buffer, including the terminating NUL byte.
+	 * @return	The length of the full name.
+	 */
+	size_t writeName(char *buffer, const size_t max_len) const;
+
+	/**
+	 * Writes the name, help, type, and unit fields of the protobuf io.prometheus.client.MetricFamily message.
+	 * Works like snprintf, meaning the return value is the full length, even if it didn't fit into the buffer.
+	 *
+	 * @param buffer	The buffer to write the fields to.
+	 * @param max_len	The size of the buffer.
+	 * @return	The length of the encoded fields.
+	 */
+	size_t writeProtobufMetadata(uint8_t *buffer, const size_t max_len) const;
+
+	/**
+	 * Checks whether the full name of this metric family, including its namespace and unit, is the given name.
+	 *
+	 * @param name	The name to compare to.
+	 * @return	True if the name is the full name of this metric family.
+	 */
+	bool hasName(const std::string &name) const;
+};
+
+/**
+ * A metric family with a single floating point sample without labels.
+ */
+class ValueFamily: public MetricFamily {
+private:
+	/**
+	 * The type of this metric family.
+	 */
+	const char *const _type;
+
+	/**
+	 * The function returning the current value of this metric.
+	 */
+	const std::function<double()> _value;
+
+	/**
+	 * The number of decimal places to write.
+	 */
+	const uint8_t _decimals;
+public:
+	/**
+	 * Creates a new floating point metric family.
+	 *
+	 * @param metric_namespace	The namespace of the metric family. May be empty.
+	 * @param name				The name of the metric family, without the namespace and unit.
+	 * @param unit				The unit of the metric family. May be empty.
+	 * @param help				The description text of the metric family.
+	 * @param type				The type of the metric family. Usually "gauge" or "counter".
+	 * @param value				The function returning the current value of the metric.
+	 * @param decimals			The number of decimal places to write.
+	 */
+	ValueFamily(const char *metric_namespace, const char *name,
+			const char *unit, const char *help, const char *type,
+			const std::function<double()> value, const uint8_t decimals = 3);
+
+	virtual const char* getType(const bool openmetrics) const override;
+
+	virtual size_t writeSample(char *buffer, const size_t max_len,
+			const size_t index, const bool openmetrics, const uint8_t consumer) const
+			override;
+
+	virtual bool writeMetric(MetricEncoder &encoder, const size_t index,
+			const uint8_t consumer) const override;
+};
+
+/**
+ * A metric family with a single unsigned integer sample without labels.
+ */
+class IntegerValueFamily: public MetricFamily {
+private:
+	/**
+	 * The type of this metric family.
+	 */
+	const char *const _type;
+
+	/**
+	 * The function returning the current value of this metric.
+	 */
+	const std::function<uint64_t()> _value;
+public:
+	/**
+	 * Creates a new integer metric family.
+	 *
+	 * @param metric_namespace	The namespace of the metric family. May be empty.
+	 * @param name				The name of the metric family, without the namespace and unit.
+	 * @param unit				The unit of the metric family. May be empty.
+	 * @param help				The description text of the metric family.
+	 * @param type				The type of the metric family. Usually "gauge" or "counter".
+	 * @param value				The function returning the current value of the metric.
+	 */
+	IntegerValueFamily(const char *metric_namespace, const char *name,
+			const char *unit, const char *help, const char *type,
+			const std::function<uint64_t()> value);
+
+	virtual const char* getType(const bool openmetrics) const override;
+
+	virtual size_t writeSample(char *buffer, const size_t max_len,
+			const size_t index, const bool openmetrics, const uint8_t consumer) const
+			override;
+
+	virtual bool writeMetric(MetricEncoder &encoder, const size_t index,
+			const uint8_t consumer) const override;
+};
+
+/**
+ * An info metric family, with a single sample with a constant value of 1 and a constant set of labels.
+ * Written as a gauge in the Prometheus 0.0.4 format, which has no info type.
+ */
+class InfoFamily: public MetricFamily {
+private:
+	/**
+	 * The pre-rendered sample line, including the name, labels, and value.
+	 */
+	const std::string _sample;
+
+	/**
+	 * The unescaped names and values of the labels, alternating.
+	 */
+	const std::vector<std::string> _labels;
+public:
+	/**
+	 * Creates a new info metric family.
+	 *
+	 * @param metric_namespace	The namespace of the metric family. May be empty.
+	 * @param name				The name of the metric family, without the namespace.
+	 * @param help				The description text of the metric family.
+	 * @param labels			The labels of the sample, including the curly braces.
+	 */
+	InfoFamily(const char *metric_namespace, const char *name,
+			const char *help, const std::string &labels);
+
+	virtual const char* getType(const bool openmetrics) const override;
+
+	virtual size_t writeSample(char *buffer, const size_t max_len,
+			const size_t index, const bool openmetrics, const uint8_t consumer) const
+			override;
+
+	virtual bool writeMetric(MetricEncoder &encoder, const size_t index,
+			const uint8_t consumer) const override;
+};
+
+/**
+ * A pull based writer for the Prometheus and OpenMetrics text exposition formats.
+ *
+ * The output is created one line at a time, and copied to the output buffer given to read.
+ * If a line doesn't fit into the remaining space, the rest of it is written by the next read call.
+ * This means the memory use doesn't depend on the number of metrics, and the total length doesn't
+ * have to be known in advance.
+ *
+ * The families to write can be limited to a set of names, in which case all other families are skipped without being rendered.
+ *
+ * The writer stores its position as a family index and sample index.
+ * Metric families with a changing number of samples may therefore skip or repeat a sample,
+ * if they change while the output is being written.
+ */
+class ExpositionWriter {
+public:
+	/**
+	 * The max length of a single line, including the trailing newline.
+	 * Longer lines are skipped.
+	 */
+	static constexpr size_t MAX_LINE_LEN = 511;
+private:
+	/**
+	 * The part of a metric family that is currently being written.
+	 */
+	enum Stage : uint8_t {
+		HELP, TYPE, UNIT, SAMPLES, END, DONE
+	};
+
+	/**
+	 * The metric families to write.
+	 */
+	const std::vector<const MetricFamily*> &_families;
+
+	/**
+	 * Whether to write the OpenMetrics format, rather than the Prometheus 0.0.4 format.
+	 */
+	const bool _openmetrics;
+
+	/**
+	 * The full names of the metric families to write.
+	 * Empty to write all of them.
+	 */
+	const std::vector<std::string> _names;
+
+	/**
+	 * The consumer the exposition is written for.
+	 */
+	const uint8_t _consumer;
+
+	/**
+	 * The index of the metric family that is currently being written.
+	 */
+	size_t _family = 0;
+
+	/**
+	 * The part of the current metric family that is currently being written.
+	 */
+	Stage _stage = HELP;
+
+	/**
+	 * The index of the next sample of the current metric family to write.
+	 */
+	size_t _sample = 0;
+
+	/**
+	 * The buffer for lines that have to be formatted while writing.
+	 */
+	char _line[MAX_LINE_LEN + 1];
+
+	/**
+	 * The line that is currently being copied to the output.
+	 * Either the line buffer, or pre-rendered lines of a metric family.
+	 */
+	const char *_output = _line;
+
+	/**
+	 * The length of the current line.
+	 */
+	size_t _line_len = 0;
+
+	/**
+	 * The number of bytes of the current line that were already copied to the output.
+	 */
+	size_t _line_pos = 0;
+
+	/**
+	 * Moves to the first metric family to write, starting at the current one.
+	 * Moves to the end if there is none.
+	 */
+	void skipFiltered();
+
+	/**
+	 * Writes the next line to the line buffer, or points the output at the next pre-rendered lines.
+	 *
+	 * @return	False if there are no more lines to write.
+	 */
+	bool nextLine();
+
+	/**
+	 * Writes a metadata line for the current metric family to the line buffer.
+	 *
+	 * @param field	The name of the metadata field. Has to be in CAPS.
+	 * @param value	The value of the metadata field.
+	 * @return	The length of the line, like snprintf.
+	 */
+	size_t writeMetadataLine(const char *field, const char *value);
+public:
+	/**
+	 * Creates a new exposition writer.
+	 *
+	 * @param families		The metric families to write. Has to remain valid until the writer is done.
+	 * @param openmetrics	Whether to write the OpenMetrics format, rather than the Prometheus 0.0.4 format.
+	 * @param names			The full names of the metric families to write. Empty to write all of them.
+	 * @param consumer		The consumer the exposition is written for. See MetricFamily::writeSample.
+	 */
+	ExpositionWriter(const std::vector<const MetricFamily*> &families,
+			const bool openmetrics = false,
+			const std::vector<std::string> &names = { },
+			const uint8_t consumer = 0);
+
+	/**
+	 * Writes the next part of the exposition to the given buffer.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The max number of bytes to write.
+	 * @return	The number of bytes written. Zero once the exposition is complete.
+	 */
+	size_t read(uint8_t *buffer, const size_t max_len);
+
+	/**
+	 * Checks whether the entire exposition was written.
+	 *
+	 * @return	True if there is nothing left to write.
+	 */
+	bool done() const;
+};
+
+/**
+ * The exposition formats a client can request.
+ */
+enum ExpositionFormat : uint8_t {
+	FORMAT_TEXT, FORMAT_OPENMETRICS, FORMAT_PROTOBUF
+};
+
+/**
+ * Selects the exposition format to write, based on the Accept header of a request.
+ *
+ * Each comma separated item is split into its media type and its semicolon separated parameters.
+ * The protobuf format is only accepted with the parameter proto=io.prometheus.client.MetricFamily,
+ * and without an encoding other than delimited.
+ * Items with a q value of zero are ignored.
+ * Of the remaining supported items, the one with the highest q value is used.
+ * If multiple items have the same q value, protobuf is preferred over OpenMetrics, and OpenMetrics over text.
+ *
+ * @param accept	The value of the Accept header. May be empty.
+ * @return	The format to write. The text format if the client doesn't accept any other format.
+ */
+ExpositionFormat negotiateFormat(const char *accept);
+
+}
+
+#endif /* LIB_PROMETHEUS_EXPOSITION_INCLUDE_PROMETHEUS_EXPOSITION_H_ */
@@ -0,0 +1,376 @@
+/*
+ * prometheus_protobuf.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROMETHEUS_EXPOSITION_INCLUDE_PROMETHEUS_PROTOBUF_H_
+#define LIB_PROMETHEUS_EXPOSITION_INCLUDE_PROMETHEUS_PROTOBUF_H_
+
+#include "prometheus_exposition.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace prom {
+
+/**
+ * An encoder for a single protobuf encoded io.prometheus.client.Metric message,
+ * or the metadata fields of a io.prometheus.client.MetricFamily message.
+ *
+ * Works like snprintf, meaning the length is counted even if the message doesn't fit into the buffer.
+ * Nested messages reserve space for the longest possible length prefix,
+ * and are moved back once their length is known, so every value is only read once.
+ */
+class MetricEncoder {
+public:
+	/**
+	 * The metric types of the io.prometheus.client.MetricFamily message.
+	 */
+	enum MetricType : uint8_t {
+		COUNTER = 0, GAUGE = 1, SUMMARY = 2, UNTYPED = 3, HISTOGRAM = 4
+	};
+
+	/**
+	 * The max number of nested messages that can be open at once.
+	 */
+	static constexpr uint8_t MAX_DEPTH = 3;
+private:
+	/**
+	 * The buffer to write the message to.
+	 */
+	uint8_t *const _buffer;
+
+	/**
+	 * The size of the buffer.
+	 */
+	const size_t _max_len;
+
+	/**
+	 * The length of the message written so far, including the parts that didn't fit into the buffer.
+	 */
+	size_t _len = 0;
+
+	/**
+	 * The start of the content of each open nested message.
+	 */
+	size_t _message_starts[MAX_DEPTH];
+
+	/**
+	 * The number of open nested messages.
+	 */
+	uint8_t _depth = 0;
+
+	/**
+	 * Writes a single byte, if it fits into the buffer.
+	 *
+	 * @param value	The byte to write.
+	 */
+	void writeByte(const uint8_t value);
+public:
+	/**
+	 * Creates a new metric encoder writing to the given buffer.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The size of the buffer.
+	 */
+	MetricEncoder(uint8_t *buffer, const size_t max_len);
+
+	/**
+	 * Gets the protobuf metric type for the given Prometheus 0.0.4 TYPE value.
+	 *
+	 * @param type	The type of a metric family.
+	 * @return	The protobuf metric type. UNTYPED for unknown types.
+	 */
+	static MetricType getType(const char *type);
+
+	/**
+	 * Calculates the length of the given value as a protobuf varint.
+	 *
+	 * @param value	The value to encode.
+	 * @return	The length of the varint.
+	 */
+	static size_t getVarintLength(uint64_t value);
+
+	/**
+	 * Writes the given value as a protobuf varint.
+	 *
+	 * @param value	The value to write.
+	 */
+	void writeVarint(uint64_t value);
+
+	/**
+	 * Writes a field tag.
+	 *
+	 * @param field		The number of the field.
+	 * @param wire_type	The protobuf wire type of the field.
+	 */
+	void writeTag(const uint32_t field, const uint8_t wire_type);
+
+	/**
+	 * Writes an unsigned integer field.
+	 *
+	 * @param field	The number of the field.
+	 * @param value	The value of the field.
+	 */
+	void writeUInt64(const uint32_t field, const uint64_t value);
+
+	/**
+	 * Writes an unsigned integer field, as a varint padded to its max length.
+	 * Used for values that can change while a metric family is written,
+	 * so the length of the metric doesn't depend on the value.
+	 *
+	 * @param field	The number of the field.
+	 * @param value	The value of the field.
+	 */
+	void writeFixedUInt64(const uint32_t field, const uint64_t value);
+
+	/**
+	 * Writes a double field, as 8 little endian bytes.
+	 *
+	 * @param field	The number of the field.
+	 * @param value	The value of the field.
+	 */
+	void writeDouble(const uint32_t field, const double value);
+
+	/**
+	 * Writes a string field.
+	 *
+	 * @param field	The number of the field.
+	 * @param value	The value of the field. Doesn't have to be NUL terminated.
+	 * @param len	The length of the value.
+	 */
+	void writeString(const uint32_t field, const char *value, const size_t len);
+
+	/**
+	 * Starts a nested message field.
+	 * Has to be followed by a matching call to endMessage.
+	 * At most MAX_DEPTH nested messages can be open at once.
+	 *
+	 * @param field	The number of the field.
+	 */
+	void beginMessage(const uint32_t field);
+
+	/**
+	 * Finishes the innermost open nested message, and writes its length.
+	 */
+	void endMessage();
+
+	/**
+	 * Writes the metadata fields of a metric family.
+	 *
+	 * @param name		The full name of the metric family.
+	 * @param name_len	The length of the full name.
+	 * @param help		The description text of the metric family.
+	 * @param type		The type of the metric family.
+	 * @param unit		The unit of the metric family. Not written if empty.
+	 */
+	void writeFamilyMetadata(const char *name, const size_t name_len,
+			const char *help, const MetricType type, const char *unit);
+
+	/**
+	 * Writes a label of the metric.
+	 *
+	 * @param name	The name of the label.
+	 * @param value	The value of the label.
+	 */
+	void writeLabel(const char *name, const char *value);
+
+	/**
+	 * Writes the value of a counter, gauge, or untyped metric.
+	 *
+	 * @param type	The type of the metric. Types other than counter and gauge are written as untyped.
+	 * @param value	The value of the metric.
+	 */
+	void writeValue(const MetricType type, const double value);
+
+	/**
+	 * Writes the timestamp of the metric.
+	 *
+	 * @param timestamp	The timestamp in milliseconds since the unix epoch.
+	 */
+	void writeTimestamp(const int64_t timestamp);
+
+	/**
+	 * Starts the histogram of the metric.
+	 * Has to be followed by the buckets, and a call to endHistogram.
+	 */
+	void beginHistogram();
+
+	/**
+	 * Writes a single histogram bucket.
+	 * The +Inf bucket doesn't have to be written, since its count is the sample count.
+	 *
+	 * @param cumulative_count	The number of observations less than or equal to the upper bound.
+	 * @param upper_bound		The upper bound of the bucket.
+	 */
+	void writeBucket(const uint64_t cumulative_count, const double upper_bound);
+
+	/**
+	 * Finishes the histogram of the metric.
+	 *
+	 * @param sample_count	The total number of observations.
+	 * @param sample_sum	The sum of all observations.
+	 */
+	void endHistogram(const uint64_t sample_count, const double sample_sum);
+
+	/**
+	 * Gets the length of the message written so far, including the parts that didn't fit into the buffer.
+	 *
+	 * @return	The length of the message.
+	 */
+	size_t length() const;
+};
+
+/**
+ * A pull based writer for the Prometheus protobuf exposition format.
+ * Writes length delimited io.prometheus.client.MetricFamily messages.
+ *
+ * Like the ExpositionWriter, the output is created one metric at a time,
+ * so the memory use doesn't depend on the number of metrics.
+ * Since each metric family message starts with its length, every metric is encoded twice.
+ * Once to calculate the length of the metric family, and once to write it.
+ *
+ * Values that can change between the two passes are written as fixed length fields, so the length of a metric never changes.
+ * If a metric family shrinks between the two passes, the remaining space is filled with an unknown field,
+ * which is skipped by decoders. New metrics added between the two passes are written by the next scrape.
+ * Metric families without metrics are skipped entirely.
+ */
+class ProtobufWriter {
+public:
+	/**
+	 * The max length of a single encoded metric, including its field tag and length.
+	 * Longer metrics are skipped.
+	 */
+	static constexpr size_t MAX_METRIC_LEN = 511;
+private:
+	/**
+	 * The part of a metric family that is currently being written.
+	 */
+	enum Stage : uint8_t {
+		HEADER, METRICS, PADDING, DONE
+	};
+
+	/**
+	 * The metric families to write.
+	 */
+	const std::vector<const MetricFamily*> &_families;
+
+	/**
+	 * The full names of the metric families to write.
+	 * Empty to write all of them.
+	 */
+	const std::vector<std::string> _names;
+
+	/**
+	 * The consumer the output is written for.
+	 */
+	const uint8_t _consumer;
+
+	/**
+	 * The index of the metric family that is currently being written.
+	 */
+	size_t _family = 0;
+
+	/**
+	 * The part of the current metric family that is currently being written.
+	 */
+	Stage _stage = HEADER;
+
+	/**
+	 * The index of the next metric of the current metric family to write.
+	 */
+	size_t _metric = 0;
+
+	/**
+	 * The number of bytes of the current metric family message that are left to be written.
+	 * Excluding the current output.
+	 */
+	size_t _remaining = 0;
+
+	/**
+	 * The buffer for the encoded parts of the output.
+	 */
+	uint8_t _buffer[MAX_METRIC_LEN];
+
+	/**
+	 * The part of the output that is currently being copied.
+	 * Points into the buffer.
+	 */
+	const uint8_t *_output = _buffer;
+
+	/**
+	 * The length of the current output part.
+	 */
+	size_t _output_len = 0;
+
+	/**
+	 * The number of bytes of the current output part that were already copied.
+	 */
+	size_t _output_pos = 0;
+
+	/**
+	 * Moves to the first metric family to write, starting at the current one.
+	 * Moves to the end if there is none.
+	 */
+	void skipFiltered();
+
+	/**
+	 * Encodes a single metric of the current metric family as a field of the metric family message.
+	 *
+	 * @param index	The index of the metric to encode.
+	 * @return	The length of the encoded field, or zero if there is no metric with the given index.
+	 */
+	size_t encodeMetric(const size_t index);
+
+	/**
+	 * Encodes the length prefix and the metadata fields of the current metric family.
+	 * Calculates the length of the metric family by encoding all of its metrics.
+	 *
+	 * @return	False if the metric family has no metrics, or its metadata is too long.
+	 */
+	bool encodeHeader();
+
+	/**
+	 * Encodes the next part of the output to the buffer.
+	 *
+	 * @return	False if there is nothing left to write.
+	 */
+	bool nextPart();
+public:
+	/**
+	 * Creates a new protobuf writer.
+	 *
+	 * @param families	The metric families to write. Has to remain valid until the writer is done.
+	 * @param names		The full names of the metric families to write. Empty to write all of them.
+	 * @param consumer	The consumer the output is written for. See MetricFamily::writeMetric.
+	 */
+	ProtobufWriter(const std::vector<const MetricFamily*> &families,
+			const std::vector<std::string> &names = { },
+			const uint8_t consumer = 0);
+
+	/**
+	 * Writes the next part of the output to the given buffer.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The max number of bytes to write.
+	 * @return	The number of bytes written. Zero once the output is complete.
+	 */
+	size_t read(uint8_t *buffer, const size_t max_len);
+
+	/**
+	 * Checks whether the entire output was written.
+	 *
+	 * @return	True if there is nothing left to write.
+	 */
+	bool done() const;
+};
+
+}
+
+#endif /* LIB_PROMETHEUS_EXPOSITION_INCLUDE_PROMETHEUS_PROTOBUF_H_ */
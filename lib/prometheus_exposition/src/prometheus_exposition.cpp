@@ -0,0 +1,493 @@
+/*
+ * prometheus_exposition.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "prometheus_exposition.h"
+#include "prometheus_protobuf.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <strings.h>
+#include <fallback_log.h>
+
+/**
+ * Joins the parts of a metric name, skipping empty parts.
+ *
+ * @param metric_namespace	The namespace of the metric family. May be empty.
+ * @param name				The name of the metric family.
+ * @param unit				The unit of the metric family. May be empty.
+ * @return	The full metric name.
+ */
+static std::string getFullName(const char *metric_namespace, const char *name,
+		const char *unit) {
+	std::string full_name = metric_namespace;
+	if (metric_namespace[0]) {
+		full_name += '_';
+	}
+	full_name += name;
+	if (unit[0]) {
+		full_name += '_';
+		full_name += unit;
+	}
+	return full_name;
+}
+
+/**
+ * Parses the labels of a sample line, and unescapes their values.
+ *
+ * @param labels	The labels, including the curly braces.
+ * @return	The names and values of the labels, alternating.
+ */
+static std::vector<std::string> parseLabels(const std::string &labels) {
+	std::vector<std::string> parsed;
+	size_t pos = labels.find('{');
+	while (pos != std::string::npos && pos + 1 < labels.length()) {
+		const size_t name_start = pos + 1;
+		const size_t name_end = labels.find("=\"", name_start);
+		if (name_end == std::string::npos) {
+			break;
+		}
+
+		std::string value;
+		for (pos = name_end + 2; pos < labels.length() && labels[pos] != '"';
+				pos++) {
+			if (labels[pos] == '\\' && pos + 1 < labels.length()) {
+				pos++;
+				value += labels[pos] == 'n' ? '\n' : labels[pos];
+			} else {
+				value += labels[pos];
+			}
+		}
+		parsed.push_back(labels.substr(name_start, name_end - name_start));
+		parsed.push_back(value);
+		// Skip the closing quote, so pos points at the comma or curly brace.
+		pos++;
+	}
+	return parsed;
+}
+
+prom::MetricFamily::MetricFamily(const char *metric_namespace,
+		const char *name, const char *unit, const char *help) :
+		_full_name(getFullName(metric_namespace, name, unit)), metric_namespace(
+				metric_namespace), name(name), unit(unit), help(help) {
+
+}
+
+prom::MetricFamily::~MetricFamily() {
+
+}
+
+void prom::MetricFamily::prerender() {
+	std::string lines[2];
+	for (uint8_t openmetrics = 0; openmetrics < 2; openmetrics++) {
+		lines[openmetrics] = "# HELP " + _full_name + ' ' + help + "\n# TYPE "
+				+ _full_name + ' ' + getType(openmetrics) + '\n';
+		if (openmetrics && unit[0]) {
+			lines[openmetrics] += "# UNIT " + _full_name + ' ' + unit + '\n';
+		}
+	}
+
+	if (lines[1].compare(0, lines[0].length(), lines[0]) == 0) {
+		_metadata = lines[1];
+		_metadata_offset[1] = 0;
+	} else {
+		_metadata = lines[0] + lines[1];
+		_metadata_offset[1] = lines[0].length();
+	}
+	_metadata_offset[0] = 0;
+	_metadata_len[0] = lines[0].length();
+	_metadata_len[1] = lines[1].length();
+}
+
+const char* prom::MetricFamily::getMetadata(const bool openmetrics,
+		size_t &len) const {
+	if (_metadata.empty()) {
+		return NULL;
+	}
+
+	len = _metadata_len[openmetrics];
+	return _metadata.c_str() + _metadata_offset[openmetrics];
+}
+
+size_t prom::MetricFamily::writeName(char *buffer, const size_t max_len) const {
+	const size_t len = _full_name.length();
+	if (max_len > 0) {
+		const size_t copy = std::min(len, max_len - 1);
+		memcpy(buffer, _full_name.c_str(), copy);
+		buffer[copy] = 0;
+	}
+	return len;
+}
+
+size_t prom::MetricFamily::writeProtobufMetadata(uint8_t *buffer,
+		const size_t max_len) const {
+	MetricEncoder encoder(buffer, max_len);
+	encoder.writeFamilyMetadata(_full_name.c_str(), _full_name.length(), help,
+			MetricEncoder::getType(getType(false)), unit);
+	return encoder.length();
+}
+
+bool prom::MetricFamily::hasName(const std::string &name) const {
+	return _full_name == name;
+}
+
+prom::ValueFamily::ValueFamily(const char *metric_namespace, const char *name,
+		const char *unit, const char *help, const char *type,
+		const std::function<double()> value, const uint8_t decimals) :
+		MetricFamily(metric_namespace, name, unit, help), _type(type), _value(
+				value), _decimals(decimals) {
+
+}
+
+const char* prom::ValueFamily::getType(const bool openmetrics) const {
+	return _type;
+}
+
+size_t prom::ValueFamily::writeSample(char *buffer, const size_t max_len,
+		const size_t index, const bool openmetrics,
+		const uint8_t consumer) const {
+	if (index > 0) {
+		return 0;
+	}
+
+	const size_t len = writeName(buffer, max_len);
+	const double value = _value();
+	if (std::isnan(value)) {
+		return len + snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " NAN\n");
+	} else {
+		return len + snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " %.*f\n", _decimals, value);
+	}
+}
+
+bool prom::ValueFamily::writeMetric(MetricEncoder &encoder,
+		const size_t index, const uint8_t consumer) const {
+	if (index > 0) {
+		return false;
+	}
+
+	encoder.writeValue(MetricEncoder::getType(_type), _value());
+	return true;
+}
+
+prom::IntegerValueFamily::IntegerValueFamily(const char *metric_namespace,
+		const char *name, const char *unit, const char *help, const char *type,
+		const std::function<uint64_t()> value) :
+		MetricFamily(metric_namespace, name, unit, help), _type(type), _value(
+				value) {
+
+}
+
+const char* prom::IntegerValueFamily::getType(const bool openmetrics) const {
+	return _type;
+}
+
+size_t prom::IntegerValueFamily::writeSample(char *buffer,
+		const size_t max_len, const size_t index, const bool openmetrics,
+		const uint8_t consumer) const {
+	if (index > 0) {
+		return 0;
+	}
+
+	const size_t len = writeName(buffer, max_len);
+	return len + snprintf(buffer + std::min(len, max_len),
+			max_len - std::min(len, max_len), " %llu\n",
+			(long long unsigned int) _value());
+}
+
+bool prom::IntegerValueFamily::writeMetric(MetricEncoder &encoder,
+		const size_t index, const uint8_t consumer) const {
+	if (index > 0) {
+		return false;
+	}
+
+	encoder.writeValue(MetricEncoder::getType(_type), (double) _value());
+	return true;
+}
+
+prom::InfoFamily::InfoFamily(const char *metric_namespace, const char *name,
+		const char *help, const std::string &labels) :
+		MetricFamily(metric_namespace, name, "", help), _sample(
+				_full_name + labels + " 1\n"), _labels(parseLabels(labels)) {
+
+}
+
+const char* prom::InfoFamily::getType(const bool openmetrics) const {
+	return openmetrics ? "info" : "gauge";
+}
+
+size_t prom::InfoFamily::writeSample(char *buffer, const size_t max_len,
+		const size_t index, const bool openmetrics,
+		const uint8_t consumer) const {
+	if (index > 0) {
+		return 0;
+	}
+
+	if (max_len > 0) {
+		const size_t copy = std::min(_sample.length(), max_len - 1);
+		memcpy(buffer, _sample.c_str(), copy);
+		buffer[copy] = 0;
+	}
+	return _sample.length();
+}
+
+bool prom::InfoFamily::writeMetric(MetricEncoder &encoder,
+		const size_t index, const uint8_t consumer) const {
+	if (index > 0) {
+		return false;
+	}
+
+	for (size_t i = 0; i + 1 < _labels.size(); i += 2) {
+		encoder.writeLabel(_labels[i].c_str(), _labels[i + 1].c_str());
+	}
+	encoder.writeValue(MetricEncoder::GAUGE, 1);
+	return true;
+}
+
+prom::ExpositionWriter::ExpositionWriter(
+		const std::vector<const MetricFamily*> &families,
+		const bool openmetrics, const std::vector<std::string> &names,
+		const uint8_t consumer) :
+		_families(families), _openmetrics(openmetrics), _names(names), _consumer(
+				consumer) {
+	_line[0] = 0;
+	skipFiltered();
+}
+
+void prom::ExpositionWriter::skipFiltered() {
+	while (!_names.empty() && _family < _families.size()
+			&& std::none_of(_names.begin(), _names.end(),
+					[this](const std::string &name) {
+						return _families[_family]->hasName(name);
+					})) {
+		_family++;
+	}
+	if (_family >= _families.size()) {
+		_stage = END;
+	}
+}
+
+size_t prom::ExpositionWriter::writeMetadataLine(const char *field,
+		const char *value) {
+	const MetricFamily *family = _families[_family];
+	size_t len = snprintf(_line, sizeof(_line), "# %s ", field);
+	len += family->writeName(_line + std::min(len, sizeof(_line)),
+			sizeof(_line) - std::min(len, sizeof(_line)));
+	len += snprintf(_line + std::min(len, sizeof(_line)),
+			sizeof(_line) - std::min(len, sizeof(_line)), " %s\n", value);
+	return len;
+}
+
+bool prom::ExpositionWriter::nextLine() {
+	while (_stage != DONE) {
+		size_t len = 0;
+		_output = _line;
+		switch (_stage) {
+		case HELP:
+			_output = _families[_family]->getMetadata(_openmetrics, len);
+			if (_output) {
+				_stage = SAMPLES;
+				break;
+			}
+
+			_output = _line;
+			len = writeMetadataLine("HELP", _families[_family]->help);
+			_stage = TYPE;
+			break;
+		case TYPE:
+			len = writeMetadataLine("TYPE",
+					_families[_family]->getType(_openmetrics));
+			_stage = _openmetrics && _families[_family]->unit[0] ?
+					UNIT : SAMPLES;
+			break;
+		case UNIT:
+			len = writeMetadataLine("UNIT", _families[_family]->unit);
+			_stage = SAMPLES;
+			break;
+		case SAMPLES:
+			len = _families[_family]->writeSample(_line, sizeof(_line),
+					_sample++, _openmetrics, _consumer);
+			if (len == 0) {
+				_sample = 0;
+				_family++;
+				_stage = HELP;
+				skipFiltered();
+				continue;
+			}
+			break;
+		case END:
+			_stage = DONE;
+			if (!_openmetrics) {
+				continue;
+			}
+			len = snprintf(_line, sizeof(_line), "# EOF\n");
+			break;
+		case DONE:
+			break;
+		}
+
+		if (_output == _line && len > MAX_LINE_LEN) {
+			log_e("Skipping metrics line of length %u, which is too long.",
+					(unsigned int ) len);
+			continue;
+		}
+
+		_line_len = len;
+		_line_pos = 0;
+		return true;
+	}
+	return false;
+}
+
+size_t prom::ExpositionWriter::read(uint8_t *buffer, const size_t max_len) {
+	size_t written = 0;
+	while (written < max_len) {
+		if (_line_pos >= _line_len && !nextLine()) {
+			break;
+		}
+
+		const size_t len = std::min(_line_len - _line_pos, max_len - written);
+		memcpy(buffer + written, _output + _line_pos, len);
+		_line_pos += len;
+		written += len;
+	}
+	return written;
+}
+
+bool prom::ExpositionWriter::done() const {
+	return _stage == DONE && _line_pos >= _line_len;
+}
+
+/**
+ * Removes spaces, tabs, and double quotes from both ends of a part of a header.
+ *
+ * @param start	The start of the part. Moved to the first remaining character.
+ * @param end	The end of the part. Moved to after the last remaining character.
+ */
+static void trimToken(const char *&start, const char *&end) {
+	while (start < end && (*start == ' ' || *start == '\t' || *start == '"')) {
+		start++;
+	}
+	while (end > start
+			&& (*(end - 1) == ' ' || *(end - 1) == '\t' || *(end - 1) == '"')) {
+		end--;
+	}
+}
+
+/**
+ * Checks whether a part of a header matches the given value, ignoring case.
+ *
+ * @param start	The start of the part.
+ * @param end	The end of the part.
+ * @param value	The value to compare it to.
+ * @return	True if the part matches the value.
+ */
+static bool tokenEquals(const char *start, const char *end,
+		const char *value) {
+	const size_t len = strlen(value);
+	return (size_t) (end - start) == len && strncasecmp(start, value, len) == 0;
+}
+
+/**
+ * Parses a q value to thousandths.
+ * Invalid values are treated as the default of one.
+ *
+ * @param start	The start of the value.
+ * @param end	The end of the value.
+ * @return	The q value in thousandths.
+ */
+static uint16_t parseQuality(const char *start, const char *end) {
+	if (start == end || *start == '1' || *start != '0') {
+		return 1000;
+	}
+
+	uint16_t quality = 0;
+	uint16_t factor = 100;
+	if (++start < end && *start == '.') {
+		while (++start < end && factor > 0 && *start >= '0' && *start <= '9') {
+			quality += (*start - '0') * factor;
+			factor /= 10;
+		}
+	}
+	return quality;
+}
+
+prom::ExpositionFormat prom::negotiateFormat(const char *accept) {
+	ExpositionFormat best = FORMAT_TEXT;
+	uint16_t best_quality = 0;
+	const char *item = accept;
+	while (item && *item) {
+		const char *item_end = strchr(item, ',');
+		if (!item_end) {
+			item_end = item + strlen(item);
+		}
+
+		const char *type_end = item;
+		while (type_end < item_end && *type_end != ';') {
+			type_end++;
+		}
+
+		bool proto = false;
+		bool delimited = true;
+		uint16_t quality = 1000;
+		const char *param = type_end;
+		while (param < item_end) {
+			const char *name = param + 1;
+			param = name;
+			while (param < item_end && *param != ';') {
+				param++;
+			}
+
+			const char *name_end = name;
+			while (name_end < param && *name_end != '=') {
+				name_end++;
+			}
+			const char *value = name_end < param ? name_end + 1 : param;
+			const char *value_end = param;
+			trimToken(name, name_end);
+			trimToken(value, value_end);
+
+			if (tokenEquals(name, name_end, "proto")) {
+				proto = tokenEquals(value, value_end,
+						"io.prometheus.client.MetricFamily");
+			} else if (tokenEquals(name, name_end, "encoding")) {
+				delimited = tokenEquals(value, value_end, "delimited");
+			} else if (tokenEquals(name, name_end, "q")) {
+				quality = parseQuality(value, value_end);
+			}
+		}
+
+		const char *type = item;
+		trimToken(type, type_end);
+		bool supported = true;
+		ExpositionFormat format = FORMAT_TEXT;
+		if (tokenEquals(type, type_end, "application/vnd.google.protobuf")) {
+			format = FORMAT_PROTOBUF;
+			supported = proto && delimited;
+		} else if (tokenEquals(type, type_end, "application/openmetrics-text")) {
+			format = FORMAT_OPENMETRICS;
+		} else if (!tokenEquals(type, type_end, "text/plain")
+				&& !tokenEquals(type, type_end, "text/*")
+				&& !tokenEquals(type, type_end, "*/*")) {
+			supported = false;
+		}
+
+		if (supported && quality > 0
+				&& (quality > best_quality
+						|| (quality == best_quality && format > best))) {
+			best = format;
+			best_quality = quality;
+		}
+
+		item = *item_end ? item_end + 1 : item_end;
+	}
+	return best;
+}
@@ -0,0 +1,403 @@
+/*
+ * prometheus_protobuf.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "prometheus_protobuf.h"
+#include <algorithm>
+#include <cstring>
+#include <fallback_log.h>
+
+/**
+ * The protobuf wire type of varint fields.
+ */
+static constexpr uint8_t WIRE_VARINT = 0;
+
+/**
+ * The protobuf wire type of 64 bit fields.
+ */
+static constexpr uint8_t WIRE_FIXED64 = 1;
+
+/**
+ * The protobuf wire type of length delimited fields.
+ */
+static constexpr uint8_t WIRE_LENGTH_DELIMITED = 2;
+
+/**
+ * The space reserved for the length of a nested message.
+ * The max length of a 32 bit varint.
+ */
+static constexpr size_t LENGTH_RESERVE = 5;
+
+/**
+ * The field numbers of the MetricFamily message.
+ */
+enum MetricFamilyField : uint8_t {
+	FAMILY_NAME = 1, FAMILY_HELP = 2, FAMILY_TYPE = 3, FAMILY_METRIC = 4,
+	FAMILY_UNIT = 5,
+	/**
+	 * A field that isn't part of the MetricFamily message, used to fill space of removed metrics.
+	 */
+	FAMILY_PADDING = 15
+};
+
+/**
+ * The field numbers of the Metric message.
+ */
+enum MetricField : uint8_t {
+	METRIC_LABEL = 1, METRIC_GAUGE = 2, METRIC_COUNTER = 3,
+	METRIC_UNTYPED = 5, METRIC_TIMESTAMP = 6, METRIC_HISTOGRAM = 7
+};
+
+/**
+ * The field numbers of the LabelPair message.
+ */
+enum LabelField : uint8_t {
+	LABEL_NAME = 1, LABEL_VALUE = 2
+};
+
+/**
+ * The field numbers of the Histogram message.
+ */
+enum HistogramField : uint8_t {
+	HISTOGRAM_COUNT = 1, HISTOGRAM_SUM = 2, HISTOGRAM_BUCKET = 3
+};
+
+/**
+ * The field numbers of the Bucket message.
+ */
+enum BucketField : uint8_t {
+	BUCKET_COUNT = 1, BUCKET_BOUND = 2
+};
+
+/**
+ * The max length of a 64 bit varint.
+ */
+static constexpr size_t MAX_VARINT_LEN = 10;
+
+/**
+ * The max length of a padding field, so its length always fits into a single byte.
+ */
+static constexpr size_t MAX_PADDING_LEN = 129;
+
+prom::MetricEncoder::MetricEncoder(uint8_t *buffer, const size_t max_len) :
+		_buffer(buffer), _max_len(max_len) {
+
+}
+
+prom::MetricEncoder::MetricType prom::MetricEncoder::getType(const char *type) {
+	if (strcmp(type, "counter") == 0) {
+		return COUNTER;
+	} else if (strcmp(type, "gauge") == 0) {
+		return GAUGE;
+	} else if (strcmp(type, "histogram") == 0) {
+		return HISTOGRAM;
+	} else if (strcmp(type, "summary") == 0) {
+		return SUMMARY;
+	} else {
+		return UNTYPED;
+	}
+}
+
+size_t prom::MetricEncoder::getVarintLength(uint64_t value) {
+	size_t len = 1;
+	while (value >= 0x80) {
+		value >>= 7;
+		len++;
+	}
+	return len;
+}
+
+void prom::MetricEncoder::writeByte(const uint8_t value) {
+	if (_len < _max_len) {
+		_buffer[_len] = value;
+	}
+	_len++;
+}
+
+void prom::MetricEncoder::writeVarint(uint64_t value) {
+	while (value >= 0x80) {
+		writeByte((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	writeByte(value);
+}
+
+void prom::MetricEncoder::writeTag(const uint32_t field,
+		const uint8_t wire_type) {
+	writeVarint(field << 3 | wire_type);
+}
+
+void prom::MetricEncoder::writeUInt64(const uint32_t field,
+		const uint64_t value) {
+	writeTag(field, WIRE_VARINT);
+	writeVarint(value);
+}
+
+void prom::MetricEncoder::writeFixedUInt64(const uint32_t field,
+		uint64_t value) {
+	writeTag(field, WIRE_VARINT);
+	// Decoders accept varints with redundant continuation bytes.
+	for (size_t i = 1; i < MAX_VARINT_LEN; i++) {
+		writeByte((value & 0x7F) | 0x80);
+		value >>= 7;
+	}
+	writeByte(value);
+}
+
+void prom::MetricEncoder::writeDouble(const uint32_t field,
+		const double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	writeTag(field, WIRE_FIXED64);
+	for (uint8_t i = 0; i < 8; i++) {
+		writeByte(bits >> (i * 8));
+	}
+}
+
+void prom::MetricEncoder::writeString(const uint32_t field, const char *value,
+		const size_t len) {
+	writeTag(field, WIRE_LENGTH_DELIMITED);
+	writeVarint(len);
+	if (_len < _max_len) {
+		memcpy(_buffer + _len, value, std::min(len, _max_len - _len));
+	}
+	_len += len;
+}
+
+void prom::MetricEncoder::beginMessage(const uint32_t field) {
+	writeTag(field, WIRE_LENGTH_DELIMITED);
+	_len += LENGTH_RESERVE;
+	_message_starts[_depth++] = _len;
+}
+
+void prom::MetricEncoder::endMessage() {
+	const size_t start = _message_starts[--_depth];
+	const size_t len = _len - start;
+	const size_t prefix_start = start - LENGTH_RESERVE;
+	const size_t content_start = prefix_start + getVarintLength(len);
+	if (content_start < _max_len) {
+		memmove(_buffer + content_start, _buffer + start,
+				std::min(_len, _max_len) - std::min(start, _max_len));
+	}
+	_len = prefix_start;
+	writeVarint(len);
+	_len = content_start + len;
+}
+
+void prom::MetricEncoder::writeFamilyMetadata(const char *name,
+		const size_t name_len, const char *help, const MetricType type,
+		const char *unit) {
+	writeString(FAMILY_NAME, name, name_len);
+	writeString(FAMILY_HELP, help, strlen(help));
+	writeUInt64(FAMILY_TYPE, type);
+	if (unit[0]) {
+		writeString(FAMILY_UNIT, unit, strlen(unit));
+	}
+}
+
+void prom::MetricEncoder::writeLabel(const char *name, const char *value) {
+	beginMessage(METRIC_LABEL);
+	writeString(LABEL_NAME, name, strlen(name));
+	writeString(LABEL_VALUE, value, strlen(value));
+	endMessage();
+}
+
+void prom::MetricEncoder::writeValue(const MetricType type,
+		const double value) {
+	switch (type) {
+	case COUNTER:
+		beginMessage(METRIC_COUNTER);
+		break;
+	case GAUGE:
+		beginMessage(METRIC_GAUGE);
+		break;
+	default:
+		beginMessage(METRIC_UNTYPED);
+		break;
+	}
+	writeDouble(1, value);
+	endMessage();
+}
+
+void prom::MetricEncoder::writeTimestamp(const int64_t timestamp) {
+	writeFixedUInt64(METRIC_TIMESTAMP, (uint64_t) timestamp);
+}
+
+void prom::MetricEncoder::beginHistogram() {
+	beginMessage(METRIC_HISTOGRAM);
+}
+
+void prom::MetricEncoder::writeBucket(const uint64_t cumulative_count,
+		const double upper_bound) {
+	beginMessage(HISTOGRAM_BUCKET);
+	writeFixedUInt64(BUCKET_COUNT, cumulative_count);
+	writeDouble(BUCKET_BOUND, upper_bound);
+	endMessage();
+}
+
+void prom::MetricEncoder::endHistogram(const uint64_t sample_count,
+		const double sample_sum) {
+	writeFixedUInt64(HISTOGRAM_COUNT, sample_count);
+	writeDouble(HISTOGRAM_SUM, sample_sum);
+	endMessage();
+}
+
+size_t prom::MetricEncoder::length() const {
+	return _len;
+}
+
+prom::ProtobufWriter::ProtobufWriter(
+		const std::vector<const MetricFamily*> &families,
+		const std::vector<std::string> &names, const uint8_t consumer) :
+		_families(families), _names(names), _consumer(consumer) {
+	skipFiltered();
+}
+
+void prom::ProtobufWriter::skipFiltered() {
+	while (!_names.empty() && _family < _families.size()
+			&& std::none_of(_names.begin(), _names.end(),
+					[this](const std::string &name) {
+						return _families[_family]->hasName(name);
+					})) {
+		_family++;
+	}
+	if (_family >= _families.size()) {
+		_stage = DONE;
+	}
+}
+
+size_t prom::ProtobufWriter::encodeMetric(const size_t index) {
+	MetricEncoder encoder(_buffer, sizeof(_buffer));
+	encoder.beginMessage(FAMILY_METRIC);
+	if (!_families[_family]->writeMetric(encoder, index, _consumer)) {
+		return 0;
+	}
+	encoder.endMessage();
+	return encoder.length();
+}
+
+bool prom::ProtobufWriter::encodeHeader() {
+	const MetricFamily *family = _families[_family];
+	size_t metrics_len = 0;
+	for (size_t i = 0;; i++) {
+		const size_t len = encodeMetric(i);
+		if (len == 0) {
+			break;
+		} else if (len > MAX_METRIC_LEN) {
+			log_e("Skipping metric of length %u, which is too long.",
+					(unsigned int ) len);
+			continue;
+		}
+		metrics_len += len;
+	}
+
+	if (metrics_len == 0) {
+		return false;
+	}
+
+	// Leave space for the length prefix, which has to be written before the metadata.
+	const size_t metadata_len = family->writeProtobufMetadata(
+			_buffer + LENGTH_RESERVE, sizeof(_buffer) - LENGTH_RESERVE);
+	if (metadata_len > sizeof(_buffer) - LENGTH_RESERVE) {
+		log_e("Skipping metric family with metadata of length %u, which is too long.",
+				(unsigned int ) metadata_len);
+		return false;
+	}
+
+	const size_t family_len = metadata_len + metrics_len;
+	const size_t prefix_len = MetricEncoder::getVarintLength(family_len);
+	MetricEncoder prefix(_buffer + LENGTH_RESERVE - prefix_len, prefix_len);
+	prefix.writeVarint(family_len);
+	_output = _buffer + LENGTH_RESERVE - prefix_len;
+	_output_len = prefix_len + metadata_len;
+	_remaining = metrics_len;
+	return true;
+}
+
+bool prom::ProtobufWriter::nextPart() {
+	while (_stage != DONE) {
+		_output = _buffer;
+		switch (_stage) {
+		case HEADER:
+			if (!encodeHeader()) {
+				_family++;
+				skipFiltered();
+				continue;
+			}
+			_metric = 0;
+			_stage = METRICS;
+			break;
+		case METRICS:
+			if (_remaining == 0) {
+				_family++;
+				_stage = HEADER;
+				skipFiltered();
+				continue;
+			}
+
+			_output_len = encodeMetric(_metric++);
+			if (_output_len > MAX_METRIC_LEN) {
+				continue;
+			} else if (_output_len == 0 || _output_len > _remaining
+					|| _remaining - _output_len == 1) {
+				// The metric family changed since its length was calculated.
+				_stage = PADDING;
+				continue;
+			}
+			_remaining -= _output_len;
+			break;
+		case PADDING: {
+			if (_remaining == 0) {
+				_family++;
+				_stage = HEADER;
+				skipFiltered();
+				continue;
+			}
+
+			// Never leave a single byte, since no field fits into it.
+			_output_len = std::min(_remaining, MAX_PADDING_LEN);
+			if (_remaining - _output_len == 1) {
+				_output_len--;
+			}
+			MetricEncoder encoder(_buffer, sizeof(_buffer));
+			encoder.writeTag(FAMILY_PADDING, WIRE_LENGTH_DELIMITED);
+			encoder.writeVarint(_output_len - 2);
+			memset(_buffer + 2, 0, _output_len - 2);
+			_remaining -= _output_len;
+			break;
+		}
+		case DONE:
+			break;
+		}
+
+		_output_pos = 0;
+		return true;
+	}
+	return false;
+}
+
+size_t prom::ProtobufWriter::read(uint8_t *buffer, const size_t max_len) {
+	size_t written = 0;
+	while (written < max_len) {
+		if (_output_pos >= _output_len && !nextPart()) {
+			break;
+		}
+
+		const size_t len = std::min(_output_len - _output_pos,
+				max_len - written);
+		memcpy(buffer + written, _output + _output_pos, len);
+		_output_pos += len;
+		written += len;
+	}
+	return written;
+}
+
+bool prom::ProtobufWriter::done() const {
+	return _stage == DONE && _output_pos >= _output_len;
+}
@@ -0,0 +1,1023 @@
+/*
+ * prometheus_registry.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROMETHEUS_REGISTRY_INCLUDE_PROMETHEUS_REGISTRY_H_
+#define LIB_PROMETHEUS_REGISTRY_INCLUDE_PROMETHEUS_REGISTRY_H_
+
+#include <prometheus_exposition.h>
+#include <prometheus_protobuf.h>
+#include <atomic>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+/**
+ * The number of shards of each sharded counter.
+ * Defaults to the number of cores of the microcontroller, or 8 on other platforms.
+ */
+#ifndef PROM_COUNTER_SHARDS
+#if defined(ESP32)
+#define PROM_COUNTER_SHARDS 2
+#elif defined(ESP8266)
+#define PROM_COUNTER_SHARDS 1
+#else
+#define PROM_COUNTER_SHARDS 8
+#endif
+#endif
+
+/**
+ * The alignment of the shards of sharded counters.
+ * Should be the cache line size on platforms with a data cache, to prevent false sharing.
+ */
+#ifndef PROM_COUNTER_SHARD_ALIGNMENT
+#if defined(ESP32) || defined(ESP8266)
+#define PROM_COUNTER_SHARD_ALIGNMENT 4
+#else
+#define PROM_COUNTER_SHARD_ALIGNMENT 64
+#endif
+#endif
+
+namespace prom {
+
+/**
+ * A collection of metric families to be written by an exposition writer.
+ *
+ * Metric families should only be added during startup.
+ * Adding a metric family while an exposition writer is using the registry is **NOT** safe.
+ */
+class Registry {
+private:
+	/**
+	 * The registered metric families, in the order they were added.
+	 */
+	std::vector<const MetricFamily*> _families;
+public:
+	/**
+	 * Adds the given metric family to this registry, and pre-renders its metadata lines.
+	 * Does nothing if the metric family is already registered.
+	 *
+	 * @param family	The metric family to add. Has to remain valid for the lifetime of this registry.
+	 */
+	void add(MetricFamily &family);
+
+	/**
+	 * Gets all the metric families registered in this registry.
+	 *
+	 * @return	The registered metric families.
+	 */
+	const std::vector<const MetricFamily*>& getFamilies() const;
+};
+
+/**
+ * The registry all metrics written to the metrics page and pushed to the pushgateway are registered in.
+ */
+extern Registry default_registry;
+
+/**
+ * A single monotonically increasing 64 bit counter series.
+ *
+ * The value is stored as two 32 bit atomics, since 64 bit atomics aren't lock-free on most microcontrollers.
+ * Increments are lock-free and never allocate.
+ * The upper half overlaps the top bit of the lower half, so a read can detect a carry that isn't stored yet.
+ * Reads are only inconsistent if increments of 2^31 or more race with them.
+ */
+class Counter {
+private:
+	/**
+	 * The lower 32 bits of the counter value.
+	 */
+	std::atomic<uint32_t> _low { 0 };
+
+	/**
+	 * The number of times bit 31 of the lower half changed.
+	 * Twice the upper 32 bits of the counter value, plus one if bit 31 of the lower half is set.
+	 */
+	std::atomic<uint32_t> _high { 0 };
+public:
+	/**
+	 * Increments this counter by the given amount.
+	 *
+	 * @param amount	The amount to increment this counter by.
+	 */
+	void inc(const uint32_t amount = 1);
+
+	/**
+	 * Gets the current value of this counter.
+	 *
+	 * @return	The current counter value.
+	 */
+	uint64_t get() const;
+};
+
+/**
+ * A counter that is split into one shard per core or thread, which are summed when it is read.
+ *
+ * Each increment only touches the shard of the current core or thread.
+ * This prevents contention between concurrent increments, without using a lock.
+ */
+class ShardedCounter {
+private:
+	/**
+	 * A single shard, aligned to prevent it from sharing a cache line with another shard.
+	 */
+	struct alignas(PROM_COUNTER_SHARD_ALIGNMENT) Shard {
+		/**
+		 * The part of the counter value counted by this shard.
+		 */
+		Counter counter;
+	};
+
+	/**
+	 * The shards of this counter.
+	 */
+	Shard _shards[PROM_COUNTER_SHARDS];
+public:
+	/**
+	 * Increments the shard of the current core or thread by the given amount.
+	 *
+	 * @param amount	The amount to increment this counter by.
+	 */
+	void inc(const uint32_t amount = 1);
+
+	/**
+	 * Gets the current value of this counter, which is the sum of all its shards.
+	 *
+	 * @return	The current counter value.
+	 */
+	uint64_t get() const;
+};
+
+/**
+ * Gets the index of the counter shard to be used by the current core or thread.
+ *
+ * @return	The shard index of the current core or thread, less than PROM_COUNTER_SHARDS.
+ */
+size_t getCounterShard();
+
+/**
+ * A table assigning series indices to the cells of a fixed size table, in the order they are first used.
+ *
+ * This allows tracking a large number of possible label combinations, while only allocating series for the used ones.
+ * Cells that are first used once all series are assigned share the overflow series.
+ *
+ * Getting the series of a cell is lock-free, and safe from any task.
+ * Tasks getting the series of a cell while it is being assigned wait for the assignment,
+ * which only takes a few instructions.
+ *
+ * @tparam CELLS	The number of cells of the table.
+ * @tparam SERIES	The max number of series to assign. Has to be less than 254.
+ */
+template<size_t CELLS, uint8_t SERIES>
+class SeriesTable {
+	static_assert(SERIES < 254, "SERIES has to be less than 254.");
+	static_assert(CELLS <= UINT16_MAX, "CELLS has to be at most UINT16_MAX.");
+public:
+	/**
+	 * The index of the series shared by all cells that were first used once all other series were assigned.
+	 */
+	static constexpr uint8_t OVERFLOW_SERIES = SERIES;
+private:
+	/**
+	 * The cell value of cells that are currently being assigned a series.
+	 */
+	static constexpr uint8_t CELL_PENDING = UINT8_MAX;
+
+	/**
+	 * The series index plus one for each cell.
+	 * Zero for cells that weren't used yet, and CELL_PENDING while a series is being assigned.
+	 */
+	std::atomic<uint8_t> _cell_series[CELLS];
+
+	/**
+	 * The cell of each assigned series.
+	 */
+	uint16_t _series_cells[SERIES];
+
+	/**
+	 * Whether the cell of each series was written.
+	 */
+	std::atomic<bool> _series_ready[SERIES];
+
+	/**
+	 * The number of cells that claimed a series.
+	 * Can be larger than the number of series, if more cells were used than there are series.
+	 */
+	std::atomic<uint16_t> _claimed_series { 0 };
+public:
+	/**
+	 * Creates a new series table without any assigned series.
+	 */
+	SeriesTable() {
+		for (std::atomic<uint8_t> &series : _cell_series) {
+			series.store(0, std::memory_order_relaxed);
+		}
+		for (std::atomic<bool> &ready : _series_ready) {
+			ready.store(false, std::memory_order_relaxed);
+		}
+	}
+
+	SeriesTable(const SeriesTable &other) = delete;
+
+	SeriesTable& operator=(const SeriesTable &other) = delete;
+
+	/**
+	 * Gets the index of the series of the given cell.
+	 * Assigns a new series to the cell if it doesn't have one yet.
+	 *
+	 * @param cell	The cell to get the series for. Has to be less than CELLS.
+	 * @return	The series index of the cell, or OVERFLOW_SERIES if all series were assigned to other cells.
+	 */
+	uint8_t getSeries(const size_t cell) {
+		uint8_t series = _cell_series[cell].load(std::memory_order_acquire);
+		while (series == 0) {
+			// Only the task that changes the cell from unused to pending assigns its series.
+			if (_cell_series[cell].compare_exchange_weak(series, CELL_PENDING,
+					std::memory_order_acq_rel, std::memory_order_acquire)) {
+				return assignSeries(cell);
+			}
+		}
+
+		// Counting the racing tasks as overflow would export an overflow series while the table isn't full.
+		while (series == CELL_PENDING) {
+			series = _cell_series[cell].load(std::memory_order_acquire);
+		}
+		return series - 1;
+	}
+
+	/**
+	 * Gets the cell the given series was assigned to.
+	 *
+	 * @param series	The index of the series to get the cell of.
+	 * @param cell		Set to the cell of the series.
+	 * @return	False if the series wasn't assigned to a cell yet, or is the overflow series.
+	 */
+	bool getCell(const uint8_t series, uint16_t &cell) const {
+		if (series >= SERIES
+				|| !_series_ready[series].load(std::memory_order_acquire)) {
+			return false;
+		}
+		cell = _series_cells[series];
+		return true;
+	}
+private:
+	/**
+	 * Assigns the next free series to the given pending cell.
+	 *
+	 * @param cell	The cell to assign a series to.
+	 * @return	The series index of the cell.
+	 */
+	uint8_t assignSeries(const size_t cell) {
+		const uint16_t index = _claimed_series.fetch_add(1,
+				std::memory_order_relaxed);
+		if (index >= SERIES) {
+			_cell_series[cell].store(OVERFLOW_SERIES + 1,
+					std::memory_order_release);
+			return OVERFLOW_SERIES;
+		}
+
+		_series_cells[index] = cell;
+		_series_ready[index].store(true, std::memory_order_release);
+		_cell_series[cell].store(index + 1, std::memory_order_release);
+		return index;
+	}
+};
+
+template<size_t CELLS, uint8_t SERIES>
+constexpr uint8_t SeriesTable<CELLS, SERIES>::OVERFLOW_SERIES;
+
+template<size_t CELLS, uint8_t SERIES>
+constexpr uint8_t SeriesTable<CELLS, SERIES>::CELL_PENDING;
+
+/**
+ * A single gauge series, containing a floating point value.
+ *
+ * The value is stored as the bits of a float in a 32 bit atomic.
+ * All operations are lock-free and never allocate.
+ */
+class Gauge {
+private:
+	/**
+	 * The bits of the current float value.
+	 */
+	std::atomic<uint32_t> _bits { 0 };
+public:
+	/**
+	 * Sets this gauge to the given value.
+	 *
+	 * @param value	The new value of this gauge.
+	 */
+	void set(const float value);
+
+	/**
+	 * Adds the given amount to the value of this gauge.
+	 *
+	 * @param amount	The amount to add. May be negative.
+	 */
+	void add(const float amount);
+
+	/**
+	 * Gets the current value of this gauge.
+	 *
+	 * @return	The current gauge value.
+	 */
+	float get() const;
+};
+
+/**
+ * A single histogram series, counting observed values in fixed buckets.
+ *
+ * Values are observed as unsigned integers in a fixed unit, for example microseconds.
+ * The histogram family converts them to the exported unit.
+ * Observations are lock-free and never allocate.
+ */
+class Histogram {
+private:
+	/**
+	 * The upper bounds of the buckets, in ascending order.
+	 * Owned by the histogram family.
+	 */
+	const uint32_t *_bounds = NULL;
+
+	/**
+	 * The number of bucket bounds, not including the +Inf bucket.
+	 */
+	size_t _bucket_count = 0;
+
+	/**
+	 * The number of observations per bucket, including the +Inf bucket.
+	 * These are not cumulative. Owned by the histogram family.
+	 */
+	std::atomic<uint32_t> *_counts = NULL;
+
+	/**
+	 * The sum of all observed values.
+	 */
+	Counter _sum;
+public:
+	/**
+	 * Initializes this histogram series.
+	 * Called by the histogram family, before this series is used.
+	 *
+	 * @param bounds		The upper bounds of the buckets, in ascending order.
+	 * @param bucket_count	The number of bucket bounds.
+	 * @param counts		The storage for the bucket counts. Has to have space for bucket_count + 1 values.
+	 */
+	void init(const uint32_t *bounds, const size_t bucket_count,
+			std::atomic<uint32_t> *counts);
+
+	/**
+	 * Records the given value in this histogram.
+	 *
+	 * @param value	The value to record.
+	 */
+	void observe(const uint32_t value);
+
+	/**
+	 * Gets the cumulative number of observations less than or equal to the bound of the given bucket.
+	 *
+	 * @param bucket	The index of the bucket. bucket_count for the +Inf bucket.
+	 * @return	The number of observations in the bucket, and all previous buckets.
+	 */
+	uint64_t getCumulativeCount(const size_t bucket) const;
+
+	/**
+	 * Gets the sum of all observed values, in the observed unit.
+	 *
+	 * @return	The sum of all observed values.
+	 */
+	uint64_t getSum() const;
+};
+
+/**
+ * A metric family with a fixed set of label names, and preallocated storage for its series.
+ *
+ * Series are created by get, which is **NOT** thread safe when it creates a new series.
+ * Series should therefore be created during startup, and the returned references kept for updates.
+ * Updating a series is lock-free and never allocates.
+ *
+ * @tparam S	The type of the series of this metric family.
+ */
+template<typename S>
+class SeriesFamily: public MetricFamily {
+protected:
+	/**
+	 * The names of the labels of this metric family.
+	 */
+	const std::vector<const char*> _label_names;
+
+	/**
+	 * The max number of series this metric family can contain.
+	 */
+	const size_t _max_series;
+
+	/**
+	 * The series of this metric family.
+	 * Contains one more series than can be exported, which is used when all others are in use.
+	 */
+	S *const _series;
+
+	/**
+	 * The label values of all series, one label name after the other.
+	 */
+	std::vector<std::string> _label_values;
+
+	/**
+	 * The number of series in use.
+	 */
+	std::atomic<size_t> _size { 0 };
+
+	/**
+	 * Writes the label set of the given series, including the curly braces.
+	 * Writes nothing if the series has no labels, and no extra label is given.
+	 * Works like snprintf.
+	 *
+	 * @param buffer		The buffer to write to.
+	 * @param max_len		The size of the buffer, including the terminating NUL byte.
+	 * @param series		The index of the series to write the labels of.
+	 * @param extra_name	The name of an additional label to write last. NULL for none.
+	 * @param extra_value	The value of the additional label.
+	 * @return	The length of the label set.
+	 */
+	size_t writeLabels(char *buffer, const size_t max_len, const size_t series,
+			const char *extra_name = NULL,
+			const char *extra_value = NULL) const {
+		const size_t label_count = _label_names.size();
+		if (label_count == 0 && !extra_name) {
+			if (max_len > 0) {
+				buffer[0] = 0;
+			}
+			return 0;
+		}
+
+		size_t len = 0;
+		append(buffer, max_len, len, "{");
+		for (size_t i = 0; i < label_count; i++) {
+			if (i > 0) {
+				append(buffer, max_len, len, ",");
+			}
+			appendLabel(buffer, max_len, len, _label_names[i],
+					_label_values[series * label_count + i].c_str());
+		}
+		if (extra_name) {
+			if (label_count > 0) {
+				append(buffer, max_len, len, ",");
+			}
+			appendLabel(buffer, max_len, len, extra_name, extra_value);
+		}
+		append(buffer, max_len, len, "}");
+		return len;
+	}
+
+	/**
+	 * Gets the number of sample lines written for each series.
+	 *
+	 * @return	The number of lines per series.
+	 */
+	virtual size_t getLinesPerSeries() const {
+		return 1;
+	}
+
+	/**
+	 * Writes a single sample line of the given series. Works like snprintf.
+	 *
+	 * @param buffer		The buffer to write to.
+	 * @param max_len		The size of the buffer, including the terminating NUL byte.
+	 * @param series		The index of the series to write.
+	 * @param line			The index of the line of the series to write.
+	 * @param openmetrics	Whether to write the OpenMetrics format.
+	 * @return	The length of the sample line.
+	 */
+	virtual size_t writeSeriesLine(char *buffer, const size_t max_len,
+			const size_t series, const size_t line,
+			const bool openmetrics) const = 0;
+
+	/**
+	 * Writes the labels of the given series to a protobuf Metric message.
+	 *
+	 * @param encoder	The encoder to write the labels to.
+	 * @param series	The index of the series to write the labels of.
+	 */
+	void writeLabels(MetricEncoder &encoder, const size_t series) const {
+		const size_t label_count = _label_names.size();
+		for (size_t i = 0; i < label_count; i++) {
+			encoder.writeLabel(_label_names[i],
+					_label_values[series * label_count + i].c_str());
+		}
+	}
+
+	/**
+	 * Writes the value of the given series to a protobuf Metric message.
+	 * The labels are already written.
+	 *
+	 * @param encoder	The encoder to write the value to.
+	 * @param series	The index of the series to write.
+	 */
+	virtual void writeSeriesMetric(MetricEncoder &encoder,
+			const size_t series) const = 0;
+public:
+	/**
+	 * Creates a new metric family with preallocated series.
+	 * Metric families without labels automatically get their only series created.
+	 *
+	 * @param metric_namespace	The namespace of the metric family. May be empty.
+	 * @param name				The name of the metric family, without the namespace and unit.
+	 * @param unit				The unit of the metric family. May be empty.
+	 * @param help				The description text of the metric family.
+	 * @param label_names		The names of the labels of this metric family.
+	 * @param max_series		The max number of series in this metric family.
+	 */
+	SeriesFamily(const char *metric_namespace, const char *name,
+			const char *unit, const char *help,
+			const std::initializer_list<const char*> label_names,
+			const size_t max_series) :
+			MetricFamily(metric_namespace, name, unit, help), _label_names(
+					label_names), _max_series(max_series), _series(
+					new S[max_series + 1]) {
+		_label_values.reserve(_max_series * _label_names.size());
+		if (_label_names.empty() && _max_series > 0) {
+			_size = 1;
+		}
+	}
+
+	/**
+	 * Destroys this metric family, and all its series.
+	 */
+	virtual ~SeriesFamily() {
+		delete[] _series;
+	}
+
+	/**
+	 * Gets the series with the given label values, creating it if it doesn't exist yet.
+	 *
+	 * If the series doesn't exist, and this metric family is full, a series that isn't exported is returned.
+	 * Creating a new series is **NOT** thread safe, and should only be done during startup.
+	 *
+	 * @param label_values	The label values of the series, in the order of the label names.
+	 * @return	The series with the given label values.
+	 */
+	S& get(const std::initializer_list<const char*> label_values = { }) {
+		const size_t label_count = _label_names.size();
+		if (label_values.size() != label_count) {
+			return _series[_max_series];
+		}
+
+		const size_t size = _size.load(std::memory_order_acquire);
+		for (size_t i = 0; i < size; i++) {
+			bool match = true;
+			size_t j = 0;
+			for (const char *value : label_values) {
+				if (_label_values[i * label_count + j++] != value) {
+					match = false;
+					break;
+				}
+			}
+			if (match) {
+				return _series[i];
+			}
+		}
+
+		if (size >= _max_series) {
+			return _series[_max_series];
+		}
+
+		for (const char *value : label_values) {
+			_label_values.push_back(value);
+		}
+		_size.store(size + 1, std::memory_order_release);
+		return _series[size];
+	}
+
+	/**
+	 * Gets the number of series in use.
+	 *
+	 * @return	The number of exported series.
+	 */
+	size_t size() const {
+		return _size.load(std::memory_order_acquire);
+	}
+
+	virtual size_t writeSample(char *buffer, const size_t max_len,
+			const size_t index, const bool openmetrics,
+			const uint8_t consumer) const override {
+		const size_t lines = getLinesPerSeries();
+		if (index / lines >= size()) {
+			return 0;
+		}
+		return writeSeriesLine(buffer, max_len, index / lines, index % lines,
+				openmetrics);
+	}
+
+	virtual bool writeMetric(MetricEncoder &encoder, const size_t index,
+			const uint8_t consumer) const override {
+		if (index >= size()) {
+			return false;
+		}
+		writeLabels(encoder, index);
+		writeSeriesMetric(encoder, index);
+		return true;
+	}
+
+	/**
+	 * Appends the given string to the given buffer. Works like snprintf.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The size of the buffer, including the terminating NUL byte.
+	 * @param len		The length of the text already in the buffer. Will be updated.
+	 * @param str		The string to append.
+	 */
+	static void append(char *buffer, const size_t max_len, size_t &len,
+			const char *str) {
+		for (; *str; str++, len++) {
+			if (len + 1 < max_len) {
+				buffer[len] = *str;
+				buffer[len + 1] = 0;
+			}
+		}
+	}
+
+	/**
+	 * Appends a single label to the given buffer, escaping its value. Works like snprintf.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The size of the buffer, including the terminating NUL byte.
+	 * @param len		The length of the text already in the buffer. Will be updated.
+	 * @param name		The name of the label.
+	 * @param value		The value of the label.
+	 */
+	static void appendLabel(char *buffer, const size_t max_len, size_t &len,
+			const char *name, const char *value) {
+		append(buffer, max_len, len, name);
+		append(buffer, max_len, len, "=\"");
+		for (; *value; value++) {
+			if (*value == '\\') {
+				append(buffer, max_len, len, "\\\\");
+			} else if (*value == '"') {
+				append(buffer, max_len, len, "\\\"");
+			} else if (*value == '\n') {
+				append(buffer, max_len, len, "\\n");
+			} else {
+				const char c[2] = { *value, 0 };
+				append(buffer, max_len, len, c);
+			}
+		}
+		append(buffer, max_len, len, "\"");
+	}
+};
+
+/**
+ * A metric family of counters.
+ *
+ * Counter values are integers, but can be exported with a scale.
+ * For example a counter of microseconds can be exported as seconds using a scale of 1000000.
+ */
+class CounterFamily: public SeriesFamily<Counter> {
+private:
+	/**
+	 * The value the counter values are divided by for the exposition.
+	 */
+	const uint32_t _scale;
+
+	/**
+	 * The number of decimal places to write, based on the scale.
+	 */
+	uint8_t _decimals = 0;
+protected:
+	virtual size_t writeSeriesLine(char *buffer, const size_t max_len,
+			const size_t series, const size_t line, const bool openmetrics) const
+					override;
+
+	virtual void writeSeriesMetric(MetricEncoder &encoder,
+			const size_t series) const override;
+public:
+	/**
+	 * Creates a new counter metric family.
+	 *
+	 * @param metric_namespace	The namespace of the metric family. May be empty.
+	 * @param name				The name of the metric family, without the namespace and unit.
+	 * @param unit				The unit of the metric family. May be empty.
+	 * @param help				The description text of the metric family.
+	 * @param label_names		The names of the labels of this metric family.
+	 * @param max_series		The max number of series in this metric family.
+	 * @param scale				The value to divide the counter values by when writing them.
+	 */
+	CounterFamily(const char *metric_namespace, const char *name,
+			const char *unit, const char *help,
+			const std::initializer_list<const char*> label_names = { },
+			const size_t max_series = 1, const uint32_t scale = 1);
+
+	virtual const char* getType(const bool openmetrics) const override;
+};
+
+/**
+ * A metric family of gauges.
+ */
+class GaugeFamily: public SeriesFamily<Gauge> {
+private:
+	/**
+	 * The number of decimal places to write.
+	 */
+	const uint8_t _decimals;
+protected:
+	virtual size_t writeSeriesLine(char *buffer, const size_t max_len,
+			const size_t series, const size_t line, const bool openmetrics) const
+					override;
+
+	virtual void writeSeriesMetric(MetricEncoder &encoder,
+			const size_t series) const override;
+public:
+	/**
+	 * Creates a new gauge metric family.
+	 *
+	 * @param metric_namespace	The namespace of the metric family. May be empty.
+	 * @param name				The name of the metric family, without the namespace and unit.
+	 * @param unit				The unit of the metric family. May be empty.
+	 * @param help				The description text of the metric family.
+	 * @param label_names		The names of the labels of this metric family.
+	 * @param max_series		The max number of series in this metric family.
+	 * @param decimals			The number of decimal places to write.
+	 */
+	GaugeFamily(const char *metric_namespace, const char *name,
+			const char *unit, const char *help,
+			const std::initializer_list<const char*> label_names = { },
+			const size_t max_series = 1, const uint8_t decimals = 3);
+
+	virtual const char* getType(const bool openmetrics) const override;
+};
+
+/**
+ * A metric family of histograms, which all use the same bucket bounds.
+ *
+ * Values are observed as integers in a fixed unit, and divided by the scale for the exposition.
+ */
+class HistogramFamily: public SeriesFamily<Histogram> {
+private:
+	/**
+	 * The upper bounds of the buckets, in the observed unit.
+	 */
+	const std::vector<uint32_t> _bounds;
+
+	/**
+	 * The bucket counts of all series.
+	 */
+	std::atomic<uint32_t> *const _counts;
+
+	/**
+	 * The value the observed values are divided by for the exposition.
+	 */
+	const uint32_t _scale;
+
+	/**
+	 * The number of decimal places to write for the sum, based on the scale.
+	 */
+	uint8_t _decimals = 0;
+protected:
+	virtual size_t getLinesPerSeries() const override;
+
+	virtual size_t writeSeriesLine(char *buffer, const size_t max_len,
+			const size_t series, const size_t line, const bool openmetrics) const
+					override;
+
+	virtual void writeSeriesMetric(MetricEncoder &encoder,
+			const size_t series) const override;
+public:
+	/**
+	 * Creates a new histogram metric family.
+	 *
+	 * @param metric_namespace	The namespace of the metric family. May be empty.
+	 * @param name				The name of the metric family, without the namespace and unit.
+	 * @param unit				The unit of the metric family. May be empty.
+	 * @param help				The description text of the metric family.
+	 * @param bounds			The upper bounds of the buckets in the observed unit, in ascending order.
+	 * @param scale				The value to divide the observed values by when writing them.
+	 * @param label_names		The names of the labels of this metric family.
+	 * @param max_series		The max number of series in this metric family.
+	 */
+	HistogramFamily(const char *metric_namespace, const char *name,
+			const char *unit, const char *help,
+			const std::initializer_list<uint32_t> bounds, const uint32_t scale =
+					1, const std::initializer_list<const char*> label_names = { },
+			const size_t max_series = 1);
+
+	/**
+	 * Destroys this histogram family, and all its series.
+	 */
+	virtual ~HistogramFamily();
+
+	virtual const char* getType(const bool openmetrics) const override;
+};
+
+/**
+ * A metric family with a single gauge series, that keeps a bounded history of timestamped samples.
+ *
+ * Every sample recorded since the last acknowledged one is written with its timestamp.
+ * This allows consumers with gaps between their reads to receive every sample, rather than only the latest.
+ * Each consumer acknowledges the samples it received separately, so consumers don't miss samples read by another one.
+ * Consumers without an acknowledgement cursor only receive the newest sample.
+ * The newest sample is always written, even if it was already acknowledged.
+ * Samples without a timestamp are only written while they are the newest sample.
+ * Once the history is full, the oldest samples are dropped.
+ *
+ * Samples can only be recorded by one task, but can be written and acknowledged by any task.
+ * Each slot of the history has its own sequence number, so writers skip samples that are overwritten while being read.
+ */
+class BackfillGaugeFamily: public MetricFamily {
+public:
+	/**
+	 * The number of consumers that can acknowledge samples.
+	 */
+	static constexpr uint8_t MAX_CONSUMERS = 8;
+private:
+	/**
+	 * A single recorded sample.
+	 */
+	struct Sample {
+		/**
+		 * The time at which the sample was taken, in milliseconds since the unix epoch.
+		 * Zero if the time is unknown.
+		 */
+		uint64_t timestamp;
+
+		/**
+		 * The value of the sample.
+		 */
+		float value;
+	};
+
+	/**
+	 * A single slot of the sample history.
+	 */
+	struct Slot {
+		/**
+		 * The time at which the sample was taken, in milliseconds since the unix epoch.
+		 * Zero if the time is unknown.
+		 */
+		uint64_t timestamp;
+
+		/**
+		 * The value of the sample.
+		 */
+		float value;
+
+		/**
+		 * The sequence number of the sample in this slot.
+		 * Zero while the slot is empty, or being written.
+		 */
+		std::atomic<uint32_t> sequence { 0 };
+	};
+
+	/**
+	 * The ring buffer containing the sample history.
+	 */
+	Slot *const _slots;
+
+	/**
+	 * The max number of samples kept in the history.
+	 */
+	const size_t _capacity;
+
+	/**
+	 * The number of decimal places to write.
+	 */
+	const uint8_t _decimals;
+
+	/**
+	 * The sequence number of the newest sample.
+	 * Sequence numbers start at one, so zero means no sample was recorded yet.
+	 */
+	std::atomic<uint32_t> _newest { 0 };
+
+	/**
+	 * The sequence number of the newest sample acknowledged by each consumer.
+	 */
+	std::atomic<uint32_t> _acknowledged[MAX_CONSUMERS] { };
+
+	/**
+	 * Copies the sample with the given sequence number from its slot.
+	 *
+	 * @param sequence	The sequence number of the sample to read.
+	 * @param sample	Set to the sample with the given sequence number.
+	 * @return	False if the slot doesn't contain the sample, or it was overwritten while being read.
+	 */
+	bool readSlot(const uint32_t sequence, Sample &sample) const;
+
+	/**
+	 * Gets the sample with the given index, counting from the oldest sample not acknowledged by the given consumer.
+	 *
+	 * @param index		The index of the sample to get.
+	 * @param consumer	The consumer to get the sample for.
+	 * @param sample	Set to the sample with the given index.
+	 * @return	False if there is no sample with the given index.
+	 */
+	bool getSample(const size_t index, const uint8_t consumer,
+			Sample &sample) const;
+public:
+	/**
+	 * Creates a new backfill gauge family.
+	 *
+	 * @param metric_namespace	The namespace of the metric family. May be empty.
+	 * @param name				The name of the metric family, without the namespace and unit.
+	 * @param unit				The unit of the metric family. May be empty.
+	 * @param help				The description text of the metric family.
+	 * @param capacity			The max number of samples to keep.
+	 * @param decimals			The number of decimal places to write.
+	 */
+	BackfillGaugeFamily(const char *metric_namespace, const char *name,
+			const char *unit, const char *help, const size_t capacity,
+			const uint8_t decimals = 3);
+
+	/**
+	 * Destroys this metric family, and frees its sample history.
+	 */
+	virtual ~BackfillGaugeFamily();
+
+	/**
+	 * Records a new sample, replacing the oldest one if the history is full.
+	 *
+	 * @param timestamp	The time the sample was taken in milliseconds since the unix epoch, or zero if unknown.
+	 *					Samples without a timestamp are written without one.
+	 * @param value		The value of the sample.
+	 * @return	The sequence number of the new sample.
+	 */
+	uint32_t record(const uint64_t timestamp, const float value);
+
+	/**
+	 * Gets the sequence number of the newest sample.
+	 *
+	 * @return	The sequence number of the newest sample, or zero if there is none.
+	 */
+	uint32_t getNewest() const;
+
+	/**
+	 * Gets the size of the heap allocated sample history.
+	 *
+	 * @return	The size of the sample history in bytes.
+	 */
+	size_t getHistorySize() const;
+
+	/**
+	 * Marks all samples up to the given sequence number as received by the given consumer,
+	 * so they aren't written for it again.
+	 * Does nothing if the consumer already acknowledged a newer sample, or the consumer is MAX_CONSUMERS or higher.
+	 *
+	 * @param sequence	The sequence number of the newest received sample.
+	 * @param consumer	The consumer that received the samples.
+	 */
+	void acknowledge(const uint32_t sequence, const uint8_t consumer = 0);
+
+	/**
+	 * Gets the sequence number of the newest sample acknowledged by the given consumer.
+	 *
+	 * @param consumer	The consumer to get the acknowledged sample for.
+	 * @return	The sequence number of the newest acknowledged sample, or zero if there is none.
+	 */
+	uint32_t getAcknowledged(const uint8_t consumer) const;
+
+	/**
+	 * Forgets which samples the given consumer acknowledged, so the entire history is written for it again.
+	 * Used when a consumer index is reassigned to a different consumer.
+	 *
+	 * @param consumer	The consumer to reset.
+	 */
+	void resetConsumer(const uint8_t consumer);
+
+	virtual const char* getType(const bool openmetrics) const override;
+
+	/**
+	 * Writes a single sample line of this metric family, including its timestamp.
+	 *
+	 * Timestamps are written in milliseconds for the Prometheus 0.0.4 format,
+	 * and in seconds for the OpenMetrics format.
+	 *
+	 * @param buffer		The buffer to write the line to.
+	 * @param max_len		The size of the buffer, including the terminating NUL byte.
+	 * @param index			The index of the sample to write, counting from the oldest unacknowledged sample.
+	 * @param openmetrics	Whether to write the OpenMetrics format, rather than the Prometheus 0.0.4 format.
+	 * @param consumer		The consumer whose acknowledged samples to skip.
+	 * @return	The length of the sample line, or zero if there is no sample with the given index.
+	 */
+	virtual size_t writeSample(char *buffer, const size_t max_len,
+			const size_t index, const bool openmetrics,
+			const uint8_t consumer) const override;
+
+	/**
+	 * Writes a single sample of this metric family as a protobuf Metric message, including its timestamp.
+	 *
+	 * @param encoder	The encoder to write the metric to.
+	 * @param index		The index of the sample to write, counting from the oldest unacknowledged sample.
+	 * @param consumer	The consumer whose acknowledged samples to skip.
+	 * @return	False if there is no sample with the given index.
+	 */
+	virtual bool writeMetric(MetricEncoder &encoder, const size_t index,
+			const uint8_t consumer) const override;
+};
+
+}
+
+#endif /* LIB_PROMETHEUS_REGISTRY_INCLUDE_PROMETHEUS_REGISTRY_H_ */
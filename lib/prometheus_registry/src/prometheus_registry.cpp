@@ -0,0 +1,465 @@
+/*
+ * prometheus_registry.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "prometheus_registry.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#endif
+
+prom::Registry prom::default_registry;
+
+void prom::Registry::add(MetricFamily &family) {
+	if (std::find(_families.begin(), _families.end(), &family)
+			== _families.end()) {
+		family.prerender();
+		_families.push_back(&family);
+	}
+}
+
+const std::vector<const prom::MetricFamily*>& prom::Registry::getFamilies() const {
+	return _families;
+}
+
+void prom::Counter::inc(const uint32_t amount) {
+	const uint32_t old = _low.fetch_add(amount, std::memory_order_relaxed);
+	const uint32_t crossings = (((uint64_t) old + amount) >> 31) - (old >> 31);
+	if (crossings > 0) {
+		_high.fetch_add(crossings, std::memory_order_release);
+	}
+}
+
+uint64_t prom::Counter::get() const {
+	uint32_t high;
+	uint32_t low;
+	do {
+		high = _high.load(std::memory_order_acquire);
+		low = _low.load(std::memory_order_acquire);
+	} while (high != _high.load(std::memory_order_acquire));
+	// If the top bit of the lower half doesn't match, a concurrent increment didn't update the upper half yet.
+	if ((high ^ low >> 31) & 1) {
+		high++;
+	}
+	return (uint64_t) (high >> 1) << 32 | low;
+}
+
+size_t prom::getCounterShard() {
+#if defined(ESP32)
+	return xPortGetCoreID() % PROM_COUNTER_SHARDS;
+#elif defined(ESP8266)
+	return 0;
+#else
+	static std::atomic<size_t> next_shard { 0 };
+	thread_local const size_t shard = next_shard.fetch_add(1,
+			std::memory_order_relaxed) % PROM_COUNTER_SHARDS;
+	return shard;
+#endif
+}
+
+void prom::ShardedCounter::inc(const uint32_t amount) {
+	_shards[getCounterShard()].counter.inc(amount);
+}
+
+uint64_t prom::ShardedCounter::get() const {
+	uint64_t value = 0;
+	for (const Shard &shard : _shards) {
+		value += shard.counter.get();
+	}
+	return value;
+}
+
+void prom::Gauge::set(const float value) {
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	_bits.store(bits, std::memory_order_relaxed);
+}
+
+void prom::Gauge::add(const float amount) {
+	uint32_t old = _bits.load(std::memory_order_relaxed);
+	uint32_t bits;
+	do {
+		float value;
+		memcpy(&value, &old, sizeof(value));
+		value += amount;
+		memcpy(&bits, &value, sizeof(bits));
+	} while (!_bits.compare_exchange_weak(old, bits, std::memory_order_relaxed));
+}
+
+float prom::Gauge::get() const {
+	const uint32_t bits = _bits.load(std::memory_order_relaxed);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+void prom::Histogram::init(const uint32_t *bounds, const size_t bucket_count,
+		std::atomic<uint32_t> *counts) {
+	_bounds = bounds;
+	_bucket_count = bucket_count;
+	_counts = counts;
+}
+
+void prom::Histogram::observe(const uint32_t value) {
+	size_t bucket = 0;
+	while (bucket < _bucket_count && value > _bounds[bucket]) {
+		bucket++;
+	}
+	_counts[bucket].fetch_add(1, std::memory_order_relaxed);
+	_sum.inc(value);
+}
+
+uint64_t prom::Histogram::getCumulativeCount(const size_t bucket) const {
+	uint64_t count = 0;
+	for (size_t i = 0; i <= bucket && i <= _bucket_count; i++) {
+		count += _counts[i].load(std::memory_order_relaxed);
+	}
+	return count;
+}
+
+uint64_t prom::Histogram::getSum() const {
+	return _sum.get();
+}
+
+/**
+ * Calculates the number of decimal places required to write values divided by the given scale.
+ *
+ * @param scale	The value to divide by.
+ * @return	The number of decimal places to write.
+ */
+static uint8_t getScaleDecimals(uint32_t scale) {
+	uint8_t decimals = 0;
+	while (scale >= 10) {
+		scale /= 10;
+		decimals++;
+	}
+	return decimals;
+}
+
+prom::CounterFamily::CounterFamily(const char *metric_namespace,
+		const char *name, const char *unit, const char *help,
+		const std::initializer_list<const char*> label_names,
+		const size_t max_series, const uint32_t scale) :
+		SeriesFamily<Counter>(metric_namespace, name, unit, help, label_names,
+				max_series), _scale(scale), _decimals(getScaleDecimals(scale)) {
+
+}
+
+const char* prom::CounterFamily::getType(const bool openmetrics) const {
+	return "counter";
+}
+
+size_t prom::CounterFamily::writeSeriesLine(char *buffer,
+		const size_t max_len, const size_t series, const size_t line,
+		const bool openmetrics) const {
+	size_t len = writeName(buffer, max_len);
+	len += writeLabels(buffer + std::min(len, max_len),
+			max_len - std::min(len, max_len), series);
+	const uint64_t value = _series[series].get();
+	if (_scale == 1) {
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " %llu\n",
+				(long long unsigned int) value);
+	} else {
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " %.*f\n", _decimals,
+				(double) value / _scale);
+	}
+	return len;
+}
+
+void prom::CounterFamily::writeSeriesMetric(MetricEncoder &encoder,
+		const size_t series) const {
+	const uint64_t value = _series[series].get();
+	encoder.writeValue(MetricEncoder::COUNTER,
+			_scale == 1 ? (double) value : (double) value / _scale);
+}
+
+prom::GaugeFamily::GaugeFamily(const char *metric_namespace, const char *name,
+		const char *unit, const char *help,
+		const std::initializer_list<const char*> label_names,
+		const size_t max_series, const uint8_t decimals) :
+		SeriesFamily<Gauge>(metric_namespace, name, unit, help, label_names,
+				max_series), _decimals(decimals) {
+
+}
+
+const char* prom::GaugeFamily::getType(const bool openmetrics) const {
+	return "gauge";
+}
+
+size_t prom::GaugeFamily::writeSeriesLine(char *buffer, const size_t max_len,
+		const size_t series, const size_t line, const bool openmetrics) const {
+	size_t len = writeName(buffer, max_len);
+	len += writeLabels(buffer + std::min(len, max_len),
+			max_len - std::min(len, max_len), series);
+	const float value = _series[series].get();
+	if (std::isnan(value)) {
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " NAN\n");
+	} else {
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " %.*f\n", _decimals,
+				(double) value);
+	}
+	return len;
+}
+
+void prom::GaugeFamily::writeSeriesMetric(MetricEncoder &encoder,
+		const size_t series) const {
+	encoder.writeValue(MetricEncoder::GAUGE, _series[series].get());
+}
+
+prom::HistogramFamily::HistogramFamily(const char *metric_namespace,
+		const char *name, const char *unit, const char *help,
+		const std::initializer_list<uint32_t> bounds, const uint32_t scale,
+		const std::initializer_list<const char*> label_names,
+		const size_t max_series) :
+		SeriesFamily<Histogram>(metric_namespace, name, unit, help,
+				label_names, max_series), _bounds(bounds), _counts(
+				new std::atomic<uint32_t>[(max_series + 1)
+						* (bounds.size() + 1)]), _scale(scale), _decimals(
+				getScaleDecimals(scale)) {
+	for (size_t i = 0; i < (max_series + 1) * (_bounds.size() + 1); i++) {
+		_counts[i].store(0, std::memory_order_relaxed);
+	}
+	for (size_t i = 0; i <= max_series; i++) {
+		_series[i].init(_bounds.data(), _bounds.size(),
+				_counts + i * (_bounds.size() + 1));
+	}
+}
+
+prom::HistogramFamily::~HistogramFamily() {
+	delete[] _counts;
+}
+
+const char* prom::HistogramFamily::getType(const bool openmetrics) const {
+	return "histogram";
+}
+
+size_t prom::HistogramFamily::getLinesPerSeries() const {
+	// One line per bucket, plus the +Inf bucket, the sum, and the count.
+	return _bounds.size() + 3;
+}
+
+size_t prom::HistogramFamily::writeSeriesLine(char *buffer,
+		const size_t max_len, const size_t series, const size_t line,
+		const bool openmetrics) const {
+	const Histogram &histogram = _series[series];
+	size_t len = writeName(buffer, max_len);
+	if (line <= _bounds.size()) {
+		append(buffer, max_len, len, "_bucket");
+		char bound[16];
+		if (line < _bounds.size()) {
+			snprintf(bound, sizeof(bound), "%g",
+					(double) _bounds[line] / _scale);
+		} else {
+			strcpy(bound, "+Inf");
+		}
+		len += writeLabels(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), series, "le", bound);
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " %llu\n",
+				(long long unsigned int) histogram.getCumulativeCount(line));
+	} else if (line == _bounds.size() + 1) {
+		append(buffer, max_len, len, "_sum");
+		len += writeLabels(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), series);
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " %.*f\n", _decimals,
+				(double) histogram.getSum() / _scale);
+	} else {
+		append(buffer, max_len, len, "_count");
+		len += writeLabels(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), series);
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " %llu\n",
+				(long long unsigned int) histogram.getCumulativeCount(
+						_bounds.size()));
+	}
+	return len;
+}
+
+void prom::HistogramFamily::writeSeriesMetric(MetricEncoder &encoder,
+		const size_t series) const {
+	const Histogram &histogram = _series[series];
+	encoder.beginHistogram();
+	for (size_t i = 0; i < _bounds.size(); i++) {
+		encoder.writeBucket(histogram.getCumulativeCount(i),
+				(double) _bounds[i] / _scale);
+	}
+	encoder.endHistogram(histogram.getCumulativeCount(_bounds.size()),
+			(double) histogram.getSum() / _scale);
+}
+
+prom::BackfillGaugeFamily::BackfillGaugeFamily(const char *metric_namespace,
+		const char *name, const char *unit, const char *help,
+		const size_t capacity, const uint8_t decimals) :
+		MetricFamily(metric_namespace, name, unit, help), _slots(
+				new Slot[capacity]), _capacity(capacity), _decimals(decimals) {
+
+}
+
+prom::BackfillGaugeFamily::~BackfillGaugeFamily() {
+	delete[] _slots;
+}
+
+uint32_t prom::BackfillGaugeFamily::record(const uint64_t timestamp,
+		const float value) {
+	const uint32_t sequence = _newest.load(std::memory_order_relaxed) + 1;
+	Slot &slot = _slots[sequence % _capacity];
+	slot.sequence.store(0, std::memory_order_relaxed);
+	// Makes sure readers see the slot as busy before any of the new values.
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.timestamp = timestamp;
+	slot.value = value;
+	slot.sequence.store(sequence, std::memory_order_release);
+	_newest.store(sequence, std::memory_order_release);
+	return sequence;
+}
+
+uint32_t prom::BackfillGaugeFamily::getNewest() const {
+	return _newest.load(std::memory_order_acquire);
+}
+
+size_t prom::BackfillGaugeFamily::getHistorySize() const {
+	return _capacity * sizeof(Slot);
+}
+
+void prom::BackfillGaugeFamily::acknowledge(const uint32_t sequence,
+		const uint8_t consumer) {
+	if (consumer >= MAX_CONSUMERS) {
+		return;
+	}
+
+	std::atomic<uint32_t> &cursor = _acknowledged[consumer];
+	uint32_t acknowledged = cursor.load(std::memory_order_relaxed);
+	while (acknowledged < sequence
+			&& !cursor.compare_exchange_weak(acknowledged, sequence,
+					std::memory_order_relaxed)) {
+	}
+}
+
+uint32_t prom::BackfillGaugeFamily::getAcknowledged(
+		const uint8_t consumer) const {
+	if (consumer >= MAX_CONSUMERS) {
+		return 0;
+	}
+	return _acknowledged[consumer].load(std::memory_order_relaxed);
+}
+
+void prom::BackfillGaugeFamily::resetConsumer(const uint8_t consumer) {
+	if (consumer < MAX_CONSUMERS) {
+		_acknowledged[consumer].store(0, std::memory_order_relaxed);
+	}
+}
+
+const char* prom::BackfillGaugeFamily::getType(const bool openmetrics) const {
+	return "gauge";
+}
+
+bool prom::BackfillGaugeFamily::readSlot(const uint32_t sequence,
+		Sample &sample) const {
+	const Slot &slot = _slots[sequence % _capacity];
+	if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+		return false;
+	}
+	sample.timestamp = slot.timestamp;
+	sample.value = slot.value;
+	// Makes sure the values are read before the sequence number is checked again.
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+bool prom::BackfillGaugeFamily::getSample(const size_t index,
+		const uint8_t consumer, Sample &sample) const {
+	const uint32_t newest = _newest.load(std::memory_order_acquire);
+	if (newest == 0) {
+		return false;
+	}
+
+	uint32_t oldest = newest;
+	if (consumer < MAX_CONSUMERS) {
+		oldest = _acknowledged[consumer].load(std::memory_order_relaxed) + 1;
+	}
+	if (newest >= _capacity && oldest < newest - _capacity + 1) {
+		oldest = newest - _capacity + 1;
+	}
+	if (oldest > newest) {
+		oldest = newest;
+	}
+	// Samples without a timestamp are only written while they are the newest one.
+	// Samples that are being overwritten are skipped as well.
+	while (oldest < newest
+			&& (!readSlot(oldest, sample) || sample.timestamp == 0)) {
+		oldest++;
+	}
+	if (index > newest - oldest) {
+		return false;
+	}
+
+	// Only the oldest samples can be overwritten while being read, so the next one is used instead.
+	for (uint32_t sequence = oldest + index; sequence <= newest; sequence++) {
+		if (readSlot(sequence, sample)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t prom::BackfillGaugeFamily::writeSample(char *buffer,
+		const size_t max_len, const size_t index, const bool openmetrics,
+		const uint8_t consumer) const {
+	Sample sample;
+	if (!getSample(index, consumer, sample)) {
+		return 0;
+	}
+
+	size_t len = writeName(buffer, max_len);
+	if (std::isnan(sample.value)) {
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " NAN");
+	} else {
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " %.*f", _decimals,
+				(double) sample.value);
+	}
+
+	if (sample.timestamp == 0) {
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), "\n");
+	} else if (openmetrics) {
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " %llu.%03u\n",
+				(long long unsigned int) (sample.timestamp / 1000),
+				(unsigned int) (sample.timestamp % 1000));
+	} else {
+		len += snprintf(buffer + std::min(len, max_len),
+				max_len - std::min(len, max_len), " %llu\n",
+				(long long unsigned int) sample.timestamp);
+	}
+	return len;
+}
+
+bool prom::BackfillGaugeFamily::writeMetric(MetricEncoder &encoder,
+		const size_t index, const uint8_t consumer) const {
+	Sample sample;
+	if (!getSample(index, consumer, sample)) {
+		return false;
+	}
+
+	encoder.writeValue(MetricEncoder::GAUGE, sample.value);
+	if (sample.timestamp != 0) {
+		encoder.writeTimestamp(sample.timestamp);
+	}
+	return true;
+}
@@ -0,0 +1,370 @@
+/*
+ * prometheus_remote_write.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROMETHEUS_REMOTE_WRITE_INCLUDE_PROMETHEUS_REMOTE_WRITE_H_
+#define LIB_PROMETHEUS_REMOTE_WRITE_INCLUDE_PROMETHEUS_REMOTE_WRITE_H_
+
+#include <prometheus_exposition.h>
+#include "snappy_compressor.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace prom {
+
+/**
+ * A buffer containing an uncompressed protobuf encoded remote write WriteRequest.
+ *
+ * Samples are parsed from Prometheus 0.0.4 sample lines, and each is encoded as a separate TimeSeries.
+ * Since a WriteRequest is only a list of TimeSeries, the buffer content is always a valid WriteRequest.
+ *
+ * The buffer is allocated when this object is created, and samples that don't fit are dropped.
+ */
+class WriteRequestBuffer {
+public:
+	/**
+	 * The max number of labels of a single sample, including the metric name.
+	 * Samples with more labels are skipped.
+	 */
+	static constexpr size_t MAX_LABELS = 16;
+private:
+	/**
+	 * The buffer containing the encoded TimeSeries.
+	 */
+	uint8_t *const _buffer;
+
+	/**
+	 * The size of the buffer.
+	 */
+	const size_t _capacity;
+
+	/**
+	 * The number of bytes in use.
+	 */
+	size_t _len = 0;
+
+	/**
+	 * The number of samples in the buffer.
+	 */
+	size_t _samples = 0;
+public:
+	/**
+	 * Creates a new write request buffer.
+	 *
+	 * @param capacity	The size of the buffer in bytes.
+	 */
+	WriteRequestBuffer(const size_t capacity);
+
+	/**
+	 * Destroys this buffer, and frees its memory.
+	 */
+	virtual ~WriteRequestBuffer();
+
+	WriteRequestBuffer(const WriteRequestBuffer &other) = delete;
+
+	WriteRequestBuffer& operator=(const WriteRequestBuffer &other) = delete;
+
+	/**
+	 * Parses a single sample line, and adds it to this buffer.
+	 * Comments, and lines that can't be parsed, are skipped.
+	 *
+	 * @param line		The sample line, without the trailing newline.
+	 * @param len		The length of the line.
+	 * @param timestamp	The timestamp in milliseconds since the unix epoch,
+	 * 					used if the line doesn't contain a timestamp.
+	 * @return	False if the sample didn't fit into this buffer.
+	 */
+	bool addSample(const char *line, const size_t len, const int64_t timestamp);
+
+	/**
+	 * Writes the Prometheus 0.0.4 exposition of the given metric families, and adds all of its samples.
+	 *
+	 * @param families	The metric families to add.
+	 * @param timestamp	The timestamp of samples without their own timestamp, in milliseconds since the unix epoch.
+	 * @param consumer	The consumer the exposition is written for. See MetricFamily::writeSample.
+	 * @return	The number of samples that didn't fit into this buffer.
+	 */
+	size_t addExposition(const std::vector<const MetricFamily*> &families,
+			const int64_t timestamp, const uint8_t consumer = 0);
+
+	/**
+	 * Removes the given number of samples from the start of this buffer.
+	 *
+	 * @param samples	The number of samples to remove.
+	 */
+	void remove(const size_t samples);
+
+	/**
+	 * Gets the encoded WriteRequest.
+	 *
+	 * @return	The content of this buffer.
+	 */
+	const uint8_t* data() const;
+
+	/**
+	 * Gets the length of the encoded WriteRequest.
+	 *
+	 * @return	The number of bytes in use.
+	 */
+	size_t size() const;
+
+	/**
+	 * Gets the size of this buffer.
+	 *
+	 * @return	The max number of bytes this buffer can hold.
+	 */
+	size_t capacity() const;
+
+	/**
+	 * Gets the number of samples in this buffer.
+	 *
+	 * @return	The number of samples.
+	 */
+	size_t getSampleCount() const;
+};
+
+/**
+ * An exponential backoff, doubling the delay after every failure up to a max delay.
+ */
+class Backoff {
+private:
+	/**
+	 * The delay after the first failure.
+	 */
+	const uint32_t _min_delay;
+
+	/**
+	 * The max delay between two attempts.
+	 */
+	const uint32_t _max_delay;
+
+	/**
+	 * The last returned delay. Zero if there was no failure since the last reset.
+	 */
+	uint32_t _delay = 0;
+public:
+	/**
+	 * Creates a new exponential backoff.
+	 *
+	 * @param min_delay	The delay after the first failure.
+	 * @param max_delay	The max delay between two attempts.
+	 */
+	Backoff(const uint32_t min_delay, const uint32_t max_delay);
+
+	/**
+	 * Gets the delay before the next attempt, and doubles it for the next failure.
+	 *
+	 * @return	The delay before the next attempt.
+	 */
+	uint32_t next();
+
+	/**
+	 * Resets the delay after a successful attempt.
+	 */
+	void reset();
+};
+
+/**
+ * A transport independent prometheus remote write client.
+ *
+ * Collects timestamped samples into a bounded buffer, and creates snappy compressed HTTP requests
+ * containing all buffered samples once the send interval passed, or the buffer is half full.
+ * Failed requests are retried with an exponential backoff, and new samples are dropped while the buffer is full.
+ *
+ * The HTTP request is rendered into a buffer allocated when the sender is created,
+ * which stays valid and unchanged until finishRequest is called.
+ * New samples can be collected while a request is in flight.
+ *
+ * This is **NOT** thread safe, all methods should be called from the same task.
+ */
+class RemoteWriteSender {
+public:
+	/**
+	 * The ways a request can finish.
+	 */
+	enum Result : uint8_t {
+		/**
+		 * The samples were accepted, and removed from the buffer.
+		 */
+		SUCCESS,
+		/**
+		 * The request failed, and will be retried after a backoff.
+		 */
+		RETRY,
+		/**
+		 * The receiver rejected the samples, so they were dropped.
+		 */
+		REJECTED
+	};
+private:
+	/**
+	 * The host to send in the Host header.
+	 */
+	const char *const _host;
+
+	/**
+	 * The request path of the remote write endpoint.
+	 */
+	const char *const _path;
+
+	/**
+	 * The value of the User-Agent header.
+	 */
+	const char *const _user_agent;
+
+	/**
+	 * The buffered samples.
+	 */
+	WriteRequestBuffer _batch;
+
+	/**
+	 * The compressor used for the request body.
+	 */
+	snappy::Compressor _compressor;
+
+	/**
+	 * The max length of the request headers.
+	 */
+	const size_t _header_capacity;
+
+	/**
+	 * The buffer the request is rendered into.
+	 * Contains space for the headers, followed by space for the compressed body.
+	 */
+	uint8_t *const _request;
+
+	/**
+	 * The offset of the request in the request buffer.
+	 */
+	size_t _request_start = 0;
+
+	/**
+	 * The number of samples in the current request. Zero if no request is in flight.
+	 */
+	size_t _in_flight = 0;
+
+	/**
+	 * The min time between two requests, in milliseconds.
+	 */
+	const uint32_t _send_interval;
+
+	/**
+	 * The backoff used for failed requests.
+	 */
+	Backoff _backoff;
+
+	/**
+	 * The time at which the last request was started, in milliseconds.
+	 */
+	uint64_t _last_send = 0;
+
+	/**
+	 * The time before which no new request should be started, in milliseconds.
+	 */
+	uint64_t _next_attempt = 0;
+public:
+	/**
+	 * Creates a new remote write sender, and allocates its buffers.
+	 * All strings have to remain valid for the lifetime of this object.
+	 *
+	 * @param host			The value of the Host header.
+	 * @param path			The request path of the remote write endpoint.
+	 * @param user_agent	The value of the User-Agent header.
+	 * @param batch_size	The max size of the uncompressed samples in bytes.
+	 * @param send_interval	The min time between two requests, in milliseconds.
+	 * @param min_backoff	The delay after the first failed request, in milliseconds.
+	 * @param max_backoff	The max delay after failed requests, in milliseconds.
+	 */
+	RemoteWriteSender(const char *host, const char *path,
+			const char *user_agent, const size_t batch_size,
+			const uint32_t send_interval, const uint32_t min_backoff,
+			const uint32_t max_backoff);
+
+	/**
+	 * Destroys this sender, and frees its buffers.
+	 */
+	virtual ~RemoteWriteSender();
+
+	RemoteWriteSender(const RemoteWriteSender &other) = delete;
+
+	RemoteWriteSender& operator=(const RemoteWriteSender &other) = delete;
+
+	/**
+	 * Gets the result of a request from its HTTP status code.
+	 * Server errors, 429 responses, and connection failures are retried.
+	 *
+	 * @param status	The HTTP status code of the response, or zero if there was no response.
+	 * @return	The result of the request.
+	 */
+	static Result getResult(const uint16_t status);
+
+	/**
+	 * Adds the current samples of the given metric families to the buffer.
+	 *
+	 * @param families	The metric families to collect.
+	 * @param timestamp	The current time in milliseconds since the unix epoch.
+	 * @param consumer	The consumer the samples are collected for. See MetricFamily::writeSample.
+	 * @return	The number of samples dropped because the buffer is full.
+	 */
+	size_t collect(const std::vector<const MetricFamily*> &families,
+			const int64_t timestamp, const uint8_t consumer = 0);
+
+	/**
+	 * Checks whether a new request should be started.
+	 *
+	 * @param now	The current time in milliseconds.
+	 * @return	True if there are buffered samples, and neither the send interval nor a backoff prevents sending.
+	 */
+	bool isReady(const uint64_t now) const;
+
+	/**
+	 * Renders a HTTP request containing all buffered samples.
+	 * Marks the request as in flight until finishRequest is called.
+	 *
+	 * @param now	The current time in milliseconds.
+	 * @param len	Set to the length of the request.
+	 * @return	The request, or NULL if there is nothing to send or a request is already in flight.
+	 */
+	const uint8_t* prepareRequest(const uint64_t now, size_t &len);
+
+	/**
+	 * Handles the end of the request in flight.
+	 *
+	 * @param status	The HTTP status code of the response, or zero if there was no response.
+	 * @param now		The current time in milliseconds.
+	 * @return	The result of the request.
+	 */
+	Result finishRequest(const uint16_t status, const uint64_t now);
+
+	/**
+	 * Checks whether a request is in flight.
+	 *
+	 * @return	True if prepareRequest returned a request that wasn't finished yet.
+	 */
+	bool isInFlight() const;
+
+	/**
+	 * Gets the number of buffered samples, including those in the request in flight.
+	 *
+	 * @return	The number of buffered samples.
+	 */
+	size_t getPendingSamples() const;
+
+	/**
+	 * Gets the number of samples in the request in flight.
+	 *
+	 * @return	The number of samples in flight.
+	 */
+	size_t getInFlightSamples() const;
+};
+
+}
+
+#endif /* LIB_PROMETHEUS_REMOTE_WRITE_INCLUDE_PROMETHEUS_REMOTE_WRITE_H_ */
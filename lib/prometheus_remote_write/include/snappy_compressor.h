@@ -0,0 +1,80 @@
+/*
+ * snappy_compressor.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_PROMETHEUS_REMOTE_WRITE_INCLUDE_SNAPPY_COMPRESSOR_H_
+#define LIB_PROMETHEUS_REMOTE_WRITE_INCLUDE_SNAPPY_COMPRESSOR_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * A minimal compressor for the raw snappy block format, as used by the prometheus remote write protocol.
+ */
+namespace snappy {
+/**
+ * The number of bits of the hash used to find matches.
+ * The hash table uses two bytes per entry.
+ */
+static constexpr uint8_t HASH_BITS = 10;
+
+/**
+ * The size of the blocks the input is split into.
+ * Matches are only searched for within a block, so offsets always fit into two bytes.
+ */
+static constexpr size_t BLOCK_SIZE = 65536;
+
+/**
+ * Calculates the max length of the compressed data for an input of the given length.
+ *
+ * @param len	The length of the uncompressed input.
+ * @return	The max compressed length.
+ */
+size_t getMaxCompressedLength(const size_t len);
+
+/**
+ * A snappy compressor with a fixed size hash table.
+ * Does not allocate any memory while compressing.
+ *
+ * This is **NOT** thread safe, a single compressor should only be used by one thread at a time.
+ */
+class Compressor {
+private:
+	/**
+	 * The positions of the last occurrence of each hashed four byte sequence in the current block.
+	 */
+	uint16_t _table[1 << HASH_BITS];
+
+	/**
+	 * Compresses a single block of at most BLOCK_SIZE bytes.
+	 *
+	 * @param input		The data to compress.
+	 * @param len		The length of the data to compress.
+	 * @param output	The buffer to write the compressed data to.
+	 * @return	The number of bytes written to the output buffer.
+	 */
+	size_t compressBlock(const uint8_t *input, const size_t len,
+			uint8_t *output);
+public:
+	/**
+	 * Compresses the given data, including the uncompressed length preamble.
+	 *
+	 * @param input		The data to compress.
+	 * @param len		The length of the data to compress.
+	 * @param output	The buffer to write the compressed data to.
+	 * @param max_len	The size of the output buffer.
+	 * @return	The length of the compressed data,
+	 * 			or zero if the output buffer is smaller than getMaxCompressedLength(len).
+	 */
+	size_t compress(const uint8_t *input, const size_t len, uint8_t *output,
+			const size_t max_len);
+};
+}
+
+#endif /* LIB_PROMETHEUS_REMOTE_WRITE_INCLUDE_SNAPPY_COMPRESSOR_H_ */
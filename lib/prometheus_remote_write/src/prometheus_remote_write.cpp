@@ -0,0 +1,463 @@
+/*
+ * prometheus_remote_write.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "prometheus_remote_write.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * The space reserved for the fixed parts of the request headers.
+ */
+static constexpr size_t FIXED_HEADER_LEN = 224;
+
+/**
+ * A label of a parsed sample line.
+ * The value is still escaped.
+ */
+struct Label {
+	const char *name;
+	size_t name_len;
+	const char *value;
+	size_t value_len;
+};
+
+/**
+ * Calculates the length of the given value as a protobuf varint.
+ *
+ * @param value	The value to encode.
+ * @return	The length of the varint.
+ */
+static size_t getVarintLength(uint64_t value) {
+	size_t len = 1;
+	while (value >= 0x80) {
+		value >>= 7;
+		len++;
+	}
+	return len;
+}
+
+/**
+ * Writes the given value as a protobuf varint.
+ *
+ * @param output	The buffer to write to.
+ * @param value		The value to write.
+ * @return	A pointer to the end of the varint.
+ */
+static uint8_t* writeVarint(uint8_t *output, uint64_t value) {
+	while (value >= 0x80) {
+		*output++ = (value & 0x7F) | 0x80;
+		value >>= 7;
+	}
+	*output++ = value;
+	return output;
+}
+
+/**
+ * Calculates the length of an escaped label value after unescaping it.
+ *
+ * @param value	The escaped label value.
+ * @param len	The length of the escaped label value.
+ * @return	The length of the unescaped value.
+ */
+static size_t getUnescapedLength(const char *value, const size_t len) {
+	size_t unescaped = 0;
+	for (size_t i = 0; i < len; i++) {
+		if (value[i] == '\\' && i + 1 < len) {
+			i++;
+		}
+		unescaped++;
+	}
+	return unescaped;
+}
+
+/**
+ * Unescapes the given label value, and writes it to the output buffer.
+ *
+ * @param output	The buffer to write to.
+ * @param value		The escaped label value.
+ * @param len		The length of the escaped label value.
+ * @return	A pointer to the end of the written value.
+ */
+static uint8_t* writeUnescaped(uint8_t *output, const char *value,
+		const size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		if (value[i] == '\\' && i + 1 < len) {
+			i++;
+			*output++ = value[i] == 'n' ? '\n' : value[i];
+		} else {
+			*output++ = value[i];
+		}
+	}
+	return output;
+}
+
+/**
+ * Calculates the length of the protobuf encoded Label message for the given label.
+ *
+ * @param label	The label to encode.
+ * @return	The length of the encoded message.
+ */
+static size_t getLabelLength(const Label &label) {
+	const size_t value_len = getUnescapedLength(label.value, label.value_len);
+	return 1 + getVarintLength(label.name_len) + label.name_len + 1
+			+ getVarintLength(value_len) + value_len;
+}
+
+/**
+ * Compares the names of two labels by their bytes.
+ *
+ * @param first		The first label to compare.
+ * @param second	The second label to compare.
+ * @return	True if the name of the first label sorts before the name of the second one.
+ */
+static bool compareLabels(const Label &first, const Label &second) {
+	const size_t len =
+			first.name_len < second.name_len ? first.name_len : second.name_len;
+	const int result = memcmp(first.name, second.name, len);
+	return result < 0 || (result == 0 && first.name_len < second.name_len);
+}
+
+/**
+ * Copies a space terminated token to a NUL terminated buffer.
+ *
+ * @param buffer	The buffer to copy the token to.
+ * @param max_len	The size of the buffer.
+ * @param line		The line to read the token from.
+ * @param len		The length of the line.
+ * @param pos		The start of the token. Set to the end of the token.
+ * @return	False if the token is empty, or doesn't fit into the buffer.
+ */
+static bool readToken(char *buffer, const size_t max_len, const char *line,
+		const size_t len, size_t &pos) {
+	const size_t start = pos;
+	while (pos < len && line[pos] != ' ') {
+		pos++;
+	}
+	if (pos == start || pos - start >= max_len) {
+		return false;
+	}
+	memcpy(buffer, line + start, pos - start);
+	buffer[pos - start] = 0;
+	return true;
+}
+
+prom::WriteRequestBuffer::WriteRequestBuffer(const size_t capacity) :
+		_buffer(new uint8_t[capacity]), _capacity(capacity) {
+
+}
+
+prom::WriteRequestBuffer::~WriteRequestBuffer() {
+	delete[] _buffer;
+}
+
+bool prom::WriteRequestBuffer::addSample(const char *line, const size_t len,
+		const int64_t timestamp) {
+	if (len == 0 || line[0] == '#') {
+		return true;
+	}
+
+	Label labels[MAX_LABELS];
+	size_t label_count = 1;
+	size_t pos = 0;
+	while (pos < len && line[pos] != '{' && line[pos] != ' ') {
+		pos++;
+	}
+	labels[0] = { "__name__", 8, line, pos };
+
+	if (pos < len && line[pos] == '{') {
+		pos++;
+		while (pos < len && line[pos] != '}') {
+			const size_t name_start = pos;
+			while (pos < len && line[pos] != '=') {
+				pos++;
+			}
+			if (pos + 1 >= len || line[pos + 1] != '"'
+					|| label_count >= MAX_LABELS) {
+				return true;
+			}
+
+			const size_t name_end = pos;
+			pos += 2;
+			const size_t value_start = pos;
+			while (pos < len && line[pos] != '"') {
+				if (line[pos] == '\\') {
+					pos++;
+				}
+				pos++;
+			}
+			if (pos >= len) {
+				return true;
+			}
+
+			labels[label_count++] = { line + name_start, name_end - name_start,
+					line + value_start, pos - value_start };
+			pos++;
+			if (pos < len && line[pos] == ',') {
+				pos++;
+			}
+		}
+		pos++;
+	}
+
+	if (pos >= len || line[pos] != ' ') {
+		return true;
+	}
+	pos++;
+
+	char token[32];
+	if (!readToken(token, sizeof(token), line, len, pos)) {
+		return true;
+	}
+	const double value = strtod(token, NULL);
+
+	int64_t sample_timestamp = timestamp;
+	if (pos < len) {
+		pos++;
+		if (readToken(token, sizeof(token), line, len, pos)) {
+			sample_timestamp = strtoll(token, NULL, 10);
+		}
+	}
+
+	// Remote write receivers require the labels to be sorted by name.
+	for (size_t i = 1; i < label_count; i++) {
+		const Label label = labels[i];
+		size_t j = i;
+		while (j > 0 && compareLabels(label, labels[j - 1])) {
+			labels[j] = labels[j - 1];
+			j--;
+		}
+		labels[j] = label;
+	}
+
+	const size_t sample_len = 1 + 8 + 1
+			+ getVarintLength((uint64_t) sample_timestamp);
+	size_t series_len = 1 + getVarintLength(sample_len) + sample_len;
+	for (size_t i = 0; i < label_count; i++) {
+		const size_t label_len = getLabelLength(labels[i]);
+		series_len += 1 + getVarintLength(label_len) + label_len;
+	}
+
+	if (_len + 1 + getVarintLength(series_len) + series_len > _capacity) {
+		return false;
+	}
+
+	// WriteRequest.timeseries
+	uint8_t *out = _buffer + _len;
+	*out++ = 0x0A;
+	out = writeVarint(out, series_len);
+	for (size_t i = 0; i < label_count; i++) {
+		// TimeSeries.labels
+		*out++ = 0x0A;
+		out = writeVarint(out, getLabelLength(labels[i]));
+		*out++ = 0x0A;
+		out = writeVarint(out, labels[i].name_len);
+		memcpy(out, labels[i].name, labels[i].name_len);
+		out += labels[i].name_len;
+		*out++ = 0x12;
+		out = writeVarint(out,
+				getUnescapedLength(labels[i].value, labels[i].value_len));
+		out = writeUnescaped(out, labels[i].value, labels[i].value_len);
+	}
+
+	// TimeSeries.samples
+	*out++ = 0x12;
+	out = writeVarint(out, sample_len);
+	*out++ = 0x09;
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	for (uint8_t i = 0; i < 8; i++) {
+		*out++ = bits >> (i * 8);
+	}
+	*out++ = 0x10;
+	out = writeVarint(out, (uint64_t) sample_timestamp);
+
+	_len = out - _buffer;
+	_samples++;
+	return true;
+}
+
+size_t prom::WriteRequestBuffer::addExposition(
+		const std::vector<const MetricFamily*> &families,
+		const int64_t timestamp, const uint8_t consumer) {
+	ExpositionWriter writer(families, false, { }, consumer);
+	char line[ExpositionWriter::MAX_LINE_LEN + 1];
+	size_t line_len = 0;
+	size_t dropped = 0;
+	size_t read;
+	while ((read = writer.read((uint8_t*) line + line_len,
+			sizeof(line) - line_len)) > 0) {
+		size_t start = 0;
+		for (size_t i = line_len; i < line_len + read; i++) {
+			if (line[i] == '\n') {
+				if (!addSample(line + start, i - start, timestamp)) {
+					dropped++;
+				}
+				start = i + 1;
+			}
+		}
+		line_len += read - start;
+		memmove(line, line + start, line_len);
+	}
+	return dropped;
+}
+
+void prom::WriteRequestBuffer::remove(const size_t samples) {
+	size_t pos = 0;
+	for (size_t i = 0; i < samples && pos < _len; i++) {
+		pos++;
+		uint64_t series_len = 0;
+		uint8_t shift = 0;
+		while (_buffer[pos] & 0x80) {
+			series_len |= (uint64_t) (_buffer[pos++] & 0x7F) << shift;
+			shift += 7;
+		}
+		series_len |= (uint64_t) _buffer[pos++] << shift;
+		pos += series_len;
+		_samples--;
+	}
+
+	memmove(_buffer, _buffer + pos, _len - pos);
+	_len -= pos;
+}
+
+const uint8_t* prom::WriteRequestBuffer::data() const {
+	return _buffer;
+}
+
+size_t prom::WriteRequestBuffer::size() const {
+	return _len;
+}
+
+size_t prom::WriteRequestBuffer::capacity() const {
+	return _capacity;
+}
+
+size_t prom::WriteRequestBuffer::getSampleCount() const {
+	return _samples;
+}
+
+prom::Backoff::Backoff(const uint32_t min_delay, const uint32_t max_delay) :
+		_min_delay(min_delay), _max_delay(max_delay) {
+
+}
+
+uint32_t prom::Backoff::next() {
+	if (_delay == 0) {
+		_delay = _min_delay;
+	} else if (_delay > _max_delay / 2) {
+		_delay = _max_delay;
+	} else {
+		_delay *= 2;
+	}
+	return _delay;
+}
+
+void prom::Backoff::reset() {
+	_delay = 0;
+}
+
+prom::RemoteWriteSender::RemoteWriteSender(const char *host, const char *path,
+		const char *user_agent, const size_t batch_size,
+		const uint32_t send_interval, const uint32_t min_backoff,
+		const uint32_t max_backoff) :
+		_host(host), _path(path), _user_agent(user_agent), _batch(batch_size), _header_capacity(
+				FIXED_HEADER_LEN + strlen(host) + strlen(path)
+						+ strlen(user_agent)), _request(
+				new uint8_t[_header_capacity
+						+ snappy::getMaxCompressedLength(batch_size)]), _send_interval(
+				send_interval), _backoff(min_backoff, max_backoff) {
+
+}
+
+prom::RemoteWriteSender::~RemoteWriteSender() {
+	delete[] _request;
+}
+
+prom::RemoteWriteSender::Result prom::RemoteWriteSender::getResult(
+		const uint16_t status) {
+	if (status >= 200 && status < 300) {
+		return SUCCESS;
+	} else if (status == 0 || status == 429 || status >= 500) {
+		return RETRY;
+	} else {
+		return REJECTED;
+	}
+}
+
+size_t prom::RemoteWriteSender::collect(
+		const std::vector<const MetricFamily*> &families,
+		const int64_t timestamp, const uint8_t consumer) {
+	return _batch.addExposition(families, timestamp, consumer);
+}
+
+bool prom::RemoteWriteSender::isReady(const uint64_t now) const {
+	if (_in_flight > 0 || _batch.getSampleCount() == 0 || now < _next_attempt) {
+		return false;
+	}
+	return now - _last_send >= _send_interval
+			|| _batch.size() >= _batch.capacity() / 2;
+}
+
+const uint8_t* prom::RemoteWriteSender::prepareRequest(const uint64_t now,
+		size_t &len) {
+	if (_in_flight > 0 || _batch.getSampleCount() == 0) {
+		return NULL;
+	}
+
+	const size_t body_len = _compressor.compress(_batch.data(), _batch.size(),
+			_request + _header_capacity,
+			snappy::getMaxCompressedLength(_batch.capacity()));
+
+	// The header is moved in front of the compressed body, since its length depends on the body length.
+	const size_t header_len = snprintf((char*) _request, _header_capacity,
+			"POST %s HTTP/1.1\r\n"
+					"Host: %s\r\n"
+					"User-Agent: %s\r\n"
+					"Content-Type: application/x-protobuf\r\n"
+					"Content-Encoding: snappy\r\n"
+					"X-Prometheus-Remote-Write-Version: 0.1.0\r\n"
+					"Content-Length: %u\r\n"
+					"Connection: close\r\n\r\n", _path, _host, _user_agent,
+			(unsigned int) body_len);
+	_request_start = _header_capacity - header_len;
+	memmove(_request + _request_start, _request, header_len);
+
+	_in_flight = _batch.getSampleCount();
+	_last_send = now;
+	len = header_len + body_len;
+	return _request + _request_start;
+}
+
+prom::RemoteWriteSender::Result prom::RemoteWriteSender::finishRequest(
+		const uint16_t status, const uint64_t now) {
+	const Result result = getResult(status);
+	if (result == RETRY) {
+		_next_attempt = now + _backoff.next();
+	} else {
+		_batch.remove(_in_flight);
+		_backoff.reset();
+		_next_attempt = now;
+	}
+	_in_flight = 0;
+	return result;
+}
+
+bool prom::RemoteWriteSender::isInFlight() const {
+	return _in_flight > 0;
+}
+
+size_t prom::RemoteWriteSender::getPendingSamples() const {
+	return _batch.getSampleCount();
+}
+
+size_t prom::RemoteWriteSender::getInFlightSamples() const {
+	return _in_flight;
+}
@@ -0,0 +1,165 @@
+/*
+ * snappy_compressor.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "snappy_compressor.h"
+#include <cstring>
+
+/**
+ * Inputs shorter than this are written as a single literal, since they are too short to contain useful matches.
+ */
+static constexpr size_t MIN_MATCH_INPUT = 15;
+
+/**
+ * Loads four bytes from the given position.
+ *
+ * @param data	The data to load from.
+ * @return	The loaded bytes.
+ */
+static inline uint32_t load32(const uint8_t *data) {
+	uint32_t value;
+	memcpy(&value, data, sizeof(value));
+	return value;
+}
+
+/**
+ * Writes a literal element containing the given data.
+ *
+ * @param output	The buffer to write to.
+ * @param data		The data to write.
+ * @param len		The length of the data. At most BLOCK_SIZE.
+ * @return	A pointer to the end of the written element.
+ */
+static uint8_t* writeLiteral(uint8_t *output, const uint8_t *data,
+		const size_t len) {
+	const size_t tag_len = len - 1;
+	if (tag_len < 60) {
+		*output++ = tag_len << 2;
+	} else if (tag_len < 256) {
+		*output++ = 60 << 2;
+		*output++ = tag_len;
+	} else {
+		*output++ = 61 << 2;
+		*output++ = tag_len & 0xFF;
+		*output++ = tag_len >> 8;
+	}
+	memcpy(output, data, len);
+	return output + len;
+}
+
+/**
+ * Writes a copy element with a two byte offset.
+ *
+ * @param output	The buffer to write to.
+ * @param offset	The distance to the start of the match.
+ * @param len		The length of the match. Between 1 and 64.
+ * @return	A pointer to the end of the written element.
+ */
+static inline uint8_t* writeCopy2(uint8_t *output, const size_t offset,
+		const size_t len) {
+	*output++ = 2 | ((len - 1) << 2);
+	*output++ = offset & 0xFF;
+	*output++ = offset >> 8;
+	return output;
+}
+
+/**
+ * Writes the copy elements for a match of the given length.
+ *
+ * @param output	The buffer to write to.
+ * @param offset	The distance to the start of the match. Less than BLOCK_SIZE.
+ * @param len		The length of the match. At least 4.
+ * @return	A pointer to the end of the written elements.
+ */
+static uint8_t* writeCopy(uint8_t *output, const size_t offset, size_t len) {
+	while (len >= 68) {
+		output = writeCopy2(output, offset, 64);
+		len -= 64;
+	}
+	if (len > 64) {
+		output = writeCopy2(output, offset, 60);
+		len -= 60;
+	}
+
+	if (len < 12 && offset < 2048) {
+		*output++ = 1 | ((len - 4) << 2) | ((offset >> 8) << 5);
+		*output++ = offset & 0xFF;
+		return output;
+	} else {
+		return writeCopy2(output, offset, len);
+	}
+}
+
+size_t snappy::getMaxCompressedLength(const size_t len) {
+	return 32 + len + len / 6;
+}
+
+size_t snappy::Compressor::compress(const uint8_t *input, const size_t len,
+		uint8_t *output, const size_t max_len) {
+	if (max_len < getMaxCompressedLength(len)) {
+		return 0;
+	}
+
+	size_t written = 0;
+	size_t preamble = len;
+	while (preamble >= 0x80) {
+		output[written++] = (preamble & 0x7F) | 0x80;
+		preamble >>= 7;
+	}
+	output[written++] = preamble;
+
+	for (size_t pos = 0; pos < len; pos += BLOCK_SIZE) {
+		written += compressBlock(input + pos,
+				len - pos < BLOCK_SIZE ? len - pos : BLOCK_SIZE,
+				output + written);
+	}
+	return written;
+}
+
+size_t snappy::Compressor::compressBlock(const uint8_t *input,
+		const size_t len, uint8_t *output) {
+	uint8_t *out = output;
+	size_t next_emit = 0;
+	if (len >= MIN_MATCH_INPUT) {
+		memset(_table, 0, sizeof(_table));
+		// Skip bytes faster the longer no match was found, like the reference implementation.
+		uint32_t skip = 32;
+		size_t pos = 1;
+		while (pos + 4 <= len) {
+			const uint32_t bytes = load32(input + pos);
+			const uint32_t hash = (bytes * 0x1E35A7BD) >> (32 - HASH_BITS);
+			const size_t candidate = _table[hash];
+			_table[hash] = pos;
+
+			if (candidate >= pos || load32(input + candidate) != bytes) {
+				pos += skip++ >> 5;
+				continue;
+			}
+
+			if (pos > next_emit) {
+				out = writeLiteral(out, input + next_emit, pos - next_emit);
+			}
+
+			size_t match_len = 4;
+			while (pos + match_len < len
+					&& input[candidate + match_len] == input[pos + match_len]) {
+				match_len++;
+			}
+			out = writeCopy(out, pos - candidate, match_len);
+			pos += match_len;
+			next_emit = pos;
+			skip = 32;
+		}
+	}
+
+	if (next_emit < len) {
+		out = writeLiteral(out, input + next_emit, len - next_emit);
+	}
+	return out - output;
+}
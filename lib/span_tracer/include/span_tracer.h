@@ -0,0 +1,305 @@
+/*
+ * span_tracer.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_SPAN_TRACER_INCLUDE_SPAN_TRACER_H_
+#define LIB_SPAN_TRACER_INCLUDE_SPAN_TRACER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace trace {
+
+/**
+ * A single recorded span.
+ */
+struct Event {
+	/**
+	 * The name of the span. Has to be a string literal, or otherwise live forever.
+	 */
+	const char *name;
+
+	/**
+	 * The time the span started, in microseconds.
+	 */
+	uint64_t start;
+
+	/**
+	 * The duration of the span, in microseconds.
+	 */
+	uint32_t duration;
+
+	/**
+	 * The id of the thread or task that recorded the span.
+	 */
+	uint32_t thread;
+};
+
+/**
+ * A fixed size ring buffer of recorded spans.
+ *
+ * Spans can be recorded from any number of tasks at once.
+ * Each slot of the ring buffer works like a seqlock, so a span that is overwritten while it is being read is skipped.
+ * If a task wraps around the ring buffer while another one is still writing a slot, its span is dropped.
+ */
+class Tracer {
+public:
+	/**
+	 * A function returning the current time in microseconds.
+	 */
+	typedef uint64_t (*clock_function)();
+
+	/**
+	 * A function returning the id of the current thread or task.
+	 */
+	typedef uint32_t (*thread_function)();
+private:
+	/**
+	 * A single slot of the ring buffer.
+	 */
+	struct Slot {
+		/**
+		 * The sequence number of the span in this slot.
+		 * Zero while the slot is empty, and UINT32_MAX while it is being written.
+		 */
+		std::atomic<uint32_t> sequence { 0 };
+
+		/**
+		 * The span in this slot.
+		 */
+		Event event;
+	};
+
+	/**
+	 * The ring buffer of recorded spans.
+	 */
+	Slot *const _slots;
+
+	/**
+	 * The number of slots in the ring buffer.
+	 */
+	const size_t _capacity;
+
+	/**
+	 * The function returning the current time.
+	 */
+	const clock_function _clock;
+
+	/**
+	 * The function returning the id of the current thread.
+	 */
+	const thread_function _thread;
+
+	/**
+	 * The sequence number of the newest span.
+	 * Sequence numbers start at one, so zero means no span was recorded yet.
+	 */
+	std::atomic<uint32_t> _newest { 0 };
+public:
+	/**
+	 * Creates a new tracer, and allocates its ring buffer.
+	 *
+	 * @param capacity	The max number of spans to keep.
+	 * @param clock		The function returning the current time in microseconds.
+	 * @param thread	The function returning the id of the current thread. NULL to always use zero.
+	 */
+	Tracer(const size_t capacity, const clock_function clock,
+			const thread_function thread = NULL);
+
+	Tracer(const Tracer &other) = delete;
+
+	Tracer& operator=(const Tracer &other) = delete;
+
+	/**
+	 * Destroys this tracer, and frees its ring buffer.
+	 */
+	~Tracer();
+
+	/**
+	 * Gets the current time of the clock of this tracer.
+	 *
+	 * @return	The current time in microseconds.
+	 */
+	uint64_t now() const;
+
+	/**
+	 * Records a span of the current thread, replacing the oldest one if the ring buffer is full.
+	 *
+	 * @param name	The name of the span. Has to be a string literal, or otherwise live forever.
+	 * @param start	The time the span started, in microseconds.
+	 * @param end	The time the span ended, in microseconds.
+	 * @return	The sequence number of the new span, or zero if it was dropped.
+	 */
+	uint32_t record(const char *name, const uint64_t start, const uint64_t end);
+
+	/**
+	 * Gets the sequence number of the newest span.
+	 *
+	 * @return	The sequence number of the newest span, or zero if there is none.
+	 */
+	uint32_t getNewest() const;
+
+	/**
+	 * Gets the sequence number of the oldest span that is still in the ring buffer.
+	 *
+	 * @return	The sequence number of the oldest span, or one if there is none.
+	 */
+	uint32_t getOldest() const;
+
+	/**
+	 * Gets the span with the given sequence number.
+	 *
+	 * @param sequence	The sequence number of the span to get.
+	 * @param event		Set to the span with the given sequence number.
+	 * @return	False if the span isn't in the ring buffer, or is being overwritten.
+	 */
+	bool getEvent(const uint32_t sequence, Event &event) const;
+};
+
+/**
+ * A span that is recorded when this object is destroyed.
+ * Has to be destroyed by the thread that created it.
+ */
+class Span {
+private:
+	/**
+	 * The tracer to record the span to.
+	 */
+	Tracer &_tracer;
+
+	/**
+	 * The name of the span.
+	 */
+	const char *const _name;
+
+	/**
+	 * The time the span started.
+	 */
+	const uint64_t _start;
+public:
+	/**
+	 * Starts a new span.
+	 *
+	 * @param tracer	The tracer to record the span to.
+	 * @param name		The name of the span. Has to be a string literal, or otherwise live forever.
+	 */
+	Span(Tracer &tracer, const char *name);
+
+	Span(const Span &other) = delete;
+
+	Span& operator=(const Span &other) = delete;
+
+	/**
+	 * Ends this span, and records it.
+	 */
+	~Span();
+};
+
+/**
+ * A pull based writer for the spans of a tracer, in the Chrome trace event JSON format.
+ *
+ * Writes the spans that were in the ring buffer when the writer was created, oldest first.
+ * Spans that are overwritten before they are written are skipped.
+ * Each span is written as a complete event, with the thread id of the span as its tid.
+ */
+class TraceWriter {
+public:
+	/**
+	 * The max length of a single event, including the separating comma.
+	 * Events with longer names are skipped.
+	 */
+	static constexpr size_t MAX_EVENT_LEN = 255;
+private:
+	/**
+	 * The part of the output that is currently being written.
+	 */
+	enum Stage : uint8_t {
+		HEADER, EVENTS, FOOTER, DONE
+	};
+
+	/**
+	 * The tracer of which to write the spans.
+	 */
+	const Tracer &_tracer;
+
+	/**
+	 * The sequence number of the next span to write.
+	 */
+	uint32_t _next;
+
+	/**
+	 * The sequence number of the last span to write.
+	 */
+	const uint32_t _last;
+
+	/**
+	 * Whether at least one span was written already.
+	 */
+	bool _written = false;
+
+	/**
+	 * The part of the output that is currently being written.
+	 */
+	Stage _stage = HEADER;
+
+	/**
+	 * The buffer for the event that is currently being written.
+	 */
+	char _buffer[MAX_EVENT_LEN + 1];
+
+	/**
+	 * The part of the output that is currently being copied.
+	 */
+	const char *_output = _buffer;
+
+	/**
+	 * The length of the current output part.
+	 */
+	size_t _output_len = 0;
+
+	/**
+	 * The number of bytes of the current output part that were already copied.
+	 */
+	size_t _output_pos = 0;
+
+	/**
+	 * Writes the next part of the output to the buffer, or points the output at a constant string.
+	 *
+	 * @return	False if there is nothing left to write.
+	 */
+	bool nextPart();
+public:
+	/**
+	 * Creates a new trace writer.
+	 *
+	 * @param tracer	The tracer of which to write the spans. Has to remain valid until the writer is done.
+	 */
+	TraceWriter(const Tracer &tracer);
+
+	/**
+	 * Writes the next part of the output to the given buffer.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The max number of bytes to write.
+	 * @return	The number of bytes written. Zero once the output is complete.
+	 */
+	size_t read(uint8_t *buffer, const size_t max_len);
+
+	/**
+	 * Checks whether the entire output was written.
+	 *
+	 * @return	True if there is nothing left to write.
+	 */
+	bool done() const;
+};
+
+} /* namespace trace */
+
+#endif /* LIB_SPAN_TRACER_INCLUDE_SPAN_TRACER_H_ */
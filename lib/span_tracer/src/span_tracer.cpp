@@ -0,0 +1,187 @@
+/*
+ * span_tracer.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "span_tracer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+/**
+ * The start of the trace event JSON object.
+ */
+static constexpr char TRACE_HEADER[] = "{\"traceEvents\":[";
+
+/**
+ * The end of the trace event JSON object.
+ */
+static constexpr char TRACE_FOOTER[] = "],\"displayTimeUnit\":\"ms\"}";
+
+/**
+ * The sequence number of a slot that is currently being written.
+ */
+static constexpr uint32_t SLOT_BUSY = UINT32_MAX;
+
+trace::Tracer::Tracer(const size_t capacity, const clock_function clock,
+		const thread_function thread) :
+		_slots(new Slot[capacity]), _capacity(capacity), _clock(clock), _thread(
+				thread) {
+
+}
+
+trace::Tracer::~Tracer() {
+	delete[] _slots;
+}
+
+uint64_t trace::Tracer::now() const {
+	return _clock();
+}
+
+uint32_t trace::Tracer::record(const char *name, const uint64_t start,
+		const uint64_t end) {
+	const uint32_t sequence = _newest.fetch_add(1, std::memory_order_relaxed)
+			+ 1;
+	Slot &slot = _slots[sequence % _capacity];
+	uint32_t current = slot.sequence.load(std::memory_order_relaxed);
+	do {
+		// Another task wrapped around the ring buffer, and is writing this slot.
+		if (current == SLOT_BUSY) {
+			return 0;
+		}
+	} while (!slot.sequence.compare_exchange_weak(current, SLOT_BUSY,
+			std::memory_order_relaxed));
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.event.name = name;
+	slot.event.start = start;
+	slot.event.duration = end - start;
+	slot.event.thread = _thread ? _thread() : 0;
+	slot.sequence.store(sequence, std::memory_order_release);
+	return sequence;
+}
+
+uint32_t trace::Tracer::getNewest() const {
+	return _newest.load(std::memory_order_acquire);
+}
+
+uint32_t trace::Tracer::getOldest() const {
+	const uint32_t newest = getNewest();
+	return newest > _capacity ? newest - _capacity + 1 : 1;
+}
+
+bool trace::Tracer::getEvent(const uint32_t sequence, Event &event) const {
+	if (sequence == 0) {
+		return false;
+	}
+
+	const Slot &slot = _slots[sequence % _capacity];
+	if (slot.sequence.load(std::memory_order_acquire) != sequence) {
+		return false;
+	}
+	event = slot.event;
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.sequence.load(std::memory_order_relaxed) == sequence;
+}
+
+trace::Span::Span(Tracer &tracer, const char *name) :
+		_tracer(tracer), _name(name), _start(tracer.now()) {
+
+}
+
+trace::Span::~Span() {
+	_tracer.record(_name, _start, _tracer.now());
+}
+
+trace::TraceWriter::TraceWriter(const Tracer &tracer) :
+		_tracer(tracer), _next(tracer.getOldest()), _last(tracer.getNewest()) {
+
+}
+
+bool trace::TraceWriter::nextPart() {
+	if (_stage == DONE) {
+		return false;
+	}
+
+	_output_pos = 0;
+	while (_stage != DONE) {
+		switch (_stage) {
+		case HEADER:
+			_output = TRACE_HEADER;
+			_output_len = strlen(TRACE_HEADER);
+			_stage = EVENTS;
+			return true;
+		case EVENTS: {
+			if (_next > _last) {
+				_stage = FOOTER;
+				continue;
+			}
+
+			Event event;
+			if (!_tracer.getEvent(_next++, event)) {
+				continue;
+			}
+
+			size_t len = 0;
+			if (_written) {
+				_buffer[len++] = ',';
+			}
+			len += snprintf(_buffer + len, sizeof(_buffer) - len,
+					"{\"name\":\"");
+			for (const char *c = event.name; *c && len < MAX_EVENT_LEN; c++) {
+				if (*c == '"' || *c == '\\') {
+					_buffer[len++] = '\\';
+				}
+				_buffer[len++] = *c;
+			}
+			if (len >= MAX_EVENT_LEN) {
+				continue;
+			}
+			len += snprintf(_buffer + len, sizeof(_buffer) - len,
+					"\",\"ph\":\"X\",\"ts\":%llu,\"dur\":%u,\"pid\":1,\"tid\":%u}",
+					(long long unsigned int) event.start,
+					(unsigned int) event.duration, (unsigned int) event.thread);
+			if (len > MAX_EVENT_LEN) {
+				continue;
+			}
+
+			_output = _buffer;
+			_output_len = len;
+			_written = true;
+			return true;
+		}
+		case FOOTER:
+			_output = TRACE_FOOTER;
+			_output_len = strlen(TRACE_FOOTER);
+			_stage = DONE;
+			return true;
+		case DONE:
+			break;
+		}
+	}
+	return false;
+}
+
+size_t trace::TraceWriter::read(uint8_t *buffer, const size_t max_len) {
+	size_t written = 0;
+	while (written < max_len) {
+		if (_output_pos >= _output_len && !nextPart()) {
+			break;
+		}
+
+		const size_t len = std::min(_output_len - _output_pos,
+				max_len - written);
+		memcpy(buffer + written, _output + _output_pos, len);
+		_output_pos += len;
+		written += len;
+	}
+	return written;
+}
+
+bool trace::TraceWriter::done() const {
+	return _stage == DONE && _output_pos >= _output_len;
+}
@@ -0,0 +1,171 @@
+/*
+ * seqlock.h
+ *
+ * This file contains a double buffered sequence lock, sharing a value between a writer and any number of readers.
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_UTILS_INCLUDE_SEQLOCK_H_
+#define LIB_UTILS_INCLUDE_SEQLOCK_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace utils {
+
+/**
+ * A lock-free container for a value that is written by a single writer, and read by any number of readers.
+ *
+ * Readers always get a consistent copy of a value that was written as a whole, and never block the writer.
+ * The value is stored in two slots, each protected by its own sequence counter.
+ * The writer only ever writes the slot that isn't the current one, so a reader only has to retry
+ * if the writer finished writing a new value while it was copying the current one.
+ * This means a reader interrupting the writer, for example on the same core, never waits for it.
+ *
+ * The value is copied as atomic words, so concurrent reads and writes aren't data races.
+ *
+ * @tparam T	The type of the stored value. Has to be trivially copyable.
+ */
+template<typename T>
+class SeqLock {
+	static_assert(std::is_trivially_copyable<T>::value,
+			"The value of a SeqLock has to be trivially copyable.");
+private:
+	/**
+	 * The number of 32 bit words required to store a value.
+	 */
+	static constexpr size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1)
+			/ sizeof(uint32_t);
+
+	/**
+	 * A single copy of the value, and the sequence counter protecting it.
+	 */
+	struct Slot {
+		/**
+		 * The number of times this slot was written, times two.
+		 * Odd while the slot is being written.
+		 */
+		std::atomic<uint32_t> sequence { 0 };
+
+		/**
+		 * The words of the value stored in this slot.
+		 */
+		std::atomic<uint32_t> data[WORDS];
+	};
+
+	/**
+	 * The two copies of the value.
+	 */
+	Slot _slots[2];
+
+	/**
+	 * The number of values written so far.
+	 * The current value is in the slot at index `generation % 2`.
+	 */
+	std::atomic<uint32_t> _generation { 0 };
+
+	/**
+	 * Copies the given value into a slot.
+	 * Has to be called by the writer only.
+	 *
+	 * @param slot	The slot to write to.
+	 * @param value	The value to store.
+	 */
+	static void store(Slot &slot, const T &value) {
+		uint32_t words[WORDS] = { };
+		memcpy(words, &value, sizeof(T));
+
+		const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+		slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+		// Makes sure the odd sequence is visible before any of the new words.
+		std::atomic_thread_fence(std::memory_order_release);
+		for (size_t i = 0; i < WORDS; i++) {
+			slot.data[i].store(words[i], std::memory_order_relaxed);
+		}
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+	}
+public:
+	/**
+	 * Creates a new SeqLock containing the given value.
+	 *
+	 * @param value	The initial value.
+	 */
+	explicit SeqLock(const T &value = T()) {
+		store(_slots[0], value);
+		store(_slots[1], value);
+	}
+
+	SeqLock(const SeqLock &other) = delete;
+
+	SeqLock& operator=(const SeqLock &other) = delete;
+
+	/**
+	 * Replaces the stored value.
+	 * Has to be called by a single writer only, and never concurrently with itself.
+	 *
+	 * @param value	The new value.
+	 */
+	void write(const T &value) {
+		const uint32_t generation = _generation.load(std::memory_order_relaxed)
+				+ 1;
+		store(_slots[generation % 2], value);
+		_generation.store(generation, std::memory_order_release);
+	}
+
+	/**
+	 * Gets a consistent copy of the current value.
+	 * Never blocks, but retries if a new value was written while the current one was being copied.
+	 *
+	 * @return	A copy of the current value.
+	 */
+	T read() const {
+		uint32_t words[WORDS];
+		while (true) {
+			const uint32_t generation = _generation.load(
+					std::memory_order_acquire);
+			const Slot &slot = _slots[generation % 2];
+			const uint32_t sequence = slot.sequence.load(
+					std::memory_order_acquire);
+			if (sequence % 2 != 0) {
+				continue;
+			}
+
+			for (size_t i = 0; i < WORDS; i++) {
+				words[i] = slot.data[i].load(std::memory_order_relaxed);
+			}
+			// Makes sure the words are read before the sequence is checked again.
+			std::atomic_thread_fence(std::memory_order_acquire);
+			// Also checks the generation, so a reader never sees a newer value before an older one.
+			if (slot.sequence.load(std::memory_order_relaxed) == sequence
+					&& _generation.load(std::memory_order_relaxed)
+							== generation) {
+				break;
+			}
+		}
+
+		T value;
+		memcpy(&value, words, sizeof(T));
+		return value;
+	}
+
+	/**
+	 * Gets the number of values written since this SeqLock was created.
+	 *
+	 * @return	The number of written values.
+	 */
+	uint32_t getGeneration() const {
+		return _generation.load(std::memory_order_acquire);
+	}
+};
+
+} /* namespace utils */
+
+#endif /* LIB_UTILS_INCLUDE_SEQLOCK_H_ */
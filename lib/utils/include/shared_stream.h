@@ -0,0 +1,194 @@
+/*
+ * shared_stream.h
+ *
+ * This file contains a stream that is produced once, and read by any number of readers at their own pace.
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_UTILS_INCLUDE_SHARED_STREAM_H_
+#define LIB_UTILS_INCLUDE_SHARED_STREAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace utils {
+
+/**
+ * A stream of bytes that is pulled from its source once, and read by any number of readers.
+ *
+ * The source is only read when a reader needs bytes that weren't produced yet.
+ * Bytes are kept until every reader read them.
+ * The beginning of the stream is kept until more than the retain limit was produced,
+ * so readers can join while nothing was dropped yet.
+ * Once the retain limit is exceeded no more readers can join, and the buffer only spans
+ * the bytes between the slowest and the fastest reader.
+ *
+ * This class is **NOT** thread safe, all readers have to be used by the same task.
+ */
+class SharedStream {
+public:
+	/**
+	 * A function writing the next part of the stream to the given buffer.
+	 * Has to fill the entire buffer, unless the end of the stream was reached.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The number of bytes to write.
+	 * @return	The number of bytes written.
+	 */
+	typedef std::function<size_t(uint8_t *buffer, const size_t max_len)> source_function;
+
+	/**
+	 * A single reader of a shared stream.
+	 * Keeps the stream alive, and leaves it when destroyed.
+	 */
+	class Reader {
+	private:
+		/**
+		 * The stream this reader reads from.
+		 */
+		const std::shared_ptr<SharedStream> _stream;
+
+		/**
+		 * The index of the position of this reader in the stream.
+		 */
+		const size_t _index;
+	public:
+		/**
+		 * Creates a new reader starting at the beginning of the given stream.
+		 * The stream has to be joinable.
+		 *
+		 * @param stream	The stream to read from.
+		 */
+		explicit Reader(const std::shared_ptr<SharedStream> &stream);
+
+		Reader(const Reader &other) = delete;
+
+		Reader& operator=(const Reader &other) = delete;
+
+		/**
+		 * Leaves the stream, so the bytes this reader didn't read yet can be dropped.
+		 */
+		~Reader();
+
+		/**
+		 * Copies the next bytes of the stream to the given buffer.
+		 *
+		 * @param buffer	The buffer to write to.
+		 * @param max_len	The max number of bytes to write.
+		 * @return	The number of bytes written. Zero once the end of the stream was reached.
+		 */
+		size_t read(uint8_t *buffer, const size_t max_len);
+
+		/**
+		 * Checks whether this reader read the entire stream.
+		 *
+		 * @return	True if there is nothing left to read.
+		 */
+		bool done() const;
+	};
+private:
+	/**
+	 * The source producing the stream.
+	 */
+	const source_function _source;
+
+	/**
+	 * The number of bytes to produce before the beginning of the stream can be dropped.
+	 */
+	const size_t _retain;
+
+	/**
+	 * The bytes that were produced, but not yet read by every reader.
+	 */
+	std::vector<uint8_t> _buffer;
+
+	/**
+	 * The position in the stream of the first byte in the buffer.
+	 */
+	size_t _base = 0;
+
+	/**
+	 * The position in the stream of each reader, or SIZE_MAX for positions that aren't used by a reader.
+	 */
+	std::vector<size_t> _positions;
+
+	/**
+	 * Whether the source reached the end of the stream.
+	 */
+	bool _done = false;
+
+	/**
+	 * Whether new readers can still join this stream.
+	 */
+	bool _joinable = true;
+
+	/**
+	 * Adds a reader at the start of the stream.
+	 *
+	 * @return	The index of the position of the new reader.
+	 */
+	size_t join();
+
+	/**
+	 * Removes the reader with the given position index.
+	 *
+	 * @param index	The index of the position of the reader.
+	 */
+	void leave(const size_t index);
+
+	/**
+	 * Copies the next bytes for the reader with the given position index.
+	 * Produces more of the stream if required.
+	 *
+	 * @param index		The index of the position of the reader.
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The max number of bytes to write.
+	 * @return	The number of bytes written.
+	 */
+	size_t read(const size_t index, uint8_t *buffer, const size_t max_len);
+
+	/**
+	 * Drops the bytes every reader already read.
+	 * Does nothing while the stream is joinable.
+	 */
+	void trim();
+public:
+	/**
+	 * Creates a new shared stream reading from the given source.
+	 *
+	 * @param source	The function producing the stream.
+	 * @param retain	The number of bytes to produce before the beginning of the stream can be dropped.
+	 * 					Readers can only join until this is exceeded.
+	 */
+	SharedStream(const source_function source, const size_t retain);
+
+	SharedStream(const SharedStream &other) = delete;
+
+	SharedStream& operator=(const SharedStream &other) = delete;
+
+	/**
+	 * Checks whether a new reader can still start at the beginning of this stream.
+	 *
+	 * @return	True if no part of the stream was dropped yet.
+	 */
+	bool joinable() const;
+
+	/**
+	 * Gets the number of bytes currently kept for the readers.
+	 *
+	 * @return	The size of the buffer.
+	 */
+	size_t getBufferedSize() const;
+};
+
+} /* namespace utils */
+
+#endif /* LIB_UTILS_INCLUDE_SHARED_STREAM_H_ */
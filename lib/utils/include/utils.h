@@ -14,6 +14,7 @@
 #define SRC_UTILS_H_
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace utils {
@@ -142,6 +143,85 @@ namespace utils {
  */
 float celsiusToFahrenheit(const float celsius);
 
+/**
+ * The fixed point value representing an unknown measurement, like NAN does for floats.
+ */
+constexpr int32_t FIXED_UNKNOWN = INT32_MIN;
+
+/**
+ * The size of a buffer that is always large enough for the output of `centi_to_chars`.
+ */
+constexpr size_t CENTI_CHARS_BUFFER_SIZE = 13;
+
+/**
+ * Converts the given temperature from hundredths of a degree celsius to hundredths of a degree fahrenheit.
+ * Rounds to the nearest hundredth, with ties rounded away from zero.
+ *
+ * @param centi_celsius	The temperature to convert in hundredths of a degree celsius.
+ * @return	The converted temperature, or FIXED_UNKNOWN if the given temperature is unknown.
+ */
+int32_t centiCelsiusToFahrenheit(const int32_t centi_celsius);
+
+/**
+ * Converts a binary fixed point number to hundredths.
+ * Rounds to the nearest hundredth, with ties rounded away from zero.
+ *
+ * For example a raw DS18B20 temperature in 1/16 °C has 4 fraction bits.
+ *
+ * @param value			The binary fixed point number to convert.
+ * @param fraction_bits	The number of bits after the binary point. At most 24.
+ * @return	The value in hundredths.
+ */
+int32_t binaryToCenti(const int32_t value, const uint8_t fraction_bits);
+
+/**
+ * Converts the given floating point number to hundredths.
+ * Meant for values from libraries that only return floats.
+ *
+ * @param value	The floating point number to convert.
+ * @return	The rounded value in hundredths, or FIXED_UNKNOWN if the value is NAN or out of range.
+ */
+int32_t floatToCenti(const float value);
+
+/**
+ * Converts the given number of hundredths to a floating point number.
+ * Meant for interfaces that require floats.
+ *
+ * @param centi	The value in hundredths.
+ * @return	The value as a float, or NAN if it is FIXED_UNKNOWN.
+ */
+float centiToFloat(const int32_t centi);
+
+/**
+ * Writes the given number of hundredths to a buffer as a decimal number.
+ *
+ * Writes "Unknown" if the value is FIXED_UNKNOWN.
+ * With trimmed zeros, values from 0 to 1000 are written exactly like `float_to_string` would.
+ * Without, the output matches printf with "%.2f" for two decimal digits.
+ *
+ * Output that doesn't fit into the buffer is truncated, but always null terminated.
+ *
+ * @param buffer			The buffer to write to.
+ * @param max_len			The size of the buffer, including the null terminator.
+ * @param centi				The value to write in hundredths.
+ * @param decimal_digits	The number of digits after the decimal dot to round to. At most 2.
+ * @param trim_zeros		Whether to remove trailing zeros after the decimal dot, and the dot itself if nothing is left.
+ * @return	The number of characters written, excluding the null terminator.
+ */
+size_t centi_to_chars(char *buffer, const size_t max_len, const int32_t centi,
+		const uint8_t decimal_digits, const bool trim_zeros);
+
+/**
+ * Converts the given number of hundredths to a string, without trailing zeros.
+ *
+ * Returns "Unknown" if the value is FIXED_UNKNOWN.
+ *
+ * @param centi				The value to convert in hundredths.
+ * @param decimal_digits	The number of digits after the decimal dot to round to. At most 2.
+ * @return	The newly created string.
+ */
+std::string centi_to_string(const int32_t centi, const uint8_t decimal_digits);
+
 /**
  * Converts the given floating point number to a string.
  *
@@ -157,6 +237,49 @@ float celsiusToFahrenheit(const float celsius);
 std::string float_to_string(const float measurement,
 		const uint8_t decimal_digits);
 
+/**
+ * The size of a buffer that is always large enough for the output of `float_to_chars` with up to 10 decimal digits.
+ */
+constexpr size_t FLOAT_CHARS_BUFFER_SIZE = 24;
+
+/**
+ * The size of a buffer that is always large enough for the output of `timespan_to_chars`.
+ */
+constexpr size_t TIMESPAN_CHARS_BUFFER_SIZE = 13;
+
+/**
+ * Writes the given floating point number to a buffer.
+ *
+ * Writes exactly the same string as `float_to_string`, but doesn't allocate any memory.
+ * Uses only integer math, unless the number is too small or too large to be scaled using 64 bit integers.
+ * In that case, or if more than 18 significant digits are required, it falls back to snprintf.
+ *
+ * Output that doesn't fit into the buffer is truncated, but always null terminated.
+ *
+ * @param buffer			The buffer to write to.
+ * @param max_len			The size of the buffer, including the null terminator.
+ * @param measurement		The floating point number to write.
+ * @param decimal_digits	The number of digits after the decimal dot to round to.
+ * @return	The number of characters written, excluding the null terminator.
+ */
+size_t float_to_chars(char *buffer, const size_t max_len,
+		const float measurement, const uint8_t decimal_digits);
+
+/**
+ * Writes the given timespan to a buffer.
+ *
+ * Writes exactly the same string as `timespan_to_string`, but doesn't allocate any memory.
+ *
+ * Output that doesn't fit into the buffer is truncated, but always null terminated.
+ *
+ * @param buffer	The buffer to write to.
+ * @param max_len	The size of the buffer, including the null terminator.
+ * @param time_ms	The timespan to write.
+ * @return	The number of characters written, excluding the null terminator.
+ */
+size_t timespan_to_chars(char *buffer, const size_t max_len,
+		const int64_t time_ms);
+
 /**
  * Converts the given timespan to a string.
  *
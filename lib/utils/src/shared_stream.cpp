@@ -0,0 +1,109 @@
+/*
+ * shared_stream.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "shared_stream.h"
+#include <algorithm>
+#include <cstring>
+
+/**
+ * The marker for a reader position that isn't used by any reader.
+ */
+static const size_t UNUSED = SIZE_MAX;
+
+utils::SharedStream::Reader::Reader(const std::shared_ptr<SharedStream> &stream) :
+		_stream(stream), _index(stream->join()) {
+
+}
+
+utils::SharedStream::Reader::~Reader() {
+	_stream->leave(_index);
+}
+
+size_t utils::SharedStream::Reader::read(uint8_t *buffer,
+		const size_t max_len) {
+	return _stream->read(_index, buffer, max_len);
+}
+
+bool utils::SharedStream::Reader::done() const {
+	return _stream->_done
+			&& _stream->_positions[_index]
+					>= _stream->_base + _stream->_buffer.size();
+}
+
+utils::SharedStream::SharedStream(const source_function source,
+		const size_t retain) :
+		_source(source), _retain(retain) {
+
+}
+
+size_t utils::SharedStream::join() {
+	std::vector<size_t>::iterator it = std::find(_positions.begin(),
+			_positions.end(), UNUSED);
+	if (it != _positions.end()) {
+		*it = 0;
+		return it - _positions.begin();
+	}
+
+	_positions.push_back(0);
+	return _positions.size() - 1;
+}
+
+void utils::SharedStream::leave(const size_t index) {
+	_positions[index] = UNUSED;
+}
+
+size_t utils::SharedStream::read(const size_t index, uint8_t *buffer,
+		const size_t max_len) {
+	size_t &position = _positions[index];
+	const size_t end = position + max_len;
+	if (!_done && _base + _buffer.size() < end) {
+		if (_buffer.size() >= _retain) {
+			_joinable = false;
+		}
+		trim();
+
+		const size_t old_size = _buffer.size();
+		const size_t missing = end - _base - old_size;
+		_buffer.resize(old_size + missing);
+		const size_t len = _source(_buffer.data() + old_size, missing);
+		_buffer.resize(old_size + len);
+		if (len < missing) {
+			_done = true;
+		}
+	}
+
+	const size_t len = std::min(max_len, _base + _buffer.size() - position);
+	memcpy(buffer, _buffer.data() + (position - _base), len);
+	position += len;
+	return len;
+}
+
+void utils::SharedStream::trim() {
+	if (_joinable) {
+		return;
+	}
+
+	const size_t min_position = *std::min_element(_positions.begin(),
+			_positions.end());
+	if (min_position == UNUSED || min_position <= _base) {
+		return;
+	}
+
+	_buffer.erase(_buffer.begin(), _buffer.begin() + (min_position - _base));
+	_base = min_position;
+}
+
+bool utils::SharedStream::joinable() const {
+	return _joinable;
+}
+
+size_t utils::SharedStream::getBufferedSize() const {
+	return _buffer.size();
+}
@@ -9,12 +9,209 @@
  */
 
 #include "utils.h"
-#include <iomanip>
+#include <algorithm>
 #include <cmath>
-#include <sstream>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 
 namespace utils {
 
+/**
+ * The powers of ten that fit into a 64 bit unsigned integer.
+ */
+static constexpr uint64_t POWERS_OF_TEN[] = { 1ull, 10ull, 100ull, 1000ull,
+		10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull,
+		1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+		10000000000000ull, 100000000000000ull, 1000000000000000ull,
+		10000000000000000ull, 100000000000000000ull, 1000000000000000000ull,
+		10000000000000000000ull };
+
+/**
+ * The max number of significant digits written using integer math.
+ */
+static constexpr uint8_t MAX_SIGNIFICANT_DIGITS = 18;
+
+/**
+ * The bits of the float 10.0f.
+ */
+static constexpr uint32_t FLOAT_BITS_10 = 0x41200000;
+
+/**
+ * The bits of the float 100.0f.
+ */
+static constexpr uint32_t FLOAT_BITS_100 = 0x42C80000;
+
+/**
+ * Copies a string into a buffer, truncating it if necessary.
+ *
+ * @param buffer	The buffer to write to.
+ * @param max_len	The size of the buffer, including the null terminator.
+ * @param str		The string to copy.
+ * @param len		The length of the string to copy.
+ * @return	The number of characters written, excluding the null terminator.
+ */
+static size_t copy_chars(char *buffer, const size_t max_len, const char *str,
+		size_t len) {
+	if (max_len == 0) {
+		return 0;
+	} else if (len >= max_len) {
+		len = max_len - 1;
+	}
+	memcpy(buffer, str, len);
+	buffer[len] = 0;
+	return len;
+}
+
+/**
+ * Calculates `mantissa * 2^exponent * 10^scale`, rounded to the nearest integer, with ties rounded to even.
+ * This is the same rounding printf uses.
+ *
+ * @param mantissa	The mantissa of the float to scale.
+ * @param exponent	The binary exponent of the float to scale.
+ * @param scale		The power of ten to multiply the float with.
+ * @param result	Set to the rounded result.
+ * @return	False if the calculation doesn't fit into 64 bit integers.
+ */
+static bool scale_float(const uint32_t mantissa, const int16_t exponent,
+		const int16_t scale, uint64_t &result) {
+	uint64_t numerator = mantissa;
+	uint64_t denominator = 1;
+	if (exponent >= 0) {
+		if (exponent > 39) {
+			return false;
+		}
+		numerator <<= exponent;
+	} else {
+		if (exponent < -63) {
+			return false;
+		}
+		denominator <<= -exponent;
+	}
+
+	if (scale >= 0) {
+		if (scale > 19 || numerator > UINT64_MAX / POWERS_OF_TEN[scale]) {
+			return false;
+		}
+		numerator *= POWERS_OF_TEN[scale];
+	} else {
+		if (scale < -19 || denominator > UINT64_MAX / POWERS_OF_TEN[-scale]) {
+			return false;
+		}
+		denominator *= POWERS_OF_TEN[-scale];
+	}
+
+	result = numerator / denominator;
+	const uint64_t remainder = numerator % denominator;
+	if (remainder > denominator - remainder
+			|| (remainder == denominator - remainder && (result & 1))) {
+		result++;
+	}
+	return true;
+}
+
+/**
+ * Writes a number like printf with the "%.*g" format, using only integer math.
+ *
+ * @param buffer	The buffer to write to. Has to be at least 32 bytes long.
+ * @param bits		The bits of the float to write. Has to be finite.
+ * @param precision	The number of significant digits to write.
+ * @return	The number of characters written, or zero if the number can't be written using 64 bit integers.
+ */
+static size_t format_general(char *buffer, const uint32_t bits,
+		const uint8_t precision) {
+	if (precision == 0 || precision > MAX_SIGNIFICANT_DIGITS) {
+		return 0;
+	}
+
+	size_t len = 0;
+	if (bits >> 31) {
+		buffer[len++] = '-';
+	}
+
+	const uint32_t exponent_bits = (bits >> 23) & 0xFF;
+	uint32_t mantissa = bits & 0x7FFFFF;
+	if (mantissa == 0 && exponent_bits == 0) {
+		buffer[len++] = '0';
+		return len;
+	}
+
+	int16_t exponent = -149;
+	if (exponent_bits != 0) {
+		mantissa |= 0x800000;
+		exponent = exponent_bits - 150;
+	}
+
+	// Estimate the decimal exponent as floor(log10(2) * binary exponent), and correct it below.
+	const int32_t binary_exponent = exponent + get_msb(mantissa);
+	int16_t decimal_exponent = (binary_exponent * 1233) >> 12;
+	uint64_t digits = 0;
+	while (true) {
+		if (!scale_float(mantissa, exponent,
+				precision - 1 - decimal_exponent, digits)) {
+			return 0;
+		}
+
+		if (digits >= POWERS_OF_TEN[precision]) {
+			decimal_exponent++;
+		} else if (digits < POWERS_OF_TEN[precision - 1]) {
+			decimal_exponent--;
+		} else {
+			break;
+		}
+	}
+
+	char digit_chars[MAX_SIGNIFICANT_DIGITS];
+	for (uint8_t i = precision; i > 0; i--) {
+		digit_chars[i - 1] = '0' + digits % 10;
+		digits /= 10;
+	}
+
+	// Trailing zeros are removed, like printf does without the '#' flag.
+	uint8_t digit_count = precision;
+	while (digit_count > 1 && digit_chars[digit_count - 1] == '0') {
+		digit_count--;
+	}
+
+	if (decimal_exponent < -4 || decimal_exponent >= precision) {
+		buffer[len++] = digit_chars[0];
+		if (digit_count > 1) {
+			buffer[len++] = '.';
+			memcpy(buffer + len, digit_chars + 1, digit_count - 1);
+			len += digit_count - 1;
+		}
+		buffer[len++] = 'e';
+		buffer[len++] = decimal_exponent < 0 ? '-' : '+';
+		const uint16_t abs_exponent =
+				decimal_exponent < 0 ? -decimal_exponent : decimal_exponent;
+		if (abs_exponent >= 100) {
+			buffer[len++] = '0' + abs_exponent / 100;
+		}
+		buffer[len++] = '0' + abs_exponent / 10 % 10;
+		buffer[len++] = '0' + abs_exponent % 10;
+	} else if (decimal_exponent < 0) {
+		buffer[len++] = '0';
+		buffer[len++] = '.';
+		for (int16_t i = -1; i > decimal_exponent; i--) {
+			buffer[len++] = '0';
+		}
+		memcpy(buffer + len, digit_chars, digit_count);
+		len += digit_count;
+	} else {
+		const uint8_t integer_digits = decimal_exponent + 1;
+		// The integer part is never affected by removing trailing zeros, since those are after the dot.
+		memcpy(buffer + len, digit_chars, integer_digits);
+		len += integer_digits;
+		if (digit_count > integer_digits) {
+			buffer[len++] = '.';
+			memcpy(buffer + len, digit_chars + integer_digits,
+					digit_count - integer_digits);
+			len += digit_count - integer_digits;
+		}
+	}
+	return len;
+}
+
 uint8_t get_msb(const uint32_t number) {
 	uint8_t idx = 0;
 	while (number >> (idx + 1)) {
@@ -27,42 +224,165 @@ float celsiusToFahrenheit(const float celsius) {
 	return celsius * 1.8 + 32;
 }
 
-std::string float_to_string(const float measurement,
-		const uint8_t decimal_digits) {
-	if (std::isnan(measurement)) {
-		return "Unknown";
+int32_t centiCelsiusToFahrenheit(const int32_t centi_celsius) {
+	if (centi_celsius == FIXED_UNKNOWN) {
+		return FIXED_UNKNOWN;
+	}
+
+	// A multiple of nine divided by five can never be exactly half way between two integers.
+	const int64_t scaled = (int64_t) centi_celsius * 9;
+	return (scaled + (scaled < 0 ? -2 : 2)) / 5 + 3200;
+}
+
+int32_t binaryToCenti(const int32_t value, const uint8_t fraction_bits) {
+	if (fraction_bits == 0) {
+		return value * 100;
+	}
+
+	const int64_t scaled = (int64_t) value * 100;
+	const int64_t half = (int64_t) 1 << (fraction_bits - 1);
+	return (scaled + (scaled < 0 ? -half : half)) / (half * 2);
+}
+
+int32_t floatToCenti(const float value) {
+	// Also false for NAN.
+	if (!(std::fabs(value) < 21474836.0f)) {
+		return FIXED_UNKNOWN;
+	}
+	return lroundf(value * 100);
+}
+
+float centiToFloat(const int32_t centi) {
+	if (centi == FIXED_UNKNOWN) {
+		return NAN;
+	}
+	return centi / 100.0f;
+}
+
+size_t centi_to_chars(char *buffer, const size_t max_len, const int32_t centi,
+		const uint8_t decimal_digits, const bool trim_zeros) {
+	if (centi == FIXED_UNKNOWN) {
+		return copy_chars(buffer, max_len, "Unknown", 7);
+	}
+
+	const uint8_t digits = std::min<uint8_t>(decimal_digits, 2);
+	uint32_t magnitude = centi < 0 ? -(uint32_t) centi : centi;
+	if (digits < 2) {
+		const uint32_t divisor = POWERS_OF_TEN[2 - digits];
+		magnitude = (magnitude + divisor / 2) / divisor;
+	}
+	// Values rounded to zero are written without a sign.
+	const bool negative = centi < 0 && magnitude > 0;
+
+	// Written from the end, since the number of integer digits isn't known yet.
+	char chars[CENTI_CHARS_BUFFER_SIZE];
+	char *pos = chars + sizeof(chars);
+	bool significant = !trim_zeros;
+	for (uint8_t i = 0; i < digits; i++) {
+		const char digit = '0' + magnitude % 10;
+		magnitude /= 10;
+		if (significant || digit != '0') {
+			*--pos = digit;
+			significant = true;
+		}
+	}
+	if (significant) {
+		*--pos = '.';
+	}
+
+	do {
+		*--pos = '0' + magnitude % 10;
+		magnitude /= 10;
+	} while (magnitude > 0);
+
+	if (negative) {
+		*--pos = '-';
+	}
+	return copy_chars(buffer, max_len, pos, chars + sizeof(chars) - pos);
+}
+
+std::string centi_to_string(const int32_t centi, const uint8_t decimal_digits) {
+	char buffer[CENTI_CHARS_BUFFER_SIZE];
+	const size_t len = centi_to_chars(buffer, sizeof(buffer), centi,
+			decimal_digits, true);
+	return std::string(buffer, len);
+}
+
+size_t float_to_chars(char *buffer, const size_t max_len,
+		const float measurement, const uint8_t decimal_digits) {
+	uint32_t bits;
+	memcpy(&bits, &measurement, sizeof(bits));
+	const bool negative = bits >> 31;
+	if (((bits >> 23) & 0xFF) == 0xFF) {
+		if (bits & 0x7FFFFF) {
+			return copy_chars(buffer, max_len, "Unknown", 7);
+		}
+		return copy_chars(buffer, max_len, negative ? "-inf" : "inf",
+				negative ? 4 : 3);
 	}
 
 	uint8_t precision = decimal_digits + 1;
-	if (measurement >= 10) {
+	if (!negative && bits >= FLOAT_BITS_10) {
 		precision++;
 	}
-	if (measurement >= 100) {
+	if (!negative && bits >= FLOAT_BITS_100) {
 		precision++;
 	}
 
-	// TODO check whether snprintf is significantly faster.
-	std::ostringstream converter;
-	converter << std::setprecision(precision) << measurement;
-	return converter.str();
+	char chars[32];
+	const size_t len = format_general(chars, bits, precision);
+	if (len == 0) {
+		const int written = snprintf(buffer, max_len, "%.*g", precision,
+				(double) measurement);
+		if (written < 0 || max_len == 0) {
+			return 0;
+		}
+		return std::min((size_t) written, max_len - 1);
+	}
+	return copy_chars(buffer, max_len, chars, len);
 }
 
-std::string timespan_to_string(const int64_t time_ms) {
+std::string float_to_string(const float measurement,
+		const uint8_t decimal_digits) {
+	char buffer[FLOAT_CHARS_BUFFER_SIZE];
+	const size_t len = float_to_chars(buffer, sizeof(buffer), measurement,
+			decimal_digits);
+	if (len < sizeof(buffer) - 1) {
+		return std::string(buffer, len);
+	}
+
+	// Only reachable with more than 10 decimal digits.
+	std::string result(decimal_digits + FLOAT_CHARS_BUFFER_SIZE, '\0');
+	result.resize(
+			float_to_chars(&result[0], result.size(), measurement,
+					decimal_digits));
+	return result;
+}
+
+size_t timespan_to_chars(char *buffer, const size_t max_len,
+		const int64_t time_ms) {
 	if (time_ms < 0) {
-		return "Unknown";
-	}
-
-	// TODO check whether snprintf is significantly faster.
-	std::ostringstream stream;
-	stream << std::internal << std::setfill('0') << std::setw(2);
-	stream << time_ms / 3600000 % 24 << ':';
-	stream << std::internal << std::setfill('0') << std::setw(2);
-	stream << time_ms / 60000 % 60 << ':';
-	stream << std::internal << std::setfill('0') << std::setw(2);
-	stream << time_ms / 1000 % 60 << '.';
-	stream << std::internal << std::setfill('0') << std::setw(3);
-	stream << time_ms % 1000;
-	return stream.str();
+		return copy_chars(buffer, max_len, "Unknown", 7);
+	}
+
+	// Only the time of day is written, so everything else can use 32 bit math.
+	const uint32_t day_ms = time_ms % 86400000;
+	const uint8_t hours = day_ms / 3600000;
+	const uint8_t minutes = day_ms / 60000 % 60;
+	const uint8_t seconds = day_ms / 1000 % 60;
+	const uint16_t millis = day_ms % 1000;
+	const char chars[] = { char('0' + hours / 10), char('0' + hours % 10), ':',
+			char('0' + minutes / 10), char('0' + minutes % 10), ':', char(
+					'0' + seconds / 10), char('0' + seconds % 10), '.', char(
+					'0' + millis / 100), char('0' + millis / 10 % 10), char(
+					'0' + millis % 10) };
+	return copy_chars(buffer, max_len, chars, sizeof(chars));
+}
+
+std::string timespan_to_string(const int64_t time_ms) {
+	char buffer[TIMESPAN_CHARS_BUFFER_SIZE];
+	const size_t len = timespan_to_chars(buffer, sizeof(buffer), time_ms);
+	return std::string(buffer, len);
 }
 
 } /* namespace utils */
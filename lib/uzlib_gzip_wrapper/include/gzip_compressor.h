@@ -0,0 +1,220 @@
+/*
+ * gzip_compressor.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef LIB_UZLIB_GZIP_WRAPPER_INCLUDE_GZIP_COMPRESSOR_H_
+#define LIB_UZLIB_GZIP_WRAPPER_INCLUDE_GZIP_COMPRESSOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+namespace gzip {
+
+/**
+ * A pull based streaming gzip compressor with a fixed memory use.
+ *
+ * The uncompressed data is read from a callback as required, and the compressed data is written to the buffer given to read.
+ * Uses LZ77 with a single entry hash table, and the fixed deflate huffman codes, all in a single deflate block.
+ *
+ * Back references are limited to WINDOW_SIZE bytes, so the output can be decompressed with a window size of -10.
+ * The input buffer and the hash table are part of this object, so it uses a bit more than 4KiB of memory.
+ */
+class gzip_compressor {
+public:
+	/**
+	 * The max distance of a back reference, in bytes.
+	 */
+	static constexpr uint16_t WINDOW_SIZE = 1024;
+
+	/**
+	 * The number of bits of the hash of three bytes used to find back references.
+	 */
+	static constexpr uint8_t HASH_BITS = 10;
+
+	/**
+	 * A function writing the next part of the uncompressed data to the given buffer.
+	 * Returns the number of bytes written, or zero once all data was written.
+	 */
+	typedef std::function<size_t(uint8_t *buffer, const size_t max_len)> source_reader;
+private:
+	/**
+	 * The size of the input buffer.
+	 * Contains the window of already compressed data, and the lookahead to find matches in.
+	 */
+	static constexpr size_t BUFFER_SIZE = WINDOW_SIZE * 2;
+
+	/**
+	 * The part of the gzip file currently being written.
+	 */
+	enum stage : uint8_t {
+		HEADER, DATA, TRAILER, DONE
+	};
+
+	/**
+	 * The function to read the uncompressed data from.
+	 */
+	const source_reader source;
+
+	/**
+	 * The buffer for the uncompressed data.
+	 */
+	uint8_t buffer[BUFFER_SIZE];
+
+	/**
+	 * The last buffer index plus one at which each hash of three bytes was found.
+	 * Zero means the hash wasn't found in the window.
+	 */
+	uint16_t hash_table[1 << HASH_BITS];
+
+	/**
+	 * The buffer index of the next byte to compress.
+	 */
+	size_t pos = 0;
+
+	/**
+	 * The number of bytes in the input buffer.
+	 */
+	size_t end = 0;
+
+	/**
+	 * Whether the source returned zero, meaning all uncompressed data is in the buffer.
+	 */
+	bool source_done = false;
+
+	/**
+	 * The compressed bits that weren't written to the output yet, starting at the lowest bit.
+	 */
+	uint64_t bits = 0;
+
+	/**
+	 * The number of compressed bits that weren't written to the output yet.
+	 */
+	uint8_t bit_count = 0;
+
+	/**
+	 * The part of the gzip file currently being written.
+	 */
+	stage current_stage = HEADER;
+
+	/**
+	 * The index of the next header or trailer byte to write.
+	 */
+	uint8_t stage_index = 0;
+
+	/**
+	 * The crc32 checksum of the uncompressed data read so far.
+	 */
+	uint32_t crc = ~(uint32_t) 0;
+
+	/**
+	 * The number of uncompressed bytes read from the source.
+	 */
+	uint32_t uncompressed = 0;
+
+	/**
+	 * The number of compressed bytes written to the output.
+	 */
+	uint32_t compressed = 0;
+
+	/**
+	 * Reads from the source until there are enough bytes after the current position to find the longest possible match,
+	 * or the source is done.
+	 */
+	void fill();
+
+	/**
+	 * Appends the given bits to the compressed bits, starting at the lowest bit.
+	 *
+	 * @param value	The bits to append.
+	 * @param count	The number of bits to append.
+	 */
+	void writeBits(const uint32_t value, const uint8_t count);
+
+	/**
+	 * Appends the given huffman code, which starts at the highest bit.
+	 *
+	 * @param code	The huffman code to append.
+	 * @param count	The length of the huffman code in bits.
+	 */
+	void writeCode(const uint16_t code, const uint8_t count);
+
+	/**
+	 * Appends a literal byte.
+	 *
+	 * @param literal	The byte to append.
+	 */
+	void writeLiteral(const uint8_t literal);
+
+	/**
+	 * Appends a back reference.
+	 *
+	 * @param length	The number of bytes to copy. From 3 to 258.
+	 * @param distance	The distance to copy from. From 1 to WINDOW_SIZE.
+	 */
+	void writeMatch(const uint16_t length, const uint16_t distance);
+
+	/**
+	 * Compresses the next literal or back reference, or finishes the deflate block.
+	 */
+	void compressNext();
+
+	/**
+	 * Appends the next part of the gzip file to the compressed bits.
+	 * Appends at most 32 bits.
+	 *
+	 * @return	False if the gzip file is complete.
+	 */
+	bool writeNext();
+public:
+	/**
+	 * Creates a new gzip compressor for the data of the given source.
+	 *
+	 * @param source	The function to read the uncompressed data from.
+	 */
+	gzip_compressor(const source_reader source);
+
+	gzip_compressor(const gzip_compressor &other) = delete;
+
+	gzip_compressor& operator=(const gzip_compressor &other) = delete;
+
+	/**
+	 * Writes the next part of the gzip file to the given buffer.
+	 *
+	 * @param buf		The buffer to write to.
+	 * @param max_len	The max number of bytes to write.
+	 * @return	The number of bytes written. Zero once the gzip file is complete.
+	 */
+	size_t read(uint8_t *buf, const size_t max_len);
+
+	/**
+	 * Checks whether the gzip file was written completely.
+	 *
+	 * @return	Whether the compression is done.
+	 */
+	bool done() const;
+
+	/**
+	 * Gets the number of uncompressed bytes read from the source so far.
+	 *
+	 * @return	The number of uncompressed bytes.
+	 */
+	uint32_t getUncompressedSize() const;
+
+	/**
+	 * Gets the number of compressed bytes written so far, including the gzip header and trailer.
+	 *
+	 * @return	The number of compressed bytes.
+	 */
+	uint32_t getCompressedSize() const;
+};
+
+} /* namespace gzip */
+
+#endif /* LIB_UZLIB_GZIP_WRAPPER_INCLUDE_GZIP_COMPRESSOR_H_ */
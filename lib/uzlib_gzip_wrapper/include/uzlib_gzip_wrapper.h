@@ -21,6 +21,21 @@ namespace gzip {
  */
 void init();
 
+/**
+ * Calculates the crc32 checksum of two consecutive blocks of data, from their individual checksums.
+ *
+ * This allows calculating the checksum of data that is partially only available in compressed form,
+ * if the checksum of that part was calculated in advance.
+ *
+ * The checksums are expected to be finalized checksums, like the ones stored in gzip files.
+ *
+ * @param crc1	The crc32 checksum of the first block of data.
+ * @param crc2	The crc32 checksum of the second block of data.
+ * @param len2	The length of the second block of data in bytes.
+ * @return	The crc32 checksum of both blocks of data combined.
+ */
+uint32_t crc32_combine(const uint32_t crc1, const uint32_t crc2, size_t len2);
+
 /**
  * A wrapper to help with storing the data associated with decompressing a gzip file using uzlib.
  * Can currently only handle the entire compressed file being accessible as a single pointer block.
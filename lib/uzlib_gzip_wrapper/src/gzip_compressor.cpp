@@ -0,0 +1,277 @@
+/*
+ * gzip_compressor.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "gzip_compressor.h"
+#include <uzlib.h>
+#include <cstring>
+
+namespace gzip {
+
+/**
+ * The min length of a back reference.
+ */
+static constexpr uint16_t MIN_MATCH = 3;
+
+/**
+ * The max length of a back reference.
+ */
+static constexpr uint16_t MAX_MATCH = 258;
+
+/**
+ * The number of bytes after the current position to keep in the buffer, unless the source is done.
+ * Enough to find the longest match, and to hash every position in it.
+ */
+static constexpr uint16_t LOOKAHEAD = MAX_MATCH + MIN_MATCH;
+
+/**
+ * The gzip header.
+ * Deflate compression, no flags, no modification time, and an unknown OS.
+ */
+static constexpr uint8_t GZIP_HEADER[] = { 0x1F, 0x8B, 0x08, 0x00, 0x00, 0x00,
+		0x00, 0x00, 0x00, 0xFF };
+
+/**
+ * The length of the gzip header.
+ */
+static constexpr uint8_t GZIP_HEADER_LEN = sizeof(GZIP_HEADER);
+
+/**
+ * The length of the gzip trailer, containing the crc32 checksum and the uncompressed size.
+ */
+static constexpr uint8_t GZIP_TRAILER_LEN = 8;
+
+/**
+ * The number of deflate length codes.
+ */
+static constexpr uint8_t LENGTH_CODES = 29;
+
+/**
+ * The number of deflate distance codes up to the WINDOW_SIZE.
+ */
+static constexpr uint8_t DISTANCE_CODES = 20;
+
+/**
+ * The smallest length of each deflate length code, starting at code 257.
+ */
+static constexpr uint16_t LENGTH_BASES[LENGTH_CODES] = { 3, 4, 5, 6, 7, 8,
+		9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115,
+		131, 163, 195, 227, 258 };
+
+/**
+ * The number of extra bits of each deflate length code, starting at code 257.
+ */
+static constexpr uint8_t LENGTH_EXTRA_BITS[LENGTH_CODES] = { 0, 0, 0, 0, 0,
+		0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+
+/**
+ * The smallest distance of each deflate distance code, up to the WINDOW_SIZE.
+ */
+static constexpr uint16_t DISTANCE_BASES[DISTANCE_CODES] = { 1, 2, 3, 4, 5,
+		7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769 };
+
+/**
+ * The number of extra bits of each deflate distance code, up to the WINDOW_SIZE.
+ */
+static constexpr uint8_t DISTANCE_EXTRA_BITS[DISTANCE_CODES] = { 0, 0, 0,
+		0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8 };
+
+static_assert(gzip_compressor::WINDOW_SIZE <= 1024,
+		"The distance codes only go up to 1024.");
+static_assert(gzip_compressor::WINDOW_SIZE > LOOKAHEAD,
+		"The window has to be larger than the lookahead.");
+
+/**
+ * Calculates the hash of the three bytes starting at the given pointer.
+ *
+ * @param data	A pointer to the first byte to hash.
+ * @return	The hash of the three bytes.
+ */
+static uint16_t hash(const uint8_t *data) {
+	const uint32_t value = data[0] | data[1] << 8 | data[2] << 16;
+	return (value * 0x1E35A7BD) >> (32 - gzip_compressor::HASH_BITS);
+}
+
+gzip_compressor::gzip_compressor(const source_reader source) :
+		source(source) {
+	memset(hash_table, 0, sizeof(hash_table));
+}
+
+size_t gzip_compressor::read(uint8_t *buf, const size_t max_len) {
+	size_t written = 0;
+	while (written < max_len) {
+		if (bit_count >= 8) {
+			buf[written++] = bits;
+			bits >>= 8;
+			bit_count -= 8;
+		} else if (!writeNext()) {
+			break;
+		}
+	}
+	compressed += written;
+	return written;
+}
+
+bool gzip_compressor::writeNext() {
+	switch (current_stage) {
+	case HEADER:
+		writeBits(GZIP_HEADER[stage_index++], 8);
+		if (stage_index == GZIP_HEADER_LEN) {
+			// A single final block using the fixed huffman codes.
+			writeBits(1, 1);
+			writeBits(1, 2);
+			current_stage = DATA;
+			stage_index = 0;
+		}
+		return true;
+	case DATA:
+		compressNext();
+		return true;
+	case TRAILER:
+		if (stage_index < 4) {
+			writeBits((~crc >> (stage_index * 8)) & 0xFF, 8);
+		} else {
+			writeBits((uncompressed >> ((stage_index - 4) * 8)) & 0xFF, 8);
+		}
+		if (++stage_index == GZIP_TRAILER_LEN) {
+			current_stage = DONE;
+		}
+		return true;
+	default:
+		return false;
+	}
+}
+
+void gzip_compressor::fill() {
+	while (!source_done && end - pos < LOOKAHEAD) {
+		if (end == BUFFER_SIZE) {
+			// Keep WINDOW_SIZE bytes before the current position for back references.
+			const size_t shift = pos - WINDOW_SIZE;
+			memmove(buffer, buffer + shift, end - shift);
+			pos -= shift;
+			end -= shift;
+			for (uint16_t &entry : hash_table) {
+				entry = entry > shift ? entry - shift : 0;
+			}
+		}
+
+		const size_t len = source(buffer + end, BUFFER_SIZE - end);
+		if (len == 0) {
+			source_done = true;
+		} else {
+			crc = uzlib_crc32(buffer + end, len, crc);
+			uncompressed += len;
+			end += len;
+		}
+	}
+}
+
+void gzip_compressor::compressNext() {
+	fill();
+	if (pos >= end) {
+		// The end of block code, followed by padding to the next byte.
+		writeCode(0, 7);
+		bit_count = (bit_count + 7) / 8 * 8;
+		current_stage = TRAILER;
+		stage_index = 0;
+		return;
+	}
+
+	uint16_t length = 0;
+	uint16_t distance = 0;
+	if (end - pos >= MIN_MATCH) {
+		const uint16_t h = hash(buffer + pos);
+		const uint16_t candidate = hash_table[h];
+		hash_table[h] = pos + 1;
+		if (candidate != 0 && pos - (candidate - 1) <= WINDOW_SIZE) {
+			const uint8_t *match = buffer + candidate - 1;
+			const size_t max_len = end - pos < MAX_MATCH ? end - pos : MAX_MATCH;
+			size_t len = 0;
+			while (len < max_len && match[len] == buffer[pos + len]) {
+				len++;
+			}
+			if (len >= MIN_MATCH) {
+				length = len;
+				distance = pos - (candidate - 1);
+			}
+		}
+	}
+
+	if (length == 0) {
+		writeLiteral(buffer[pos++]);
+		return;
+	}
+
+	writeMatch(length, distance);
+	for (size_t i = pos + 1; i < pos + length && end - i >= MIN_MATCH; i++) {
+		hash_table[hash(buffer + i)] = i + 1;
+	}
+	pos += length;
+}
+
+void gzip_compressor::writeBits(const uint32_t value, const uint8_t count) {
+	bits |= (uint64_t) value << bit_count;
+	bit_count += count;
+}
+
+void gzip_compressor::writeCode(const uint16_t code, const uint8_t count) {
+	uint16_t reversed = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		reversed |= ((code >> i) & 1) << (count - 1 - i);
+	}
+	writeBits(reversed, count);
+}
+
+void gzip_compressor::writeLiteral(const uint8_t literal) {
+	if (literal < 144) {
+		writeCode(0x30 + literal, 8);
+	} else {
+		writeCode(0x190 + literal - 144, 9);
+	}
+}
+
+void gzip_compressor::writeMatch(const uint16_t length,
+		const uint16_t distance) {
+	uint8_t length_code = 0;
+	while (length_code + 1 < LENGTH_CODES
+			&& LENGTH_BASES[length_code + 1] <= length) {
+		length_code++;
+	}
+	// Codes 257 to 279 are 7 bits long, and 280 to 287 are 8 bits long.
+	if (length_code < 23) {
+		writeCode(length_code + 1, 7);
+	} else {
+		writeCode(0xC0 + length_code - 23, 8);
+	}
+	writeBits(length - LENGTH_BASES[length_code],
+			LENGTH_EXTRA_BITS[length_code]);
+
+	uint8_t distance_code = 0;
+	while (distance_code + 1 < DISTANCE_CODES
+			&& DISTANCE_BASES[distance_code + 1] <= distance) {
+		distance_code++;
+	}
+	writeCode(distance_code, 5);
+	writeBits(distance - DISTANCE_BASES[distance_code],
+			DISTANCE_EXTRA_BITS[distance_code]);
+}
+
+bool gzip_compressor::done() const {
+	return current_stage == DONE && bit_count == 0;
+}
+
+uint32_t gzip_compressor::getUncompressedSize() const {
+	return uncompressed;
+}
+
+uint32_t gzip_compressor::getCompressedSize() const {
+	return compressed;
+}
+
+} /* namespace gzip */
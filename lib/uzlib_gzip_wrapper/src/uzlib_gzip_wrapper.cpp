@@ -17,10 +17,56 @@
 
 namespace gzip {
 
+/**
+ * The reversed crc32 polynomial, as used by gzip.
+ */
+static constexpr uint32_t CRC32_POLYNOMIAL = 0xEDB88320;
+
+/**
+ * Multiplies two polynomials modulo the crc32 polynomial.
+ *
+ * Both polynomials are in reversed bit order, meaning the highest bit represents x^0.
+ *
+ * @param a	The first polynomial to multiply. Must not be zero.
+ * @param b	The second polynomial to multiply.
+ * @return	The product of both polynomials, modulo the crc32 polynomial.
+ */
+static uint32_t multiply_mod_poly(const uint32_t a, uint32_t b) {
+	uint32_t mask = (uint32_t) 1 << 31;
+	uint32_t product = 0;
+	while (true) {
+		if (a & mask) {
+			product ^= b;
+			if ((a & (mask - 1)) == 0) {
+				break;
+			}
+		}
+		mask >>= 1;
+		b = b & 1 ? (b >> 1) ^ CRC32_POLYNOMIAL : b >> 1;
+	}
+	return product;
+}
+
 void init() {
 	uzlib_init();
 }
 
+uint32_t crc32_combine(const uint32_t crc1, const uint32_t crc2, size_t len2) {
+	// Shifting crc1 by len2 bytes means multiplying it by x^(8 * len2).
+	// x^(2^n) starting at x^8, in reversed bit order.
+	uint32_t square = (uint32_t) 1 << 23;
+	// x^0 in reversed bit order.
+	uint32_t shift = (uint32_t) 1 << 31;
+	while (len2 > 0) {
+		if (len2 & 1) {
+			shift = multiply_mod_poly(square, shift);
+		}
+		len2 >>= 1;
+		square = multiply_mod_poly(square, square);
+	}
+	return multiply_mod_poly(shift, crc1) ^ crc2;
+}
+
 uzlib_ungzip_wrapper::uzlib_ungzip_wrapper(const uint8_t *cmp_start,
 		const uint8_t *cmp_end, int8_t wsize) {
 	if (wsize > -8) {
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+
+"""A simple benchmark for the static file responses of the web server.
+
+Downloads a file from the ESP repeatedly, and reports the achieved throughput.
+If the prometheus scrape endpoint is enabled, the CPU time used per MB served is calculated from the flash response metrics.
+
+To compare the flash responses with the original progmem responses of ESPAsyncWebServer run this with
+ * ENABLE_FLASH_RESPONSES set to 0, for the progmem baseline,
+ * ENABLE_ZERO_COPY_FLASH_RESPONSES set to 0, for copying flash responses,
+ * and the default config, for zero copy flash responses.
+Use the same --record file and a different --label for each build.
+Each run appends its results to that file, and prints them relative to the run labeled "baseline"."""
+
+from concurrent.futures import ThreadPoolExecutor
+import csv
+import os
+import sys
+import time
+from typing import Dict, Final, List, Optional
+from urllib.error import URLError
+from urllib.request import Request, urlopen
+
+__all__ = ["fetch", "read_flash_metrics", "record_results", "run_benchmark"]
+
+# The names of the metrics containing the flash response statistics, without the namespace.
+SENT_METRIC: Final[str] = "flash_response_sent_bytes_total"
+BUSY_METRIC: Final[str] = "flash_response_busy_seconds_total"
+
+# The label of the recorded run other runs are compared to.
+BASELINE_LABEL: Final[str] = "baseline"
+
+# The columns of the results file.
+RESULT_FIELDS: Final[List[str]] = ["label", "path", "gzip", "requests", "concurrency",
+    "bytes_per_second", "requests_per_second", "cpu_ms_per_mb"]
+
+
+def fetch(url: str, gzip: bool) -> int:
+    """Downloads the given url once, and returns the number of received body bytes.
+
+    @param url: The url to download.
+    @param gzip: Whether to accept gzip compressed responses.
+    @return The number of bytes in the response body.
+    @raise URLError: If the request fails.
+    """
+    headers: Dict[str, str] = {"Accept-Encoding": "gzip" if gzip else "identity"}
+    with urlopen(Request(url, headers=headers), timeout=30) as response:
+        return len(response.read())
+
+
+def read_flash_metrics(host: str) -> Optional[Dict[str, float]]:
+    """Reads the flash response statistics from the metrics endpoint of the given host.
+
+    @param host: The host name or IP address, and optionally port, of the ESP.
+    @return A dictionary containing the values of the flash response metrics, or None if they aren't available.
+    """
+    try:
+        with urlopen(f"http://{host}/metrics", timeout=30) as response:
+            metrics: Dict[str, float] = {}
+            for line in response.read().decode().splitlines():
+                if line.startswith("#") or " " not in line:
+                    continue
+
+                name, value = line.rsplit(" ", 1)
+                for metric in [SENT_METRIC, BUSY_METRIC]:
+                    if name.endswith("_" + metric):
+                        metrics[metric] = float(value)
+
+            return metrics if len(metrics) == 2 else None
+    except URLError:
+        return None
+
+
+def record_results(file: str, result: Dict[str, str]) -> None:
+    """Appends the given result to the given results file, and compares all recorded results with the baseline.
+
+    Only results for the same path, gzip setting, request count, and concurrency are compared.
+
+    @param file: The path of the CSV file to record the results in.
+    @param result: The result of this run, containing a value for each of the RESULT_FIELDS.
+    """
+    exists: Final[bool] = os.path.isfile(file)
+    with open(file, "a", newline="") as results:
+        writer = csv.DictWriter(results, fieldnames=RESULT_FIELDS)
+        if not exists:
+            writer.writeheader()
+        writer.writerow(result)
+
+    with open(file, newline="") as results:
+        comparable: List[Dict[str, str]] = [row for row in csv.DictReader(results)
+            if all(row[key] == result[key] for key in ["path", "gzip", "requests", "concurrency"])]
+
+    baseline: Optional[Dict[str, str]] = next((row for row in reversed(comparable)
+        if row["label"] == BASELINE_LABEL), None)
+    if baseline is None:
+        print(f"No run labeled \"{BASELINE_LABEL}\" recorded in {file}, can't compare results.")
+        return
+
+    print(f"Recorded results relative to the latest \"{BASELINE_LABEL}\" run:")
+    for row in comparable:
+        line: str = f"{row['label']}: {float(row['bytes_per_second']):.0f} bytes/s"
+        line += f" ({float(row['bytes_per_second']) / float(baseline['bytes_per_second']) * 100:.1f}%)"
+        if row["cpu_ms_per_mb"] and baseline["cpu_ms_per_mb"]:
+            line += f", {float(row['cpu_ms_per_mb']):.3f}ms CPU time per MB"
+            line += f" ({float(row['cpu_ms_per_mb']) / float(baseline['cpu_ms_per_mb']) * 100:.1f}%)"
+        print(line)
+
+
+def run_benchmark(host: str, path: str, requests: int, concurrency: int, gzip: bool,
+        record: Optional[str] = None, label: str = BASELINE_LABEL) -> int:
+    """Runs the benchmark and prints the results.
+
+    @param host: The host name or IP address, and optionally port, of the ESP.
+    @param path: The path of the file to download.
+    @param requests: The total number of requests to send.
+    @param concurrency: The number of requests to run in parallel.
+    @param gzip: Whether to accept gzip compressed responses.
+    @param record: The path of a CSV file to record the results in, or None to not record them.
+    @param label: The label of the firmware build to record the results for.
+    @return Zero if the benchmark succeeded.
+    """
+    url: Final[str] = f"http://{host}{path}"
+    before = read_flash_metrics(host)
+
+    start: Final[float] = time.monotonic()
+    try:
+        with ThreadPoolExecutor(max_workers=concurrency) as executor:
+            received: int = sum(executor.map(lambda _: fetch(url, gzip), range(requests)))
+    except URLError as e:
+        print(f"Downloading {url} failed: {e.reason}", file=sys.stderr)
+        return 1
+    duration: Final[float] = time.monotonic() - start
+
+    after = read_flash_metrics(host)
+
+    print(f"Downloaded {received} bytes in {requests} requests in {duration:.3f}s.")
+    print(f"Throughput: {received / duration:.0f} bytes/s, {requests / duration:.2f} requests/s.")
+    cpu_ms_per_mb: str = ""
+    if before is not None and after is not None:
+        sent: float = after[SENT_METRIC] - before[SENT_METRIC]
+        busy: float = after[BUSY_METRIC] - before[BUSY_METRIC]
+        if sent > 0:
+            cpu_ms_per_mb = f"{busy * 1000 / (sent / 1000000):.3f}"
+            print(f"Flash responses sent {sent:.0f} bytes using {busy * 1000:.3f}ms of CPU time.")
+            print(f"CPU time per MB served: {cpu_ms_per_mb}ms.")
+    else:
+        print("Flash response metrics unavailable, can't calculate CPU time per MB.")
+
+    if record is not None:
+        record_results(record, {"label": label, "path": path, "gzip": str(gzip),
+            "requests": str(requests), "concurrency": str(concurrency),
+            "bytes_per_second": f"{received / duration:.0f}",
+            "requests_per_second": f"{requests / duration:.2f}", "cpu_ms_per_mb": cpu_ms_per_mb})
+
+    return 0
+
+
+def main() -> int:
+    """The entrypoint for the command line interface.
+
+    Parses the command line arguments, and runs the benchmark.
+
+    @return The process exit code.
+    """
+
+    from argparse import ArgumentParser
+    parser = ArgumentParser(description=
+        "Benchmarks the static file responses of an ESP-WiFi-Thermometer web server.")
+    parser.add_argument("host", help="The host name or IP address, and optionally port, of the ESP.")
+    parser.add_argument('-p', "--path", default="/index.js", help="The path of the file to download.")
+    parser.add_argument('-n', "--requests", type=int, default=100, help="The total number of requests to send.")
+    parser.add_argument('-c', "--concurrency", type=int, default=2, help="The number of parallel requests.")
+    parser.add_argument("--no-gzip", dest="gzip", action="store_false",
+        help="Don't accept gzip compressed responses, making the ESP decompress files on the fly.")
+    parser.add_argument('-r', "--record", help="A CSV file to append the results to, and compare them with.")
+    parser.add_argument('-l', "--label", default=BASELINE_LABEL,
+        help=f"The label of the firmware build to record the results for. Other runs are compared to \"{BASELINE_LABEL}\".")
+    args = parser.parse_args()
+
+    return run_benchmark(args.host, args.path, args.requests, args.concurrency, args.gzip,
+        args.record, args.label)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
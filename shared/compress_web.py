@@ -1,9 +1,13 @@
 #!/usr/bin/env python3
 
+from base64 import b64encode
 from enum import Enum
+import hashlib
 import os
 from os import path
+import re
 import sys
+import zlib
 
 from gzip_compressing_stream import GzipCompressingStream
 
@@ -35,6 +39,31 @@ separator_chars = [ '(', ')', '[', ']', '{', '}', '<', '>', ':', ';', ',', '+',
 # This requires a pow(2, -gzip_windowsize) byte buffer on the esp.
 gzip_windowsize = -10
 
+# The html file to inline the stylesheet and script into, relative to the data directory.
+inline_bundle_page = 'index.html'
+
+# The files to inline into the bundle, relative to the data directory.
+# Mapped to the tag to replace them with, and a regex matching the tag referencing them.
+inline_bundle_files = {
+    'main.css': ('style', re.compile(r'<link[^>]*href="/?main\.css"[^>]*>')),
+    'index.js': ('script', re.compile(r'<script[^>]*src="/?index\.js"[^>]*>\s*</script>'))
+}
+
+# The gzip template file to write the inlined bundle to, relative to the data directory.
+inline_bundle_output = path.join('gzip', 'index.html.gzt')
+
+# The header containing the segment table and content security policy for the bundle.
+inline_bundle_header = path.join(env.subst('$PROJECT_SRC_DIR'), 'generated', 'web_bundle.h')
+
+# The config option enabling the inlined bundle.
+inline_bundle_option = 'ENABLE_INLINE_WEB_BUNDLE'
+
+# The header containing the default values of the config options.
+config_header = path.join(env.subst('$PROJECT_SRC_DIR'), 'config.h')
+
+# The regex matching a template string to be replaced by the web server.
+template_regex = re.compile(r'\$([A-Z_]+)\$')
+
 MinifyMode = Enum('MinifyMode', [ 'Default', 'HTML', 'CSS', 'JavaScript' ])
 
 
@@ -216,6 +245,146 @@ def compress_file(input, text):
         gzip_file(input, path.join(gzip_dir, filename + ".gz"))
 
 
+def create_inline_bundle():
+    """Creates the gzip template for the main page, with the stylesheet and script inlined.
+
+    The page is split at each template string, and each part is compressed into a separate segment.
+    Each segment ends with a full flush, so no segment references data from a previous one.
+    This allows the web server to insert the template replacements as uncompressed blocks.
+
+    The resulting file contains the gzip header and the compressed segments, but not the gzip trailer.
+    The web server has to append the trailer, since the checksum depends on the replacements.
+
+    Also generates a header file containing the segment table, and the content security policy
+    required to allow the inlined stylesheet and script.
+    """
+
+    data_dir = env.get('PROJECT_DATA_DIR')
+    with open(path.join(data_dir, inline_bundle_page)) as src:
+        page = src.read()
+
+    csp_hashes = {}
+    for file, (tag, regex) in inline_bundle_files.items():
+        with open(path.join(data_dir, file)) as src:
+            content = src.read().strip()
+
+        if f"</{tag}" in content.lower():
+            print(f"File \"{file}\" contains a closing {tag} tag, and can't be inlined.")
+            env.Exit(1)
+            return
+
+        if len(regex.findall(page)) != 1:
+            print(f"Page \"{inline_bundle_page}\" doesn't reference \"{file}\" exactly once.")
+            env.Exit(1)
+            return
+
+        # Use a function, so the content isn't parsed for backreferences.
+        page = regex.sub(lambda match: f"<{tag}>{content}</{tag}>", page)
+        csp_hashes[tag] = b64encode(hashlib.sha256(content.encode()).digest()).decode()
+
+    # Even elements are static parts, odd elements are template names.
+    parts = template_regex.split(page)
+    compressor = zlib.compressobj(9, zlib.DEFLATED, gzip_windowsize, zlib.DEF_MEM_LEVEL, 0)
+    # Magic numbers, deflate, no flags, no modification time, max compression, unknown os.
+    output = bytearray(b'\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\xff')
+    segments = []
+    for i in range(0, len(parts), 2):
+        last = i + 1 >= len(parts)
+        segment = parts[i].encode()
+        output += compressor.compress(segment)
+        output += compressor.flush(zlib.Z_FINISH if last else zlib.Z_FULL_FLUSH)
+        segments.append((len(output), len(segment), zlib.crc32(segment), None if last else parts[i + 1]))
+
+    with open(path.join(data_dir, inline_bundle_output), 'wb') as dst:
+        dst.write(output)
+
+    csp = "default-src 'self'; " + "; ".join(f"{tag}-src 'self' 'sha256-{hash}'" for tag, hash in csp_hashes.items())
+    id = path.basename(inline_bundle_output).upper().replace('.', '_')
+
+    print("Generating " + path.relpath(inline_bundle_header, env.subst("$PROJECT_DIR")))
+    with open(inline_bundle_header, 'w') as header:
+        header.write(
+f"""/*
+ * web_bundle.h
+ *
+ * **Warning:** This file is automatically generated, and should not be edited manually.
+ *
+ * This file contains the segment table and content security policy of the inlined main page bundle.
+ *
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_GENERATED_WEB_BUNDLE_H_
+#define SRC_GENERATED_WEB_BUNDLE_H_
+
+#include "../webhandler.h"
+#if ENABLE_WEB_SERVER == 1
+
+/**
+ * The segments of the gzip template "{path.basename(inline_bundle_output)}".
+ */
+static constexpr web::GzipTemplateSegment {id}_SEGMENTS[] = {{
+""")
+
+        entries = []
+        for end, size, crc, name in segments:
+            name = "NULL" if name is None else f'"{name}"'
+            entries.append(f"\t\t{{ {end}, {size}, 0x{crc:08X}, {name} }}")
+        header.write(("," + os.linesep).join(entries))
+        header.write(f""" }};
+
+/**
+ * The number of segments in the gzip template "{path.basename(inline_bundle_output)}".
+ */
+static constexpr size_t {id}_SEGMENT_COUNT = {len(segments)};
+
+/**
+ * The Content-Security-Policy allowing the inlined stylesheet and script of "{path.basename(inline_bundle_output)}".
+ */
+static constexpr char {id}_CSP[] = "{csp}";
+
+#endif /* ENABLE_WEB_SERVER == 1 */
+#endif /* SRC_GENERATED_WEB_BUNDLE_H_ */
+""")
+
+
+def inline_bundle_enabled():
+    """Checks whether the inlined main page bundle is enabled for the current build.
+
+    The option can be set using a build flag, which overrides the default from config.h.
+
+    Returns
+    -------
+    bool
+        True if the web server sends the inlined bundle.
+    """
+
+    for define in env.ParseFlags(env.get('BUILD_FLAGS', [])).get('CPPDEFINES', []):
+        if isinstance(define, (list, tuple)) and define[0] == inline_bundle_option:
+            return str(define[1]) == '1'
+        elif define == inline_bundle_option:
+            return True
+
+    with open(config_header) as config:
+        match = re.search(r'^#define ' + inline_bundle_option + r' (\d+)$', config.read(), re.MULTILINE)
+    return match is not None and match.group(1) == '1'
+
+
+def exclude_inline_bundle():
+    """Removes the inlined main page bundle from the files to embed into the firmware.
+
+    The web server doesn't reference it if the bundle is disabled, so it would only waste flash space.
+    """
+
+    option = 'board_build.embed_files'
+    bundle = path.join(path.basename(env.get('PROJECT_DATA_DIR')), inline_bundle_output).replace(os.sep, '/')
+    files = env.GetProjectOption(option, '').splitlines()
+    if bundle in files:
+        files.remove(bundle)
+        env.GetProjectConfig().set('env:' + env['PIOENV'], option, '\n'.join(files))
+
+
 for file in input_text_files:
     if file in input_gzip_blacklist:
         filename = path.basename(file)
@@ -226,3 +395,7 @@ for file in input_text_files:
 for file in input_binary_files:
     filename = path.basename(file) + ".gz"
     compress_file(file, False)
+
+create_inline_bundle()
+if not inline_bundle_enabled():
+    exclude_inline_bundle()
@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+
+"""A decoder for the output of the tokenized log.
+
+Reads the serial output of a firmware built with ENABLE_TOKENIZED_LOG set to 1, and turns the binary log frames
+back into the same text the regular log macros would print, using the token database generated at build time.
+All output that isn't part of a log frame is written unchanged.
+
+Reads from a serial port if pyserial is installed and a port is given, and from a file or stdin otherwise."""
+
+import json
+import re
+import struct
+import sys
+from typing import BinaryIO, Dict, Final, Iterator, List, Optional, Tuple
+
+__all__ = ["load_tokens", "decode_args", "format_message", "decode_frame", "decode_stream"]
+
+# The byte starting each tokenized log frame.
+TOKEN_FRAME_START: Final[int] = 0x1E
+
+# The length of the fixed part of a frame after the length byte, containing the token, line, and timestamp.
+FRAME_HEADER_LEN: Final[int] = 10
+
+# The argument types, in the same order as logging::TokenFrame::ArgType.
+ARG_INT: Final[int] = 0
+ARG_UINT: Final[int] = 1
+ARG_DOUBLE: Final[int] = 2
+ARG_STRING: Final[int] = 3
+ARG_POINTER: Final[int] = 4
+
+# A single printf conversion specifier.
+SPEC_PATTERN: Final[re.Pattern] = re.compile(r'%([-+ #0]*)(\d*)(?:\.(\d*))?(hh|h|ll|l|j|z|t|L)?([diouxXeEfFgGaAcspn%])')
+
+
+def load_tokens(path: str) -> Dict[int, Dict[str, str]]:
+    """Loads the token database generated by shared/generate_log_tokens.py.
+
+    @param path: The path of the log_tokens.json file.
+    @return A dictionary mapping the tokens to their level, file, and format.
+    @raise IOError: If reading the file fails.
+    """
+    with open(path, 'r') as file:
+        return {int(token, 16): entry for token, entry in json.load(file).items()}
+
+
+def read_varint(data: bytes, pos: int) -> Tuple[int, int]:
+    """Reads a varint from the given position.
+
+    @param data: The data to read the varint from.
+    @param pos: The position of the first byte of the varint.
+    @return The value of the varint, and the position after it.
+    @raise IndexError: If the varint isn't terminated.
+    """
+    value: int = 0
+    shift: int = 0
+    while True:
+        byte: int = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def decode_args(data: bytes) -> List[Tuple[int, object]]:
+    """Decodes the arguments of a frame.
+
+    @param data: The encoded arguments.
+    @return A list containing the type and value of each argument.
+    @raise IndexError: If the arguments are truncated.
+    """
+    args: List[Tuple[int, object]] = []
+    pos: int = 0
+    while pos < len(data):
+        type: int = data[pos]
+        pos += 1
+        if type == ARG_INT:
+            value, pos = read_varint(data, pos)
+            args.append((type, (value >> 1) ^ -(value & 1)))
+        elif type in (ARG_UINT, ARG_POINTER):
+            value, pos = read_varint(data, pos)
+            args.append((type, value))
+        elif type == ARG_DOUBLE:
+            args.append((type, struct.unpack_from('<d', data, pos)[0]))
+            pos += 8
+        elif type == ARG_STRING:
+            length: int = data[pos]
+            args.append((type, data[pos + 1:pos + 1 + length].decode(errors='replace')))
+            pos += 1 + length
+        else:
+            raise IndexError(f"Unknown argument type {type}.")
+
+    return args
+
+
+def format_arg(spec: re.Match, type: int, value: object) -> str:
+    """Formats a single argument like printf would.
+
+    @param spec: The match of the conversion specifier.
+    @param type: The type of the argument.
+    @param value: The value of the argument.
+    @return The formatted argument.
+    """
+    flags, width, precision, length, conversion = spec.groups()
+    python_spec: str = '%' + flags + width + ('.' + precision if precision is not None else '')
+    if conversion == 's':
+        return (python_spec + 's') % (value if type == ARG_STRING else spec.group(0))
+    elif conversion == 'p':
+        return (python_spec + 's') % hex(value if isinstance(value, int) else 0)
+    elif conversion == 'c':
+        return (python_spec + 'c') % (value & 0xFF if isinstance(value, int) else 0x3F)
+    elif conversion in 'eEfFgGaA':
+        if conversion in 'aA':
+            return float(value).hex()  # type: ignore[arg-type]
+        return (python_spec + conversion) % float(value)  # type: ignore[arg-type]
+    elif not isinstance(value, int):
+        return spec.group(0)
+
+    if conversion in 'ouxX' and value < 0:
+        # Mask negative numbers to the size of the C type, since python doesn't know it.
+        bits: int = 64 if length in ('ll', 'j') else 8 if length == 'hh' else 16 if length == 'h' else 32
+        value &= (1 << bits) - 1
+    return (python_spec + ('d' if conversion in 'iu' else conversion)) % value
+
+
+def format_message(format: str, args: List[Tuple[int, object]]) -> str:
+    """Formats a message from a printf format string and its decoded arguments.
+
+    Conversion specifiers without an argument, or with an unsupported width or precision, are written as is.
+
+    @param format: The printf format string.
+    @param args: The decoded arguments.
+    @return The formatted message.
+    """
+    remaining: Iterator[Tuple[int, object]] = iter(args)
+
+    def replace(spec: re.Match) -> str:
+        if spec.group(5) == '%':
+            return '%'
+        elif spec.group(5) == 'n':
+            return ''
+        arg: Optional[Tuple[int, object]] = next(remaining, None)
+        return spec.group(0) if arg is None else format_arg(spec, *arg)
+
+    return SPEC_PATTERN.sub(replace, format)
+
+
+def decode_frame(frame: bytes, tokens: Dict[int, Dict[str, str]]) -> str:
+    """Decodes a single frame, without the start and length bytes, into a line of text.
+
+    @param frame: The content of the frame.
+    @param tokens: The token database.
+    @return The decoded line, including the line ending.
+    """
+    token, line, timestamp = struct.unpack_from('<IHI', frame)
+    try:
+        args: List[Tuple[int, object]] = decode_args(frame[FRAME_HEADER_LEN:])
+    except (IndexError, struct.error):
+        args = []
+
+    entry: Optional[Dict[str, str]] = tokens.get(token)
+    if entry is None:
+        return f"[{timestamp:6d}][?][unknown:{line}] Unknown token {token:08x} with arguments {[a[1] for a in args]}\r\n"
+
+    return f"[{timestamp:6d}][{entry['level']}][{entry['file']}:{line}] {format_message(entry['format'], args)}\r\n"
+
+
+def decode_stream(input: BinaryIO, output: BinaryIO, tokens: Dict[int, Dict[str, str]]) -> None:
+    """Decodes all frames read from the input, and writes the result to the output.
+
+    Bytes that aren't part of a frame are written unchanged.
+
+    @param input: The stream to read the serial output from.
+    @param output: The stream to write the decoded output to.
+    @param tokens: The token database.
+    """
+    buffer: bytes = b''
+    while True:
+        # Read single bytes, so output from a serial port is written as soon as it is received.
+        data: bytes = input.read(1)
+        if not data:
+            break
+        buffer += data
+
+        while buffer:
+            start: int = buffer.find(TOKEN_FRAME_START)
+            if start != 0:
+                output.write(buffer[:start if start > 0 else len(buffer)])
+                output.flush()
+                buffer = buffer[start:] if start > 0 else b''
+                continue
+
+            if len(buffer) < 2 or len(buffer) < 2 + buffer[1]:
+                break
+
+            length: int = buffer[1]
+            if length < FRAME_HEADER_LEN:
+                # Not a valid frame, so write the start byte as is.
+                output.write(buffer[:1])
+                buffer = buffer[1:]
+                continue
+
+            output.write(decode_frame(buffer[2:2 + length], tokens).encode())
+            output.flush()
+            buffer = buffer[2 + length:]
+
+    output.write(buffer)
+    output.flush()
+
+
+def main() -> int:
+    """The entrypoint for the command line interface.
+
+    Parses the command line arguments, and decodes the log output.
+
+    @return The process exit code.
+    """
+
+    from argparse import ArgumentParser
+    parser = ArgumentParser(description=
+        "Decodes the serial output of an ESP-WiFi-Thermometer built with the tokenized log.")
+    parser.add_argument('-t', "--tokens", required=True,
+        help="The log_tokens.json file from the build directory of the firmware.")
+    parser.add_argument('-p', "--port", help="The serial port to read from. Requires pyserial.")
+    parser.add_argument('-b', "--baud", type=int, default=115200, help="The baud rate of the serial port.")
+    parser.add_argument("input", nargs='?', help="A file containing captured serial output. Defaults to stdin.")
+    args = parser.parse_args()
+
+    tokens: Dict[int, Dict[str, str]] = load_tokens(args.tokens)
+    try:
+        if args.port:
+            import serial  # type: ignore[import]
+            with serial.Serial(args.port, args.baud) as port:
+                decode_stream(port, sys.stdout.buffer, tokens)
+        elif args.input:
+            with open(args.input, 'rb') as file:
+                decode_stream(file, sys.stdout.buffer, tokens)
+        else:
+            decode_stream(sys.stdin.buffer, sys.stdout.buffer, tokens)
+    except KeyboardInterrupt:
+        pass
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
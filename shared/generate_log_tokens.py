@@ -0,0 +1,183 @@
+#!/usr/bin/env python3
+
+"""Generates the token database for the tokenized log.
+
+Finds all log_X calls with a string literal format in the project sources and libraries,
+and calculates the same token for them that the firmware calculates at compile time.
+The resulting database is written to log_tokens.json in the build directory, and is used by shared/decode_log.py."""
+
+import json
+import os
+from os import path
+import re
+import sys
+from typing import Dict, Final, Iterator, List, Tuple
+
+__all__ = ["hash_string", "unescape", "find_log_calls", "generate_tokens"]
+
+# The FNV-1a offset basis, the initial value of a token hash.
+TOKEN_HASH_OFFSET: Final[int] = 2166136261
+
+# The FNV-1a prime, used to combine each byte with the hash.
+TOKEN_HASH_PRIME: Final[int] = 16777619
+
+# The file endings of the files to search for log calls.
+source_types: Final[List[str]] = ['.c', '.cpp', '.h', '.hpp', '.ino']
+
+# The start of a log call, followed by its level letter.
+LOG_CALL_PATTERN: Final[re.Pattern] = re.compile(r'\blog_([ewidv])\s*\(')
+
+# A single string literal, or the whitespace and comments between two of them.
+STRING_LITERAL_PATTERN: Final[re.Pattern] = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+SEPARATOR_PATTERN: Final[re.Pattern] = re.compile(r'(?:\s|//[^\n]*\n|/\*.*?\*/)*', re.DOTALL)
+
+# The simple C escape sequences, and the bytes they represent.
+SIMPLE_ESCAPES: Final[Dict[str, int]] = {'n': 0x0A, 'r': 0x0D, 't': 0x09, 'a': 0x07, 'b': 0x08, 'f': 0x0C,
+                                         'v': 0x0B, 'e': 0x1B, '\\': 0x5C, '"': 0x22, "'": 0x27, '?': 0x3F}
+
+
+def hash_string(data: bytes, hash: int = TOKEN_HASH_OFFSET) -> int:
+    """Calculates the 32 bit FNV-1a hash of some bytes.
+
+    Matches logging::hashString from the fallback log library.
+
+    @param data: The bytes to hash.
+    @param hash: The hash of the previous bytes to combine with these.
+    @return The resulting hash.
+    """
+    for byte in data:
+        hash = ((hash ^ byte) * TOKEN_HASH_PRIME) & 0xFFFFFFFF
+    return hash
+
+
+def unescape(literal: str) -> bytes:
+    """Converts the content of a C string literal to the bytes it represents.
+
+    @param literal: The content of the string literal, without the quotes.
+    @return The bytes of the string, without a null terminator.
+    @raise ValueError: If the literal contains an unknown escape sequence.
+    """
+    result: bytearray = bytearray()
+    i: int = 0
+    while i < len(literal):
+        c: str = literal[i]
+        i += 1
+        if c != '\\':
+            result.extend(c.encode())
+            continue
+
+        c = literal[i]
+        i += 1
+        if c in SIMPLE_ESCAPES:
+            result.append(SIMPLE_ESCAPES[c])
+        elif c == 'x':
+            match = re.match(r'[0-9a-fA-F]+', literal[i:])
+            if not match:
+                raise ValueError(f"Invalid hex escape in \"{literal}\".")
+            result.append(int(match.group(0), 16) & 0xFF)
+            i += len(match.group(0))
+        elif c in '01234567':
+            match = re.match(r'[0-7]{1,3}', literal[i - 1:])
+            result.append(int(match.group(0), 8) & 0xFF)  # type: ignore[union-attr]
+            i += len(match.group(0)) - 1  # type: ignore[union-attr]
+        else:
+            raise ValueError(f"Unknown escape sequence \"\\{c}\" in \"{literal}\".")
+
+    return bytes(result)
+
+
+def find_log_calls(source: str) -> Iterator[Tuple[str, int, bytes]]:
+    """Finds all log calls with a format consisting only of string literals.
+
+    Calls with a different format, like the definitions of the log macros, are skipped.
+
+    @param source: The content of the source file to search.
+    @return An iterator over the level letter, line, and format of each call.
+    @raise ValueError: If a format string contains an invalid escape sequence.
+    """
+    for call in LOG_CALL_PATTERN.finditer(source):
+        pos: int = call.end()
+        format: bytes = b''
+        literals: int = 0
+        while True:
+            pos = SEPARATOR_PATTERN.match(source, pos).end()  # type: ignore[union-attr]
+            literal = STRING_LITERAL_PATTERN.match(source, pos)
+            if not literal:
+                break
+            format += unescape(literal.group(1))
+            literals += 1
+            pos = literal.end()
+
+        if literals > 0 and pos < len(source) and source[pos] in ',)':
+            yield call.group(1).upper(), source.count('\n', 0, call.start()) + 1, format
+
+
+def generate_tokens(paths: List[str]) -> Dict[str, Dict[str, str]]:
+    """Calculates the tokens for all the log calls in the given files.
+
+    The token of a message is the hash of "<level letter>|<file base name>|<format>".
+
+    @param paths: The paths of the files to search.
+    @return A dictionary mapping the hex representations of the tokens to their level, file, and format.
+    @raise IOError: If reading one of the files fails.
+    @raise ValueError: If two different messages have the same token.
+    """
+    tokens: Dict[str, Dict[str, str]] = {}
+    for p in paths:
+        with open(p, 'r', encoding='utf-8') as file:
+            source: str = file.read()
+
+        name: str = path.basename(p)
+        for level, line, format in find_log_calls(source):
+            token: str = f"{hash_string(format, hash_string(f'{level}|{name}|'.encode())):08x}"
+            entry: Dict[str, str] = {"level": level, "file": name, "format": format.decode(errors='replace')}
+            if token in tokens and tokens[token] != entry:
+                raise ValueError(f"Token collision between {tokens[token]} and {entry} at {p}:{line}.")
+            tokens[token] = entry
+
+    return tokens
+
+
+def main() -> int:
+    """The main entrypoint of this script.
+
+    The main function executing all the functionality of this script.
+    Searches the project sources and libraries for log calls, and writes their tokens to the build directory.
+
+    @return Zero if nothing goes wrong.
+    @raise IOError: If reading a source file or writing the database fails.
+    """
+
+    paths: List[str] = []
+    for dir in [env.subst('$PROJECT_SRC_DIR'), env.subst('$PROJECT_LIB_DIR')]:  # type: ignore[name-defined]
+        for root, _, files in os.walk(dir):
+            paths.extend(path.join(root, file) for file in files if path.splitext(file)[1] in source_types)
+
+    try:
+        tokens: Dict[str, Dict[str, str]] = generate_tokens(sorted(paths))
+    except ValueError as e:
+        print(f"Generating the log tokens failed: {e}", file=sys.stderr)
+        return 1
+
+    build_dir: Final[str] = env.subst('$BUILD_DIR')  # type: ignore[name-defined]
+    database_path: Final[str] = path.join(build_dir, 'log_tokens.json')
+    print("Generating " + path.relpath(database_path, env.subst("$PROJECT_ROOT")))  # type: ignore[name-defined]
+
+    os.makedirs(build_dir, exist_ok=True)
+    with open(database_path, 'w') as database:
+        json.dump(tokens, database, indent=4, sort_keys=True)
+        database.write(os.linesep)
+
+    return 0
+
+
+if __name__ == 'SCons.Script':
+    try:
+        Import ("env")  # type: ignore[name-defined]
+    except:
+        print("Failed to load platformio environment!", file=sys.stderr)
+        sys.exit(1)
+
+    error: int = main()
+    if error != 0:
+        sys.exit(error)
@@ -0,0 +1,38 @@
+/*
+ * AsyncChunkedCompletionResponse.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "AsyncChunkedCompletionResponse.h"
+#if ENABLE_WEB_SERVER == 1
+
+web::AsyncChunkedCompletionResponse::AsyncChunkedCompletionResponse(
+		const String &content_type, const AwsResponseFiller filler,
+		const std::function<void()> on_complete) :
+		AsyncChunkedResponse(content_type, filler), _onComplete(on_complete) {
+
+}
+
+size_t web::AsyncChunkedCompletionResponse::_ack(
+		AsyncWebServerRequest *request, size_t len, uint32_t time) {
+	const size_t written = AsyncChunkedResponse::_ack(request, len, time);
+	// A chunked response ends once the last chunk was written, so the acknowledged length has to be checked too.
+	if (_onComplete
+			&& (_state == RESPONSE_WAIT_ACK || _state == RESPONSE_END)
+			&& _ackedLength >= _writtenLength) {
+		_onComplete();
+		_onComplete = nullptr;
+	}
+	return written;
+}
+
+bool web::AsyncChunkedCompletionResponse::_finished() const {
+	return _state == RESPONSE_FAILED
+			|| (_state == RESPONSE_END && _ackedLength >= _writtenLength);
+}
+#endif /* ENABLE_WEB_SERVER == 1 */
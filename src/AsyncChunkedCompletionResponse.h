@@ -0,0 +1,71 @@
+/*
+ * AsyncChunkedCompletionResponse.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_ASYNCCHUNKEDCOMPLETIONRESPONSE_H_
+#define SRC_ASYNCCHUNKEDCOMPLETIONRESPONSE_H_
+
+#include "config.h"
+#if ENABLE_WEB_SERVER == 1
+#include <ESPAsyncWebServer.h>
+#include <functional>
+
+namespace web {
+
+/**
+ * A chunked response calling a function once the client acknowledged the entire response.
+ *
+ * Unlike the last call of the response filler, this means the client actually received all of the data.
+ * The function isn't called if the connection is closed before that.
+ *
+ * Chunked responses can only be sent to HTTP/1.1 clients.
+ */
+class AsyncChunkedCompletionResponse: public AsyncChunkedResponse {
+private:
+	/**
+	 * The function to call once the client acknowledged the entire response.
+	 * Cleared once it was called.
+	 */
+	std::function<void()> _onComplete;
+public:
+	/**
+	 * Creates a new chunked completion response.
+	 *
+	 * @param content_type	The content type of the data to send.
+	 * @param filler		The function writing the chunks of the response.
+	 * @param on_complete	The function to call once the client acknowledged the entire response.
+	 */
+	AsyncChunkedCompletionResponse(const String &content_type,
+			const AwsResponseFiller filler,
+			const std::function<void()> on_complete);
+
+	/**
+	 * Handles the client acknowledging some data, and sends the next part of the response.
+	 * Calls the completion function once all data was acknowledged.
+	 *
+	 * @param request	The request this is a response to.
+	 * @param len		The number of bytes the client acknowledged.
+	 * @param time		The time it took the client to acknowledge the data.
+	 * @return	The number of bytes handed to the TCP stack.
+	 */
+	virtual size_t _ack(AsyncWebServerRequest *request, size_t len,
+			uint32_t time) override;
+
+	/**
+	 * Checks whether this response is done.
+	 * Unlike a plain chunked response, it isn't done until the client acknowledged all data.
+	 *
+	 * @return	True if the response was fully acknowledged, or failed.
+	 */
+	virtual bool _finished() const override;
+};
+
+}
+#endif /* ENABLE_WEB_SERVER == 1 */
+#endif /* SRC_ASYNCCHUNKEDCOMPLETIONRESPONSE_H_ */
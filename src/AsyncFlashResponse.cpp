@@ -0,0 +1,157 @@
+/*
+ * AsyncFlashResponse.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "AsyncFlashResponse.h"
+#if ENABLE_WEB_SERVER == 1
+#include <fallback_log.h>
+#ifdef ESP8266
+#include <fallback_timer.h>
+#endif
+
+#if ENABLE_ZERO_COPY_FLASH_RESPONSES != 1
+/**
+ * The size of the stack buffer used to copy data from flash, if zero copy responses are disabled.
+ */
+static constexpr size_t COPY_BUFFER_SIZE = 512;
+#endif
+
+prom::CounterFamily web::AsyncFlashResponse::_totalSent(PROMETHEUS_NAMESPACE,
+		"flash_response_sent_bytes_total", "",
+		"The total number of static file bytes sent directly from flash.");
+prom::CounterFamily web::AsyncFlashResponse::_totalBusyTime(
+		PROMETHEUS_NAMESPACE, "flash_response_busy_seconds_total", "",
+		"The total CPU time spent sending static files from flash in seconds.",
+		{ }, 1, 1000000);
+
+web::AsyncFlashResponse::AsyncFlashResponse(const int code,
+		const String &content_type, const uint8_t *content, const size_t len) :
+		AsyncWebServerResponse(), _content(content) {
+	_code = code;
+	_contentType = content_type;
+	_contentLength = len;
+}
+
+web::AsyncFlashResponse::~AsyncFlashResponse() {
+
+}
+
+bool web::AsyncFlashResponse::_sourceValid() const {
+	return _content != NULL;
+}
+
+void web::AsyncFlashResponse::_respond(AsyncWebServerRequest *request) {
+	_state = RESPONSE_HEADERS;
+	_head = _assembleHead(request->version());
+	_state = RESPONSE_CONTENT;
+	_send(request);
+}
+
+size_t web::AsyncFlashResponse::_ack(AsyncWebServerRequest *request,
+		size_t len, uint32_t time) {
+	_ackedLength += len;
+	if (_state == RESPONSE_CONTENT) {
+		return _send(request);
+	} else if (_state == RESPONSE_WAIT_ACK && _ackedLength >= _writtenLength) {
+		_state = RESPONSE_END;
+	}
+	return 0;
+}
+
+size_t web::AsyncFlashResponse::_send(AsyncWebServerRequest *request) {
+	const uint64_t start = (uint64_t) esp_timer_get_time();
+	AsyncClient *client = request->client();
+	size_t written = 0;
+	size_t content_written = 0;
+
+	if (_headSent < _headLength) {
+		// The head is a temporary string, so it has to be copied.
+		const size_t len = client->add(_head.c_str() + _headSent,
+				min(client->space(), _headLength - _headSent),
+				ASYNC_WRITE_FLAG_COPY);
+		_headSent += len;
+		written += len;
+		if (_headSent >= _headLength) {
+			_head = String();
+		}
+	}
+
+	while (_headSent >= _headLength && _sentLength < _contentLength) {
+		const size_t space = client->space();
+		if (space == 0) {
+			break;
+		}
+
+#if ENABLE_ZERO_COPY_FLASH_RESPONSES == 1
+		// The content is memory mapped flash, so lwip can reference it directly.
+		const size_t len = client->add((const char*) _content + _sentLength,
+				min(space, _contentLength - _sentLength), 0);
+#else
+		uint8_t buffer[COPY_BUFFER_SIZE];
+		size_t len = min(min(space, _contentLength - _sentLength),
+				COPY_BUFFER_SIZE);
+		memcpy_P(buffer, _content + _sentLength, len);
+		len = client->add((const char*) buffer, len, ASYNC_WRITE_FLAG_COPY);
+#endif
+		if (len == 0) {
+			break;
+		}
+		_sentLength += len;
+		content_written += len;
+	}
+	written += content_written;
+
+	if (written > 0) {
+		client->send();
+		_writtenLength += written;
+	}
+
+	if (_headSent >= _headLength && _sentLength >= _contentLength) {
+		_state = RESPONSE_WAIT_ACK;
+	}
+
+	const uint64_t busy = (uint64_t) esp_timer_get_time() - start;
+	_busyTime += busy;
+	_recordSend(content_written, busy);
+	if (_state == RESPONSE_WAIT_ACK) {
+		log_d("Sent %u bytes from flash using %lluus of CPU time.",
+				_contentLength, _busyTime);
+	}
+	return written;
+}
+
+void web::AsyncFlashResponse::_recordSend(const size_t sent,
+		const uint64_t busy) {
+	_totalBusyTime.get().inc(busy);
+	_totalSent.get().inc(sent);
+}
+
+void web::AsyncFlashResponse::registerMetrics(prom::Registry &registry) {
+	registry.add(_totalSent);
+	registry.add(_totalBusyTime);
+}
+
+#if ENABLE_FLASH_RESPONSES != 1
+web::AsyncProgmemBaselineResponse::AsyncProgmemBaselineResponse(const int code,
+		const String &content_type, const uint8_t *content, const size_t len) :
+		AsyncProgmemResponse(code, content_type, content, len) {
+
+}
+
+size_t web::AsyncProgmemBaselineResponse::_ack(AsyncWebServerRequest *request,
+		size_t len, uint32_t time) {
+	const uint64_t start = (uint64_t) esp_timer_get_time();
+	const size_t sent = _sentLength;
+	const size_t written = AsyncProgmemResponse::_ack(request, len, time);
+	AsyncFlashResponse::_recordSend(_sentLength - sent,
+			(uint64_t) esp_timer_get_time() - start);
+	return written;
+}
+#endif /* ENABLE_FLASH_RESPONSES != 1 */
+#endif /* ENABLE_WEB_SERVER == 1 */
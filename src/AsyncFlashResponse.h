@@ -0,0 +1,169 @@
+/*
+ * AsyncFlashResponse.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_ASYNCFLASHRESPONSE_H_
+#define SRC_ASYNCFLASHRESPONSE_H_
+
+#include "config.h"
+#if ENABLE_WEB_SERVER == 1
+#include <ESPAsyncWebServer.h>
+#include <prometheus_registry.h>
+namespace web {
+
+/**
+ * A response sending a constant file that is stored in the flash memory of the microcontroller.
+ *
+ * If zero copy flash responses are enabled, the memory mapped flash data is given to the TCP stack as is.
+ * This means the data isn't copied to a RAM buffer before sending it.
+ * Otherwise the data is copied chunk by chunk into a stack buffer, and then handed to the TCP stack.
+ *
+ * The content **HAS TO** stay valid until the response is fully acknowledged by the client.
+ * This is always the case for files embedded into the firmware image.
+ */
+class AsyncFlashResponse: public AsyncWebServerResponse {
+private:
+	/**
+	 * A pointer to the first byte of the content to send.
+	 */
+	const uint8_t *_content;
+
+	/**
+	 * The response head to send to the client.
+	 * Emptied once it was fully handed to the TCP stack.
+	 */
+	String _head;
+
+	/**
+	 * The number of bytes of the response head that were already handed to the TCP stack.
+	 */
+	size_t _headSent = 0;
+
+	/**
+	 * The number of microseconds spent sending this response so far.
+	 */
+	uint64_t _busyTime = 0;
+
+	/**
+	 * The metric counting the content bytes sent by all flash responses since startup.
+	 */
+	static prom::CounterFamily _totalSent;
+
+	/**
+	 * The metric counting the microseconds spent sending flash responses since startup.
+	 * Exported in seconds.
+	 */
+	static prom::CounterFamily _totalBusyTime;
+
+	/**
+	 * Counts the given number of content bytes and CPU time in the flash response metrics.
+	 *
+	 * @param sent	The number of content bytes that were handed to the TCP stack.
+	 * @param busy	The number of microseconds spent sending them.
+	 */
+	static void _recordSend(const size_t sent, const uint64_t busy);
+
+	/**
+	 * Hands as much of the remaining head and content to the TCP stack as it can currently accept.
+	 *
+	 * @param request	The request this is a response to.
+	 * @return	The number of bytes handed to the TCP stack.
+	 */
+	size_t _send(AsyncWebServerRequest *request);
+public:
+	/**
+	 * Creates a new flash response sending the given content.
+	 *
+	 * @param code			The HTTP status code to send.
+	 * @param content_type	The content type of the data to send.
+	 * @param content		A pointer to the first byte of the data to send.
+	 * 						Has to stay valid until the response was sent.
+	 * @param len			The number of bytes to send.
+	 */
+	AsyncFlashResponse(const int code, const String &content_type,
+			const uint8_t *content, const size_t len);
+
+	/**
+	 * Destroys this response.
+	 * Does not free the content, since that is expected to be constant data in flash.
+	 */
+	virtual ~AsyncFlashResponse();
+
+	/**
+	 * Checks whether the content of this response is valid.
+	 *
+	 * @return	True if the content pointer isn't NULL.
+	 */
+	virtual bool _sourceValid() const override;
+
+	/**
+	 * Assembles the response head, and starts sending the response.
+	 *
+	 * @param request	The request this is a response to.
+	 */
+	virtual void _respond(AsyncWebServerRequest *request) override;
+
+	/**
+	 * Handles the client acknowledging some data, and sends the next part of the response.
+	 *
+	 * @param request	The request this is a response to.
+	 * @param len		The number of bytes the client acknowledged.
+	 * @param time		The time it took the client to acknowledge the data.
+	 * @return	The number of bytes handed to the TCP stack.
+	 */
+	virtual size_t _ack(AsyncWebServerRequest *request, size_t len,
+			uint32_t time) override;
+
+	/**
+	 * Registers the metrics for the bytes sent by flash responses, and the CPU time used to send them.
+	 * The CPU time includes the time spent copying the data, if zero copy responses are disabled.
+	 *
+	 * @param registry	The registry to add the metrics to.
+	 */
+	static void registerMetrics(prom::Registry &registry);
+
+	friend class AsyncProgmemBaselineResponse;
+};
+
+#if ENABLE_FLASH_RESPONSES != 1
+/**
+ * The progmem response of ESPAsyncWebServer, which was used to send static files before the flash response.
+ * Records the same metrics as the flash response, so benchmarks can compare the two.
+ */
+class AsyncProgmemBaselineResponse: public AsyncProgmemResponse {
+public:
+	/**
+	 * Creates a new progmem response sending the given content.
+	 *
+	 * @param code			The HTTP status code to send.
+	 * @param content_type	The content type of the data to send.
+	 * @param content		A pointer to the first byte of the data to send.
+	 * 						Has to stay valid until the response was sent.
+	 * @param len			The number of bytes to send.
+	 */
+	AsyncProgmemBaselineResponse(const int code, const String &content_type,
+			const uint8_t *content, const size_t len);
+
+	/**
+	 * Sends the next part of the response, and records the time spent doing so.
+	 * Also called by the progmem response to send the first part of the response.
+	 *
+	 * @param request	The request this is a response to.
+	 * @param len		The number of bytes the client acknowledged.
+	 * @param time		The time it took the client to acknowledge the data.
+	 * @return	The number of bytes handed to the TCP stack.
+	 */
+	virtual size_t _ack(AsyncWebServerRequest *request, size_t len,
+			uint32_t time) override;
+};
+#endif /* ENABLE_FLASH_RESPONSES != 1 */
+
+}
+#endif /* ENABLE_WEB_SERVER == 1 */
+#endif /* SRC_ASYNCFLASHRESPONSE_H_ */
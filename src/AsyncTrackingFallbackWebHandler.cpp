@@ -10,9 +10,10 @@
 
 #include "AsyncTrackingFallbackWebHandler.h"
 #if ENABLE_WEB_SERVER == 1
-#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_PUSH == 1
-#include "prometheus.h"
-#endif
+#include "webhandler.h"
+#include "HttpRequestStats.h"
+#include "tracing.h"
+#include "profiling.h"
 #include <utils.h>
 #include <fallback_log.h>
 #ifdef ESP8266
@@ -21,7 +22,8 @@
 
 web::AsyncTrackingFallbackWebHandler::AsyncTrackingFallbackWebHandler(
 		const String &uri, HTTPFallbackRequestHandler fallback) :
-		_uri(uri), _fallbackHandler(fallback), _handlers(
+		_uri(uri), _route(http_requests_total.addRoute(_uri.c_str())), _fallbackHandler(
+				fallback), _handlers(
 				utils::get_msb(HTTP_ANY) + 1) {
 
 }
@@ -71,6 +73,8 @@ bool web::AsyncTrackingFallbackWebHandler::canHandle(AsyncWebServerRequest *requ
 }
 
 void web::AsyncTrackingFallbackWebHandler::handleRequest(AsyncWebServerRequest *request) {
+	TRACE_SPAN("web::handleRequest");
+	ALLOC_SCOPE(_uri.c_str());
 	const uint64_t start = (uint64_t) esp_timer_get_time();
 	ResponseData response(request->beginResponse(500), 0, 500);
 	HTTPRequestHandler handler = _getHandler((WebRequestMethod) request->method());
@@ -85,11 +89,9 @@ void web::AsyncTrackingFallbackWebHandler::handleRequest(AsyncWebServerRequest *
 				"The handler for uri \"%s\" didn't have a handler for request type %s, and didn't have a fallback handler.",
 				_uri.c_str(), request->methodToString());
 	}
-#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
-	prom::http_requests_total[request->url()][ {
-			(WebRequestMethod) request->method(), response.status_code }]++;
-#endif
+	http_requests_total.track(_route, request->method(), response.status_code);
 	const uint64_t mid = (uint64_t) esp_timer_get_time();
+	http_handler_duration.get().observe(mid - start);
 	request->send(response.response);
 	const uint64_t end = (uint64_t) esp_timer_get_time();
 	log_d("Handling a request to \"%s\" took %lluus + %lluus.",
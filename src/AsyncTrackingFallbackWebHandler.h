@@ -23,7 +23,7 @@ namespace web {
  * Can not handle uri templates, all uris are treated as literals.
  * Can not handle a custom upload or body handler.
  *
- * Also tracks the requests for the prometheus integration, if it is enabled.
+ * Also tracks the handled requests in the HTTP request statistics.
  */
 class AsyncTrackingFallbackWebHandler: public AsyncWebHandler {
 protected:
@@ -33,6 +33,11 @@ protected:
 	 */
 	const String _uri;
 
+	/**
+	 * The id of the route of this handler in the HTTP request statistics.
+	 */
+	const uint8_t _route;
+
 	/**
 	 * The request handler handling all request methods for which no handler was set.
 	 */
@@ -101,7 +106,7 @@ public:
 
 	/**
 	 * The function being called for each request to be handled by this handler.
-	 * Automatically tracks the request if prometheus support is enabled.
+	 * Automatically tracks the request in the HTTP request statistics.
 	 *
 	 * @param request	The request to handle.
 	 */
@@ -0,0 +1,261 @@
+/*
+ * HttpPushClient.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "HttpPushClient.h"
+#if ENABLE_PROMETHEUS_PUSH == 1
+#include <fallback_log.h>
+
+/**
+ * The number of bytes added around each chunk of the body.
+ * Four hex digits for the size, and two line breaks.
+ */
+static constexpr size_t CHUNK_OVERHEAD = 8;
+
+/**
+ * The line ending a chunked body.
+ */
+static constexpr char LAST_CHUNK[] = "0\r\n\r\n";
+
+/**
+ * The length of the line ending a chunked body.
+ */
+static constexpr size_t LAST_CHUNK_LEN = 5;
+
+/**
+ * The lower case hex digits, by value.
+ */
+static constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+static_assert(http::PushClient::WRITE_BUFFER_SIZE < 0x10000 + CHUNK_OVERHEAD,
+		"The chunk size has to fit into four hex digits.");
+
+http::PushClient::PushClient(const char *host, const uint16_t port,
+		const std::string &path, const char *content_type,
+		const char *content_encoding, const uint32_t timeout,
+		prom::Counter &connects, prom::Histogram &duration) :
+		_host(host), _port(port), _path(path), _content_type(content_type), _content_encoding(
+				content_encoding), _timeout(timeout), _connects(connects), _duration(
+				duration) {
+	_client.setAckTimeout(timeout);
+	// No rx timeout, since it would also close the idle connection between requests.
+	_client.onConnect([](void *arg, AsyncClient *client) {
+		((PushClient*) arg)->startRequest();
+	}, this);
+	_client.onData([](void *arg, AsyncClient *client, void *data, size_t len) {
+		((PushClient*) arg)->handleData((const uint8_t*) data, len);
+	}, this);
+	_client.onAck([](void *arg, AsyncClient *client, size_t len, uint32_t time) {
+		PushClient *push_client = (PushClient*) arg;
+		if (push_client->_writing) {
+			push_client->writeRequest();
+		}
+	}, this);
+	_client.onPoll([](void *arg, AsyncClient *client) {
+		((PushClient*) arg)->handlePoll();
+	}, this);
+	_client.onError([](void *arg, AsyncClient *client, int8_t error) {
+		log_e("Connection to %s failed with error %d.", ((PushClient*) arg)->_host, error);
+		((PushClient*) arg)->handleDisconnect();
+	}, this);
+	_client.onDisconnect([](void *arg, AsyncClient *client) {
+		((PushClient*) arg)->handleDisconnect();
+	}, this);
+}
+
+bool http::PushClient::push(const BodyWriter body,
+		const ResponseHandler handler) {
+	if (_next_state.load() != NEXT_EMPTY) {
+		return false;
+	}
+
+	_next.body = body;
+	_next.handler = handler;
+	_next_state.store(NEXT_READY);
+
+	if (_client.disconnected()) {
+		_connects.inc();
+		if (!_client.connect(_host, _port)) {
+			log_e("Connecting to %s failed!", _host);
+			failNext();
+		}
+	}
+	return true;
+}
+
+bool http::PushClient::isBusy() const {
+	return _next_state.load() != NEXT_EMPTY || _pending_count.load() > 0;
+}
+
+bool http::PushClient::takeNext() {
+	uint8_t expected = NEXT_READY;
+	if (!_next_state.compare_exchange_strong(expected, NEXT_TAKEN)) {
+		return false;
+	}
+
+	const uint8_t count = _pending_count.load();
+	Request &request = _pending[(_pending_start + count)
+			% MAX_PIPELINED_REQUESTS];
+	request.body = std::move(_next.body);
+	request.handler = std::move(_next.handler);
+	request.start = (uint64_t) esp_timer_get_time();
+	_pending_count.store(count + 1);
+	_next_state.store(NEXT_EMPTY);
+	return true;
+}
+
+void http::PushClient::failNext() {
+	uint8_t expected = NEXT_READY;
+	if (!_next_state.compare_exchange_strong(expected, NEXT_TAKEN)) {
+		return;
+	}
+
+	const ResponseHandler handler = std::move(_next.handler);
+	_next.body = nullptr;
+	_next_state.store(NEXT_EMPTY);
+	handler(0);
+}
+
+void http::PushClient::startRequest() {
+	if (_writing || _pending_count.load() >= MAX_PIPELINED_REQUESTS
+			|| !_client.connected() || !takeNext()) {
+		return;
+	}
+
+	_writing = true;
+	_headers_written = false;
+	_body_done = false;
+	writeRequest();
+}
+
+void http::PushClient::writeRequest() {
+	const size_t space =
+			_client.space() < WRITE_BUFFER_SIZE ?
+					_client.space() : WRITE_BUFFER_SIZE;
+	size_t len = 0;
+
+	if (!_headers_written) {
+		const int header_len = snprintf((char*) _buffer, space,
+				"POST %s HTTP/1.1\r\nHost: %s\r\nContent-Type: %s\r\n%s%s%sTransfer-Encoding: chunked\r\n\r\n",
+				_path.c_str(), _host, _content_type,
+				_content_encoding ? "Content-Encoding: " : "",
+				_content_encoding ? _content_encoding : "",
+				_content_encoding ? "\r\n" : "");
+		if (header_len < 0 || (size_t) header_len >= space) {
+			// Wait for more space in the send buffer.
+			return;
+		}
+		len = header_len;
+		_headers_written = true;
+	}
+
+	// The body length isn't known in advance, so it is sent using chunked transfer encoding.
+	const Request &request = _pending[(_pending_start + _pending_count.load()
+			- 1) % MAX_PIPELINED_REQUESTS];
+	while (!_body_done && space - len > CHUNK_OVERHEAD) {
+		uint8_t *chunk = _buffer + len + CHUNK_OVERHEAD - 2;
+		const size_t chunk_len = request.body(chunk,
+				space - len - CHUNK_OVERHEAD);
+		if (chunk_len == 0) {
+			_body_done = true;
+			break;
+		}
+
+		for (uint8_t i = 0; i < 4; i++) {
+			_buffer[len + i] = HEX_DIGITS[(chunk_len >> (12 - i * 4)) & 0xF];
+		}
+		memcpy(_buffer + len + 4, "\r\n", 2);
+		memcpy(chunk + chunk_len, "\r\n", 2);
+		len += chunk_len + CHUNK_OVERHEAD;
+	}
+
+	if (_body_done && space - len >= LAST_CHUNK_LEN) {
+		memcpy(_buffer + len, LAST_CHUNK, LAST_CHUNK_LEN);
+		len += LAST_CHUNK_LEN;
+		_writing = false;
+	}
+
+	if (len > 0) {
+		_client.add((const char*) _buffer, len);
+		_client.send();
+	}
+
+	// Start the next request while waiting for the response to this one.
+	if (!_writing) {
+		startRequest();
+	}
+}
+
+void http::PushClient::finishRequest(const uint16_t status) {
+	Request &request = _pending[_pending_start];
+	const ResponseHandler handler = std::move(request.handler);
+	request.body = nullptr;
+	if (status != 0) {
+		_duration.observe((uint64_t) esp_timer_get_time() - request.start);
+	}
+
+	_pending_start = (_pending_start + 1) % MAX_PIPELINED_REQUESTS;
+	_pending_count.store(_pending_count.load() - 1);
+	handler(status);
+}
+
+void http::PushClient::handleData(const uint8_t *data, const size_t len) {
+	size_t pos = 0;
+	while (pos < len) {
+		pos += _parser.parse(data + pos, len - pos);
+		if (_parser.hasError()
+				|| (_parser.isComplete() && _pending_count.load() == 0)) {
+			log_e("Received an invalid response from %s.", _host);
+			_client.close(true);
+			return;
+		} else if (_parser.isComplete()) {
+			// A response before the end of the request means the rest of it won't be read.
+			const bool interrupted = _writing && _pending_count.load() == 1;
+			const bool keep_alive = _parser.isKeepAlive();
+			const uint16_t status = _parser.getStatus();
+			_parser.reset();
+			if (interrupted) {
+				_writing = false;
+			}
+			finishRequest(status);
+			if (interrupted || !keep_alive) {
+				_client.close(true);
+				return;
+			}
+		}
+	}
+}
+
+void http::PushClient::handleDisconnect() {
+	if (_parser.finish() && _pending_count.load() > 0) {
+		finishRequest(_parser.getStatus());
+	}
+	_parser.reset();
+	_writing = false;
+
+	while (_pending_count.load() > 0) {
+		log_e("Connection to %s was closed before receiving a response.", _host);
+		finishRequest(0);
+	}
+	failNext();
+}
+
+void http::PushClient::handlePoll() {
+	if (_pending_count.load() > 0
+			&& (uint64_t) esp_timer_get_time() - _pending[_pending_start].start
+					>= _timeout * 1000ull) {
+		log_e("Request to %s timed out.", _host);
+		_client.close(true);
+	} else if (_writing) {
+		writeRequest();
+	} else {
+		startRequest();
+	}
+}
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 */
@@ -0,0 +1,278 @@
+/*
+ * HttpPushClient.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_HTTPPUSHCLIENT_H_
+#define SRC_HTTPPUSHCLIENT_H_
+
+#include "config.h"
+#if ENABLE_PROMETHEUS_PUSH == 1
+#include <atomic>
+#include <functional>
+#include <string>
+#include <http_response_parser.h>
+#include <prometheus_registry.h>
+#ifdef ESP32
+#include <AsyncTCP.h>
+#elif defined(ESP8266)
+#include <ESPAsyncTCP.h>
+#endif
+
+namespace http {
+
+/**
+ * A HTTP/1.1 client sending POST requests with chunked bodies to a single server.
+ *
+ * The connection is kept alive between requests, and only reopened if the server closed it.
+ * Each part of a request, including the headers, is written using a single write to the connection.
+ * A new request can be started while the response to the previous one is still being received.
+ * Responses are parsed using an incremental parser, and matched to their request in order.
+ *
+ * Requests are handed to the connection task by push.
+ * Requests on an open connection are started the next time the connection is polled.
+ * All other methods, and the body writers and response handlers, are called from the connection task.
+ */
+class PushClient {
+public:
+	/**
+	 * The max number of requests waiting for their response at the same time.
+	 */
+	static constexpr uint8_t MAX_PIPELINED_REQUESTS = 2;
+
+	/**
+	 * The max number of bytes to write to the connection at once.
+	 */
+	static constexpr size_t WRITE_BUFFER_SIZE = 536;
+
+	/**
+	 * A function writing the next part of a request body to the given buffer.
+	 * Returns the number of bytes written, or zero once the body is complete.
+	 */
+	typedef std::function<size_t(uint8_t *buffer, const size_t max_len)> BodyWriter;
+
+	/**
+	 * A function handling the HTTP status code of the response to a request.
+	 * The status code is zero if the request failed without a response.
+	 */
+	typedef std::function<void(const uint16_t status)> ResponseHandler;
+private:
+	/**
+	 * A single request, with the handler for its response.
+	 */
+	struct Request {
+		/**
+		 * The function writing the request body.
+		 */
+		BodyWriter body;
+
+		/**
+		 * The function handling the response.
+		 */
+		ResponseHandler handler;
+
+		/**
+		 * The system time in microseconds at which the request was started.
+		 */
+		uint64_t start;
+	};
+
+	/**
+	 * The states of the request handed to the connection task.
+	 */
+	enum NextState : uint8_t {
+		NEXT_EMPTY, NEXT_READY, NEXT_TAKEN
+	};
+
+	/**
+	 * The address of the server.
+	 */
+	const char *const _host;
+
+	/**
+	 * The port of the server.
+	 */
+	const uint16_t _port;
+
+	/**
+	 * The request path. Must not be modified while requests are in progress.
+	 */
+	const std::string &_path;
+
+	/**
+	 * The value of the Content-Type header.
+	 */
+	const char *const _content_type;
+
+	/**
+	 * The value of the Content-Encoding header, or NULL to not send one.
+	 */
+	const char *const _content_encoding;
+
+	/**
+	 * The time after which a request without a response is aborted, in milliseconds.
+	 */
+	const uint32_t _timeout;
+
+	/**
+	 * The counter for opened connections.
+	 */
+	prom::Counter &_connects;
+
+	/**
+	 * The histogram for the time between starting a request and receiving its response.
+	 */
+	prom::Histogram &_duration;
+
+	/**
+	 * The connection to the server.
+	 */
+	AsyncClient _client;
+
+	/**
+	 * The parser for the responses of the server.
+	 */
+	ResponseParser _parser;
+
+	/**
+	 * The request handed to the connection task by push.
+	 */
+	Request _next;
+
+	/**
+	 * The state of the request handed to the connection task.
+	 */
+	std::atomic<uint8_t> _next_state { NEXT_EMPTY };
+
+	/**
+	 * The requests waiting for a response, oldest first.
+	 * The last one may still be being written.
+	 */
+	Request _pending[MAX_PIPELINED_REQUESTS];
+
+	/**
+	 * The index of the oldest request waiting for a response.
+	 */
+	uint8_t _pending_start = 0;
+
+	/**
+	 * The number of requests waiting for a response.
+	 */
+	std::atomic<uint8_t> _pending_count { 0 };
+
+	/**
+	 * Whether the newest pending request is still being written.
+	 */
+	bool _writing = false;
+
+	/**
+	 * Whether the headers of the request being written were written.
+	 */
+	bool _headers_written = false;
+
+	/**
+	 * Whether the body writer of the request being written returned zero.
+	 */
+	bool _body_done = false;
+
+	/**
+	 * The buffer for the data to write to the connection.
+	 */
+	uint8_t _buffer[WRITE_BUFFER_SIZE];
+
+	/**
+	 * Moves the request handed to the connection task to the end of the pending requests, if there is one.
+	 *
+	 * @return	True if a request was taken.
+	 */
+	bool takeNext();
+
+	/**
+	 * Fails the request handed to the connection task, if there is one.
+	 */
+	void failNext();
+
+	/**
+	 * Starts the next request, if one was handed over and the connection is ready for it.
+	 */
+	void startRequest();
+
+	/**
+	 * Writes as much of the current request as fits into the send buffer of the connection.
+	 */
+	void writeRequest();
+
+	/**
+	 * Handles the response to the oldest pending request.
+	 *
+	 * @param status	The status code of the response, or zero if there was no response.
+	 */
+	void finishRequest(const uint16_t status);
+
+	/**
+	 * Handles data received from the server.
+	 *
+	 * @param data	The received data.
+	 * @param len	The length of the received data.
+	 */
+	void handleData(const uint8_t *data, const size_t len);
+
+	/**
+	 * Handles the connection being closed, or failing to connect.
+	 * Fails all requests that didn't get a response.
+	 */
+	void handleDisconnect();
+
+	/**
+	 * Starts handed over requests, and aborts requests that exceeded the timeout.
+	 */
+	void handlePoll();
+public:
+	/**
+	 * Creates a new push client.
+	 * All strings have to remain valid for the lifetime of this object.
+	 *
+	 * @param host			The address of the server.
+	 * @param port			The port of the server.
+	 * @param path			The request path.
+	 * @param content_type	The value of the Content-Type header.
+	 * @param content_encoding	The value of the Content-Encoding header, or NULL to not send one.
+	 * @param timeout		The time after which a request without a response is aborted, in milliseconds.
+	 * @param connects		The counter for opened connections.
+	 * @param duration		The histogram for the time between starting a request and receiving its response.
+	 */
+	PushClient(const char *host, const uint16_t port, const std::string &path,
+			const char *content_type, const char *content_encoding,
+			const uint32_t timeout, prom::Counter &connects,
+			prom::Histogram &duration);
+
+	PushClient(const PushClient &other) = delete;
+
+	PushClient& operator=(const PushClient &other) = delete;
+
+	/**
+	 * Hands a new request to the connection task, and opens the connection if it isn't open.
+	 *
+	 * @param body		The function writing the request body.
+	 * @param handler	The function handling the response.
+	 * @return	False if the previous request wasn't started yet, so this request was dropped.
+	 */
+	bool push(const BodyWriter body, const ResponseHandler handler);
+
+	/**
+	 * Checks whether there is a request that didn't get a response yet.
+	 *
+	 * @return	True if a request is waiting to be started, or for its response.
+	 */
+	bool isBusy() const;
+};
+
+}
+
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 */
+#endif /* SRC_HTTPPUSHCLIENT_H_ */
@@ -0,0 +1,142 @@
+/*
+ * HttpRequestStats.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "HttpRequestStats.h"
+#if ENABLE_WEB_SERVER == 1
+#include <utils.h>
+#include <fallback_log.h>
+
+/**
+ * The label values of the tracked request methods, by method index.
+ */
+static constexpr const char *METHOD_NAMES[] = { "get", "post", "delete", "put",
+		"patch", "head", "options", "other" };
+
+/**
+ * The label values of the tracked status classes, by status class index.
+ */
+static constexpr const char *STATUS_CLASS_NAMES[] = { "1xx", "2xx", "3xx",
+		"4xx", "5xx" };
+
+web::HttpRequestStats web::http_requests_total(PROMETHEUS_NAMESPACE,
+		"http_requests_total",
+		"The total number of HTTP requests handled by this server.");
+
+web::HttpRequestStats::HttpRequestStats(const char *metric_namespace,
+		const char *name, const char *help) :
+		MetricFamily(metric_namespace, name, "", help) {
+
+}
+
+uint8_t web::HttpRequestStats::getMethodIndex(
+		const WebRequestMethodComposite method) {
+	switch (method) {
+	case HTTP_GET:
+	case HTTP_POST:
+	case HTTP_DELETE:
+	case HTTP_PUT:
+	case HTTP_PATCH:
+	case HTTP_HEAD:
+	case HTTP_OPTIONS:
+		return utils::get_msb(method);
+	default:
+		return METHOD_COUNT - 1;
+	}
+}
+
+uint8_t web::HttpRequestStats::addRoute(const char *path) {
+	if (_route_count >= HTTP_REQUEST_STATS_MAX_ROUTES) {
+		log_w("Can't track requests to \"%s\", max number of routes reached.",
+				path);
+		return OTHER_ROUTE;
+	}
+	_routes[_route_count] = path;
+	return _route_count++;
+}
+
+void web::HttpRequestStats::track(const uint8_t route,
+		const WebRequestMethodComposite method, const uint16_t status) {
+	// Status codes outside the valid range can only come from a bug, so they count as server errors.
+	const uint8_t status_class =
+			status >= 100 && status < 600 ? status / 100 - 1 : 4;
+	const size_t cell = ((size_t) (route < OTHER_ROUTE ? route : OTHER_ROUTE)
+			* METHOD_COUNT + getMethodIndex(method)) * STATUS_CLASS_COUNT
+			+ status_class;
+
+	_counters[_cells.getSeries(cell)].inc();
+}
+
+const char* web::HttpRequestStats::getType(const bool openmetrics) const {
+	return "counter";
+}
+
+bool web::HttpRequestStats::getLabels(const size_t index, size_t &counter,
+		const char *&method, const char *&status_class,
+		const char *&path) const {
+	// The overflow counter is always written first, so the index of the other counters can't shift.
+	method = "other";
+	status_class = "other";
+	path = "other";
+	counter = HTTP_REQUEST_STATS_MAX_SERIES;
+	if (index > 0) {
+		counter = index - 1;
+		uint16_t cell;
+		if (counter >= HTTP_REQUEST_STATS_MAX_SERIES
+				|| !_cells.getCell(counter, cell)) {
+			return false;
+		}
+
+		status_class = STATUS_CLASS_NAMES[cell % STATUS_CLASS_COUNT];
+		method = METHOD_NAMES[cell / STATUS_CLASS_COUNT % METHOD_COUNT];
+		const uint8_t route = cell / STATUS_CLASS_COUNT / METHOD_COUNT;
+		if (route != OTHER_ROUTE) {
+			path = _routes[route];
+		}
+	}
+	return true;
+}
+
+size_t web::HttpRequestStats::writeSample(char *buffer, const size_t max_len,
+		const size_t index, const bool openmetrics,
+		const uint8_t consumer) const {
+	size_t counter;
+	const char *method;
+	const char *status_class;
+	const char *path;
+	if (!getLabels(index, counter, method, status_class, path)) {
+		return 0;
+	}
+
+	const size_t len = writeName(buffer, max_len);
+	return len + snprintf(buffer + std::min(len, max_len),
+			max_len - std::min(len, max_len),
+			"{method=\"%s\",code=\"%s\",path=\"%s\"} %llu\n", method,
+			status_class, path,
+			(long long unsigned int) _counters[counter].get());
+}
+
+bool web::HttpRequestStats::writeMetric(prom::MetricEncoder &encoder,
+		const size_t index, const uint8_t consumer) const {
+	size_t counter;
+	const char *method;
+	const char *status_class;
+	const char *path;
+	if (!getLabels(index, counter, method, status_class, path)) {
+		return false;
+	}
+
+	encoder.writeLabel("method", method);
+	encoder.writeLabel("code", status_class);
+	encoder.writeLabel("path", path);
+	encoder.writeValue(prom::MetricEncoder::COUNTER,
+			(double) _counters[counter].get());
+	return true;
+}
+#endif /* ENABLE_WEB_SERVER == 1 */
@@ -0,0 +1,152 @@
+/*
+ * HttpRequestStats.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_HTTPREQUESTSTATS_H_
+#define SRC_HTTPREQUESTSTATS_H_
+
+#include "config.h"
+#if ENABLE_WEB_SERVER == 1
+#include <ESPAsyncWebServer.h>
+#include <prometheus_registry.h>
+
+namespace web {
+
+/**
+ * A metric family counting the handled HTTP requests by route, method, and status class.
+ *
+ * Requests are tracked by the id of the route that handled them, rather than their url.
+ * Requests to unknown paths share a single route with the path "other".
+ * This limits the number of series, no matter which urls clients request.
+ *
+ * All memory is allocated at compile time.
+ * Each route, method, and status class combination maps to a cell of a flat table.
+ * Cells are assigned a counter the first time they are incremented, in constant time.
+ * Only cells first incremented once all counters were assigned share the overflow counter.
+ *
+ * Tracking requests and writing the statistics is safe from any task, without a lock.
+ * The counters are sharded by core, so concurrent requests don't contend on the same counter.
+ */
+class HttpRequestStats: public prom::MetricFamily {
+public:
+	/**
+	 * The route id used for requests to unknown paths.
+	 */
+	static constexpr uint8_t OTHER_ROUTE = HTTP_REQUEST_STATS_MAX_ROUTES;
+private:
+	/**
+	 * The number of tracked request methods.
+	 * GET, POST, DELETE, PUT, PATCH, HEAD, OPTIONS, and other.
+	 */
+	static constexpr uint8_t METHOD_COUNT = 8;
+
+	/**
+	 * The number of tracked status classes, 1xx to 5xx.
+	 */
+	static constexpr uint8_t STATUS_CLASS_COUNT = 5;
+
+	/**
+	 * The number of cells in the route, method, and status class table.
+	 */
+	static constexpr size_t CELL_COUNT = (HTTP_REQUEST_STATS_MAX_ROUTES + 1)
+			* METHOD_COUNT * STATUS_CLASS_COUNT;
+
+	/**
+	 * The paths of the registered routes, by route id.
+	 */
+	const char *_routes[HTTP_REQUEST_STATS_MAX_ROUTES];
+
+	/**
+	 * The number of registered routes.
+	 */
+	uint8_t _route_count = 0;
+
+	/**
+	 * The table assigning counters to the route, method, and status class combinations.
+	 */
+	prom::SeriesTable<CELL_COUNT, HTTP_REQUEST_STATS_MAX_SERIES> _cells;
+
+	/**
+	 * The request counters.
+	 * The last counter counts the requests for which no other counter was available.
+	 */
+	prom::ShardedCounter _counters[HTTP_REQUEST_STATS_MAX_SERIES + 1];
+
+	/**
+	 * Gets the table index of the given request method.
+	 *
+	 * @param method	The request method to get the index for.
+	 * @return	The method index.
+	 */
+	static uint8_t getMethodIndex(const WebRequestMethodComposite method);
+
+	/**
+	 * Gets the counter and the label values of the sample with the given index.
+	 *
+	 * @param index			The index of the sample.
+	 * @param counter		Set to the index of the counter of the sample.
+	 * @param method		Set to the method label value.
+	 * @param status_class	Set to the status class label value.
+	 * @param path			Set to the path label value.
+	 * @return	False if there is no sample with the given index.
+	 */
+	bool getLabels(const size_t index, size_t &counter, const char *&method,
+			const char *&status_class, const char *&path) const;
+public:
+	/**
+	 * Creates a new http request stats metric family.
+	 *
+	 * @param metric_namespace	The namespace of the metric.
+	 * @param name				The name of the metric.
+	 * @param help				The help text of the metric.
+	 */
+	HttpRequestStats(const char *metric_namespace, const char *name,
+			const char *help);
+
+	/**
+	 * Registers a route to track requests for.
+	 * Should only be called during startup.
+	 *
+	 * The given path has to stay valid for the lifetime of this object.
+	 *
+	 * @param path	The path of the new route.
+	 * @return	The id of the new route, or OTHER_ROUTE if the max number of routes was reached.
+	 */
+	uint8_t addRoute(const char *path);
+
+	/**
+	 * Counts a handled request.
+	 * Takes constant time, and can be called from any task.
+	 *
+	 * @param route		The id of the route that handled the request.
+	 * @param method	The method of the request.
+	 * @param status	The status code of the response.
+	 */
+	void track(const uint8_t route, const WebRequestMethodComposite method,
+			const uint16_t status);
+
+	virtual const char* getType(const bool openmetrics) const override;
+
+	virtual size_t writeSample(char *buffer, const size_t max_len,
+			const size_t index, const bool openmetrics,
+			const uint8_t consumer) const override;
+
+	virtual bool writeMetric(prom::MetricEncoder &encoder, const size_t index,
+			const uint8_t consumer) const override;
+};
+
+/**
+ * The metric counting the handled HTTP requests.
+ */
+extern HttpRequestStats http_requests_total;
+
+} /* namespace web */
+
+#endif /* ENABLE_WEB_SERVER == 1 */
+#endif /* SRC_HTTPREQUESTSTATS_H_ */
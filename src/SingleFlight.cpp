@@ -0,0 +1,21 @@
+/*
+ * SingleFlight.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "SingleFlight.h"
+#if ENABLE_WEB_SERVER == 1
+
+prom::CounterFamily web::SingleFlightBase::_total_coalesced(
+		PROMETHEUS_NAMESPACE, "http_coalesced_requests_total", "",
+		"The total number of requests that reused the render of a concurrent identical request.");
+
+void web::SingleFlightBase::registerMetrics(prom::Registry &registry) {
+	registry.add(_total_coalesced);
+}
+#endif /* ENABLE_WEB_SERVER == 1 */
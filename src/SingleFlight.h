@@ -0,0 +1,140 @@
+/*
+ * SingleFlight.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_SINGLEFLIGHT_H_
+#define SRC_SINGLEFLIGHT_H_
+
+#include "config.h"
+#if ENABLE_WEB_SERVER == 1
+#include <Arduino.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <prometheus_registry.h>
+#ifdef ESP8266
+#include <fallback_timer.h>
+#endif
+
+namespace web {
+
+/**
+ * The non template base class of SingleFlight, tracking the statistics of all instances.
+ */
+class SingleFlightBase {
+protected:
+	/**
+	 * The metric counting the requests that reused a render of any SingleFlight instance.
+	 */
+	static prom::CounterFamily _total_coalesced;
+public:
+	/**
+	 * Registers the metric counting the requests that reused the render of a concurrent identical request.
+	 *
+	 * @param registry	The registry to add the metric to.
+	 */
+	static void registerMetrics(prom::Registry &registry);
+};
+
+/**
+ * A helper to coalesce concurrent identical requests into a single render.
+ *
+ * Renders are stored as shared pointers, which are held by the responses sending them.
+ * As long as any response still holds a render, identical requests get the same render.
+ * The render is freed once the last response holding it is done.
+ *
+ * Since all web requests are handled by the same task, a render is considered in progress
+ * until all responses using it are sent, rather than only while it is being created.
+ * Renders that are streamed while they are sent, like the metrics exposition, can use a utils::SharedStream.
+ *
+ * This class is **NOT** thread safe, and should only be used from the web server task.
+ *
+ * @tparam T	The type of the rendered data.
+ */
+template<typename T>
+class SingleFlight: public SingleFlightBase {
+private:
+	/**
+	 * A render that may still be held by some responses.
+	 */
+	struct Entry {
+		/**
+		 * The rendered data, if it is still held by a response.
+		 */
+		std::weak_ptr<T> value;
+
+		/**
+		 * The system time in ms at which the data was rendered.
+		 */
+		uint64_t time;
+	};
+
+	/**
+	 * The renders that may still be in use, by request key.
+	 */
+	std::map<String, Entry> _inflight;
+
+	/**
+	 * The max age of a render in ms, for it to be reused by a new request.
+	 */
+	const uint32_t _max_age;
+public:
+	/**
+	 * Creates a new SingleFlight instance.
+	 *
+	 * @param max_age	The max age of a render in ms, for it to be reused.
+	 * 					Limits how outdated data sent to a request can be, if an earlier client is slow.
+	 */
+	SingleFlight(const uint32_t max_age) :
+			_max_age(max_age) {
+	}
+
+	/**
+	 * Gets the render for the given key.
+	 *
+	 * Reuses the render of an earlier request with the same key, if it is still in use and not too old.
+	 * Otherwise calls the given render function, and stores its result.
+	 *
+	 * @param key		The key identifying identical requests.
+	 * @param render	The function creating the data, if it can't be reused.
+	 * @param reusable	A function checking whether a render that is still in use can be reused.
+	 * 					Used for renders that are streamed, and can only be shared until a part of them was dropped.
+	 * @return	A shared pointer to the render for the key.
+	 */
+	std::shared_ptr<T> get(const String &key,
+			const std::function<std::shared_ptr<T>()> &render,
+			const std::function<bool(const T&)> &reusable = nullptr) {
+		const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
+		typename std::map<String, Entry>::iterator it = _inflight.find(key);
+		if (it != _inflight.end() && now - it->second.time <= _max_age) {
+			std::shared_ptr<T> value = it->second.value.lock();
+			if (value && (!reusable || reusable(*value))) {
+				_total_coalesced.get().inc();
+				return value;
+			}
+		}
+
+		// Remove renders that aren't used anymore.
+		for (it = _inflight.begin(); it != _inflight.end();) {
+			if (it->second.value.expired()) {
+				it = _inflight.erase(it);
+			} else {
+				it++;
+			}
+		}
+
+		std::shared_ptr<T> value = render();
+		_inflight[key] = Entry { value, now };
+		return value;
+	}
+};
+
+}
+#endif /* ENABLE_WEB_SERVER == 1 */
+#endif /* SRC_SINGLEFLIGHT_H_ */
@@ -111,6 +111,44 @@ static constexpr uint16_t WEB_SERVER_PORT = 80;
 // The range of valid values is -8 to -15.
 // Default is -10.
 static constexpr int8_t GZIP_DECOMP_WINDOW_SIZE = -10;
+// Whether static files embedded in the firmware should be handed to the TCP stack directly from flash.
+// This avoids copying them to a RAM buffer first, but is only possible on the ESP32, since its flash is memory mapped.
+// On the ESP8266 this is always disabled, and the files are copied chunk by chunk instead.
+// Set to 0 to disable.
+// Default is 1.
+#ifndef ENABLE_ZERO_COPY_FLASH_RESPONSES
+#define ENABLE_ZERO_COPY_FLASH_RESPONSES 1
+#endif
+// Whether static files embedded in the firmware should be sent by the custom flash response.
+// Set to 0 to send them using the progmem response of ESPAsyncWebServer instead, which copies each chunk to a newly allocated buffer.
+// This is only meant as a baseline for benchmarks, the flash response metrics are recorded either way.
+// Set to 1 to enable and 0 to disable.
+// Default is 1.
+#ifndef ENABLE_FLASH_RESPONSES
+#define ENABLE_FLASH_RESPONSES 1
+#endif
+// Whether the main page should be sent as a single gzip compressed bundle, with the stylesheet and script inlined.
+// This saves the browser two requests when loading the page for the first time.
+// Clients not accepting gzip compressed responses still get the page with separate stylesheet and script.
+// The bundle is only embedded into the firmware if this is enabled.
+// Set to 1 to enable and 0 to disable.
+// Default is 0.
+#ifndef ENABLE_INLINE_WEB_BUNDLE
+#define ENABLE_INLINE_WEB_BUNDLE 0
+#endif
+// The max age in milliseconds of a rendered page, for it to be reused for an identical request.
+// Renders are only reused while an earlier response is still sending them.
+// Default is 1000.
+static constexpr uint16_t SINGLE_FLIGHT_MAX_AGE = 1000;
+// The max number of distinct request paths to track HTTP request statistics for.
+// Requests to paths registered after this limit, or to unknown paths, are tracked as path "other".
+// Default is 24.
+static constexpr uint8_t HTTP_REQUEST_STATS_MAX_ROUTES = 24;
+// The max number of path, method, and status class combinations to export HTTP request statistics for.
+// Requests with a combination beyond this limit are counted in a single series with all labels set to "other".
+// Has to be less than 254.
+// Default is 64.
+static constexpr uint8_t HTTP_REQUEST_STATS_MAX_SERIES = 64;
 // Whether or not a Content-Security-Policy should be sent with html pages.
 // This prevents scripts from other sources from being loaded, but can make debugging and addons harder/less reliable.
 // Set to 0 to disable.
@@ -127,6 +165,10 @@ static constexpr int8_t GZIP_DECOMP_WINDOW_SIZE = -10;
 #endif
 
 // Web server automatic config.
+#ifndef ESP32
+#undef ENABLE_ZERO_COPY_FLASH_RESPONSES
+#define ENABLE_ZERO_COPY_FLASH_RESPONSES 0
+#endif
 #if SERVER_HEADER_APPEND_HARDWARE != 1
 static constexpr const char SERVER_HEADER[] = SERVER_HEADER_PROGRAM;
 #else
@@ -187,6 +229,11 @@ static constexpr uint8_t SENSOR_PIN = 5;
 #warning Prometheus scrape support requires the web server to be enabled.
 #endif
 #endif
+// The number of bytes of a metrics exposition to keep, so concurrent identical scrapes can share it.
+// A scrape can only join an exposition that didn't produce more than this yet, and isn't older than SINGLE_FLIGHT_MAX_AGE.
+// Set to 0 to disable coalescing scrapes.
+// Default is 4096.
+static constexpr size_t PROMETHEUS_SCRAPE_SHARED_BUFFER_SIZE = 4096;
 // The namespace to be used as a prefix for most prometheus metrics.
 // Will by default also be used as the pushgateway namespace.
 // The default namespace is "esptherm".
@@ -229,6 +276,151 @@ static constexpr const char PROMETHEUS_PUSH_NAMESPACE[] = "";
 // The length of the prometheus pushgateway namespace string.
 static constexpr size_t PROMETHEUS_PUSH_NAMESPACE_LEN = utils::strlen(PROMETHEUS_PUSH_NAMESPACE);
 #endif
+// Whether the bodies of the pushgateway requests should be gzip compressed.
+// Reduces the amount of data to send, at the cost of about 4KiB of memory while pushing.
+// Requires a pushgateway that accepts gzip compressed request bodies.
+// Set to 1 to enable and to 0 to disable.
+// Default is 1.
+#ifndef ENABLE_PROMETHEUS_PUSH_GZIP
+#define ENABLE_PROMETHEUS_PUSH_GZIP 1
+#endif
+// Whether the esp should send its metrics to a prometheus remote write receiver.
+// The metrics are collected at a fixed interval, with the time they were collected at, and sent in batches.
+// The current time is requested from a SNTP server.
+// Not supported in deep sleep mode.
+// Set to 1 to enable and to 0 to disable.
+// Default is 0.
+#ifndef ENABLE_PROMETHEUS_REMOTE_WRITE
+#define ENABLE_PROMETHEUS_REMOTE_WRITE 0
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#if ENABLE_DEEP_SLEEP_MODE == 1
+#undef ENABLE_PROMETHEUS_REMOTE_WRITE
+#define ENABLE_PROMETHEUS_REMOTE_WRITE 0
+#warning Prometheus remote write is not supported in deep sleep mode.
+#endif
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+// The address of the prometheus remote write receiver.
+// Can be an IP address, a hostname, or a domain name.
+static constexpr const char PROMETHEUS_REMOTE_WRITE_ADDR[] = "192.168.2.203";
+// The port of the prometheus remote write receiver.
+// The default prometheus port is 9090.
+static constexpr uint16_t PROMETHEUS_REMOTE_WRITE_PORT = 9090;
+// The request path of the remote write endpoint.
+// Prometheus receives remote writes on "/api/v1/write", if started with --web.enable-remote-write-receiver.
+static constexpr const char PROMETHEUS_REMOTE_WRITE_PATH[] = "/api/v1/write";
+// The time between two collections of the metrics.
+// Specified in seconds.
+// Default is 30.
+static constexpr uint16_t PROMETHEUS_REMOTE_WRITE_COLLECT_INTERVAL = 30;
+// The min time between two remote write requests.
+// Requests are sent earlier if the buffer is half full.
+// Specified in seconds.
+// Default is 120.
+static constexpr uint16_t PROMETHEUS_REMOTE_WRITE_SEND_INTERVAL = 120;
+// The size of the buffer for collected samples, in bytes.
+// Samples collected while the buffer is full are dropped.
+// The compressed request needs a second buffer, which is slightly larger than this.
+// Default is 8192.
+static constexpr size_t PROMETHEUS_REMOTE_WRITE_BUFFER_SIZE = 8192;
+// The time to wait before retrying a failed request.
+// Doubled after every failure, up to the max backoff.
+// Specified in seconds.
+// Default is 5.
+static constexpr uint16_t PROMETHEUS_REMOTE_WRITE_MIN_BACKOFF = 5;
+// The max time to wait before retrying a failed request.
+// Specified in seconds.
+// Default is 300.
+static constexpr uint16_t PROMETHEUS_REMOTE_WRITE_MAX_BACKOFF = 300;
+#endif
+// Whether to attach the time at which they were taken to the temperature and humidity prometheus samples.
+// The current time is requested from a SNTP server.
+// Every measurement since the last finished scrape, successful push, or remote write collection is written, with its timestamp.
+// Note that the official prometheus pushgateway rejects samples with timestamps.
+// Set to 1 to enable and to 0 to disable.
+// Default is 0.
+#ifndef ENABLE_MEASUREMENT_TIMESTAMPS
+#define ENABLE_MEASUREMENT_TIMESTAMPS 0
+#endif
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT != 1 && ENABLE_PROMETHEUS_PUSH != 1 && ENABLE_PROMETHEUS_REMOTE_WRITE != 1
+#undef ENABLE_MEASUREMENT_TIMESTAMPS
+#define ENABLE_MEASUREMENT_TIMESTAMPS 0
+#warning Measurement timestamps require prometheus scrape, push, or remote write support to be enabled.
+#endif
+#endif
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+// The SNTP server to get the current time from.
+// Default is "pool.ntp.org".
+static constexpr const char SNTP_SERVER[] = "pool.ntp.org";
+#endif
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+// The max number of measurements to keep until the next scrape or push.
+// Older measurements are dropped.
+// Default is 32.
+static constexpr size_t MEASUREMENT_BACKFILL_SIZE = 32;
+#endif
+
+// Performance monitoring options
+// The time a single section of the main loop can take before it is considered a stall.
+// Stalls are logged, and counted in the loop stalls metric.
+// Specified in milliseconds.
+// Default is 100.
+static constexpr uint16_t LOOP_STALL_THRESHOLD = 100;
+#ifdef ESP32
+// The time between two samples of the cpu usage of the FreeRTOS tasks.
+// Only used if the FreeRTOS run time stats are enabled in the framework.
+// Specified in seconds.
+// Default is 10.
+static constexpr uint16_t TASK_CPU_SAMPLE_INTERVAL = 10;
+#endif
+// Whether to record the duration of request handling, measurements, and pushes as spans.
+// The recorded spans can be downloaded from /debug/trace as Chrome trace event JSON, and viewed using Perfetto.
+// Requires the web server.
+// Set to 1 to enable and to 0 to disable.
+// Default is 0.
+#ifndef ENABLE_SPAN_TRACING
+#define ENABLE_SPAN_TRACING 0
+#endif
+#if ENABLE_SPAN_TRACING == 1
+#if ENABLE_WEB_SERVER != 1
+#undef ENABLE_SPAN_TRACING
+#define ENABLE_SPAN_TRACING 0
+#endif
+#endif
+// The max number of spans to keep.
+// Each span uses 24 bytes of memory.
+// Default is 256.
+static constexpr size_t SPAN_TRACE_CAPACITY = 256;
+// Whether to store log messages in a ring buffer, and print them from a low priority task.
+// This keeps the log_X macros from blocking on the serial port, but messages are dropped if the buffer is full.
+// The max number of buffered messages can be set using ASYNC_LOG_CAPACITY, which has to be a power of two.
+// Has to be set as a build flag, since the fallback log library has to see it too.
+// Set to 1 to enable and to 0 to disable.
+// Default is 0.
+#ifndef ENABLE_ASYNC_LOG
+#define ENABLE_ASYNC_LOG 0
+#endif
+// Whether to write log messages as binary frames containing a token instead of the format string.
+// This removes the format strings from the firmware, and reduces the serial bandwidth used by log messages.
+// The token database is generated as log_tokens.json in the build directory,
+// and shared/decode_log.py uses it to turn the serial output back into text.
+// Can't be combined with the async log.
+// Has to be set as a build flag, since the fallback log library has to see it too.
+// Set to 1 to enable and to 0 to disable.
+// Default is 0.
+#ifndef ENABLE_TOKENIZED_LOG
+#define ENABLE_TOKENIZED_LOG 0
+#endif
+// Whether to count heap allocations by call site and by the request handler making them.
+// The counts can be downloaded from /debug/alloc, if the web server is enabled.
+// Has to be set as a build flag, since the allocation profiler library has to see it too.
+// Set to 1 to enable and to 0 to disable.
+// Default is 0.
+#ifndef ENABLE_ALLOCATION_PROFILER
+#define ENABLE_ALLOCATION_PROFILER 0
+#endif
 
 // MQTT options
 // Whether or not to enable the MQTT client.
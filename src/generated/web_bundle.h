@@ -0,0 +1,39 @@
+/*
+ * web_bundle.h
+ *
+ * **Warning:** This file is automatically generated, and should not be edited manually.
+ *
+ * This file contains the segment table and content security policy of the inlined main page bundle.
+ *
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_GENERATED_WEB_BUNDLE_H_
+#define SRC_GENERATED_WEB_BUNDLE_H_
+
+#include "../webhandler.h"
+#if ENABLE_WEB_SERVER == 1
+
+/**
+ * The segments of the gzip template "index.html.gzt".
+ */
+static constexpr web::GzipTemplateSegment INDEX_HTML_GZT_SEGMENTS[] = {
+		{ 1726, 4281, 0x288ECC47, "TEMP" },
+		{ 1776, 48, 0x26858ABA, "HUMID" },
+		{ 1847, 73, 0xC4179F26, "TIME" },
+		{ 1855, 2, 0x270A4974, "TIME" },
+		{ 1888, 36, 0xCA6B217F, NULL } };
+
+/**
+ * The number of segments in the gzip template "index.html.gzt".
+ */
+static constexpr size_t INDEX_HTML_GZT_SEGMENT_COUNT = 5;
+
+/**
+ * The Content-Security-Policy allowing the inlined stylesheet and script of "index.html.gzt".
+ */
+static constexpr char INDEX_HTML_GZT_CSP[] = "default-src 'self'; style-src 'self' 'sha256-6SfnghJBg13auK+9hTnKer+/C6lRtu4TDv4IKquQ/uA='; script-src 'self' 'sha256-HOZ7YtAcz1Y+qM9noVq2vaK+uaNL8VhIsn4gmCrULhg='";
+
+#endif /* ENABLE_WEB_SERVER == 1 */
+#endif /* SRC_GENERATED_WEB_BUNDLE_H_ */
@@ -0,0 +1,148 @@
+/*
+ * logger.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "logger.h"
+#if ENABLE_ASYNC_LOG == 1
+#include <atomic>
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+prom::CounterFamily logger::dropped_total(PROMETHEUS_NAMESPACE,
+		"log_dropped_messages_total", "",
+		"The number of log messages dropped because the async log was full.");
+
+/**
+ * The max length of a single log line, including the line ending.
+ * Longer lines are truncated.
+ */
+static constexpr size_t MAX_LINE_LEN = 255;
+
+#ifdef ESP32
+/**
+ * The time between two runs of the drain task, in milliseconds.
+ */
+static constexpr uint16_t DRAIN_INTERVAL = 20;
+#else
+/**
+ * The max number of lines to print per main loop iteration.
+ */
+static constexpr size_t DRAIN_LIMIT = 8;
+#endif
+
+/**
+ * Set while a task is draining the async log, since it only supports a single consumer.
+ */
+static std::atomic_flag draining = ATOMIC_FLAG_INIT;
+
+/**
+ * The number of dropped messages that were already added to the metric.
+ */
+static uint32_t counted_dropped = 0;
+
+/**
+ * Prints messages from the async log to the serial port.
+ * Has to be called while holding the draining flag.
+ *
+ * @param max_lines	The max number of messages to print.
+ */
+static void drainLines(const size_t max_lines) {
+	char line[MAX_LINE_LEN + 1];
+	size_t len = 0;
+	for (size_t i = 0;
+			i < max_lines
+					&& (len = logging::async_log.pop(line, sizeof(line))) > 0;
+			i++) {
+		Serial.write((const uint8_t*) line, len);
+	}
+}
+
+#ifdef ESP32
+/**
+ * The FreeRTOS task draining the async log.
+ *
+ * @param parameter	Unused.
+ */
+static void drainTask(void *parameter) {
+	while (true) {
+		if (!draining.test_and_set(std::memory_order_acquire)) {
+			drainLines(SIZE_MAX);
+			draining.clear(std::memory_order_release);
+		}
+		vTaskDelay(pdMS_TO_TICKS(DRAIN_INTERVAL));
+	}
+}
+#endif
+#endif /* ENABLE_ASYNC_LOG == 1 */
+
+#if ENABLE_TOKENIZED_LOG == 1
+/**
+ * Writes a tokenized log frame to the serial port.
+ * Used instead of stdout, which may replace line feeds in the binary frames.
+ *
+ * @param data	The frame to write.
+ * @param len	The length of the frame.
+ */
+static void writeTokenFrame(const uint8_t *data, const size_t len) {
+	Serial.write(data, len);
+}
+#endif
+
+void logger::setup() {
+#if ENABLE_TOKENIZED_LOG == 1
+	logging::setTokenOutput(writeTokenFrame);
+#endif
+#if ENABLE_ASYNC_LOG == 1
+	dropped_total.get();
+	prom::default_registry.add(dropped_total);
+#ifdef ESP32
+	xTaskCreate(drainTask, "async_log", 3072, NULL, tskIDLE_PRIORITY + 1, NULL);
+#endif
+#endif
+}
+
+void logger::loop() {
+#if ENABLE_ASYNC_LOG == 1
+	const uint32_t dropped = logging::async_log.getDropped();
+	if (dropped != counted_dropped) {
+		dropped_total.get().inc(dropped - counted_dropped);
+		counted_dropped = dropped;
+	}
+
+#ifdef ESP8266
+	if (!draining.test_and_set(std::memory_order_acquire)) {
+		drainLines(DRAIN_LIMIT);
+		draining.clear(std::memory_order_release);
+	}
+#endif
+#endif
+}
+
+void logger::flush() {
+#if ENABLE_ASYNC_LOG == 1
+	while (draining.test_and_set(std::memory_order_acquire)) {
+		delay(1);
+	}
+	drainLines(SIZE_MAX);
+	draining.clear(std::memory_order_release);
+#endif
+	Serial.flush();
+}
+
+bool logger::setLevel(const uint8_t level) {
+#if ENABLE_ASYNC_LOG == 1
+	if (level <= logging::LEVEL_VERBOSE) {
+		logging::async_log.setLevel((logging::Level) level);
+		return true;
+	}
+#endif
+	return false;
+}
@@ -0,0 +1,60 @@
+/*
+ * logger.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_LOGGER_H_
+#define SRC_LOGGER_H_
+
+#include "config.h"
+#include <fallback_log.h>
+#if ENABLE_ASYNC_LOG == 1
+#include <prometheus_registry.h>
+#endif
+
+/**
+ * This header, and the source file with the same name, connect the async or tokenized log to the serial port.
+ */
+namespace logger {
+#if ENABLE_ASYNC_LOG == 1
+/**
+ * The metric counting the log messages that were dropped because the async log was full.
+ */
+extern prom::CounterFamily dropped_total;
+#endif
+
+/**
+ * Registers the dropped messages metric, and starts the task draining the async log on the ESP32.
+ * Makes the tokenized log write its frames to the serial port.
+ * Does nothing if both are disabled.
+ */
+void setup();
+
+/**
+ * Updates the dropped messages metric, and drains part of the async log on the ESP8266.
+ * Does nothing if the async log is disabled.
+ */
+void loop();
+
+/**
+ * Prints all messages that are currently in the async log, and waits for them to be sent.
+ * Used before going to sleep.
+ */
+void flush();
+
+/**
+ * Changes the max level of messages to log at runtime.
+ * Messages above the CORE_DEBUG_LEVEL are compiled out, and can't be enabled at runtime.
+ *
+ * @param level	The new max log level, from 0(none) to 5(verbose).
+ * @return	False if the async log is disabled, or the level is invalid.
+ */
+bool setLevel(const uint8_t level);
+}
+
+#endif /* SRC_LOGGER_H_ */
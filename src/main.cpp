@@ -13,6 +13,11 @@
 #include "webhandler.h"
 #include "prometheus.h"
 #include "sensor_handler.h"
+#include "memory.h"
+#include "perf.h"
+#include "tracing.h"
+#include "profiling.h"
+#include "logger.h"
 #if ENABLE_ARDUINO_OTA == 1
 #include <ArduinoOTA.h>
 #endif
@@ -33,10 +38,17 @@ volatile uint64_t start_ms = 0;
 void setup() {
 	start_ms = millis();
 	Serial.begin(115200);
+	logger::setup();
 
 	sensors::SENSOR_HANDLER.begin();
+	sensors::registerMetrics(prom::default_registry);
+	mem::setup();
+	perf::setup();
 
 	setupWiFi();
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	configTime(0, 0, SNTP_SERVER);
+#endif
 #if ENABLE_ARDUINO_OTA == 1
 	setupOTA();
 #endif
@@ -44,15 +56,22 @@ void setup() {
 	web::setup();
 	prom::setup();
 	mqtt::setup();
+	tracing::setup();
+	profiling::setup();
 
 #if ENABLE_DEEP_SLEEP_MODE == 1
 	sensors::SENSOR_HANDLER.requestMeasurement();
 	// FiXME wait for measurements
 
-	printTemperature(Serial, sensors::SENSOR_HANDLER.getTemperature());
+	const sensors::Measurement measurement =
+			sensors::SENSOR_HANDLER.getMeasurement();
+	printTemperature(Serial, measurement.temperature);
 	Serial.print("Humidity: ");
-	Serial.print(sensors::SENSOR_HANDLER.getHumidityString().c_str());
-	if (!std::isnan(sensors::SENSOR_HANDLER.getHumidity())) {
+	char humidity_string[utils::CENTI_CHARS_BUFFER_SIZE];
+	utils::centi_to_chars(humidity_string, sizeof(humidity_string),
+			measurement.humidity, 2, true);
+	Serial.print(humidity_string);
+	if (measurement.humidity != utils::FIXED_UNKNOWN) {
 		Serial.println('%');
 	} else {
 		Serial.println();
@@ -70,6 +89,7 @@ void setup() {
 	}
 
 	WiFi.disconnect(1);
+	logger::flush();
 
 #ifdef ESP32
 	esp_sleep_enable_timer_wakeup(
@@ -231,8 +251,11 @@ void onWiFiEvent(WiFiEvent_t id) {
 
 void loop() {
 	const uint64_t start = (uint64_t) esp_timer_get_time() / 1000;
+	perf::beginLoop();
 
 	if (loop_iterations % 4 == 0) {
+		perf::enterSection(perf::SENSOR);
+		sensors::SENSOR_HANDLER.loop();
 		if (sensors::SENSOR_HANDLER.getTimeSinceMeasurement() == -1
 				|| sensors::SENSOR_HANDLER.getTimeSinceMeasurement()
 						>= sensors::SENSOR_HANDLER.getMinInterval()) {
@@ -243,19 +266,23 @@ void loop() {
 
 		if (loop_iterations % 20 == 0
 				&& sensors::SENSOR_HANDLER.getTimeSinceMeasurement() < 10000) {
-			printTemperature(Serial, sensors::SENSOR_HANDLER.getTemperature());
+			const sensors::Measurement measurement =
+					sensors::SENSOR_HANDLER.getMeasurement();
+			printTemperature(Serial, measurement.temperature);
 			if (sensors::SENSOR_HANDLER.supportsHumidity()) {
 				Serial.print("Relative Humidity: ");
-				Serial.print(
-						utils::float_to_string(
-								sensors::SENSOR_HANDLER.getHumidity(), 2).c_str());
-				if (!std::isnan(sensors::SENSOR_HANDLER.getHumidity())) {
+				char humidity_string[utils::CENTI_CHARS_BUFFER_SIZE];
+				utils::centi_to_chars(humidity_string, sizeof(humidity_string),
+						measurement.humidity, 2, true);
+				Serial.print(humidity_string);
+				if (measurement.humidity != utils::FIXED_UNKNOWN) {
 					Serial.println('%');
 				} else {
 					Serial.println();
 				}
 			}
 		}
+		perf::leaveSection();
 	}
 
 	const uint available = Serial.available();
@@ -294,14 +321,23 @@ void loop() {
 	}
 
 #if ENABLE_ARDUINO_OTA == 1
+	perf::enterSection(perf::OTA);
 	ArduinoOTA.handle();
 #endif
 
+	perf::enterSection(perf::WEB);
 	web::loop();
+	perf::enterSection(perf::PROM);
 	prom::loop();
+	perf::enterSection(perf::MQTT);
 	mqtt::loop();
+	perf::leaveSection();
+	mem::loop();
+	perf::loop();
+	logger::loop();
 
 	loop_iterations++;
+	perf::endLoop();
 	const uint64_t end = (uint64_t) esp_timer_get_time() / 1000;
 	delay(max(0, 500 - int16_t(end - start)));
 }
@@ -309,14 +345,19 @@ void loop() {
 bool handle_serial_input(const std::string &input) {
 	if (input == "temperature" || input == "temp") {
 		Serial.println();
-		printTemperature(Serial, sensors::SENSOR_HANDLER.getTemperature());
+		printTemperature(Serial,
+				sensors::SENSOR_HANDLER.getMeasurement().temperature);
 		return true;
 	} else if (input == "humidity") {
 		Serial.println();
 		Serial.print("Relative humidity: ");
-		Serial.print(
-				utils::float_to_string(sensors::SENSOR_HANDLER.getHumidity(), 2).c_str());
-		if (!std::isnan(sensors::SENSOR_HANDLER.getHumidity())) {
+		const int32_t humidity =
+				sensors::SENSOR_HANDLER.getMeasurement().humidity;
+		char humidity_string[utils::CENTI_CHARS_BUFFER_SIZE];
+		utils::centi_to_chars(humidity_string, sizeof(humidity_string),
+				humidity, 2, true);
+		Serial.print(humidity_string);
+		if (humidity != utils::FIXED_UNKNOWN) {
 			Serial.println('%');
 		} else {
 			Serial.println();
@@ -341,6 +382,24 @@ bool handle_serial_input(const std::string &input) {
 		Serial.println("WiFi scanning is not currently supported on ESP8266 hardware.");
 #endif
 		return true;
+	} else if (input == "mem") {
+		Serial.println();
+		mem::printStats(Serial);
+		return true;
+	} else if (input == "perf") {
+		Serial.println();
+		perf::printStats(Serial);
+		return true;
+	} else if (input.size() == 10 && input.compare(0, 9, "loglevel=") == 0
+			&& isdigit(input[9])) {
+		Serial.println();
+		if (logger::setLevel(input[9] - '0')) {
+			Serial.print("Log level set to ");
+			Serial.println(input[9]);
+		} else {
+			Serial.println("Changing the log level requires the async log.");
+		}
+		return true;
 	} else if (input == "help") {
 		Serial.println();
 		Serial.println("ESP-WiFi-Thermometer help:");
@@ -354,6 +413,12 @@ bool handle_serial_input(const std::string &input) {
 		Serial.println(
 				"scan:                  Scans for WiFi networks in the area and prints the result.");
 #endif
+		Serial.println(
+				"mem:                   Prints the heap statistics and the memory used by each subsystem.");
+		Serial.println(
+				"perf:                  Prints the main loop durations, the longest stall, and the task cpu usage.");
+		Serial.println(
+				"loglevel=<0-5>:        Changes the max level of log messages to print, if the async log is enabled.");
 		Serial.println("help:                  Prints this help text.");
 		return true;
 	} else {
@@ -361,13 +426,16 @@ bool handle_serial_input(const std::string &input) {
 	}
 }
 
-void printTemperature(Print &out, const float temp) {
+void printTemperature(Print &out, const int32_t temp) {
 	out.print("Temperature: ");
-	if (!std::isnan(temp)) {
-		out.print(utils::float_to_string(temp, 2).c_str());
+	if (temp != utils::FIXED_UNKNOWN) {
+		char buffer[utils::CENTI_CHARS_BUFFER_SIZE];
+		utils::centi_to_chars(buffer, sizeof(buffer), temp, 2, true);
+		out.print(buffer);
 		out.print("°C, ");
-		out.print(
-				utils::float_to_string(utils::celsiusToFahrenheit(temp), 2).c_str());
+		utils::centi_to_chars(buffer, sizeof(buffer),
+				utils::centiCelsiusToFahrenheit(temp), 2, true);
+		out.print(buffer);
 		out.println("°F");
 	} else {
 		out.println("Unknown");
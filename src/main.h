@@ -87,8 +87,8 @@ bool handle_serial_input(const std::string &input);
  * Print the given temperature in degrees celsius and degrees fahrenheit.
  *
  * @param out	The print object to print to.
- * @param temp	The temperature to print. In degrees celsius.
+ * @param temp	The temperature to print. In hundredths of a degree celsius.
  */
-void printTemperature(Print &out, const float temp);
+void printTemperature(Print &out, const int32_t temp);
 
 #endif /* SRC_MAIN_H_ */
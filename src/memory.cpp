@@ -0,0 +1,214 @@
+/*
+ * memory.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "memory.h"
+#include <atomic>
+#ifdef ESP32
+#include <esp_heap_caps.h>
+#endif
+
+const char *const mem::SUBSYSTEM_NAMES[SUBSYSTEM_COUNT] = { "web", "prom",
+		"gzip", "mqtt", "sensors" };
+
+prom::GaugeFamily mem::live_bytes(PROMETHEUS_NAMESPACE, "memory_live", "bytes",
+		"The number of heap bytes currently allocated by each subsystem.", {
+				"subsystem" }, SUBSYSTEM_COUNT, 0);
+
+/**
+ * The number of bytes currently allocated by each subsystem.
+ */
+static std::atomic<int32_t> live[mem::SUBSYSTEM_COUNT];
+
+#ifdef ESP8266
+/**
+ * The lowest free heap seen so far.
+ * The ESP8266 core doesn't keep track of this itself.
+ */
+static std::atomic<uint32_t> min_free_heap { UINT32_MAX };
+
+/**
+ * Updates the minimum free heap, if the heap currently has less free memory.
+ */
+static void updateMinFreeHeap() {
+	const uint32_t free_heap = ESP.getFreeHeap();
+	uint32_t min = min_free_heap.load(std::memory_order_relaxed);
+	while (free_heap < min
+			&& !min_free_heap.compare_exchange_weak(min, free_heap)) {
+	}
+}
+#endif
+
+void mem::setup() {
+	static prom::IntegerValueFamily free_heap(PROMETHEUS_NAMESPACE,
+			"heap_free", "bytes", "The number of free bytes on the heap.",
+			"gauge", []() {
+				return (uint64_t) getFreeHeap();
+			});
+	static prom::IntegerValueFamily min_free_heap(PROMETHEUS_NAMESPACE,
+			"heap_min_free", "bytes",
+			"The lowest number of free bytes on the heap since startup.",
+			"gauge", []() {
+				return (uint64_t) getMinFreeHeap();
+			});
+	static prom::IntegerValueFamily largest_free_block(PROMETHEUS_NAMESPACE,
+			"heap_largest_free_block", "bytes",
+			"The size of the largest free block on the heap.", "gauge", []() {
+				return (uint64_t) getLargestFreeBlock();
+			});
+	static prom::ValueFamily fragmentation(PROMETHEUS_NAMESPACE,
+			"heap_fragmentation", "ratio",
+			"The part of the free heap that isn't in the largest free block.",
+			"gauge", []() {
+				return getFragmentation() / 100.0;
+			}, 2);
+
+	prom::default_registry.add(free_heap);
+	prom::default_registry.add(min_free_heap);
+	prom::default_registry.add(largest_free_block);
+	prom::default_registry.add(fragmentation);
+	for (uint8_t i = 0; i < SUBSYSTEM_COUNT; i++) {
+		live_bytes.get( { SUBSYSTEM_NAMES[i] });
+	}
+	prom::default_registry.add(live_bytes);
+}
+
+void mem::loop() {
+#ifdef ESP8266
+	updateMinFreeHeap();
+#endif
+	for (uint8_t i = 0; i < SUBSYSTEM_COUNT; i++) {
+		live_bytes.get( { SUBSYSTEM_NAMES[i] }).set(
+				live[i].load(std::memory_order_relaxed));
+	}
+}
+
+size_t mem::getFreeHeap() {
+	return ESP.getFreeHeap();
+}
+
+size_t mem::getMinFreeHeap() {
+#ifdef ESP32
+	return ESP.getMinFreeHeap();
+#elif defined(ESP8266)
+	updateMinFreeHeap();
+	return min_free_heap.load(std::memory_order_relaxed);
+#endif
+}
+
+size_t mem::getLargestFreeBlock() {
+#ifdef ESP32
+	return ESP.getMaxAllocHeap();
+#elif defined(ESP8266)
+	return ESP.getMaxFreeBlockSize();
+#endif
+}
+
+uint8_t mem::getFragmentation() {
+#ifdef ESP32
+	// Both values have to come from the same snapshot, or an allocation in between could skew the result.
+	multi_heap_info_t info;
+	heap_caps_get_info(&info, MALLOC_CAP_8BIT);
+	if (info.total_free_bytes == 0) {
+		return 0;
+	}
+	return 100
+			- (uint64_t) info.largest_free_block * 100 / info.total_free_bytes;
+#elif defined(ESP8266)
+	return ESP.getHeapFragmentation();
+#endif
+}
+
+void mem::allocated(const Subsystem subsystem, const size_t bytes) {
+	live[subsystem].fetch_add(bytes, std::memory_order_relaxed);
+#ifdef ESP8266
+	updateMinFreeHeap();
+#endif
+}
+
+void mem::freed(const Subsystem subsystem, const size_t bytes) {
+	live[subsystem].fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+int32_t mem::getLiveBytes(const Subsystem subsystem) {
+	return live[subsystem].load(std::memory_order_relaxed);
+}
+
+void mem::printStats(Print &out) {
+	out.print("Free heap:          ");
+	out.print(getFreeHeap());
+	out.println(" bytes");
+	out.print("Min free heap:      ");
+	out.print(getMinFreeHeap());
+	out.println(" bytes");
+	out.print("Largest free block: ");
+	out.print(getLargestFreeBlock());
+	out.println(" bytes");
+	out.print("Fragmentation:      ");
+	out.print(getFragmentation());
+	out.println('%');
+	out.println("Live bytes by subsystem:");
+	for (uint8_t i = 0; i < SUBSYSTEM_COUNT; i++) {
+		out.print("  ");
+		out.print(SUBSYSTEM_NAMES[i]);
+		out.print(": ");
+		out.println(getLiveBytes((Subsystem) i));
+	}
+}
+
+/**
+ * A deleter for shared buffers, that stops counting the buffer when it is freed.
+ */
+struct BufferDeleter {
+	/**
+	 * The subsystem the buffer is counted for.
+	 */
+	const mem::Subsystem subsystem;
+
+	/**
+	 * The size of the buffer in bytes.
+	 */
+	const size_t len;
+
+	/**
+	 * Frees the given buffer.
+	 *
+	 * @param buffer	The buffer to free.
+	 */
+	void operator()(uint8_t *buffer) const {
+		delete[] buffer;
+		mem::freed(subsystem, len);
+	}
+};
+
+std::shared_ptr<uint8_t> mem::make_shared_buffer(const Subsystem subsystem,
+		const size_t len) {
+	std::shared_ptr<uint8_t> buffer(new uint8_t[len],
+			BufferDeleter { subsystem, len });
+	allocated(subsystem, len);
+	return buffer;
+}
+
+mem::Allocation::Allocation(const Subsystem subsystem, const size_t bytes) :
+		_subsystem(subsystem) {
+	resize(bytes);
+}
+
+mem::Allocation::~Allocation() {
+	resize(0);
+}
+
+void mem::Allocation::resize(const size_t bytes) {
+	if (bytes > _bytes) {
+		allocated(_subsystem, bytes - _bytes);
+	} else if (bytes < _bytes) {
+		freed(_subsystem, _bytes - bytes);
+	}
+	_bytes = bytes;
+}
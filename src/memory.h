@@ -0,0 +1,259 @@
+/*
+ * memory.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_MEMORY_H_
+#define SRC_MEMORY_H_
+
+#include "config.h"
+#include <prometheus_registry.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+/**
+ * This header, and the source file with the same name, contain the heap statistics,
+ * and the accounting of the memory used by the individual subsystems.
+ */
+namespace mem {
+/**
+ * The subsystems of which the live heap allocations are counted.
+ */
+enum Subsystem : uint8_t {
+	WEB, PROM, GZIP, MQTT, SENSORS, SUBSYSTEM_COUNT
+};
+
+/**
+ * The names of the subsystems, as used in the metric labels and the serial output.
+ */
+extern const char *const SUBSYSTEM_NAMES[SUBSYSTEM_COUNT];
+
+/**
+ * The metric containing the number of live bytes allocated by each subsystem.
+ */
+extern prom::GaugeFamily live_bytes;
+
+/**
+ * Initializes the memory statistics, and registers their metrics.
+ */
+void setup();
+
+/**
+ * A method that does everything that should be done every loop iteration.
+ * Updates the minimum free heap on the ESP8266, and the live bytes metric.
+ */
+void loop();
+
+/**
+ * Gets the number of free bytes on the heap.
+ *
+ * @return	The free heap in bytes.
+ */
+size_t getFreeHeap();
+
+/**
+ * Gets the lowest number of free bytes on the heap since startup.
+ * On the ESP8266 this is only updated when memory is counted, and once per loop iteration,
+ * so short lived minimums may be missed.
+ *
+ * @return	The minimum free heap in bytes.
+ */
+size_t getMinFreeHeap();
+
+/**
+ * Gets the size of the largest free block on the heap.
+ * This is the largest allocation that can currently succeed.
+ *
+ * @return	The largest free block in bytes.
+ */
+size_t getLargestFreeBlock();
+
+/**
+ * Gets the fragmentation of the free heap in percent.
+ * Zero means all of the free heap is a single block.
+ *
+ * @return	The heap fragmentation, from 0 to 100.
+ */
+uint8_t getFragmentation();
+
+/**
+ * Counts the given number of bytes as allocated by the given subsystem.
+ *
+ * @param subsystem	The subsystem that allocated the memory.
+ * @param bytes		The number of bytes that were allocated.
+ */
+void allocated(const Subsystem subsystem, const size_t bytes);
+
+/**
+ * Counts the given number of bytes as freed by the given subsystem.
+ *
+ * @param subsystem	The subsystem that freed the memory.
+ * @param bytes		The number of bytes that were freed.
+ */
+void freed(const Subsystem subsystem, const size_t bytes);
+
+/**
+ * Gets the number of bytes currently allocated by the given subsystem.
+ * Only counts the allocations that are explicitly counted,
+ * not the ones made internally by libraries.
+ *
+ * @param subsystem	The subsystem to get the live bytes of.
+ * @return	The live bytes of the subsystem.
+ */
+int32_t getLiveBytes(const Subsystem subsystem);
+
+/**
+ * Prints the heap statistics and the live bytes of each subsystem.
+ *
+ * @param out	The print object to print to.
+ */
+void printStats(Print &out);
+
+/**
+ * An allocator counting its allocations as live bytes of a subsystem.
+ * Used with std::allocate_shared, so the control block is counted as well.
+ *
+ * @tparam T	The type of the objects to allocate.
+ */
+template<typename T>
+class Allocator {
+public:
+	typedef T value_type;
+
+	template<typename U>
+	struct rebind {
+		typedef Allocator<U> other;
+	};
+
+	/**
+	 * The subsystem to count the allocations of this allocator for.
+	 */
+	const Subsystem subsystem;
+
+	/**
+	 * Creates a new allocator counting its allocations for the given subsystem.
+	 *
+	 * @param subsystem	The subsystem to count the allocations for.
+	 */
+	Allocator(const Subsystem subsystem) :
+			subsystem(subsystem) {
+	}
+
+	/**
+	 * Creates a new allocator for the same subsystem as the given one.
+	 *
+	 * @param other	The allocator to copy the subsystem from.
+	 */
+	template<typename U>
+	Allocator(const Allocator<U> &other) :
+			subsystem(other.subsystem) {
+	}
+
+	/**
+	 * Allocates memory for the given number of objects, and counts it.
+	 *
+	 * @param n	The number of objects to allocate memory for.
+	 * @return	A pointer to the allocated memory.
+	 */
+	T* allocate(const size_t n) {
+		T *ptr = std::allocator<T>().allocate(n);
+		allocated(subsystem, n * sizeof(T));
+		return ptr;
+	}
+
+	/**
+	 * Frees memory allocated by this allocator, and stops counting it.
+	 *
+	 * @param ptr	The memory to free.
+	 * @param n		The number of objects the memory was allocated for.
+	 */
+	void deallocate(T *ptr, const size_t n) {
+		std::allocator<T>().deallocate(ptr, n);
+		freed(subsystem, n * sizeof(T));
+	}
+};
+
+template<typename T, typename U>
+bool operator==(const Allocator<T> &first, const Allocator<U> &second) {
+	return first.subsystem == second.subsystem;
+}
+
+template<typename T, typename U>
+bool operator!=(const Allocator<T> &first, const Allocator<U> &second) {
+	return first.subsystem != second.subsystem;
+}
+
+/**
+ * Creates a new shared object, counting its memory as allocated by the given subsystem.
+ * Memory allocated by the object itself isn't counted.
+ *
+ * @tparam T		The type of the object to create.
+ * @param subsystem	The subsystem to count the memory for.
+ * @param args		The arguments to pass to the constructor of the object.
+ * @return	A shared pointer to the new object.
+ */
+template<typename T, typename ... Args>
+std::shared_ptr<T> make_shared(const Subsystem subsystem, Args &&... args) {
+	return std::allocate_shared<T>(Allocator<T>(subsystem),
+			std::forward<Args>(args)...);
+}
+
+/**
+ * Allocates a shared byte buffer of the given size, counting it as allocated by the given subsystem.
+ *
+ * @param subsystem	The subsystem to count the buffer for.
+ * @param len		The size of the buffer in bytes.
+ * @return	A shared pointer to the first byte of the buffer.
+ */
+std::shared_ptr<uint8_t> make_shared_buffer(const Subsystem subsystem,
+		const size_t len);
+
+/**
+ * A counted amount of memory, that is no longer counted once this object is destroyed.
+ * Used for memory allocated internally by containers, which can't easily use an Allocator.
+ */
+class Allocation {
+private:
+	/**
+	 * The subsystem the memory is counted for.
+	 */
+	const Subsystem _subsystem;
+
+	/**
+	 * The number of bytes currently counted.
+	 */
+	size_t _bytes = 0;
+public:
+	/**
+	 * Creates a new allocation, counting the given number of bytes for the given subsystem.
+	 *
+	 * @param subsystem	The subsystem to count the memory for.
+	 * @param bytes		The number of bytes to count.
+	 */
+	Allocation(const Subsystem subsystem, const size_t bytes = 0);
+
+	Allocation(const Allocation &other) = delete;
+
+	Allocation& operator=(const Allocation &other) = delete;
+
+	/**
+	 * Stops counting the memory of this allocation.
+	 */
+	~Allocation();
+
+	/**
+	 * Changes the number of bytes counted for this allocation.
+	 *
+	 * @param bytes	The new number of bytes to count.
+	 */
+	void resize(const size_t bytes);
+};
+}
+
+#endif /* SRC_MEMORY_H_ */
@@ -11,14 +11,49 @@
 #include "mqtt.h"
 #include "main.h"
 #include "sensor_handler.h"
-#include <iomanip>
-#include <sstream>
+#include "memory.h"
+#include <cstring>
 
 #if ENABLE_MQTT_PUBLISH == 1
 AsyncMqttClient mqtt::mqttClient;
 #if ENABLE_DEEP_SLEEP_MODE != 1
 uint64_t mqtt::last_publish = 0;
 #endif
+prom::CounterFamily mqtt::publishes_total(PROMETHEUS_NAMESPACE,
+		"mqtt_publishes_total", "",
+		"The total number of attempted measurement publishes by result.", {
+				"result" }, 2);
+
+/**
+ * The counter for publishes of which all messages were accepted by the client.
+ */
+static prom::Counter &successful_publishes = mqtt::publishes_total.get( {
+		"success" });
+
+/**
+ * The counter for publishes of which at least one message couldn't be published.
+ */
+static prom::Counter &failed_publishes = mqtt::publishes_total.get( {
+		"failure" });
+
+/**
+ * Writes a measured value with three significant digits.
+ * Writes "nan" for unknown values.
+ *
+ * @param buffer	The buffer to write to. Has to be at least CENTI_CHARS_BUFFER_SIZE bytes long.
+ * @param centi		The value to write in hundredths.
+ */
+static void writeMeasurement(char *buffer, const int32_t centi) {
+	if (centi == utils::FIXED_UNKNOWN) {
+		strcpy(buffer, "nan");
+		return;
+	}
+
+	const uint32_t magnitude = centi < 0 ? -(uint32_t) centi : centi;
+	const uint8_t digits = magnitude >= 10000 ? 0 : magnitude >= 1000 ? 1 : 2;
+	utils::centi_to_chars(buffer, utils::CENTI_CHARS_BUFFER_SIZE, centi, digits,
+			true);
+}
 #endif
 
 void mqtt::setup() {
@@ -33,6 +68,8 @@ void mqtt::setup() {
 #if MQTT_PUBLISH_ANONYMOUS != 1
 	mqttClient.setCredentials(MQTT_USER, MQTT_PASS);
 #endif
+
+	prom::default_registry.add(publishes_total);
 #endif
 }
 
@@ -70,33 +107,34 @@ void mqtt::publishMeasurements() {
 				ns = HOSTNAME;
 			}
 
-			std::ostringstream converter;
+			const sensors::Measurement measurement =
+					sensors::SENSOR_HANDLER.getMeasurement();
+			char buffer[utils::CENTI_CHARS_BUFFER_SIZE];
 			if (sensors::SENSOR_HANDLER.supportsTemperature()) {
-				converter << std::setprecision(3)
-						<< sensors::SENSOR_HANDLER.getTemperature();
+				writeMeasurement(buffer, measurement.temperature);
 				if (!mqttClient.publish((ns + "/temperature").c_str(), 0, true,
-						converter.str().c_str())) {
+						buffer)) {
 					log_w("Failed to publish temperature.");
+					failed_publishes.inc();
 					return;
 				}
 			}
 
-			converter.str("");
-			converter.clear();
-
 			if (sensors::SENSOR_HANDLER.supportsHumidity()) {
-				converter << std::setprecision(3)
-						<< sensors::SENSOR_HANDLER.getHumidity();
+				writeMeasurement(buffer, measurement.humidity);
 
 				if (!mqttClient.publish((ns + "/humidity").c_str(), 0, true,
-						converter.str().c_str())) {
+						buffer)) {
 					log_w("Failed to publish humidity.");
+					failed_publishes.inc();
 					return;
 				}
 			}
+			successful_publishes.inc();
 
 #if ENABLE_DEEP_SLEEP_MODE == 1
-			std::shared_ptr<bool> connected = std::make_shared<bool>(true);
+			std::shared_ptr<bool> connected = mem::make_shared<bool>(mem::MQTT,
+					true);
 
 			mqttClient.onDisconnect(
 					[connected](AsyncMqttClientDisconnectReason reason) {
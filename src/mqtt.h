@@ -14,6 +14,7 @@
 #include "config.h"
 #if ENABLE_MQTT_PUBLISH == 1
 #include <AsyncMqttClient.h>
+#include <prometheus_registry.h>
 #endif
 
 /**
@@ -25,6 +26,11 @@ extern AsyncMqttClient mqttClient;
 #if ENABLE_DEEP_SLEEP_MODE != 1
 extern uint64_t last_publish;
 #endif
+
+/**
+ * The metric counting the measurement publishes, by whether they succeeded.
+ */
+extern prom::CounterFamily publishes_total;
 #endif
 
 // TODO make optional, somehow
@@ -0,0 +1,308 @@
+/*
+ * perf.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "perf.h"
+#ifdef ESP8266
+#include <fallback_timer.h>
+#endif
+#include <fallback_log.h>
+#if ENABLE_TASK_CPU_STATS == 1
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * The max number of FreeRTOS tasks of which the cpu usage is exported.
+ */
+static constexpr size_t MAX_TASKS = 24;
+#endif
+
+const char *const perf::SECTION_NAMES[SECTION_COUNT] = { "sensor", "ota", "web",
+		"prom", "mqtt" };
+
+prom::HistogramFamily perf::loop_duration(PROMETHEUS_NAMESPACE, "loop_duration",
+		"seconds",
+		"The time a single main loop iteration took, excluding the delay after it, in seconds.",
+		{ 1000, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000 },
+		1000000);
+prom::HistogramFamily perf::section_duration(PROMETHEUS_NAMESPACE,
+		"loop_section_duration", "seconds",
+		"The time a single run of a main loop section took in seconds.", { 100,
+				1000, 5000, 10000, 50000, 100000, 500000 }, 1000000, {
+				"section" }, SECTION_COUNT);
+prom::GaugeFamily perf::section_max_duration(PROMETHEUS_NAMESPACE,
+		"loop_section_max_duration", "seconds",
+		"The longest time a single run of a main loop section took since startup in seconds.",
+		{ "section" }, SECTION_COUNT, 6);
+prom::CounterFamily perf::stalls_total(PROMETHEUS_NAMESPACE, "loop_stalls_total",
+		"",
+		"The number of main loop section runs that took longer than the stall threshold.",
+		{ "section" }, SECTION_COUNT);
+#if ENABLE_TASK_CPU_STATS == 1
+prom::GaugeFamily perf::task_cpu(PROMETHEUS_NAMESPACE, "task_cpu", "ratio",
+		"The part of a cpu core each FreeRTOS task used in the last sample interval.",
+		{ "task" }, MAX_TASKS);
+#endif
+
+/**
+ * The run time statistics of a single loop section, or the entire loop.
+ */
+struct Stats {
+	/**
+	 * The number of runs since startup.
+	 */
+	uint32_t runs = 0;
+
+	/**
+	 * The total run time since startup in microseconds.
+	 */
+	uint64_t total = 0;
+
+	/**
+	 * The longest single run since startup in microseconds.
+	 */
+	uint32_t max = 0;
+
+	/**
+	 * The number of runs that took longer than LOOP_STALL_THRESHOLD.
+	 */
+	uint32_t stalls = 0;
+
+	/**
+	 * Records a single run.
+	 *
+	 * @param duration	The run time in microseconds.
+	 */
+	void record(const uint32_t duration) {
+		runs++;
+		total += duration;
+		if (duration > max) {
+			max = duration;
+		}
+	}
+};
+
+/**
+ * The statistics of the entire loop iterations.
+ */
+static Stats loop_stats;
+
+/**
+ * The statistics of each loop section.
+ */
+static Stats section_stats[perf::SECTION_COUNT];
+
+/**
+ * The histogram series of each loop section.
+ */
+static prom::Histogram *section_histograms[perf::SECTION_COUNT];
+
+/**
+ * The time the current loop iteration started, in microseconds since startup.
+ */
+static uint64_t loop_start = 0;
+
+/**
+ * The loop section that is currently running.
+ * SECTION_COUNT if none is.
+ */
+static perf::Section current_section = perf::SECTION_COUNT;
+
+/**
+ * The time the current section started, in microseconds since startup.
+ */
+static uint64_t section_start = 0;
+
+#if ENABLE_TASK_CPU_STATS == 1
+/**
+ * The state of all tasks at the last sample.
+ */
+static std::vector<TaskStatus_t> last_tasks;
+
+/**
+ * The total run time counter value at the last sample.
+ */
+static uint32_t last_total_runtime = 0;
+
+/**
+ * The time of the last sample, in milliseconds since startup.
+ */
+static uint64_t last_task_sample = 0;
+
+/**
+ * The name and cpu usage of each task in the last sample interval.
+ */
+static std::vector<std::pair<std::string, float>> task_usage;
+
+/**
+ * Gets the current state of all tasks, and calculates their cpu usage since the last sample.
+ * The cpu usage is the part of the run time counter that elapsed while each task was running,
+ * so the sum of all tasks, including the idle tasks, is the number of cores.
+ */
+static void sampleTasks() {
+	std::vector<TaskStatus_t> tasks(uxTaskGetNumberOfTasks() + 2);
+	uint32_t total_runtime = 0;
+	tasks.resize(
+			uxTaskGetSystemState(tasks.data(), tasks.size(), &total_runtime));
+
+	const uint32_t elapsed = total_runtime - last_total_runtime;
+	if (!last_tasks.empty() && elapsed > 0) {
+		task_usage.clear();
+		for (const TaskStatus_t &task : tasks) {
+			for (const TaskStatus_t &last : last_tasks) {
+				if (last.xHandle == task.xHandle) {
+					const float usage = (float) (task.ulRunTimeCounter
+							- last.ulRunTimeCounter) / elapsed;
+					perf::task_cpu.get( { task.pcTaskName }).set(usage);
+					task_usage.emplace_back(task.pcTaskName, usage);
+					break;
+				}
+			}
+		}
+	}
+
+	last_tasks.swap(tasks);
+	last_total_runtime = total_runtime;
+}
+#endif
+
+void perf::setup() {
+	for (uint8_t i = 0; i < SECTION_COUNT; i++) {
+		section_histograms[i] = &section_duration.get( { SECTION_NAMES[i] });
+		section_max_duration.get( { SECTION_NAMES[i] });
+		stalls_total.get( { SECTION_NAMES[i] });
+	}
+
+	prom::default_registry.add(loop_duration);
+	prom::default_registry.add(section_duration);
+	prom::default_registry.add(section_max_duration);
+	prom::default_registry.add(stalls_total);
+#if ENABLE_TASK_CPU_STATS == 1
+	prom::default_registry.add(task_cpu);
+#endif
+}
+
+void perf::loop() {
+#if ENABLE_TASK_CPU_STATS == 1
+	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
+	if (last_task_sample == 0
+			|| now - last_task_sample >= TASK_CPU_SAMPLE_INTERVAL * 1000) {
+		sampleTasks();
+		last_task_sample = now;
+	}
+#endif
+}
+
+void perf::beginLoop() {
+	loop_start = (uint64_t) esp_timer_get_time();
+}
+
+void perf::endLoop() {
+	leaveSection();
+	const uint32_t duration = (uint64_t) esp_timer_get_time() - loop_start;
+	loop_stats.record(duration);
+	loop_duration.get().observe(duration);
+}
+
+void perf::enterSection(const Section section) {
+	leaveSection();
+	current_section = section;
+	section_start = (uint64_t) esp_timer_get_time();
+}
+
+void perf::leaveSection() {
+	if (current_section >= SECTION_COUNT) {
+		return;
+	}
+
+	const Section section = current_section;
+	current_section = SECTION_COUNT;
+	const uint32_t duration = (uint64_t) esp_timer_get_time() - section_start;
+	Stats &stats = section_stats[section];
+	if (duration > stats.max) {
+		section_max_duration.get( { SECTION_NAMES[section] }).set(
+				duration / 1000000.0);
+	}
+	stats.record(duration);
+	section_histograms[section]->observe(duration);
+
+	if (duration > LOOP_STALL_THRESHOLD * 1000) {
+		stats.stalls++;
+		stalls_total.get( { SECTION_NAMES[section] }).inc();
+		log_w("Loop section %s stalled for %lums.", SECTION_NAMES[section],
+				(unsigned long) (duration / 1000));
+	}
+}
+
+void perf::printStats(Print &out) {
+	out.print("Loop iterations: ");
+	out.println(loop_stats.runs);
+	if (loop_stats.runs == 0) {
+		return;
+	}
+
+	out.print("Loop duration:   avg ");
+	out.print(
+			utils::float_to_string(loop_stats.total / 1000.0 / loop_stats.runs,
+					2).c_str());
+	out.print("ms, max ");
+	out.print(utils::float_to_string(loop_stats.max / 1000.0, 2).c_str());
+	out.println("ms");
+
+	out.println("Section  Avg ms   Max ms   Stalls");
+	Section worst = SECTION_COUNT;
+	for (uint8_t i = 0; i < SECTION_COUNT; i++) {
+		const Stats &stats = section_stats[i];
+		if (stats.runs == 0) {
+			continue;
+		}
+		if (worst == SECTION_COUNT || stats.max > section_stats[worst].max) {
+			worst = (Section) i;
+		}
+
+		const std::string avg = utils::float_to_string(
+				stats.total / 1000.0 / stats.runs, 2);
+		const std::string max = utils::float_to_string(stats.max / 1000.0, 2);
+		out.print(SECTION_NAMES[i]);
+		for (size_t j = strlen(SECTION_NAMES[i]); j < 9; j++) {
+			out.print(' ');
+		}
+		out.print(avg.c_str());
+		for (size_t j = avg.length(); j < 9; j++) {
+			out.print(' ');
+		}
+		out.print(max.c_str());
+		for (size_t j = max.length(); j < 9; j++) {
+			out.print(' ');
+		}
+		out.println(stats.stalls);
+	}
+
+	if (worst != SECTION_COUNT) {
+		out.print("Longest stall: ");
+		out.print(
+				utils::float_to_string(section_stats[worst].max / 1000.0, 2).c_str());
+		out.print("ms in ");
+		out.println(SECTION_NAMES[worst]);
+	}
+
+#if ENABLE_TASK_CPU_STATS == 1
+	if (!task_usage.empty()) {
+		out.println("Task cpu usage:");
+		for (const std::pair<std::string, float> &task : task_usage) {
+			out.print("  ");
+			out.print(task.first.c_str());
+			out.print(": ");
+			out.print(utils::float_to_string(task.second * 100, 1).c_str());
+			out.println('%');
+		}
+	}
+#endif
+}
@@ -0,0 +1,114 @@
+/*
+ * perf.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_PERF_H_
+#define SRC_PERF_H_
+
+#include "config.h"
+#include <prometheus_registry.h>
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
+
+// The cpu usage of the FreeRTOS tasks can only be measured if the run time stats are enabled.
+#if defined(ESP32) && configUSE_TRACE_FACILITY == 1 && configGENERATE_RUN_TIME_STATS == 1
+#define ENABLE_TASK_CPU_STATS 1
+#else
+#define ENABLE_TASK_CPU_STATS 0
+#endif
+
+/**
+ * This header, and the source file with the same name, contain the main loop latency monitor.
+ */
+namespace perf {
+/**
+ * The sections of the main loop, of which the run time is measured separately.
+ */
+enum Section : uint8_t {
+	SENSOR, OTA, WEB, PROM, MQTT, SECTION_COUNT
+};
+
+/**
+ * The names of the loop sections, as used in the metric labels and the serial output.
+ */
+extern const char *const SECTION_NAMES[SECTION_COUNT];
+
+/**
+ * The metric for the run time of a single main loop iteration, excluding the delay after it.
+ */
+extern prom::HistogramFamily loop_duration;
+
+/**
+ * The metric for the run time of each loop section.
+ */
+extern prom::HistogramFamily section_duration;
+
+/**
+ * The metric for the longest run time of each loop section since startup.
+ */
+extern prom::GaugeFamily section_max_duration;
+
+/**
+ * The metric counting the loop section runs that took longer than LOOP_STALL_THRESHOLD.
+ */
+extern prom::CounterFamily stalls_total;
+
+#if ENABLE_TASK_CPU_STATS == 1
+/**
+ * The metric for the part of a cpu core used by each FreeRTOS task.
+ */
+extern prom::GaugeFamily task_cpu;
+#endif
+
+/**
+ * Initializes the latency monitor, and registers its metrics.
+ */
+void setup();
+
+/**
+ * A method that does everything that should be done every loop iteration.
+ * Samples the cpu usage of the FreeRTOS tasks, if supported.
+ */
+void loop();
+
+/**
+ * Marks the start of a main loop iteration.
+ */
+void beginLoop();
+
+/**
+ * Marks the end of a main loop iteration, and records its duration.
+ * Also ends the current section, if there is one.
+ */
+void endLoop();
+
+/**
+ * Ends the current section, if there is one, and starts the given one.
+ *
+ * @param section	The loop section that is starting.
+ */
+void enterSection(const Section section);
+
+/**
+ * Ends the current section, and records its duration.
+ * Logs a warning if it took longer than LOOP_STALL_THRESHOLD.
+ */
+void leaveSection();
+
+/**
+ * Prints the loop and section durations, the longest stall, and the task cpu usage if supported.
+ *
+ * @param out	The print object to print to.
+ */
+void printStats(Print &out);
+}
+
+#endif /* SRC_PERF_H_ */
@@ -0,0 +1,34 @@
+/*
+ * profiling.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "profiling.h"
+#if ENABLE_ALLOCATION_PROFILER == 1 && ENABLE_WEB_SERVER == 1
+#include "memory.h"
+#endif
+
+void profiling::setup() {
+#if ENABLE_ALLOCATION_PROFILER == 1 && ENABLE_WEB_SERVER == 1
+	web::registerRequestHandler("/debug/alloc", HTTP_GET, handleAlloc);
+#endif
+}
+
+#if ENABLE_ALLOCATION_PROFILER == 1 && ENABLE_WEB_SERVER == 1
+web::ResponseData profiling::handleAlloc(AsyncWebServerRequest *request) {
+	std::shared_ptr<alloc::ReportWriter> writer = mem::make_shared<
+			alloc::ReportWriter>(mem::WEB);
+	AsyncWebServerResponse *response = request->beginChunkedResponse(
+			"text/plain",
+			[writer](uint8_t *buffer, const size_t max_len, const size_t index) {
+				return writer->read(buffer, max_len);
+			});
+	response->addHeader("Cache-Control", web::CACHE_CONTROL_NOCACHE);
+	return web::ResponseData(response, 0, 200);
+}
+#endif
@@ -0,0 +1,66 @@
+/*
+ * profiling.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_PROFILING_H_
+#define SRC_PROFILING_H_
+
+#include "config.h"
+#if ENABLE_ALLOCATION_PROFILER == 1
+#include <alloc_profiler.h>
+
+/**
+ * Creates the variable name of an allocation scope from the line it is created in.
+ */
+#define ALLOC_SCOPE_VARIABLE(line) alloc_scope_ ## line
+
+/**
+ * Expands the line macro before creating the variable name of an allocation scope.
+ */
+#define ALLOC_SCOPE_NAME(line) ALLOC_SCOPE_VARIABLE(line)
+
+/**
+ * Attributes all allocations of the current task from this line to the end of the current scope to a tag.
+ *
+ * @param tag	The tag to attribute the allocations to. Has to live forever.
+ */
+#define ALLOC_SCOPE(tag) alloc::Scope ALLOC_SCOPE_NAME(__LINE__)(tag)
+#else
+/**
+ * Does nothing, since the allocation profiler is disabled.
+ */
+#define ALLOC_SCOPE(tag)
+#endif
+
+#if ENABLE_ALLOCATION_PROFILER == 1 && ENABLE_WEB_SERVER == 1
+#include "webhandler.h"
+#endif
+
+/**
+ * This header, and the source file with the same name, contain the web endpoint of the allocation profiler.
+ */
+namespace profiling {
+/**
+ * Registers the /debug/alloc endpoint, if the allocation profiler is enabled.
+ */
+void setup();
+
+#if ENABLE_ALLOCATION_PROFILER == 1 && ENABLE_WEB_SERVER == 1
+/**
+ * The request handler for /debug/alloc.
+ * Streams the allocation counts as plain text.
+ *
+ * @param request	The request to handle.
+ * @return	The response to send.
+ */
+web::ResponseData handleAlloc(AsyncWebServerRequest *request);
+#endif
+}
+
+#endif /* SRC_PROFILING_H_ */
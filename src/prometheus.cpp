@@ -9,27 +9,267 @@
  */
 
 #include "prometheus.h"
-#if ENABLE_DEEP_SLEEP_MODE == 1 || ENABLE_PROMETHEUS_PUSH == 1
+#if ENABLE_DEEP_SLEEP_MODE == 1 || ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
 #include "main.h"
 #endif
-#include "sensor_handler.h"
 #include "generated/esptherm_version.h"
+#include "memory.h"
+#include "tracing.h"
+#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
+#include "AsyncChunkedCompletionResponse.h"
+#endif
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+#include "sensor_handler.h"
+#endif
 #include <iomanip>
 #include <sstream>
-#include <fallback_log.h>
+#if ENABLE_PROMETHEUS_PUSH_GZIP == 1
+#include <gzip_compressor.h>
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include <atomic>
+#include <sys/time.h>
+#include <http_response_parser.h>
+#endif
+
+#if ENABLE_PROMETHEUS_PUSH == 1
+/**
+ * The Content-Type of the push request bodies.
+ */
+static constexpr char PUSH_CONTENT_TYPE[] = "text/plain; version=0.0.4; charset=utf-8";
+
+#if ENABLE_PROMETHEUS_PUSH_GZIP == 1
+/**
+ * The Content-Encoding of the push request bodies.
+ */
+static constexpr const char *PUSH_CONTENT_ENCODING = "gzip";
+#else
+/**
+ * The Content-Encoding of the push request bodies.
+ */
+static constexpr const char *PUSH_CONTENT_ENCODING = NULL;
+#endif
+#endif
+#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
+/**
+ * The max number of metric family names a scrape can be limited to.
+ */
+static constexpr size_t MAX_METRICS_FILTER_NAMES = 32;
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+/**
+ * The time after which a remote write connection without a response is closed, in seconds.
+ */
+static constexpr uint8_t REMOTE_WRITE_TIMEOUT = 10;
+
+/**
+ * The value of the remote write status while no request is in flight.
+ */
+static constexpr int32_t REMOTE_WRITE_IDLE = -1;
+
+/**
+ * The value of the remote write status while a request is in flight.
+ */
+static constexpr int32_t REMOTE_WRITE_PENDING = -2;
 
-#if ENABLE_WEB_SERVER == 1 && (ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1)
-std::map<String, std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>> prom::http_requests_total;
+/**
+ * Wall clock times before this are assumed to mean that the clock wasn't synchronized yet.
+ */
+static constexpr time_t MIN_VALID_TIME = 1700000000;
 #endif
+#include <fallback_log.h>
+
 #if ENABLE_PROMETHEUS_PUSH == 1 && ENABLE_DEEP_SLEEP_MODE != 1
 uint64_t prom::last_push = 0;
+
+/**
+ * The time at which the last push was started, in milliseconds.
+ */
+static uint64_t last_push_attempt = 0;
+#endif
+#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
+web::SingleFlight<prom::MetricsRender> prom::metrics_renders(
+		SINGLE_FLIGHT_MAX_AGE);
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+/**
+ * The scrapers that have their own consumer, by consumer index minus CONSUMER_SCRAPE.
+ * Only used by the web server task.
+ */
+static String scrapers[prom::SCRAPE_CONSUMERS];
+
+/**
+ * The time each scraper with its own consumer last started a scrape, in milliseconds.
+ * Zero for consumers that weren't assigned yet.
+ */
+static uint64_t scraper_times[prom::SCRAPE_CONSUMERS] = { };
+#endif
 #endif
 #if ENABLE_PROMETHEUS_PUSH == 1
-AsyncClient *prom::tcpClient = NULL;
 std::string prom::push_url;
+prom::CounterFamily prom::push_requests_total(PROMETHEUS_NAMESPACE,
+		"push_requests_total", "",
+		"The total number of attempted pushes to the pushgateway by result.", {
+				"result" }, 2);
+prom::CounterFamily prom::push_connections_total(PROMETHEUS_NAMESPACE,
+		"push_connections_total", "",
+		"The total number of connections opened to the pushgateway.");
+prom::HistogramFamily prom::push_request_duration(PROMETHEUS_NAMESPACE,
+		"push_request_duration", "seconds",
+		"The time between starting a push and receiving the response in seconds.",
+		{ 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000, 5000000 },
+		1000000);
+http::PushClient prom::push_client(PROMETHEUS_PUSH_ADDR, PROMETHEUS_PUSH_PORT,
+		push_url, PUSH_CONTENT_TYPE, PUSH_CONTENT_ENCODING,
+		PROMETHEUS_PUSH_INTERVAL * 750, push_connections_total.get(),
+		push_request_duration.get());
+#if ENABLE_PROMETHEUS_PUSH_GZIP == 1
+prom::GaugeFamily prom::push_compression_ratio(PROMETHEUS_NAMESPACE,
+		"push_compression_ratio", "",
+		"The uncompressed size of the last push body divided by its compressed size.");
+prom::CounterFamily prom::push_compression_saved_bytes_total(
+		PROMETHEUS_NAMESPACE, "push_compression_saved_bytes_total", "",
+		"The total number of push body bytes that weren't sent because of the compression.");
+#endif
+
+/**
+ * The counter for pushes that were acknowledged with a HTTP 200 response.
+ */
+static prom::Counter &successful_pushes = prom::push_requests_total.get( {
+		"success" });
+
+/**
+ * The counter for pushes that failed to connect, were interrupted, or received an error response.
+ */
+static prom::Counter &failed_pushes = prom::push_requests_total.get( {
+		"failure" });
+#endif
+
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+prom::CounterFamily prom::remote_write_requests_total(PROMETHEUS_NAMESPACE,
+		"remote_write_requests_total", "",
+		"The total number of attempted requests to the remote write receiver by result.",
+		{ "result" }, 3);
+prom::CounterFamily prom::remote_write_dropped_samples_total(
+		PROMETHEUS_NAMESPACE, "remote_write_dropped_samples_total", "",
+		"The total number of samples dropped because the buffer was full, or the receiver rejected them.");
+prom::RemoteWriteSender prom::remote_write_sender(PROMETHEUS_REMOTE_WRITE_ADDR,
+		PROMETHEUS_REMOTE_WRITE_PATH, "ESP-WiFi-Thermometer",
+		PROMETHEUS_REMOTE_WRITE_BUFFER_SIZE,
+		PROMETHEUS_REMOTE_WRITE_SEND_INTERVAL * 1000,
+		PROMETHEUS_REMOTE_WRITE_MIN_BACKOFF * 1000,
+		PROMETHEUS_REMOTE_WRITE_MAX_BACKOFF * 1000);
+
+/**
+ * The counter for remote write requests that were accepted by the receiver.
+ */
+static prom::Counter &successful_remote_writes =
+		prom::remote_write_requests_total.get( { "success" });
+
+/**
+ * The counter for remote write requests that failed, and will be retried.
+ */
+static prom::Counter &failed_remote_writes =
+		prom::remote_write_requests_total.get( { "failure" });
+
+/**
+ * The counter for remote write requests that were rejected by the receiver.
+ */
+static prom::Counter &rejected_remote_writes =
+		prom::remote_write_requests_total.get( { "rejected" });
+
+/**
+ * The counter for samples that were dropped instead of being sent.
+ */
+static prom::Counter &dropped_remote_write_samples =
+		prom::remote_write_dropped_samples_total.get();
+
+/**
+ * The time at which the metrics were last collected for the remote write receiver, in milliseconds.
+ */
+static uint64_t last_remote_write_collect = 0;
+
+/**
+ * The HTTP status code of the last remote write request, or zero if it failed without a response.
+ * REMOTE_WRITE_PENDING while a request is in flight, and REMOTE_WRITE_IDLE after the result was handled.
+ * Written by the connection callbacks, and read by the loop.
+ */
+static std::atomic<int32_t> remote_write_status { REMOTE_WRITE_IDLE };
+
+/**
+ * The connection of the remote write request in flight.
+ * Callbacks of older connections, that weren't closed yet, don't affect the current request.
+ */
+static std::atomic<AsyncClient*> remote_write_client { NULL };
+
+/**
+ * The remote write request in flight.
+ * Remains valid and unchanged until the result is handled by the loop.
+ */
+static const uint8_t *remote_write_request = NULL;
+
+/**
+ * The length of the remote write request in flight.
+ */
+static size_t remote_write_request_len = 0;
+
+/**
+ * The number of bytes of the remote write request that were already written to the connection.
+ */
+static size_t remote_write_request_sent = 0;
+
+/**
+ * The parser for the remote write response.
+ */
+static http::ResponseParser remote_write_parser;
+
+/**
+ * Gets the current wall clock time.
+ *
+ * @return	The current time in milliseconds since the unix epoch, or zero if the clock isn't synchronized.
+ */
+static uint64_t getWallClockTime() {
+	timeval now;
+	gettimeofday(&now, NULL);
+	if (now.tv_sec < MIN_VALID_TIME) {
+		return 0;
+	}
+	return (uint64_t) now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+/**
+ * Stores the result of the remote write request of the given connection, if it wasn't stored yet,
+ * and deletes the connection once it was closed.
+ *
+ * This is the only place deleting remote write connections.
+ * AsyncTCP calls the disconnect callback after the error callback, and from close,
+ * so the connection is only deleted from the disconnect callback, or if connecting failed.
+ *
+ * @param client	The connection of the request.
+ * @param status	The HTTP status code of the response, or zero if there was no response.
+ * @param closed	Whether the connection was closed, and won't call any more callbacks.
+ * @return	True if this call stored the result.
+ */
+static bool finishRemoteWrite(AsyncClient *client, const uint16_t status,
+		const bool closed) {
+	bool stored = false;
+	if (remote_write_client.load() == client) {
+		int32_t expected = REMOTE_WRITE_PENDING;
+		stored = remote_write_status.compare_exchange_strong(expected, status);
+	}
+
+	if (closed) {
+		AsyncClient *expected = client;
+		remote_write_client.compare_exchange_strong(expected, NULL);
+		delete client;
+	}
+	return stored;
+}
 #endif
 
 void prom::setup() {
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	registerMetrics();
+#endif
 #if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
 	web::registerRequestHandler("/metrics", HTTP_GET, handleMetrics);
 #endif
@@ -39,6 +279,9 @@ void prom::loop() {
 #if ENABLE_PROMETHEUS_PUSH == 1
 	pushMetrics();
 #endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	remoteWrite();
+#endif
 }
 
 void prom::connect() {
@@ -67,15 +310,15 @@ void prom::connect() {
 #endif
 }
 
-#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
-String prom::getMetrics(const bool openmetrics) {
-#if ENABLE_WEB_SERVER == 1
-	// First determine the sum of all called path lengths.
-	size_t uri_len_sum = 0;
-	for (const std::pair<String,
-			std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>> &uri_stats : http_requests_total) {
-		uri_len_sum += uri_stats.first.length();
-	}
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+void prom::registerMetrics() {
+	// From what I could find this seems to be impossible on a ESP8266.
+#ifdef ESP32
+	static ValueFamily heap("process", "heap", "bytes",
+			"The amount of heap used on the ESP in bytes.", "gauge", []() {
+				return (double) (ESP.getHeapSize() - ESP.getFreeHeap());
+			});
+	default_registry.add(heap);
 #endif
 
 #if defined(ESP32) || defined(ESP8266)
@@ -83,402 +326,425 @@ String prom::getMetrics(const bool openmetrics) {
 #else
 	const char *SDK_VERSION = "unknown";
 #endif
-	const size_t SDK_VERSION_LEN = strlen(SDK_VERSION);
+	std::string build_info_labels = "{esptherm_commit=\"";
+	build_info_labels += ESPTHERM_COMMIT;
+	build_info_labels += "\",mcu_type=\"";
+	build_info_labels += MCU_TYPE;
+	build_info_labels += "\",arduino_version=\"";
+	build_info_labels += ARDUINO_VERSION;
+	build_info_labels += "\",sdk_version=\"";
+	build_info_labels += SDK_VERSION;
+	build_info_labels += "\",cpp_std_version=\"";
+	build_info_labels += CPP_VERSION;
+	build_info_labels += "\"}";
+	static InfoFamily build_info(PROMETHEUS_NAMESPACE, "build_info",
+			"A constant 1 with compile time information as labels.",
+			build_info_labels);
+	default_registry.add(build_info);
 
-	// The temperature should never be more than three digits before and after the dot.
-	const size_t temp_max_len = 99 + 43 + PROMETHEUS_NAMESPACE_LEN * 3
-			+ (openmetrics ? 45 + PROMETHEUS_NAMESPACE_LEN : 0) + 38;
-	// The relative humidity should be three digits before and after the dot at most.
-	const size_t humidity_max_len = 94 + 40 + PROMETHEUS_NAMESPACE_LEN * 3
-			+ (openmetrics ? 42 + PROMETHEUS_NAMESPACE_LEN : 0) + 35;
-#ifdef ESP32
-	// A 32 bit unsigned int has 10 digits at most, plus four characters because of the way the number will be formatted.
-	const size_t heap_max_len = 71 + 32 + (openmetrics ? 32 : 0) + 34;
-#else
-	const size_t heap_max_len = 0;
-#endif
-	// Assume that the hash is always seven characters long.
-	const size_t build_info_max_len = 73 + 25 + PROMETHEUS_NAMESPACE_LEN * 3
-			+ (openmetrics ? -1 : 0) + 104 + MCU_TYPE_LEN + ARDUINO_VERSION_LEN + SDK_VERSION_LEN + CPP_VERSION_LEN;
-#if ENABLE_WEB_SERVER == 1
-	// An integer is assumed to be at most 20 digits, plus four characters because of the way they are formatted.
-	const size_t web_requests_total_max_len = 86 + 36
-			+ PROMETHEUS_NAMESPACE_LEN * 2
-			+ (83 + PROMETHEUS_NAMESPACE_LEN) * getRequestCounts()
-			+ uri_len_sum;
-#else
-	const size_t web_requests_total_max_len = 0;
+#if ENABLE_PROMETHEUS_PUSH == 1
+	default_registry.add(push_requests_total);
+	default_registry.add(push_connections_total);
+	default_registry.add(push_request_duration);
+#if ENABLE_PROMETHEUS_PUSH_GZIP == 1
+	default_registry.add(push_compression_ratio);
+	default_registry.add(push_compression_saved_bytes_total);
 #endif
-	const size_t eof_max_len = (openmetrics ? 5 : 0);
-
-	// The added lengths of all the lines.
-	const size_t max_len = temp_max_len + humidity_max_len + heap_max_len
-			+ build_info_max_len + web_requests_total_max_len + eof_max_len;
-
-	char *buffer = new char[max_len + 1];
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+	default_registry.add(remote_write_requests_total);
+	default_registry.add(remote_write_dropped_samples_total);
+#endif
+}
 
-	// Write sensor metrics.
-	size_t len = writeMetric(buffer, PROMETHEUS_NAMESPACE,
-			"external_temperature", "celsius",
-			"The current measured external temperature in degrees celsius.",
-			"gauge", (double) sensors::SENSOR_HANDLER.getTemperature(),
-			openmetrics);
-	len += writeMetric(buffer + len, PROMETHEUS_NAMESPACE, "external_humidity",
-			"percent",
-			"The current measured external relative humidity in percent.",
-			"gauge", (double) sensors::SENSOR_HANDLER.getHumidity(),
-			openmetrics);
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1 */
 
-	// From what I could find this seems to be impossible on a ESP8266.
-#ifdef ESP32
-	const uint64_t used_heap = ESP.getHeapSize() - ESP.getFreeHeap();
-	len += writeMetric(buffer + len, "process", "heap", "bytes",
-			"The amount of heap used on the ESP in bytes.", "gauge",
-			(double) used_heap, openmetrics);
-#endif
-
-	len += writeMetricMetadataLine(buffer + len, "HELP", PROMETHEUS_NAMESPACE,
-			"build_info", "",
-			"A constant 1 with compile time information as labels.");
-	if (openmetrics) {
-		len += writeMetricMetadataLine(buffer + len, "TYPE",
-				PROMETHEUS_NAMESPACE, "build_info", "", "info");
+#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
+web::ResponseData prom::handleMetrics(AsyncWebServerRequest *request) {
+	TRACE_SPAN("prom::handleMetrics");
+	const String accept =
+			request->hasHeader("Accept") ? request->header("Accept") : "";
+	const ExpositionFormat format = negotiateFormat(accept.c_str());
+	const bool protobuf = format == FORMAT_PROTOBUF;
+	const bool openmetrics = format == FORMAT_OPENMETRICS;
+
+	if (protobuf) {
+		log_d("Client accepts protobuf.");
+	} else if (openmetrics) {
+		log_d("Client accepts openmetrics.");
 	} else {
-		len += writeMetricMetadataLine(buffer + len, "TYPE",
-				PROMETHEUS_NAMESPACE, "build_info", "", "gauge");
+		log_d("Client doesn't accept openmetrics.");
 	}
-	strcpy(buffer + len, PROMETHEUS_NAMESPACE);
-	len += PROMETHEUS_NAMESPACE_LEN;
-	strcpy(buffer + len, "_build_info{esptherm_commit=\"");
-	len += 29;
-	strcpy(buffer + len, ESPTHERM_COMMIT);
-	len += 7;
-	strcpy(buffer + len, "\",mcu_type=\"");
-	len += 12;
-	strcpy(buffer + len, MCU_TYPE);
-	len += MCU_TYPE_LEN;
-	strcpy(buffer + len, "\",arduino_version=\"");
-	len += 19;
-	strcpy(buffer + len, ARDUINO_VERSION);
-	len += ARDUINO_VERSION_LEN;
-	strcpy(buffer + len, "\",sdk_version=\"");
-	len += 15;
-	strcpy(buffer + len, SDK_VERSION);
-	len += SDK_VERSION_LEN;
-	strcpy(buffer + len, "\",cpp_std_version=\"");
-	len += 19;
-	strcpy(buffer + len, CPP_VERSION);
-	len += CPP_VERSION_LEN;
-	strcpy(buffer + len, "\"} 1\n");
-	len += 5;
-
-#if ENABLE_WEB_SERVER == 1
-	// Write web server statistics.
-	len += writeMetricMetadataLine(buffer + len, "HELP", PROMETHEUS_NAMESPACE,
-			"http_requests_total", "",
-			"The total number of HTTP requests handled by this server.");
-	len += writeMetricMetadataLine(buffer + len, "TYPE", PROMETHEUS_NAMESPACE,
-			"http_requests_total", "", "counter");
-
-	for (std::map<String,
-			std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>>::const_iterator uri_stats =
-			http_requests_total.cbegin();
-			uri_stats != http_requests_total.cend(); uri_stats++) {
-		for (std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>::const_iterator response_stats =
-				uri_stats->second.cbegin();
-				response_stats != uri_stats->second.cend(); response_stats++) {
-			strncpy(buffer + len, PROMETHEUS_NAMESPACE,
-					min(max_len - len, PROMETHEUS_NAMESPACE_LEN));
-			len += PROMETHEUS_NAMESPACE_LEN;
-			strncpy(buffer + len, "_http_requests_total{method=\"",
-					min(max_len - len, (size_t) 29));
-			len += 29;
-			switch (response_stats->first.first) {
-			case HTTP_GET:
-				strncpy(buffer + len, "get", min(max_len - len, (size_t) 3));
-				len += 3;
-				break;
-			case HTTP_POST:
-				strncpy(buffer + len, "post", min(max_len - len, (size_t) 4));
-				len += 4;
-				break;
-			case HTTP_PUT:
-				strncpy(buffer + len, "put", min(max_len - len, (size_t) 3));
-				len += 3;
-				break;
-			case HTTP_PATCH:
-				strncpy(buffer + len, "patch", min(max_len - len, (size_t) 5));
-				len += 5;
-				break;
-			case HTTP_DELETE:
-				strncpy(buffer + len, "delete", min(max_len - len, (size_t) 6));
-				len += 6;
-				break;
-			case HTTP_HEAD:
-				strncpy(buffer + len, "head", min(max_len - len, (size_t) 4));
-				len += 4;
-				break;
-			case HTTP_OPTIONS:
-				strncpy(buffer + len, "options",
-						min(max_len - len, (size_t) 7));
-				len += 7;
-				break;
-			default:
-				strncpy(buffer + len, "unknown",
-						min(max_len - len, (size_t) 7));
-				len += 7;
-				log_e("Unknown request method %u for uri \"%s\" in stats map.",
-						response_stats->first.first, uri_stats->first.c_str());
-				break;
-			}
 
-			len += snprintf(buffer + len, max_len - len,
-					"\",code=\"%u\",path=\"%s\"} %.3f\n",
-					response_stats->first.second, uri_stats->first.c_str(),
-					(double) response_stats->second);
-			if (len >= max_len) {
-				log_e("Metrics generation buffer overflow.");
-				break;
+	std::vector<std::string> names;
+	for (size_t i = 0; i < request->params(); i++) {
+		const AsyncWebParameter *param = request->getParam(i);
+		if (param->isPost() || (param->name() != "name[]" && param->name() != "family")) {
+			continue;
+		}
+
+		const char *start = param->value().c_str();
+		while (*start && names.size() < MAX_METRICS_FILTER_NAMES) {
+			const char *end = strchr(start, ',');
+			const size_t len = end ? (size_t) (end - start) : strlen(start);
+			if (len > 0) {
+				names.emplace_back(start, len);
 			}
+			start += end ? len + 1 : len;
 		}
 	}
-#endif /* ENABLE_WEB_SERVER == 1 */
-	if (openmetrics) {
-		strncpy(buffer + len, "# EOF\n", min(max_len - len, (size_t) 7));
-		len += 6;
-	}
-
-	String metrics = buffer;
-	delete[] buffer;
-	return metrics;
-}
 
-template<size_t ns_l, size_t nm_l, size_t u_l, size_t dc_l, size_t tp_l>
-size_t prom::writeMetric(char *buffer, const char (&metric_namespace)[ns_l],
-		const char (&metric_name)[nm_l], const char (&metric_unit)[u_l],
-		const char (&metric_description)[dc_l], const char (&metric_type)[tp_l],
-		const double value, const bool openmetrics) {
-	size_t written = writeMetricMetadataLine(buffer, "HELP", metric_namespace,
-			metric_name, metric_unit, metric_description);
-	written += writeMetricMetadataLine(buffer + written, "TYPE",
-			metric_namespace, metric_name, metric_unit, metric_type);
-	if (openmetrics) {
-		written += writeMetricMetadataLine(buffer + written, "UNIT",
-				metric_namespace, metric_name, metric_unit, metric_unit);
+	if (!names.empty()) {
+		log_d("Limiting the metrics to %u families.", (unsigned int) names.size());
 	}
 
-	if (ns_l > 1) {
-		strcpy(buffer + written, metric_namespace);
-		written += ns_l - 1;
-		buffer[written++] = '_';
-	}
-	strcpy(buffer + written, metric_name);
-	written += nm_l - 1;
-	if (u_l > 1) {
-		buffer[written++] = '_';
-		strcpy(buffer + written, metric_unit);
-		written += u_l - 1;
-	}
+	// Measurements written by a partial scrape are still written to the next complete one.
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+	const uint32_t measurement_sequence =
+			names.empty() ? sensors::getMeasurementSequence() : 0;
+	const String scraper =
+			request->hasParam("scraper") ?
+					request->getParam("scraper")->value() :
+					request->client()->remoteIP().toString();
+	const uint8_t consumer = getScrapeConsumer(scraper);
+#else
+	const uint32_t measurement_sequence = 0;
+	const uint8_t consumer = CONSUMER_SCRAPE;
+#endif
 
-	if (!std::isnan(value)) {
-		written += sprintf(buffer + written, " %.3f\n", value);
-	} else {
-		strcpy(buffer + written, " NAN\n");
-		written += 5;
+	// Concurrent scrapes share an exposition if they use the same format and filter.
+	String key = protobuf ? "protobuf" : (openmetrics ? "openmetrics" : "text");
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+	// Scrapers that acknowledged the same measurements get the same exposition.
+	key += '@';
+	key += sensors::getAcknowledgedMeasurement(consumer);
+#endif
+	for (const std::string &name : names) {
+		key += ',';
+		key += name.c_str();
 	}
-	buffer[written] = 0;
 
-	return written;
-}
+	const std::shared_ptr<MetricsRender> render =
+			metrics_renders.get(key,
+					[protobuf, openmetrics, &names, measurement_sequence, consumer]() -> std::shared_ptr<MetricsRender> {
+						if (protobuf) {
+							const std::shared_ptr<ProtobufWriter> writer = mem::make_shared<ProtobufWriter>(mem::PROM,
+									default_registry.getFamilies(), names, consumer);
+							return mem::make_shared<MetricsRender>(mem::PROM,
+									[writer](uint8_t *buffer, const size_t max_len) {
+										return writer->read(buffer, max_len);
+									}, measurement_sequence);
+						}
 
-template<size_t fnm_l, size_t ns_l, size_t nm_l, size_t u_l, size_t vl_l>
-size_t prom::writeMetricMetadataLine(char *buffer,
-		const char (&field_name)[fnm_l], const char (&metric_namespace)[ns_l],
-		const char (&metric_name)[nm_l], const char (&metric_unit)[u_l],
-		const char (&value)[vl_l]) {
-	size_t written = 0;
-	buffer[written++] = '#';
-	buffer[written++] = ' ';
-	strcpy(buffer + written, field_name);
-	written += fnm_l - 1;
-	buffer[written++] = ' ';
-
-	if (ns_l > 1) {
-		strcpy(buffer + written, metric_namespace);
-		written += ns_l - 1;
-		buffer[written++] = '_';
+						const std::shared_ptr<ExpositionWriter> writer = mem::make_shared<ExpositionWriter>(mem::PROM,
+								default_registry.getFamilies(), openmetrics, names, consumer);
+						return mem::make_shared<MetricsRender>(mem::PROM,
+								[writer](uint8_t *buffer, const size_t max_len) {
+									return writer->read(buffer, max_len);
+								}, measurement_sequence);
+					}, [](const MetricsRender &render) {
+						return render.stream.joinable();
+					});
+
+	const char *content_type =
+			protobuf ?
+					"application/vnd.google.protobuf; proto=io.prometheus.client.MetricFamily; encoding=delimited" :
+					(openmetrics ?
+							"application/openmetrics-text; version=1.0.0; charset=utf-8" :
+							"text/plain; version=0.0.4; charset=utf-8");
+	using namespace std::placeholders;
+	const AwsResponseFiller filler = std::bind(metricsResponseFiller,
+			mem::make_shared<utils::SharedStream::Reader>(mem::PROM,
+					std::shared_ptr<utils::SharedStream>(render,
+							&render->stream)), _1, _2, _3);
+
+	AsyncWebServerResponse *response = NULL;
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+	// HTTP/1.0 clients don't support chunked responses, so they don't acknowledge measurements.
+	if (render->measurement_sequence != 0 && request->version() != 0) {
+		const uint32_t sequence = render->measurement_sequence;
+		response = new web::AsyncChunkedCompletionResponse(content_type, filler,
+				[consumer, scraper, sequence]() {
+					acknowledgeScrape(consumer, scraper, sequence);
+				});
 	}
-	strcpy(buffer + written, metric_name);
-	written += nm_l - 1;
-	if (u_l > 1) {
-		buffer[written++] = '_';
-		strcpy(buffer + written, metric_unit);
-		written += u_l - 1;
+#endif
+	if (!response) {
+		response = request->beginChunkedResponse(content_type, filler);
 	}
+	response->addHeader("Cache-Control", web::CACHE_CONTROL_NOCACHE);
+	response->addHeader("Vary", "Accept");
+	return web::ResponseData(response, 0, 200);
+}
 
-	buffer[written++] = ' ';
-	strcpy(buffer + written, value);
-	written += vl_l - 1;
-	buffer[written++] = '\n';
-	buffer[written] = 0;
+prom::MetricsRender::MetricsRender(
+		const utils::SharedStream::source_function source,
+		const uint32_t measurement_sequence) :
+		stream(source, PROMETHEUS_SCRAPE_SHARED_BUFFER_SIZE), measurement_sequence(
+				measurement_sequence) {
 
-	return written;
 }
 
-#if ENABLE_WEB_SERVER == 1
-size_t prom::getRequestCounts() {
-	size_t count = 0;
-	for (const std::pair<String,
-			std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>> &uri_stats : http_requests_total) {
-		count += uri_stats.second.size();
-	}
-	return count;
+size_t prom::metricsResponseFiller(
+		const std::shared_ptr<utils::SharedStream::Reader> reader,
+		uint8_t *buffer, const size_t max_len, const size_t index) {
+	TRACE_SPAN("prom::metricsResponseFiller");
+	return reader->read(buffer, max_len);
 }
-#endif
-#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 */
 
-#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
-web::ResponseData prom::handleMetrics(AsyncWebServerRequest *request) {
-	const bool openmetrics = request->hasHeader("Accept")
-			&& web::csvHeaderContains(request->header("Accept").c_str(),
-					"application/openmetrics-text");
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+uint8_t prom::getScrapeConsumer(const String &scraper) {
+	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
+	uint8_t oldest = 0;
+	for (uint8_t i = 0; i < SCRAPE_CONSUMERS; i++) {
+		if (scraper_times[i] != 0 && scrapers[i] == scraper) {
+			scraper_times[i] = now;
+			return CONSUMER_SCRAPE + i;
+		} else if (scraper_times[i] < scraper_times[oldest]) {
+			oldest = i;
+		}
+	}
 
-	if (openmetrics) {
-		log_d("Client accepts openmetrics.");
-	} else {
-		log_d("Client doesn't accept openmetrics.");
+	if (scraper_times[oldest] != 0) {
+		log_i("Reassigning the measurement consumer of scraper %s to %s.",
+				scrapers[oldest].c_str(), scraper.c_str());
 	}
+	scrapers[oldest] = scraper;
+	scraper_times[oldest] = now;
+	sensors::resetMeasurementConsumer(CONSUMER_SCRAPE + oldest);
+	return CONSUMER_SCRAPE + oldest;
+}
 
-	const String metrics = getMetrics(openmetrics);
-	AsyncWebServerResponse *response =
-			request->beginResponse(200,
-					(openmetrics ?
-							"application/openmetrics-text; version=1.0.0; charset=utf-8" :
-							"text/plain; version=0.0.4; charset=utf-8"),
-					metrics);
-	response->addHeader("Cache-Control", web::CACHE_CONTROL_NOCACHE);
-	response->addHeader("Vary", "Accept");
-	return web::ResponseData(response, metrics.length(), 200);
+void prom::acknowledgeScrape(const uint8_t consumer, const String &scraper,
+		const uint32_t sequence) {
+	if (consumer >= CONSUMER_SCRAPE && consumer - CONSUMER_SCRAPE < SCRAPE_CONSUMERS
+			&& scrapers[consumer - CONSUMER_SCRAPE] == scraper) {
+		sensors::acknowledgeMeasurements(consumer, sequence);
+	}
 }
 #endif
+#endif
 
 #if ENABLE_PROMETHEUS_PUSH == 1
 void prom::pushMetrics() {
+	TRACE_SPAN("prom::pushMetrics");
 	if (!WiFi.isConnected()) {
 		delay(20);
 		return;
 	}
 
-	if (tcpClient) { // Don't try pushing if tcpClient isn't NULL.
-		if (tcpClient->connected() || tcpClient->connecting()) {
-			tcpClient->close(true);
-		}
-		delay(20);
+#if ENABLE_DEEP_SLEEP_MODE != 1
+	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
+	if (last_push_attempt != 0
+			&& now - last_push_attempt < PROMETHEUS_PUSH_INTERVAL * 1000) {
 		return;
 	}
+	last_push_attempt = now;
+#endif
+
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+	const uint32_t measurement_sequence = sensors::getMeasurementSequence();
+#else
+	const uint32_t measurement_sequence = 0;
+#endif
 
+	std::shared_ptr<ExpositionWriter> writer = mem::make_shared<
+			ExpositionWriter>(mem::PROM, default_registry.getFamilies(), false,
+			std::vector<std::string>(), CONSUMER_PUSH);
+#if ENABLE_PROMETHEUS_PUSH_GZIP == 1
+	std::shared_ptr<gzip::gzip_compressor> compressor = mem::make_shared<
+			gzip::gzip_compressor>(mem::GZIP,
+			[writer](uint8_t *buffer, const size_t max_len) {
+				return writer->read(buffer, max_len);
+			});
+	const bool queued = push_client.push(
+			[compressor](uint8_t *buffer, const size_t max_len) {
+				return compressor->read(buffer, max_len);
+			}, [measurement_sequence, compressor](const uint16_t status) {
+				if (compressor->done()) {
+					const uint32_t uncompressed = compressor->getUncompressedSize();
+					const uint32_t compressed = compressor->getCompressedSize();
+					push_compression_ratio.get().set((float) uncompressed / compressed);
+					if (uncompressed > compressed) {
+						push_compression_saved_bytes_total.get().inc(uncompressed - compressed);
+					}
+				}
+#else
+	const bool queued = push_client.push(
+			[writer](uint8_t *buffer, const size_t max_len) {
+				return writer->read(buffer, max_len);
+			}, [measurement_sequence](const uint16_t status) {
+#endif
+				if (status == 200) {
+					successful_pushes.inc();
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+					sensors::acknowledgeMeasurements(CONSUMER_PUSH, measurement_sequence);
+#endif
 #if ENABLE_DEEP_SLEEP_MODE != 1
-	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
-	if (now - last_push >= PROMETHEUS_PUSH_INTERVAL * 1000) {
+					const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
+					if (now - last_push >= (PROMETHEUS_PUSH_INTERVAL + 10) * 1000) {
+						log_i("Successfully pushed again after %lums.", (unsigned long) (now - last_push));
+					}
+					last_push = now;
 #endif
-		tcpClient = new AsyncClient();
+				} else if (status == 0) {
+					failed_pushes.inc();
+					log_e("Pushing metrics to the prometheus pushgateway failed.");
+				} else {
+					failed_pushes.inc();
+					log_w("Received http status code %d when trying to push metrics.", status);
+				}
+			});
 
-		if (!tcpClient) {
-			log_e("Failed to allocate Async TCP Client!");
-			return;
-		}
+	if (!queued) {
+		// The previous push didn't start yet, so the connection is stuck.
+		log_w("The previous push is still waiting to be sent.");
+	}
 
-		tcpClient->setAckTimeout(PROMETHEUS_PUSH_INTERVAL * 0.75);
-		tcpClient->setRxTimeout(PROMETHEUS_PUSH_INTERVAL * 0.75);
-		tcpClient->onError([](void *arg, AsyncClient *cli, int error) {
-			log_e("Connecting to the metrics server failed!");
-			log_e("Connection Error: %d", error);
-			if (tcpClient != NULL) {
-				tcpClient = NULL;
-				delete cli;
-			}
-		}, NULL);
+#if ENABLE_DEEP_SLEEP_MODE == 1
+	while (push_client.isBusy()) {
+		delay(10);
+	}
+#endif
+}
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 */
 
-		tcpClient->onConnect([](void *arg, AsyncClient *cli) {
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+void prom::remoteWrite() {
+	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
+	const int32_t status = remote_write_status.load();
+	if (status >= 0) {
+		const size_t samples = remote_write_sender.getInFlightSamples();
+		switch (remote_write_sender.finishRequest(status, now)) {
+		case RemoteWriteSender::SUCCESS:
+			successful_remote_writes.inc();
+			log_d("Sent %u samples to the remote write receiver.",
+					(unsigned int ) samples);
+			break;
+		case RemoteWriteSender::RETRY:
+			failed_remote_writes.inc();
+			log_w("Remote write failed with status code %d, retrying later.",
+					status);
+			break;
+		case RemoteWriteSender::REJECTED:
+			rejected_remote_writes.inc();
+			dropped_remote_write_samples.inc(samples);
+			log_e("Remote write receiver rejected %u samples with status code %d.",
+					(unsigned int ) samples, status);
+			break;
+		}
+		remote_write_status.store(REMOTE_WRITE_IDLE);
+	}
 
-			cli->onDisconnect([](void *arg, AsyncClient *c) {
-				if (tcpClient != NULL) {
-					tcpClient = NULL;
-					log_e("Connection to prometheus pushgateway server was closed while reading or writing.");
-					delete c;
-				}
-			}, NULL);
+	if (now - last_remote_write_collect
+			>= PROMETHEUS_REMOTE_WRITE_COLLECT_INTERVAL * 1000) {
+		const uint64_t timestamp = getWallClockTime();
+		if (timestamp != 0) {
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+			const uint32_t measurement_sequence =
+					sensors::getMeasurementSequence();
+#endif
+			const size_t dropped = remote_write_sender.collect(
+					default_registry.getFamilies(), timestamp,
+					CONSUMER_REMOTE_WRITE);
+			if (dropped > 0) {
+				dropped_remote_write_samples.inc(dropped);
+				log_w("Dropped %u samples, because the remote write buffer is full.",
+						(unsigned int ) dropped);
+			}
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+			sensors::acknowledgeMeasurements(CONSUMER_REMOTE_WRITE,
+					measurement_sequence);
+#endif
+			last_remote_write_collect = now;
+		}
+	}
 
-			std::shared_ptr<size_t> read = std::make_shared<size_t>(0);
-			cli->onData([read](void *arg, AsyncClient *c, void *data, size_t len) mutable {
-				uint8_t *d = (uint8_t*) data;
+	if (remote_write_status.load() != REMOTE_WRITE_IDLE || !WiFi.isConnected()
+			|| !remote_write_sender.isReady(now)) {
+		return;
+	}
 
-				for (size_t i = 0; i < len; i++) {
-					if (*read > 8 && isDigit(d[i]) && len > i + 2) {
-						char status_code[4] { 0 };
-						for (uint8_t j = 0; j < 3; j++) {
-							status_code[j] = d[i + j];
-						}
+	remote_write_request = remote_write_sender.prepareRequest(now,
+			remote_write_request_len);
+	remote_write_request_sent = 0;
+	remote_write_parser.reset();
+	remote_write_status.store(REMOTE_WRITE_PENDING);
 
-						uint32_t code = atoi(status_code);
-						if (code == 200) {
-#if ENABLE_DEEP_SLEEP_MODE != 1
-							const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
+	AsyncClient *client = new AsyncClient();
+	if (!client) {
+		log_e("Failed to allocate Async TCP Client!");
+		remote_write_status.store(0);
+		return;
+	}
+	remote_write_client.store(client);
+
+	client->setAckTimeout(REMOTE_WRITE_TIMEOUT * 1000);
+	client->setRxTimeout(REMOTE_WRITE_TIMEOUT);
+	client->onError([](void *arg, AsyncClient *cli, int error) {
+		log_e("Connecting to the remote write receiver failed!");
+		log_e("Connection Error: %d", error);
+		finishRemoteWrite(cli, 0, false);
+	}, NULL);
+
+	client->onDisconnect([](void *arg, AsyncClient *c) {
+		if (finishRemoteWrite(c, 0, true)) {
+			log_e("Connection to the remote write receiver was closed before receiving a response.");
+		}
+	}, NULL);
+
+	client->onConnect([](void *arg, AsyncClient *cli) {
+		// The result is known once the final status line is parsed, so the rest of the response is ignored.
+		// Closing the connection here would delete it while AsyncTCP is still using it, so it is closed on the next poll.
+		cli->onData([](void *arg, AsyncClient *c, void *data, size_t len) {
+			if (remote_write_client.load() != c) {
+				return;
+			}
 
-							if (now - last_push >= (PROMETHEUS_PUSH_INTERVAL + 10) * 1000) {
-								log_i("Successfully pushed again after %lums.", now - last_push);
-							}
+			remote_write_parser.parse((const uint8_t*) data, len);
+			const uint16_t status = remote_write_parser.getStatus();
+			if (status >= 200 || remote_write_parser.hasError()) {
+				c->onAck(NULL, NULL);
+				c->onData(NULL, NULL);
+				finishRemoteWrite(c,
+						remote_write_parser.hasError() ? 0 : status, false);
+			}
+		}, NULL);
 
-							last_push = now;
-#endif
-						} else {
-							log_w("Received http status code %d when trying to push metrics.", code);
-						}
+		cli->onPoll([](void *arg, AsyncClient *c) {
+			if (remote_write_client.load() != c
+					|| remote_write_status.load() != REMOTE_WRITE_PENDING) {
+				c->close(true);
+			}
+		}, NULL);
 
-						if (tcpClient != NULL) {
-							tcpClient = NULL;
-							if (c->connected()) {
-								c->close(true);
-							}
-							delete c;
-						}
-						return;
-					}
-					(*read)++;
-				}
-			}, NULL);
-
-			cli->write("POST ");
-			cli->write(push_url.c_str());
-			cli->write(" HTTP/1.0\r\nHost: ");
-			cli->write(PROMETHEUS_PUSH_ADDR);
-			cli->write("\r\n");
-			String metrics = getMetrics();
-			cli->write("Content-Type: application/x-www-form-urlencoded\r\n");
-			cli->write("Content-Length: ");
-			std::ostringstream converter;
-			converter << metrics.length();
-			cli->write(converter.str().c_str());
-			cli->write("\r\n\r\n");
-			cli->write(metrics.c_str());
-			cli->write("\r\n\r\n");
+		cli->onAck([](void *arg, AsyncClient *c, size_t len, uint32_t time) {
+			writeRemoteWriteRequest(c);
 		}, NULL);
+		writeRemoteWriteRequest(cli);
+	}, NULL);
 
-		if (!tcpClient->connect(PROMETHEUS_PUSH_ADDR, PROMETHEUS_PUSH_PORT)) {
-			log_e("Connecting to the metrics server failed!");
-			if (tcpClient != NULL) {
-				AsyncClient *cli = tcpClient;
-				tcpClient = NULL;
-				delete cli;
-			}
-		}
+	if (!client->connect(PROMETHEUS_REMOTE_WRITE_ADDR,
+			PROMETHEUS_REMOTE_WRITE_PORT)) {
+		log_e("Connecting to the remote write receiver failed!");
+		finishRemoteWrite(client, 0, true);
+	}
+}
 
-#if ENABLE_DEEP_SLEEP_MODE == 1
-		while (tcpClient != NULL) {
-			delay(10);
-		}
-#else
+void prom::writeRemoteWriteRequest(AsyncClient *client) {
+	const size_t space = client->space();
+	if (remote_write_request_sent >= remote_write_request_len || space == 0) {
+		return;
+	}
+
+	const size_t len = min(space,
+			remote_write_request_len - remote_write_request_sent);
+	client->add((const char*) remote_write_request + remote_write_request_sent,
+			len);
+	client->send();
+	remote_write_request_sent += len;
+	if (remote_write_request_sent >= remote_write_request_len) {
+		client->onAck(NULL, NULL);
 	}
-#endif
 }
-#endif /* ENABLE_PROMETHEUS_PUSH == 1 */
+#endif /* ENABLE_PROMETHEUS_REMOTE_WRITE == 1 */
@@ -15,39 +15,100 @@
 #if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
 #include "webhandler.h"
 #endif
-#if ENABLE_WEB_SERVER == 1 && (ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1)
-#include <map>
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include <prometheus_registry.h>
+#include <memory>
+#include <vector>
 #endif
-#if ENABLE_PROMETHEUS_PUSH == 1
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+#include <prometheus_remote_write.h>
+#endif
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
 #ifdef ESP32
 #include <AsyncTCP.h>
 #elif defined(ESP8266)
 #include <ESPAsyncTCP.h>
 #endif
 #endif
+#if ENABLE_PROMETHEUS_PUSH == 1
+#include "HttpPushClient.h"
+#endif
 #if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
 #include <ESPAsyncWebServer.h>
+#include <shared_stream.h>
 #endif
 
 /**
  * This header, and the source file with the same name, contain everything for the prometheus integration.
  */
 namespace prom {
-#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
-#if ENABLE_WEB_SERVER == 1
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
 /**
- * A map used to track the number of http requests handled by this esp.
- * The format is "URI -> (Method, Response Code) -> Count".
+ * The consumers the metrics are written for.
+ * Each of them acknowledges the measurements it received separately.
+ * Each scraper gets its own consumer, starting at CONSUMER_SCRAPE.
  */
-extern std::map<String,
-		std::map<std::pair<WebRequestMethod, uint16_t>, uint64_t>> http_requests_total;
-#endif
+enum MetricsConsumer : uint8_t {
+	CONSUMER_PUSH, CONSUMER_REMOTE_WRITE, CONSUMER_SCRAPE
+};
+
+/**
+ * The max number of scrapers that acknowledge measurements separately.
+ */
+static constexpr uint8_t SCRAPE_CONSUMERS = BackfillGaugeFamily::MAX_CONSUMERS
+		- CONSUMER_SCRAPE;
+
 #if ENABLE_PROMETHEUS_PUSH == 1
+/**
+ * The metric counting the pushes to the pushgateway, by whether they succeeded.
+ */
+extern CounterFamily push_requests_total;
+
+/**
+ * The metric counting the connections opened to the pushgateway.
+ */
+extern CounterFamily push_connections_total;
+
+/**
+ * The metric for the time between starting a push and receiving the response of the pushgateway.
+ */
+extern HistogramFamily push_request_duration;
+#if ENABLE_PROMETHEUS_PUSH_GZIP == 1
+/**
+ * The metric for the ratio between the uncompressed and the compressed size of the last push body.
+ */
+extern GaugeFamily push_compression_ratio;
+
+/**
+ * The metric counting the bytes that weren't sent because the push bodies were compressed.
+ */
+extern CounterFamily push_compression_saved_bytes_total;
+#endif
 #if ENABLE_DEEP_SLEEP_MODE != 1
 extern uint64_t last_push;
 #endif
-extern AsyncClient *tcpClient;
 extern std::string push_url;
+
+/**
+ * The client keeping the connection to the pushgateway open, and sending the push requests.
+ */
+extern http::PushClient push_client;
+#endif
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+/**
+ * The metric counting the requests to the remote write receiver, by result.
+ */
+extern CounterFamily remote_write_requests_total;
+
+/**
+ * The metric counting the samples that were dropped instead of being sent to the remote write receiver.
+ */
+extern CounterFamily remote_write_dropped_samples_total;
+
+/**
+ * The sender buffering the samples for the remote write receiver.
+ */
+extern RemoteWriteSender remote_write_sender;
 #endif
 
 /**
@@ -61,11 +122,6 @@ static constexpr const char MCU_TYPE[] = "esp8266";
 static constexpr const char MCU_TYPE[] = "unknown";
 #endif
 
-/**
- * The length of the microcontroller type string(MCU_TYPE).
- */
-static constexpr const size_t MCU_TYPE_LEN = utils::strlen(MCU_TYPE);
-
 /**
  * The version of the arduino implementation used on the microcontroller.
  */
@@ -81,11 +137,6 @@ static const char *ARDUINO_VERSION =
 				UNSIGNED_TO_STRING(esp8266::coreVersionRevision()));
 #endif
 
-/**
- * The length of the arduino version string.
- */
-static const size_t ARDUINO_VERSION_LEN = utils::strlen(ARDUINO_VERSION);
-
 /**
  * CPP_VER is a helper macro to get the C++ version number component for the C++ standard version string.
  */
@@ -106,12 +157,7 @@ static const char *CPP_VERSION =
 #else
 		strcat(strcat(new char[6] { 0 }, "c++"), CPP_VER);
 #endif
-
-/**
- * The length of the C++ standard version used to compile this program.
- */
-static const size_t CPP_VERSION_LEN = utils::strlen(CPP_VERSION);
-#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 */
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1 */
 
 /**
  * Initializes the prometheus integration.
@@ -128,84 +174,102 @@ void loop();
  */
 void connect();
 
-#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
+#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1
 /**
- * Creates a string containing the metrics for prometheus.
- *
- * @param openmetrics	Whether to generate OpenMetrics compliant output. Default is Prometheus 0.0.4 output.
- * @return	A string containing all the metrics for a prometheus server.
+ * Registers the metric families that aren't owned by another module in the default registry.
+ * Called by setup.
  */
-String getMetrics(const bool openmetrics = false);
+void registerMetrics();
+
+#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_REMOTE_WRITE == 1 */
 
+#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
 /**
- * Writes a metric entry constructed from the given values to the given buffer.
- * All the string arguments have to be compile time constant character arrays, **NOT POINTERS**!
- * This function does write a NUL byte after the text it writes, but this byte isn't considered for the return value.
- *
- * @tparam ns_l	The length of the metric namespace.
- * @tparam nm_l	The length of the metric name, without the unit and namespace part.
- * @tparam u_l	The length of the unit string.
- * @tparam dc_l	The length of the metric description.
- * @tparam tp_l	The length of the metric type.
- * @param buffer				The character buffer to write to.
- * @param metric_namespace		The name of the metric namespace to use.
- * @param metric_name			The name of the metric to write without the namespace and unit components.
- * @param metric_unit			The unit of the metric to write. May be empty.
- * @param metric_description	The description text for the metric.
- * @param metric_type			The metric type to write to the buffer.
- * @param value					The current value of the given metric.
- * @param openmetrics			Whether to use the OpenMetrics spec, instead of the default prometheus one.
- * @return	The number of bytes written to the output buffer.
+ * A metrics exposition that is shared by concurrent identical scrapes.
  */
-template<size_t ns_l, size_t nm_l, size_t u_l, size_t dc_l, size_t tp_l>
-size_t writeMetric(char *buffer, const char (&metric_namespace)[ns_l],
-		const char (&metric_name)[nm_l], const char (&metric_unit)[u_l],
-		const char (&metric_description)[dc_l], const char (&metric_type)[tp_l],
-		const double value, const bool openmetrics = false);
+struct MetricsRender {
+	/**
+	 * The stream the exposition is written to.
+	 */
+	utils::SharedStream stream;
+
+	/**
+	 * The sequence number of the newest measurement when the exposition was started.
+	 */
+	const uint32_t measurement_sequence;
+
+	/**
+	 * Creates a new metrics render.
+	 *
+	 * @param source				The function writing the exposition.
+	 * @param measurement_sequence	The sequence number of the newest measurement.
+	 */
+	MetricsRender(const utils::SharedStream::source_function source,
+			const uint32_t measurement_sequence);
+};
 
 /**
- * Writes a metric metadata line constructed from the given strings to the given buffer.
- * All the string arguments have to be compile time constant character arrays, **NOT POINTERS**!
- * This function does write a NUL byte after the text it writes, but this byte isn't considered for the return value.
+ * The metrics expositions that are still being sent, by format and metric family filter.
+ */
+extern web::SingleFlight<MetricsRender> metrics_renders;
+
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+/**
+ * Gets the consumer of the given scraper, assigning one if it doesn't have one yet.
  *
- * @tparam fnm_l	The length of the metadata field name.
- * @tparam ns_l		The length of the metric namespace.
- * @tparam nm_l		The length of the metric name, without the unit and namespace part.
- * @tparam u_l		The length of the unit string.
- * @tparam vl_l		The length of the value string.
- * @param buffer				The character buffer to write to.
- * @param field_name			The name of the metric metadata field. Has to be in CAPS.
- * @param metric_namespace		The name of the metric namespace to use.
- * @param metric_name			The name of the metric to write without the namespace and unit components.
- * @param metric_unit			The unit of the metric to write. May be empty.
- * @param value					The value string to write to the output buffer.
- * @return	The number of characters that were written to the output buffer.
- */
-template<size_t fnm_l, size_t ns_l, size_t nm_l, size_t u_l, size_t vl_l>
-size_t writeMetricMetadataLine(char *buffer, const char (&field_name)[fnm_l],
-		const char (&metric_namespace)[ns_l], const char (&metric_name)[nm_l],
-		const char (&metric_unit)[u_l], const char (&value)[vl_l]);
-
-#if ENABLE_WEB_SERVER == 1
-/**
- * Checks the total number of request counts.
+ * If all scrape consumers are in use, the one of the scraper that scraped least recently is reassigned.
+ * Its acknowledged measurements are reset, so the new scraper receives the entire history.
  *
- * Used to generate the metrics page.
+ * @param scraper	The "scraper" query parameter of the request, or the address of the client.
+ * @return	The consumer index of the scraper.
+ */
+uint8_t getScrapeConsumer(const String &scraper);
+
+/**
+ * Acknowledges the measurements up to the given sequence number for the given scraper.
+ * Does nothing if its consumer was reassigned to another scraper in the meantime.
  *
- * @return	The total number of metrics counts.
+ * @param consumer	The consumer index of the scraper.
+ * @param scraper	The scraper that received the measurements.
+ * @param sequence	The sequence number of the newest received measurement.
  */
-size_t getRequestCounts();
+void acknowledgeScrape(const uint8_t consumer, const String &scraper,
+		const uint32_t sequence);
 #endif
-#endif /* ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 */
 
-#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
 /**
  * The callback method to respond to a HTTP get request for the metrics page.
  *
+ * The metrics are written to the chunks of a chunked response as they are sent,
+ * so the response size doesn't affect the memory use.
+ * Concurrent scrapes with the same format and filter share one exposition,
+ * as long as it didn't produce more than PROMETHEUS_SCRAPE_SHARED_BUFFER_SIZE bytes yet.
+ *
+ * The metric families to write can be limited using "name[]" or "family" query parameters,
+ * each containing a comma separated list of full metric family names.
+ * Measurements are only acknowledged once the client received a complete scrape.
+ * Each scraper acknowledges them separately, identified by the "scraper" query parameter or its address.
+ *
+ * Clients accepting the delimited protobuf format get it instead of a text format.
+ * Otherwise the OpenMetrics text format is written if it is accepted, and the Prometheus 0.0.4 text format if not.
+ *
  * @param request	The request to respond to.
  * @return	The HTTP status code of the response.
  */
 web::ResponseData handleMetrics(AsyncWebServerRequest *request);
+
+/**
+ * An AwsResponseFiller writing the next part of a metrics exposition to the output buffer.
+ *
+ * @param reader	The reader of the shared metrics exposition.
+ * @param buffer	The output buffer to write to.
+ * @param max_len	The max number of bytes to write to the output buffer.
+ * @param index		The number of bytes already written to this response.
+ * @return	The number of bytes written to the output buffer.
+ */
+size_t metricsResponseFiller(
+		const std::shared_ptr<utils::SharedStream::Reader> reader,
+		uint8_t *buffer, const size_t max_len, const size_t index);
 #endif
 
 #if ENABLE_PROMETHEUS_PUSH == 1
@@ -214,6 +278,23 @@ web::ResponseData handleMetrics(AsyncWebServerRequest *request);
  */
 void pushMetrics();
 #endif
+
+#if ENABLE_PROMETHEUS_REMOTE_WRITE == 1
+/**
+ * Handles the result of the last remote write request, collects the metrics if the collect interval passed,
+ * and starts a new remote write request if the sender is ready.
+ */
+void remoteWrite();
+
+/**
+ * Writes as much of the remote write request as fits into the send buffer of the connection.
+ *
+ * Called again whenever sent data is acknowledged, until the entire request was sent.
+ *
+ * @param client	The connection to the remote write receiver.
+ */
+void writeRemoteWriteRequest(AsyncClient *client);
+#endif
 }
 
 #endif /* SRC_PROMETHEUS_H_ */
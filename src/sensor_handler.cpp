@@ -10,6 +10,7 @@
 
 #include "config.h"
 #include "sensor_handler.h"
+#include "memory.h"
 #include <fallback_log.h>
 #if SENSOR_TYPE == SENSOR_TYPE_DHT
 #include "sensors/DHTHandler.h"
@@ -19,6 +20,9 @@
 #ifdef ESP8266
 #include <fallback_timer.h>
 #endif
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+#include <sys/time.h>
+#endif
 
 namespace sensors {
 
@@ -29,50 +33,70 @@ SensorHandler::SensorHandler(const uint16_t min_interval) :
 SensorHandler::~SensorHandler() {
 }
 
+void SensorHandler::loop() {
+}
+
+Measurement SensorHandler::getMeasurement() {
+	return _measurement.read();
+}
+
+float SensorHandler::getTemperature() {
+	return utils::centiToFloat(getMeasurement().temperature);
+}
+
+float SensorHandler::getLastTemperature() {
+	return utils::centiToFloat(getMeasurement().last_valid_temperature);
+}
+
 const std::string SensorHandler::getTemperatureString() {
-	return utils::float_to_string(getTemperature(), 2);
+	return utils::centi_to_string(getMeasurement().temperature, 2);
 }
 
 const std::string SensorHandler::getLastTemperatureString() {
-	return utils::float_to_string(getLastTemperature(), 2);
+	return utils::centi_to_string(getMeasurement().last_valid_temperature, 2);
+}
+
+float SensorHandler::getHumidity() {
+	return utils::centiToFloat(getMeasurement().humidity);
+}
+
+float SensorHandler::getLastHumidity() {
+	return utils::centiToFloat(getMeasurement().last_valid_humidity);
 }
 
 const std::string SensorHandler::getHumidityString() {
-	return utils::float_to_string(getHumidity(), 2);
+	return utils::centi_to_string(getMeasurement().humidity, 2);
 }
 
 const std::string SensorHandler::getLastHumidityString() {
-	return utils::float_to_string(getLastHumidity(), 2);
+	return utils::centi_to_string(getMeasurement().last_valid_humidity, 2);
 }
 
-int64_t SensorHandler::getTimeSinceMeasurement() {
+int64_t SensorHandler::getTimeSince(const int64_t time) {
 	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
-	if (_last_finished_request == -1) {
+	if (time == -1) {
 		return -1;
-	} else if (_last_finished_request < 0) {
-		log_d("Invalid time of last measurement: %lldms.", _last_finished_request);
+	} else if (time < 0) {
+		log_d("Invalid system time: %lldms.", time);
 		return -1;
-	} else if ((uint64_t) _last_finished_request > now) {
-		log_d("Invalid time since last measurement: %lldms.", now - _last_finished_request);
+	} else if ((uint64_t) time > now) {
+		log_d("Invalid time since system time: %lldms.", now - time);
 		return -1;
 	}
 
-	return now - _last_finished_request;
+	return now - time;
+}
+
+int64_t SensorHandler::getTimeSinceMeasurement() {
+	return getTimeSince(getMeasurement().finished_time);
 }
 
 int64_t SensorHandler::getTimeSinceValidMeasurement() {
-	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
-	if (_last_valid_request == -1) {
-		return -1;
-	} else if (_last_valid_request < 0) {
-		log_d("Invalid time of last valid measurement: %lldms.", _last_valid_request);
-		return -1;
-	} else if ((uint64_t) _last_valid_request > now) {
-		log_d("Invalid time since last valid measurement: %lldms.", now - _last_valid_request);
-		return -1;
-	}
+	return getTimeSince(getMeasurement().valid_time);
+}
 
-	return now - _last_valid_request;
+int64_t SensorHandler::getTimeSinceRequest() {
+	return getTimeSince(getMeasurement().request_time);
 }
 
 const std::string SensorHandler::getTimeSinceMeasurementString() {
@@ -87,6 +111,143 @@ uint16_t SensorHandler::getMinInterval() const {
 	return MIN_INTERVAL;
 }
 
+prom::CounterFamily measurements_total(PROMETHEUS_NAMESPACE,
+		"sensor_measurements_total", "",
+		"The total number of finished sensor measurements by result.", {
+				"result" }, 2);
+prom::Counter &valid_measurements = measurements_total.get( { "valid" });
+prom::Counter &invalid_measurements = measurements_total.get( { "invalid" });
+
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+/**
+ * The earliest wall clock time considered valid, in seconds since the unix epoch.
+ * Times before this mean the clock wasn't synchronized yet.
+ */
+static constexpr time_t MIN_VALID_TIME = 1700000000;
+
+/**
+ * Converts a system time to the matching wall clock time.
+ *
+ * @param system_time	The system time in milliseconds.
+ * @return	The wall clock time in milliseconds since the unix epoch, or zero if the clock isn't synchronized.
+ */
+static uint64_t getWallClockTime(const int64_t system_time) {
+	timeval now;
+	gettimeofday(&now, NULL);
+	if (now.tv_sec < MIN_VALID_TIME) {
+		return 0;
+	}
+
+	const uint64_t system_now = (uint64_t) esp_timer_get_time() / 1000;
+	return (uint64_t) now.tv_sec * 1000 + now.tv_usec / 1000
+			- (system_now - system_time);
+}
+
+/**
+ * The metric containing the temperature measurement history.
+ */
+static prom::BackfillGaugeFamily temperature(PROMETHEUS_NAMESPACE,
+		"external_temperature", "celsius",
+		"The measured external temperature in degrees celsius.",
+		MEASUREMENT_BACKFILL_SIZE);
+
+/**
+ * The metric containing the relative humidity measurement history.
+ */
+static prom::BackfillGaugeFamily humidity(PROMETHEUS_NAMESPACE,
+		"external_humidity", "percent",
+		"The measured external relative humidity in percent.",
+		MEASUREMENT_BACKFILL_SIZE);
+
+uint32_t getMeasurementSequence() {
+	return temperature.getNewest();
+}
+
+void acknowledgeMeasurements(const uint8_t consumer,
+		const uint32_t sequence) {
+	temperature.acknowledge(sequence, consumer);
+	humidity.acknowledge(sequence, consumer);
+}
+
+uint32_t getAcknowledgedMeasurement(const uint8_t consumer) {
+	return temperature.getAcknowledged(consumer);
+}
+
+void resetMeasurementConsumer(const uint8_t consumer) {
+	temperature.resetConsumer(consumer);
+	humidity.resetConsumer(consumer);
+}
+#else
+/**
+ * The metric containing the current temperature.
+ */
+static prom::ValueFamily temperature(PROMETHEUS_NAMESPACE,
+		"external_temperature", "celsius",
+		"The current measured external temperature in degrees celsius.",
+		"gauge", []() {
+			return (double) SENSOR_HANDLER.getTemperature();
+		});
+
+/**
+ * The metric containing the current relative humidity.
+ */
+static prom::ValueFamily humidity(PROMETHEUS_NAMESPACE, "external_humidity",
+		"percent", "The current measured external relative humidity in percent.",
+		"gauge", []() {
+			return (double) SENSOR_HANDLER.getHumidity();
+		});
+#endif
+
+void SensorHandler::startMeasurement(const int64_t time) {
+	Measurement measurement = _measurement.read();
+	measurement.request_time = time;
+	_measurement.write(measurement);
+}
+
+bool SensorHandler::finishMeasurement(const int32_t temperature,
+		const int32_t humidity) {
+	Measurement measurement = _measurement.read();
+	measurement.temperature = temperature;
+	measurement.humidity = humidity;
+	measurement.finished_time = measurement.request_time;
+	measurement.generation++;
+	measurement.valid = (!supportsTemperature()
+			|| temperature != utils::FIXED_UNKNOWN)
+			&& (!supportsHumidity() || humidity != utils::FIXED_UNKNOWN);
+	if (measurement.valid) {
+		measurement.last_valid_temperature = temperature;
+		measurement.last_valid_humidity = humidity;
+		measurement.valid_time = measurement.finished_time;
+	}
+	_measurement.write(measurement);
+
+	if (measurement.valid) {
+		valid_measurements.inc();
+	} else {
+		invalid_measurements.inc();
+	}
+
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+	// Both histories always contain the same measurements, so they share sequence numbers.
+	const uint64_t timestamp = getWallClockTime(measurement.finished_time);
+	sensors::temperature.record(timestamp, utils::centiToFloat(temperature));
+	sensors::humidity.record(timestamp, utils::centiToFloat(humidity));
+#endif
+
+	return measurement.valid;
+}
+
+void registerMetrics(prom::Registry &registry) {
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+	// The histories are never freed, so they are only counted once.
+	mem::allocated(mem::SENSORS,
+			temperature.getHistorySize() + humidity.getHistorySize());
+#endif
+	registry.add(temperature);
+	registry.add(humidity);
+	registry.add(measurements_total);
+}
+
 #if SENSOR_TYPE == SENSOR_TYPE_DHT
 DHTHandler dht_handler(SENSOR_PIN, DHT_TYPE);
 SensorHandler &SENSOR_HANDLER = dht_handler;
@@ -11,39 +11,116 @@
 #ifndef SRC_SENSOR_HANDLER_H_
 #define SRC_SENSOR_HANDLER_H_
 
+#include <prometheus_registry.h>
+#include <seqlock.h>
+#include <utils.h>
 #include <string>
 
 namespace sensors {
 
 /**
- * An abstract base class for the classes handling a specific type of sensor.
+ * An immutable snapshot of the measurement state of a sensor.
  *
- * Supports getting the measurements as a float or a string.
+ * All values in a snapshot belong to the same measurement, so they can be used together safely.
+ * Measured values are stored as fixed point numbers, so they can be converted and formatted without floating point math.
  */
-class SensorHandler {
-protected:
+struct Measurement {
 	/**
-	 * The minimum time between two measurements in milliseconds.
-	 * Depends on the selected resolution.
+	 * The temperature from the last finished measurement, in hundredths of a degree celsius.
+	 * FIXED_UNKNOWN if the last measurement failed, or no measurement finished yet.
 	 */
-	const uint16_t MIN_INTERVAL;
+	int32_t temperature = utils::FIXED_UNKNOWN;
+
+	/**
+	 * The relative humidity from the last finished measurement, in hundredths of a percent.
+	 * FIXED_UNKNOWN if the last measurement failed, or no measurement finished yet.
+	 */
+	int32_t humidity = utils::FIXED_UNKNOWN;
+
+	/**
+	 * The temperature from the last successful measurement, in hundredths of a degree celsius.
+	 * FIXED_UNKNOWN if no measurement succeeded yet.
+	 */
+	int32_t last_valid_temperature = utils::FIXED_UNKNOWN;
+
+	/**
+	 * The relative humidity from the last successful measurement, in hundredths of a percent.
+	 * FIXED_UNKNOWN if no measurement succeeded yet.
+	 */
+	int32_t last_valid_humidity = utils::FIXED_UNKNOWN;
 
 	/**
 	 * The system time of the last measurement request in milliseconds.
 	 * This request may or may not be finished yet.
+	 * -1 if there was no request yet.
 	 */
-	volatile int64_t _last_request = -1;
+	int64_t request_time = -1;
 
 	/**
 	 * The system time of the last finished measurement request in milliseconds.
-	 * This require may or may not have been successful.
+	 * This request may or may not have been successful.
+	 * -1 if no measurement finished yet.
 	 */
-	volatile int64_t _last_finished_request = -1;
+	int64_t finished_time = -1;
 
 	/**
 	 * The system time of the last successful measurement request in milliseconds.
+	 * -1 if no measurement succeeded yet.
+	 */
+	int64_t valid_time = -1;
+
+	/**
+	 * The number of finished measurements, including failed ones.
+	 */
+	uint32_t generation = 0;
+
+	/**
+	 * Whether the last finished measurement was successful and returned valid values.
+	 */
+	bool valid = false;
+};
+
+/**
+ * An abstract base class for the classes handling a specific type of sensor.
+ *
+ * Supports getting the measurements as a float or a string.
+ */
+class SensorHandler {
+private:
+	/**
+	 * The current measurement snapshot.
+	 * Only written by the implementation, which has to make sure it never writes it concurrently.
+	 */
+	utils::SeqLock<Measurement> _measurement;
+
+protected:
+	/**
+	 * The minimum time between two measurements in milliseconds.
+	 * Depends on the selected resolution.
+	 */
+	const uint16_t MIN_INTERVAL;
+
+	/**
+	 * Publishes the time of a new measurement request.
+	 * Has to be called by the implementation for each measurement request.
+	 *
+	 * @param time	The system time of the request in milliseconds.
+	 */
+	void startMeasurement(const int64_t time);
+
+	/**
+	 * Publishes the result of the last measurement request, and tracks whether it was valid.
+	 * Has to be called once by the implementation for each finished measurement.
+	 *
+	 * A measurement is considered valid if all the values supported by the sensor are valid.
+	 *
+	 * @param temperature	The measured temperature in hundredths of a degree celsius,
+	 * 						or FIXED_UNKNOWN if it couldn't be measured.
+	 * @param humidity		The measured relative humidity in hundredths of a percent,
+	 * 						or FIXED_UNKNOWN if it couldn't be measured.
+	 * @return	Whether the measurement was valid.
 	 */
-	volatile int64_t _last_valid_request = -1;
+	bool finishMeasurement(const int32_t temperature, const int32_t humidity);
 public:
 	/**
 	 * Creates a new SensorHandler and initializes the minimum interval to be used.
@@ -78,6 +155,24 @@ public:
 	 */
 	virtual bool requestMeasurement() = 0;
 
+	/**
+	 * Does everything that should be done every loop iteration, like reading finished measurements.
+	 * Has to be called from the loop task only, since it may block while communicating with the sensor.
+	 * Does nothing by default.
+	 */
+	virtual void loop();
+
+	/**
+	 * Gets a consistent snapshot of the last measurement and its timestamps.
+	 *
+	 * Never blocks, so it can safely be used from any task.
+	 * Use this instead of separate getters if multiple values are needed together,
+	 * since those might be from different measurements.
+	 *
+	 * @return	The current measurement snapshot.
+	 */
+	virtual Measurement getMeasurement();
+
 	/**
 	 * Checks whether this sensor supports measuring the ambient temperature.
 	 *
@@ -94,7 +189,7 @@ public:
 	 *
 	 * @return	The last measured temperature.
 	 */
-	virtual float getTemperature() = 0;
+	virtual float getTemperature();
 
 	/**
 	 * Returns the last valid temperature measurement.
@@ -104,7 +199,7 @@ public:
 	 *
 	 * @return	The last valid measured temperature.
 	 */
-	virtual float getLastTemperature() = 0;
+	virtual float getLastTemperature();
 
 	/**
 	 * Gets the string representation of the last temperature measurement from the sensor.
@@ -147,7 +242,7 @@ public:
 	 *
 	 * @return	The last measured relative humidity.
 	 */
-	virtual float getHumidity() = 0;
+	virtual float getHumidity();
 
 	/**
 	 * Returns the last valid humidity measurement.
@@ -157,7 +252,7 @@ public:
 	 *
 	 * @return	The last valid measured relative humidity.
 	 */
-	virtual float getLastHumidity() = 0;
+	virtual float getLastHumidity();
 
 	/**
 	 * Gets the string representation of the last humidity measurement from the sensor.
@@ -208,6 +303,18 @@ public:
 	 */
 	virtual int64_t getTimeSinceValidMeasurement();
 
+	/**
+	 * Returns the time in ms since the last measurement was requested.
+	 *
+	 * This includes measurements that are not finished yet.
+	 * The next measurement can't be finished earlier than the min interval after this request.
+	 *
+	 * Returns -1 if there was no measurement request yet.
+	 *
+	 * @return	The time since the last measurement request.
+	 */
+	virtual int64_t getTimeSinceRequest();
+
 	/**
 	 * Returns the string representation of the time in ms since the last finished measurement was requested.
 	 *
@@ -234,6 +341,17 @@ public:
 	 */
 	virtual const std::string getTimeSinceValidMeasurementString();
 
+	/**
+	 * Calculates the time since the given system time.
+	 * Can be used to get the age of the timestamps in a measurement snapshot.
+	 *
+	 * Returns -1 if the time is -1, negative, or in the future.
+	 *
+	 * @param time	The system time in milliseconds.
+	 * @return	The time in ms since the given time.
+	 */
+	static int64_t getTimeSince(const int64_t time);
+
 	/**
 	 * Gets the minimum time between two measurements with this sensor.
 	 * In milliseconds.
@@ -245,6 +363,62 @@ public:
 
 extern SensorHandler &SENSOR_HANDLER;
 
+/**
+ * The metric counting the finished measurements, by whether they were valid.
+ */
+extern prom::CounterFamily measurements_total;
+
+/**
+ * The counter for measurements that returned a valid value.
+ */
+extern prom::Counter &valid_measurements;
+
+/**
+ * The counter for measurements that failed, or returned an invalid value.
+ */
+extern prom::Counter &invalid_measurements;
+
+#if ENABLE_MEASUREMENT_TIMESTAMPS == 1
+/**
+ * Gets the sequence number of the newest measurement in the measurement history.
+ *
+ * @return	The sequence number of the newest measurement.
+ */
+uint32_t getMeasurementSequence();
+
+/**
+ * Marks all measurements up to the given sequence number as received by the given consumer,
+ * so they aren't written for it again.
+ *
+ * @param consumer	The consumer that received the measurements. One of prom::MetricsConsumer.
+ * @param sequence	The sequence number of the newest received measurement.
+ */
+void acknowledgeMeasurements(const uint8_t consumer,
+		const uint32_t sequence);
+
+/**
+ * Gets the sequence number of the newest measurement acknowledged by the given consumer.
+ *
+ * @param consumer	The consumer to get the acknowledged measurement for.
+ * @return	The sequence number of the newest acknowledged measurement, or zero if there is none.
+ */
+uint32_t getAcknowledgedMeasurement(const uint8_t consumer);
+
+/**
+ * Forgets which measurements the given consumer acknowledged, so the entire history is written for it again.
+ *
+ * @param consumer	The consumer to reset.
+ */
+void resetMeasurementConsumer(const uint8_t consumer);
+#endif
+
+/**
+ * Registers the sensor metrics in the given registry.
+ *
+ * @param registry	The registry to add the metrics to.
+ */
+void registerMetrics(prom::Registry &registry);
+
 }
 
 #endif /* SRC_SENSOR_HANDLER_H_ */
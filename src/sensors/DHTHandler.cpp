@@ -9,6 +9,7 @@
  */
 
 #include "sensors/DHTHandler.h"
+#include "tracing.h"
 #include <fallback_log.h>
 #ifdef ESP8266
 #include <fallback_timer.h>
@@ -30,25 +31,21 @@ bool DHTHandler::begin() {
 }
 
 bool DHTHandler::requestMeasurement() {
+	TRACE_SPAN("sensors::requestMeasurement");
 	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
-	if (_last_request == -1 || now - (uint64_t) _last_request >= MIN_INTERVAL) {
-		_last_request = now;
+	const int64_t last_request = getMeasurement().request_time;
+	if (last_request == -1 || now - (uint64_t) last_request >= MIN_INTERVAL) {
+		startMeasurement(now);
 		if (!_dht.read(false)) {
-			_temperature = _humidity = NAN;
+			finishMeasurement(utils::FIXED_UNKNOWN, utils::FIXED_UNKNOWN);
 			log_w("Failed to read data from dht.");
 			return false;
 		}
 
-		_temperature = _dht.readTemperature(false);
-		_humidity = _dht.readHumidity(false);
-		_last_finished_request = _last_request;
-
 		// Measurements are considered to be either entirely valid, or entirely invalid.
-		if (!std::isnan(_temperature) && !std::isnan(_humidity)) {
-			_last_valid_temperature = _temperature;
-			_last_valid_humidity = _humidity;
-			_last_valid_request = _last_finished_request;
-		} else {
+		// The DHT library only returns floats, so they are converted right away.
+		if (!finishMeasurement(utils::floatToCenti(_dht.readTemperature(false)),
+				utils::floatToCenti(_dht.readHumidity(false)))) {
 			log_i("Read partially invalid data from dht.");
 		}
 
@@ -56,7 +53,7 @@ bool DHTHandler::requestMeasurement() {
 	} else {
 		log_i("Attempted to read sensor data before minimum delay.");
 		log_d("Min delay: %hums, Time since measurement: %llums",
-				MIN_INTERVAL, (now - (uint64_t) _last_request));
+				MIN_INTERVAL, (now - (uint64_t) last_request));
 		return false;
 	}
 }
@@ -65,24 +62,8 @@ bool DHTHandler::supportsTemperature() const {
 	return true;
 }
 
-float DHTHandler::getTemperature() {
-	return _temperature;
-}
-
-float DHTHandler::getLastTemperature() {
-	return _last_valid_temperature;
-}
-
 bool DHTHandler::supportsHumidity() const {
 	return true;
 }
 
-float DHTHandler::getHumidity() {
-	return _humidity;
-}
-
-float DHTHandler::getLastHumidity() {
-	return _last_valid_humidity;
-}
-
 } /* namespace sensors */
@@ -29,30 +29,6 @@ protected:
 	 * The internal driver used to interact with the sensor.
 	 */
 	DHT _dht;
-
-	/**
-	 * The last measured temperature.
-	 * NAN if the last measurement failed, or no measurement took place yet.
-	 */
-	volatile float _temperature = NAN;
-
-	/**
-	 * The temperature from the last successful measurement.
-	 * NAN if no measurement succeeded yet.
-	 */
-	volatile float _last_valid_temperature = NAN;
-
-	/**
-	 * The last measured relative humidity.
-	 * NAN if the last measurement failed, or no measurement took place yet.
-	 */
-	volatile float _humidity = NAN;
-
-	/**
-	 * The relative humidity from the last successful measurement.
-	 * NAN if no measurement succeeded yet.
-	 */
-	volatile float _last_valid_humidity = NAN;
 public:
 	/**
 	 * Creates a new DHTHandler with the given pin and DHT Type.
@@ -70,11 +46,7 @@ public:
 	virtual bool begin() override;
 	virtual bool requestMeasurement() override;
 	virtual bool supportsTemperature() const override;
-	virtual float getTemperature() override;
-	virtual float getLastTemperature() override;
 	virtual bool supportsHumidity() const override;
-	virtual float getHumidity() override;
-	virtual float getLastHumidity() override;
 };
 
 }
@@ -9,6 +9,7 @@
  */
 
 #include "sensors/DallasHandler.h"
+#include "tracing.h"
 #include <fallback_log.h>
 #ifdef ESP8266
 #include <fallback_timer.h>
@@ -43,15 +44,25 @@ bool DallasHandler::begin() {
 }
 
 bool DallasHandler::requestMeasurement() {
-	uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
-	if (_last_request == -1 || now - (uint64_t) _last_request >= MIN_INTERVAL) {
+	TRACE_SPAN("sensors::requestMeasurement");
+	if (_updating.test_and_set(std::memory_order_acquire)) {
+		log_d("Another task is currently accessing the DS18 sensor.");
+		return false;
+	}
+
+	const bool requested = requestConversion();
+	_updating.clear(std::memory_order_release);
+	return requested;
+}
+
+bool DallasHandler::requestConversion() {
+	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
+	const int64_t last_request = SensorHandler::getMeasurement().request_time;
+	if (last_request == -1 || now - (uint64_t) last_request >= MIN_INTERVAL) {
 		// Read previous measurements, if they weren't read yet.
-		if (_last_request > _last_finished_request) {
-			getTemperature();
-			now = (uint64_t) esp_timer_get_time() / 1000;
-		}
+		finishConversion();
+		startMeasurement((uint64_t) esp_timer_get_time() / 1000);
 
-		_last_request = now;
 		DeviceAddress address;
 		if (!_sensors.getAddress(address, SENSOR_INDEX)) {
 			log_w("Failed to get address for sensor %u.", SENSOR_INDEX);
@@ -70,74 +81,56 @@ bool DallasHandler::requestMeasurement() {
 	} else {
 		log_i("Attempted to read sensor data before minimum delay.");
 		log_d("Min delay: %hums, Time since measurement: %llums", MIN_INTERVAL,
-				(now - (uint64_t) _last_request));
+				(now - (uint64_t) last_request));
 		return false;
 	}
 }
 
-bool DallasHandler::supportsTemperature() const {
-	return true;
-}
-
-float DallasHandler::getTemperature() {
+void DallasHandler::finishConversion() {
+	const Measurement measurement = SensorHandler::getMeasurement();
 	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
-	if (_last_request > _last_finished_request
-			&& now - (uint64_t) _last_request >= MIN_INTERVAL) {
-		DeviceAddress address;
-		if (!_sensors.getAddress(address, SENSOR_INDEX)) {
-			log_w("Failed to get address for sensor %u.", SENSOR_INDEX);
-			_temperature = NAN;
-			_last_finished_request = _last_request;
-			return _temperature;
-		}
-
-		const int32_t temp = _sensors.getTemp(address);
-		if (temp == DEVICE_DISCONNECTED_RAW) {
-			log_d("Failed to read data from DS18 index %u.", SENSOR_INDEX);
-			_temperature = NAN;
-		} else if (temp == DEVICE_FAULT_OPEN_RAW) {
-			log_d("Failed to read data from DS18 index %u.", SENSOR_INDEX);
-			_temperature = NAN;
-		} else if (temp == DEVICE_FAULT_SHORTGND_RAW) {
-			log_d("DS18 sensor reports short to ground fault.");
-			_temperature = NAN;
-		} else if (temp == DEVICE_FAULT_SHORTVDD_RAW) {
-			log_d("DS18 sensor reports short to vdd fault.");
-			_temperature = NAN;
-		} else {
-			_temperature = DallasTemperature::rawToCelsius(temp);
-		}
+	if (measurement.request_time <= measurement.finished_time
+			|| now - (uint64_t) measurement.request_time < MIN_INTERVAL) {
+		return;
+	}
 
-		_last_finished_request = _last_request;
+	DeviceAddress address;
+	if (!_sensors.getAddress(address, SENSOR_INDEX)) {
+		log_w("Failed to get address for sensor %u.", SENSOR_INDEX);
+		finishMeasurement(utils::FIXED_UNKNOWN, utils::FIXED_UNKNOWN);
+		return;
+	}
 
-		if (!std::isnan(_temperature)) {
-			_last_valid_temperature = _temperature;
-			_last_valid_request = _last_finished_request;
-		}
+	int32_t temperature = utils::FIXED_UNKNOWN;
+	const int32_t temp = _sensors.getTemp(address);
+	if (temp == DEVICE_DISCONNECTED_RAW) {
+		log_d("Failed to read data from DS18 index %u.", SENSOR_INDEX);
+	} else if (temp == DEVICE_FAULT_OPEN_RAW) {
+		log_d("Failed to read data from DS18 index %u.", SENSOR_INDEX);
+	} else if (temp == DEVICE_FAULT_SHORTGND_RAW) {
+		log_d("DS18 sensor reports short to ground fault.");
+	} else if (temp == DEVICE_FAULT_SHORTVDD_RAW) {
+		log_d("DS18 sensor reports short to vdd fault.");
+	} else {
+		temperature = utils::binaryToCenti(temp, RAW_FRACTION_BITS);
 	}
 
-	return _temperature;
+	finishMeasurement(temperature, utils::FIXED_UNKNOWN);
 }
 
-float DallasHandler::getLastTemperature() {
-	const uint64_t now = (uint64_t) esp_timer_get_time() / 1000;
-	if (_last_request > _last_finished_request
-			&& now - (uint64_t) _last_request >= MIN_INTERVAL) {
-		getTemperature();
+void DallasHandler::loop() {
+	if (!_updating.test_and_set(std::memory_order_acquire)) {
+		finishConversion();
+		_updating.clear(std::memory_order_release);
 	}
-	return _last_valid_temperature;
 }
 
-bool DallasHandler::supportsHumidity() const {
-	return false;
-}
-
-float DallasHandler::getHumidity() {
-	return NAN;
+bool DallasHandler::supportsTemperature() const {
+	return true;
 }
 
-float DallasHandler::getLastHumidity() {
-	return NAN;
+bool DallasHandler::supportsHumidity() const {
+	return false;
 }
 
 } /* namespace sensors */
@@ -13,6 +13,7 @@
 
 #include "sensor_handler.h"
 #include "DallasTemperature.h"
+#include <atomic>
 
 namespace sensors {
 
@@ -35,6 +36,12 @@ protected:
 	 */
 	static const uint8_t RESOLUTION = 12;
 
+	/**
+	 * The number of fraction bits of the raw temperatures returned by the DallasTemperature library.
+	 * The sensor measures in 1/16 °C, which the library shifts to 1/128 °C.
+	 */
+	static const uint8_t RAW_FRACTION_BITS = 7;
+
 	/**
 	 * The internal OneWire instance to use to communicate with the sensor.
 	 */
@@ -46,16 +53,24 @@ protected:
 	DallasTemperature _sensors;
 
 	/**
-	 * The last measured temperature.
-	 * NAN if the last measurement failed, or no measurement took place yet.
+	 * Whether a task is currently requesting or finishing a measurement.
+	 * Makes sure only one task at a time accesses the sensor, and writes the measurement snapshot.
+	 */
+	std::atomic_flag _updating = ATOMIC_FLAG_INIT;
+
+	/**
+	 * Requests a new conversion from the sensor, after reading the result of the previous one.
+	 * Has to be called while holding the update flag.
+	 *
+	 * @return	Whether a conversion was successfully requested.
 	 */
-	volatile float _temperature = NAN;
+	bool requestConversion();
 
 	/**
-	 * The temperature from the last successful measurement.
-	 * NAN if no measurement succeeded yet.
+	 * Reads the result of the last conversion, if it is done and wasn't read yet, and publishes it.
+	 * Has to be called while holding the update flag.
 	 */
-	volatile float _last_valid_temperature = NAN;
+	void finishConversion();
 public:
 	/**
 	 * Creates a new DallasHandler with the given sensor pin and sensor index.
@@ -72,12 +87,14 @@ public:
 
 	virtual bool begin() override;
 	virtual bool requestMeasurement() override;
+
+	/**
+	 * Reads the result of the last conversion, once it is done.
+	 * Blocks while communicating with the sensor, so it has to be called from the loop task only.
+	 */
+	virtual void loop() override;
 	virtual bool supportsTemperature() const override;
-	virtual float getTemperature() override;
-	virtual float getLastTemperature() override;
 	virtual bool supportsHumidity() const override;
-	virtual float getHumidity() override;
-	virtual float getLastHumidity() override;
 };
 
 } /* namespace sensors */
@@ -0,0 +1,60 @@
+/*
+ * tracing.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include "tracing.h"
+#if ENABLE_SPAN_TRACING == 1
+#include "memory.h"
+#ifdef ESP32
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif defined(ESP8266)
+#include <fallback_timer.h>
+#endif
+
+/**
+ * @return	The current time in microseconds since startup.
+ */
+static uint64_t getTime() {
+	return (uint64_t) esp_timer_get_time();
+}
+
+#ifdef ESP32
+/**
+ * @return	The handle of the current FreeRTOS task, as an id.
+ */
+static uint32_t getTask() {
+	return (uint32_t) (uintptr_t) xTaskGetCurrentTaskHandle();
+}
+
+trace::Tracer tracing::tracer(SPAN_TRACE_CAPACITY, getTime, getTask);
+#else
+trace::Tracer tracing::tracer(SPAN_TRACE_CAPACITY, getTime);
+#endif
+#endif
+
+void tracing::setup() {
+#if ENABLE_SPAN_TRACING == 1
+	web::registerRequestHandler("/debug/trace", HTTP_GET, handleTrace);
+#endif
+}
+
+#if ENABLE_SPAN_TRACING == 1
+web::ResponseData tracing::handleTrace(AsyncWebServerRequest *request) {
+	std::shared_ptr<trace::TraceWriter> writer = mem::make_shared<
+			trace::TraceWriter>(mem::WEB, tracer);
+	AsyncWebServerResponse *response = request->beginChunkedResponse(
+			"application/json",
+			[writer](uint8_t *buffer, const size_t max_len, const size_t index) {
+				return writer->read(buffer, max_len);
+			});
+	response->addHeader("Cache-Control", web::CACHE_CONTROL_NOCACHE);
+	return web::ResponseData(response, 0, 200);
+}
+#endif
@@ -0,0 +1,70 @@
+/*
+ * tracing.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#ifndef SRC_TRACING_H_
+#define SRC_TRACING_H_
+
+#include "config.h"
+#if ENABLE_SPAN_TRACING == 1
+#include "webhandler.h"
+#include <span_tracer.h>
+
+/**
+ * Creates the variable name of a span from the line it is created in.
+ */
+#define TRACE_SPAN_VARIABLE(line) trace_span_ ## line
+
+/**
+ * Expands the line macro before creating the variable name of a span.
+ */
+#define TRACE_SPAN_NAME(line) TRACE_SPAN_VARIABLE(line)
+
+/**
+ * Records a span from this line to the end of the current scope.
+ *
+ * @param name	The name of the span. Has to be a string literal.
+ */
+#define TRACE_SPAN(name) trace::Span TRACE_SPAN_NAME(__LINE__)(tracing::tracer, name)
+#else
+/**
+ * Does nothing, since span tracing is disabled.
+ */
+#define TRACE_SPAN(name)
+#endif
+
+/**
+ * This header, and the source file with the same name, contain the span tracer and its web endpoint.
+ */
+namespace tracing {
+#if ENABLE_SPAN_TRACING == 1
+/**
+ * The tracer recording the spans of this program.
+ */
+extern trace::Tracer tracer;
+#endif
+
+/**
+ * Initializes the span tracing, and registers the /debug/trace endpoint.
+ */
+void setup();
+
+#if ENABLE_SPAN_TRACING == 1
+/**
+ * The request handler for /debug/trace.
+ * Streams the recorded spans as Chrome trace event JSON, which can be opened using Perfetto.
+ *
+ * @param request	The request to handle.
+ * @return	The response to send.
+ */
+web::ResponseData handleTrace(AsyncWebServerRequest *request);
+#endif
+}
+
+#endif /* SRC_TRACING_H_ */
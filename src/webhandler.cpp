@@ -10,19 +10,21 @@
 
 #include "webhandler.h"
 #if ENABLE_WEB_SERVER == 1
-#if ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1 || ENABLE_PROMETHEUS_PUSH == 1
-#include "prometheus.h"
-#endif
 #include "sensor_handler.h"
 #include "generated/web_file_hashes.h"
+#include "generated/web_bundle.h"
 #include "AsyncHeadOnlyResponse.h"
+#include "AsyncFlashResponse.h"
+#include "HttpRequestStats.h"
+#include "memory.h"
+#include "tracing.h"
 #ifdef ESP32
 #include <ESPmDNS.h>
 #elif defined(ESP8266)
 #include <ESP8266mDNS.h>
 #endif
 #include <fallback_log.h>
-#if ENABLE_TIMINGS_API == 1 && defined(ESP8266)
+#ifdef ESP8266
 #include <fallback_timer.h>
 #endif
 #endif /* ENABLE_WEB_SERVER == 1 */
@@ -30,6 +32,16 @@
 #if ENABLE_WEB_SERVER == 1
 AsyncWebServer web::server(WEB_SERVER_PORT);
 std::map<String, web::AsyncTrackingFallbackWebHandler*> web::handlers;
+web::SingleFlight<std::map<String, String>> web::index_renders(
+		SINGLE_FLIGHT_MAX_AGE);
+web::SingleFlight<web::GzipTemplateData> web::index_bundle_renders(
+		SINGLE_FLIGHT_MAX_AGE);
+uint8_t web::StateBuffer::_buffers[STATE_BUFFER_COUNT][STATE_MAX_LEN];
+uint8_t web::StateBuffer::_references[STATE_BUFFER_COUNT] = { };
+prom::HistogramFamily web::http_handler_duration(PROMETHEUS_NAMESPACE,
+		"http_handler_duration", "seconds",
+		"The time spent creating HTTP responses in seconds.", { 100, 500, 1000,
+				5000, 10000, 50000, 100000, 500000 }, 1000000);
 
 web::ResponseData::ResponseData(AsyncWebServerResponse *response,
 		size_t content_len, uint16_t status_code) :
@@ -37,6 +49,38 @@ web::ResponseData::ResponseData(AsyncWebServerResponse *response,
 				status_code) {
 
 }
+
+size_t web::StateBuffer::findUnused() {
+	size_t index = 0;
+	while (index < STATE_BUFFER_COUNT && _references[index] > 0) {
+		index++;
+	}
+	return index;
+}
+
+web::StateBuffer::StateBuffer() :
+		_index(findUnused()) {
+	if (_index < STATE_BUFFER_COUNT) {
+		_references[_index]++;
+	}
+}
+
+web::StateBuffer::StateBuffer(const StateBuffer &other) :
+		_index(other._index) {
+	if (_index < STATE_BUFFER_COUNT) {
+		_references[_index]++;
+	}
+}
+
+web::StateBuffer::~StateBuffer() {
+	if (_index < STATE_BUFFER_COUNT) {
+		_references[_index]--;
+	}
+}
+
+uint8_t* web::StateBuffer::get() const {
+	return _index < STATE_BUFFER_COUNT ? _buffers[_index] : NULL;
+}
 #endif
 
 void web::setup() {
@@ -50,8 +94,9 @@ void web::setup() {
 			&sensors::SENSOR_HANDLER) } };
 
 	registerRedirect("/", "/index.html");
-	registerReplacingStaticHandler("/index.html", "text/html", INDEX_HTML_START,
-			INDEX_HTML_END - 1, index_replacements);
+	registerRequestHandler("/index.html", HTTP_GET,
+			std::bind(indexHandler, index_replacements,
+					std::placeholders::_1));
 
 	registerCompressedStaticHandler("/main.css", "text/css", MAIN_CSS_START,
 			MAIN_CSS_END, MAIN_CSS_GZ_HASH);
@@ -66,7 +111,7 @@ void web::setup() {
 						sensors::SENSOR_HANDLER.getTemperatureString();
 				AsyncWebServerResponse *response = request->beginResponse(200,
 						"text/plain", temp.c_str());
-				response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+				addMeasurementCacheHeaders(response);
 				return ResponseData(response, temp.length(), 200);
 			});
 
@@ -76,7 +121,7 @@ void web::setup() {
 						sensors::SENSOR_HANDLER.getHumidityString();
 				AsyncWebServerResponse *response = request->beginResponse(200,
 						"text/plain", humidity.c_str());
-				response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+				addMeasurementCacheHeaders(response);
 				return ResponseData(response, humidity.length(), 200);
 			});
 
@@ -120,6 +165,7 @@ void web::setup() {
 #endif
 
 	registerRequestHandler("/data.json", HTTP_GET, getJson);
+	registerRequestHandler("/api/state", HTTP_GET, getState);
 
 	registerCompressedStaticHandler("/favicon.ico", "image/x-icon",
 			FAVICON_ICO_GZ_START, FAVICON_ICO_GZ_END, FAVICON_ICO_GZ_HASH);
@@ -135,6 +181,11 @@ void web::setup() {
 
 	server.onNotFound(notFoundHandler);
 
+	prom::default_registry.add(http_requests_total);
+	prom::default_registry.add(http_handler_duration);
+	AsyncFlashResponse::registerMetrics(prom::default_registry);
+	SingleFlightBase::registerMetrics(prom::default_registry);
+
 	DefaultHeaders::Instance().addHeader("Server", SERVER_HEADER);
 	DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
 	server.begin();
@@ -188,51 +239,278 @@ bool web::csvHeaderContains(const char *header, const char *value) {
 }
 
 web::ResponseData web::getJson(AsyncWebServerRequest *request) {
-	// TODO format time from int64_t using snprintf
-	const std::string time_string =
-			sensors::SENSOR_HANDLER.getTimeSinceValidMeasurementString();
+	// All values have to be from the same measurement.
+	const sensors::Measurement measurement =
+			sensors::SENSOR_HANDLER.getMeasurement();
+	char time_string[utils::TIMESPAN_CHARS_BUFFER_SIZE];
+	const size_t time_len = utils::timespan_to_chars(time_string,
+			sizeof(time_string),
+			sensors::SensorHandler::getTimeSince(measurement.valid_time));
 	// Valid values will never be longer than "Unknown".
-	const size_t max_len = 62 + time_string.length();
+	const size_t max_len = 62 + time_len;
 	char *buffer = new char[max_len + 1];
 	buffer[0] = 0;
 
 	strcpy(buffer, "{\"temperature\": ");
 	size_t len = 16;
-	const float temperature = sensors::SENSOR_HANDLER.getLastTemperature();
-	if (std::isnan(temperature)) {
+	const int32_t temperature = measurement.last_valid_temperature;
+	if (temperature == utils::FIXED_UNKNOWN) {
 		strcpy(buffer + len, "\"Unknown\"");
 		len += 9;
 	} else {
-		len += snprintf(buffer + len, max_len - len, "%.2f", temperature);
+		len += utils::centi_to_chars(buffer + len, max_len - len, temperature,
+				2, false);
 	}
 
 	strcpy(buffer + len, ", \"humidity\": ");
 	len += 14;
-	const float humidity = sensors::SENSOR_HANDLER.getLastHumidity();
-	if (std::isnan(humidity)) {
+	const int32_t humidity = measurement.last_valid_humidity;
+	if (humidity == utils::FIXED_UNKNOWN) {
 		strcpy(buffer + len, "\"Unknown\"");
 		len += 9;
 	} else {
-		len += snprintf(buffer + len, max_len - len, "%.2f", humidity);
+		len += utils::centi_to_chars(buffer + len, max_len - len, humidity, 2,
+				false);
 	}
 	len += snprintf(buffer + len, max_len - len, ", \"time\": \"%s\"}",
-			time_string.c_str());
+			time_string);
 
 	AsyncWebServerResponse *response = request->beginResponse(200,
 			"application/json", buffer);
 	delete[] buffer;
-	response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+	addMeasurementCacheHeaders(response);
+	return ResponseData(response, len, 200);
+}
+
+web::ResponseData web::getState(AsyncWebServerRequest *request) {
+	uint8_t fields = STATE_ALL_FIELDS;
+	if (request->hasParam("fields")) {
+		fields = parseStateFields(request->getParam("fields")->value().c_str());
+	}
+
+	StateFormat format = STATE_FORMAT_JSON;
+	const char *content_type = "application/json";
+	if (request->hasParam("format")) {
+		const String &format_str = request->getParam("format")->value();
+		if (format_str == "csv") {
+			format = STATE_FORMAT_CSV;
+			content_type = "text/csv";
+		} else if (format_str == "binary") {
+			format = STATE_FORMAT_BINARY;
+			content_type = "application/octet-stream";
+		} else if (format_str != "json") {
+			fields = 0;
+		}
+	}
+
+	if (fields == 0) {
+		const char *error = "Unknown or empty field list, or unknown format.";
+		AsyncWebServerResponse *response = request->beginResponse(400,
+				"text/plain", error);
+		response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+		return ResponseData(response, strlen(error), 400);
+	}
+
+	using namespace std::placeholders;
+	AsyncWebServerResponse *response = NULL;
+	size_t len = 0;
+	const StateBuffer state_buffer;
+	if (state_buffer.get()) {
+		len = serializeState(fields, format, state_buffer.get(), STATE_MAX_LEN);
+		response = request->beginResponse(content_type, len,
+				std::bind(stateResponseFiller, state_buffer, len, _1, _2, _3));
+	} else {
+		// All preallocated buffers are still used by responses that weren't sent yet.
+		std::shared_ptr<uint8_t> buffer = mem::make_shared_buffer(mem::WEB,
+				STATE_MAX_LEN);
+		len = serializeState(fields, format, buffer.get(), STATE_MAX_LEN);
+		response = request->beginResponse(content_type, len,
+				std::bind(bufferResponseFiller, buffer, len, _1, _2, _3));
+	}
+	// The time since something changes continuously, so it can't be cached.
+	if (fields
+			& (STATE_SINCE_MEASUREMENT | STATE_SINCE_VALID | STATE_SINCE_STARTUP)) {
+		response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+	} else {
+		addMeasurementCacheHeaders(response);
+	}
 	return ResponseData(response, len, 200);
 }
 
+uint8_t web::parseStateFields(const char *fields) {
+	uint8_t mask = 0;
+	const char *start = fields;
+	while (*start) {
+		const char *end = strchr(start, ',');
+		const size_t len = end ? (size_t) (end - start) : strlen(start);
+		size_t i = 0;
+		while (i < STATE_FIELD_COUNT
+				&& (strlen(STATE_FIELD_NAMES[i]) != len
+						|| strncmp(start, STATE_FIELD_NAMES[i], len) != 0)) {
+			i++;
+		}
+
+		if (i == STATE_FIELD_COUNT) {
+			log_d("Unknown state field in \"%s\".", fields);
+			return 0;
+		}
+
+		mask |= 1 << i;
+		if (!end) {
+			break;
+		}
+		start = end + 1;
+	}
+	return mask;
+}
+
+size_t web::serializeState(const uint8_t fields, const StateFormat format,
+		uint8_t *buffer, const size_t max_len) {
+	const sensors::Measurement measurement =
+			sensors::SENSOR_HANDLER.getMeasurement();
+	const int32_t fixed[] = { measurement.last_valid_temperature,
+			measurement.last_valid_humidity };
+	const int64_t ints[] = { sensors::SensorHandler::getTimeSince(
+			measurement.finished_time), sensors::SensorHandler::getTimeSince(
+			measurement.valid_time), esp_timer_get_time() / 1000 };
+	const size_t fixed_count = sizeof(fixed) / sizeof(fixed[0]);
+	char *out = (char*) buffer;
+	size_t len = 0;
+
+	if (format == STATE_FORMAT_BINARY) {
+		buffer[len++] = fields;
+		for (size_t i = 0; i < STATE_FIELD_COUNT; i++) {
+			if (!(fields & (1 << i))) {
+				continue;
+			}
+
+			uint64_t value;
+			size_t size = 8;
+			if (i < fixed_count) {
+				// The binary format contains floats, so it doesn't depend on the internal representation.
+				const float float_value = utils::centiToFloat(fixed[i]);
+				uint32_t bits;
+				memcpy(&bits, &float_value, 4);
+				value = bits;
+				size = 4;
+			} else {
+				value = (uint64_t) ints[i - fixed_count];
+			}
+
+			for (size_t j = 0; j < size && len < max_len; j++) {
+				buffer[len++] = (value >> (j * 8)) & 0xFF;
+			}
+		}
+		return len;
+	}
+
+	if (format == STATE_FORMAT_CSV) {
+		for (size_t i = 0; i < STATE_FIELD_COUNT; i++) {
+			if (fields & (1 << i)) {
+				len += snprintf(out + len, max_len - len, "%s%s",
+						len > 0 ? "," : "", STATE_FIELD_NAMES[i]);
+			}
+		}
+		len += snprintf(out + len, max_len - len, "\n");
+	} else {
+		len += snprintf(out + len, max_len - len, "{");
+	}
+
+	bool first = true;
+	for (size_t i = 0; i < STATE_FIELD_COUNT && len < max_len; i++) {
+		if (!(fields & (1 << i))) {
+			continue;
+		}
+
+		if (!first) {
+			len += snprintf(out + len, max_len - len, ",");
+		}
+		first = false;
+
+		if (format == STATE_FORMAT_JSON) {
+			len += snprintf(out + len, max_len - len, "\"%s\":",
+					STATE_FIELD_NAMES[i]);
+		}
+
+		const char *unknown = format == STATE_FORMAT_JSON ? "null" : "";
+		if (i < fixed_count) {
+			if (fixed[i] == utils::FIXED_UNKNOWN) {
+				len += snprintf(out + len, max_len - len, "%s", unknown);
+			} else if (len < max_len) {
+				len += utils::centi_to_chars(out + len, max_len - len, fixed[i],
+						2, false);
+			}
+		} else {
+			const int64_t value = ints[i - fixed_count];
+			if (value < 0) {
+				len += snprintf(out + len, max_len - len, "%s", unknown);
+			} else {
+				len += snprintf(out + len, max_len - len, "%lld",
+						(long long int) value);
+			}
+		}
+	}
+
+	len += snprintf(out + len, max_len - len,
+			format == STATE_FORMAT_JSON ? "}" : "\n");
+	return min(len, max_len - 1);
+}
+
+size_t web::stateResponseFiller(const StateBuffer &data, const size_t len,
+		uint8_t *buffer, const size_t max_len, const size_t index) {
+	const size_t count = min(len - index, max_len);
+	memcpy(buffer, data.get() + index, count);
+	return count;
+}
+
+size_t web::bufferResponseFiller(const std::shared_ptr<uint8_t> data,
+		const size_t len, uint8_t *buffer, const size_t max_len,
+		const size_t index) {
+	const size_t count = min(len - index, max_len);
+	memcpy(buffer, data.get() + index, count);
+	return count;
+}
+
+void web::addMeasurementCacheHeaders(AsyncWebServerResponse *response) {
+	const int64_t since_request = sensors::SENSOR_HANDLER.getTimeSinceRequest();
+	const uint16_t interval = sensors::SENSOR_HANDLER.getMinInterval();
+	if (since_request < 0 || since_request >= interval
+			|| (interval - since_request) / 1000 == 0) {
+		response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+		return;
+	}
+
+	// Round the remaining time down, so the response never gets cached for too long.
+	const uint16_t remaining = (interval - since_request) / 1000;
+	const uint16_t max_age = interval / 1000;
+	// "public, max-age=" + 5 digits + null byte.
+	char buffer[30];
+	snprintf(buffer, 30, "public, max-age=%u", max_age);
+	response->addHeader("Cache-Control", buffer);
+	snprintf(buffer, 30, "%u", max_age - remaining);
+	response->addHeader("Age", buffer);
+
+	const time_t now = time(NULL);
+	if (now >= MIN_VALID_TIME) {
+		struct tm tm;
+		strftime(buffer, 30, "%a, %d %b %Y %H:%M:%S GMT", gmtime_r(&now, &tm));
+		response->addHeader("Date", buffer);
+		const time_t expires = now + remaining;
+		strftime(buffer, 30, "%a, %d %b %Y %H:%M:%S GMT",
+				gmtime_r(&expires, &tm));
+		response->addHeader("Expires", buffer);
+	}
+}
+
 size_t web::decompressingResponseFiller(
 		const std::shared_ptr<gzip::uzlib_ungzip_wrapper> decomp,
 		uint8_t *buffer, const size_t max_len, const size_t index) {
+	TRACE_SPAN("gzip::decompress");
 	return decomp->decompress(buffer, max_len);
 }
 
 size_t web::replacingResponseFiller(
-		const std::map<String, String> &replacements,
+		const std::shared_ptr<const std::map<String, String>> replacements,
 		std::shared_ptr<int64_t> offset, const uint8_t *start,
 		const uint8_t *end, uint8_t *buffer, const size_t max_len,
 		const size_t index) {
@@ -266,9 +544,9 @@ size_t web::replacingResponseFiller(
 			memcpy(buf, template_start + 1, template_end - template_start - 1);
 			buf[template_end - template_start - 1] = 0;
 			String replacement = String((char*) buf);
-			std::map<String, String>::const_iterator it = replacements.find(
+			std::map<String, String>::const_iterator it = replacements->find(
 					replacement);
-			if (it != replacements.end()) {
+			if (it != replacements->end()) {
 				replacement = it->second;
 			}
 			if (replacement.length() > max_len - written) {
@@ -296,6 +574,28 @@ size_t web::replacingResponseFiller(
 	}
 }
 
+size_t web::gzipTemplateResponseFiller(
+		const std::shared_ptr<GzipTemplateData> data, uint8_t *buffer,
+		const size_t max_len, const size_t index) {
+	size_t skip = index;
+	size_t written = 0;
+	for (const std::pair<const uint8_t*, size_t> &block : data->blocks) {
+		if (skip >= block.second) {
+			skip -= block.second;
+			continue;
+		}
+
+		const size_t len = min(block.second - skip, max_len - written);
+		memcpy(buffer + written, block.first + skip, len);
+		written += len;
+		skip = 0;
+		if (written >= max_len) {
+			break;
+		}
+	}
+	return written;
+}
+
 size_t web::dummyResponseFiller(const uint8_t *buffer, const size_t max_len,
 		const size_t index) {
 	return 0;
@@ -316,18 +616,18 @@ void web::notFoundHandler(AsyncWebServerRequest *request) {
 			"The requested file can not be found on this server!" }, {
 			"DETAILS", "The page <code>" + request->url()
 					+ "</code> couldn't be found." } };
-	ResponseData response = replacingRequestHandler(replacements, 404,
+	ResponseData response = replacingRequestHandler(
+			std::make_shared<const std::map<String, String>>(replacements), 404,
 			"text/html", (uint8_t*) ERROR_HTML_START,
 			(uint8_t*) ERROR_HTML_END - 1, request);
 	if (request->method() == HTTP_HEAD) {
 		response.response = new AsyncHeadOnlyResponse(response.response,
 				response.status_code);
 	}
-#if ENABLE_PROMETHEUS_PUSH == 1 || ENABLE_PROMETHEUS_SCRAPE_SUPPORT == 1
-	prom::http_requests_total[request->url()][ {
-			(WebRequestMethod) request->method(), response.status_code }]++;
-#endif
+	http_requests_total.track(HttpRequestStats::OTHER_ROUTE, request->method(),
+			response.status_code);
 	const size_t mid = micros();
+	http_handler_duration.get().observe(mid - start);
 	request->send(response.response);
 	const size_t end = micros();
 	log_i("A client tried to access the not existing file \"%s\".",
@@ -383,7 +683,9 @@ web::ResponseData web::invalidMethodHandler(
 				+ request->url() + "</code> can handle the request methods "
 				+ validStr + "." } };
 
-		ResponseData response = replacingRequestHandler(replacements, 405,
+		ResponseData response = replacingRequestHandler(
+				std::make_shared<const std::map<String, String>>(replacements),
+				405,
 				"text/html", (uint8_t*) ERROR_HTML_START,
 				(uint8_t*) ERROR_HTML_END - 1, request);
 		if (request->method() == HTTP_HEAD) {
@@ -458,8 +760,13 @@ web::ResponseData web::staticHandler(const uint16_t status_code,
 		response = request->beginResponse(content_type, content_length,
 				dummyResponseFiller);
 	} else {
-		response = request->beginResponse_P(code, content_type, start,
+#if ENABLE_FLASH_RESPONSES == 1
+		response = new AsyncFlashResponse(code, content_type, start,
+				content_length);
+#else
+		response = new AsyncProgmemBaselineResponse(code, content_type, start,
 				content_length);
+#endif
 	}
 
 	response->setCode(code);
@@ -523,13 +830,18 @@ web::ResponseData web::compressedStaticHandler(const uint16_t status_code,
 		}
 	} else if (accepts_gzip) {
 		content_length = end - start;
-		response = request->beginResponse_P(code, content_type, start,
+#if ENABLE_FLASH_RESPONSES == 1
+		response = new AsyncFlashResponse(code, content_type, start,
+				content_length);
+#else
+		response = new AsyncProgmemBaselineResponse(code, content_type, start,
 				content_length);
+#endif
 		response->addHeader("Content-Encoding", "gzip");
 	} else {
 		using namespace std::placeholders;
-		std::shared_ptr<gzip::uzlib_ungzip_wrapper> decomp = std::make_shared<
-				gzip::uzlib_ungzip_wrapper>(start, end,
+		std::shared_ptr<gzip::uzlib_ungzip_wrapper> decomp = mem::make_shared<
+				gzip::uzlib_ungzip_wrapper>(mem::GZIP, start, end,
 				GZIP_DECOMP_WINDOW_SIZE);
 		content_length = max(0, decomp->getDecompressedSize());
 		if (content_length == 0) {
@@ -566,9 +878,10 @@ web::ResponseData web::replacingRequestHandler(
 		const uint16_t status_code, const String &content_type,
 		const uint8_t *start, const uint8_t *end,
 		AsyncWebServerRequest *request) {
-	std::map<String, String> repl;
+	std::shared_ptr<std::map<String, String>> repl = mem::make_shared<
+			std::map<String, String>>(mem::WEB);
 	for (std::pair<String, std::function<std::string()>> replacement : replacements) {
-		repl[replacement.first] = replacement.second().c_str();
+		(*repl)[replacement.first] = replacement.second().c_str();
 	}
 
 	return replacingRequestHandler(repl, status_code, content_type, start, end,
@@ -576,8 +889,9 @@ web::ResponseData web::replacingRequestHandler(
 }
 
 web::ResponseData web::replacingRequestHandler(
-		const std::map<String, String> replacements, const uint16_t status_code,
-		const String &content_type, const uint8_t *start, const uint8_t *end,
+		const std::shared_ptr<const std::map<String, String>> replacements,
+		const uint16_t status_code, const String &content_type,
+		const uint8_t *start, const uint8_t *end,
 		AsyncWebServerRequest *request) {
 	using namespace std::placeholders;
 	int64_t len_diff = 0;
@@ -591,8 +905,8 @@ web::ResponseData web::replacingRequestHandler(
 		uint8_t *buf = new uint8_t[template_end - idx];
 		memcpy(buf, idx + 1, template_end - idx - 1);
 		buf[template_end - idx - 1] = 0;
-		if (replacements.find(String((char*) buf)) != replacements.end()) {
-			len_diff += replacements.at(String((char*) buf)).length()
+		if (replacements->find(String((char*) buf)) != replacements->end()) {
+			len_diff += replacements->at(String((char*) buf)).length()
 					- (template_end - idx + 1);
 		} else {
 			len_diff -= 2;
@@ -619,6 +933,148 @@ web::ResponseData web::replacingRequestHandler(
 	return ResponseData(response, content_length, status_code);
 }
 
+std::shared_ptr<web::GzipTemplateData> web::renderGzipTemplate(
+		const std::map<String, std::function<std::string()>> &replacements,
+		const uint8_t *start, const GzipTemplateSegment *segments,
+		const size_t segment_count) {
+	// The max length of a single uncompressed deflate block.
+	const size_t MAX_BLOCK_LEN = 65535;
+
+	std::vector<std::string> values;
+	values.reserve(segment_count);
+	// Start with the length of the gzip trailer.
+	size_t dynamic_len = 8;
+	for (size_t i = 0; i + 1 < segment_count; i++) {
+		std::map<String, std::function<std::string()>>::const_iterator it =
+				replacements.find(segments[i].name);
+		if (it == replacements.end()) {
+			log_e("Unknown gzip template replacement \"%s\".",
+					segments[i].name);
+			return nullptr;
+		}
+		values.push_back(it->second());
+		dynamic_len += values[i].length()
+				+ (values[i].length() + MAX_BLOCK_LEN - 1) / MAX_BLOCK_LEN * 5;
+	}
+
+	std::shared_ptr<GzipTemplateData> data = mem::make_shared<
+			GzipTemplateData>(mem::WEB);
+	data->blocks.reserve(segment_count * 2);
+	// Reserve the entire length, so pointers into the buffer stay valid.
+	data->dynamic.reserve(dynamic_len);
+	uint32_t crc = 0;
+	uint32_t size = 0;
+	size_t segment_start = 0;
+	for (size_t i = 0; i < segment_count; i++) {
+		data->blocks.push_back(
+				std::make_pair(start + segment_start,
+						segments[i].end - segment_start));
+		data->content_length += segments[i].end - segment_start;
+		segment_start = segments[i].end;
+		crc = gzip::crc32_combine(crc, segments[i].crc, segments[i].size);
+		size += segments[i].size;
+
+		if (i + 1 >= segment_count || values[i].empty()) {
+			continue;
+		}
+
+		const std::string &value = values[i];
+		const size_t offset = data->dynamic.length();
+		for (size_t pos = 0; pos < value.length(); pos += MAX_BLOCK_LEN) {
+			const uint16_t len = min(value.length() - pos, MAX_BLOCK_LEN);
+			// A non-final uncompressed block, followed by its length and the ones complement of its length.
+			data->dynamic.push_back(0);
+			data->dynamic.push_back(len & 0xFF);
+			data->dynamic.push_back(len >> 8);
+			data->dynamic.push_back(~len & 0xFF);
+			data->dynamic.push_back((~len >> 8) & 0xFF);
+			data->dynamic.append(value, pos, len);
+		}
+		crc = ~uzlib_crc32(value.c_str(), value.length(), ~crc);
+		size += value.length();
+		data->blocks.push_back(
+				std::make_pair((uint8_t*) data->dynamic.c_str() + offset,
+						data->dynamic.length() - offset));
+		data->content_length += data->dynamic.length() - offset;
+	}
+
+	const size_t offset = data->dynamic.length();
+	for (size_t i = 0; i < 4; i++) {
+		data->dynamic.push_back((crc >> (i * 8)) & 0xFF);
+	}
+	for (size_t i = 0; i < 4; i++) {
+		data->dynamic.push_back((size >> (i * 8)) & 0xFF);
+	}
+	data->blocks.push_back(
+			std::make_pair((uint8_t*) data->dynamic.c_str() + offset, 8));
+	data->content_length += 8;
+	data->allocation.resize(
+			data->blocks.capacity() * sizeof(data->blocks[0])
+					+ data->dynamic.capacity());
+	return data;
+}
+
+web::ResponseData web::gzipTemplateRequestHandler(
+		const std::shared_ptr<GzipTemplateData> data,
+		const uint16_t status_code, const String &content_type,
+		AsyncWebServerRequest *request) {
+	using namespace std::placeholders;
+	AsyncWebServerResponse *response = request->beginResponse(content_type,
+			data->content_length,
+			std::bind(gzipTemplateResponseFiller, data, _1, _2, _3));
+	response->setCode(status_code);
+	response->addHeader("Content-Encoding", "gzip");
+	response->addHeader("Vary", "Accept-Encoding");
+	response->addHeader("Cache-Control", CACHE_CONTROL_NOCACHE);
+	return ResponseData(response, data->content_length, status_code);
+}
+
+web::ResponseData web::indexHandler(
+		const std::map<String, std::function<std::string()>> &replacements,
+		AsyncWebServerRequest *request) {
+#if ENABLE_INLINE_WEB_BUNDLE == 1
+	if (request->hasHeader("Accept-Encoding")
+			&& csvHeaderContains(request->header("Accept-Encoding").c_str(),
+					"gzip")) {
+		const std::shared_ptr<GzipTemplateData> data =
+				index_bundle_renders.get("/index.html",
+						std::bind(renderGzipTemplate, std::cref(replacements),
+								INDEX_HTML_GZT_START, INDEX_HTML_GZT_SEGMENTS,
+								INDEX_HTML_GZT_SEGMENT_COUNT));
+		// Fall back to the page with separate stylesheet and script if the bundle can't be rendered.
+		if (data) {
+			ResponseData response = gzipTemplateRequestHandler(data, 200,
+					"text/html", request);
+#if ENABLE_CONTENT_SECURITY_POLICY == 1
+			response.response->addHeader("Content-Security-Policy",
+					INDEX_HTML_GZT_CSP);
+#endif
+			response.response->addHeader("Link", INDEX_BUNDLE_PRELOAD_LINKS);
+			return response;
+		}
+	}
+#endif
+
+	const std::shared_ptr<std::map<String, String>> values =
+			index_renders.get("/index.html",
+					[&replacements]() -> std::shared_ptr<std::map<String, String>> {
+						std::shared_ptr<std::map<String, String>> values =
+								mem::make_shared<std::map<String, String>>(mem::WEB);
+						for (const std::pair<String, std::function<std::string()>> &replacement : replacements) {
+							(*values)[replacement.first] =
+									replacement.second().c_str();
+						}
+						return values;
+					});
+	ResponseData response = replacingRequestHandler(values, 200, "text/html",
+			INDEX_HTML_START, INDEX_HTML_END - 1, request);
+#if ENABLE_INLINE_WEB_BUNDLE == 1
+	response.response->addHeader("Vary", "Accept-Encoding");
+#endif
+	response.response->addHeader("Link", INDEX_PRELOAD_LINKS);
+	return response;
+}
+
 web::ResponseData web::redirectHandler(const char *target,
 		AsyncWebServerRequest *request) {
 	const uint16_t status_code = 307;
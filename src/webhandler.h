@@ -38,8 +38,13 @@ typedef std::function<
 }
 
 #include "AsyncTrackingFallbackWebHandler.h"
+#include "SingleFlight.h"
+#include "memory.h"
 #include <uzlib_gzip_wrapper.h>
+#include <prometheus_registry.h>
 #include <map>
+#include <vector>
+#include <ctime>
 
 /**
  * A pointer to the first byte of the templated main page of the web interface.
@@ -51,6 +56,19 @@ extern const uint8_t INDEX_HTML_START[] asm("_binary_data_index_html_start");
  */
 extern const uint8_t INDEX_HTML_END[] asm("_binary_data_index_html_end");
 
+#if ENABLE_INLINE_WEB_BUNDLE == 1
+/**
+ * A pointer to the first byte of the gzip template of the main page with inlined stylesheet and script.
+ * Only embedded into the firmware if the inlined main page bundle is enabled.
+ */
+extern const uint8_t INDEX_HTML_GZT_START[] asm("_binary_data_gzip_index_html_gzt_start");
+
+/**
+ * A pointer to the first byte after the gzip template of the main page with inlined stylesheet and script.
+ */
+extern const uint8_t INDEX_HTML_GZT_END[] asm("_binary_data_gzip_index_html_gzt_end");
+#endif
+
 /**
  * A pointer to the first byte of the gzip compressed main css stylesheet.
  */
@@ -156,6 +174,167 @@ public:
 			const uint16_t status_code);
 };
 
+/**
+ * A single segment of a gzip template file, as generated by compress_web.py.
+ *
+ * A gzip template is a gzip file split into independently compressed segments, without the gzip trailer.
+ * Each segment except the last is followed by a template string, that is replaced when sending the file.
+ */
+struct GzipTemplateSegment {
+	/**
+	 * The offset of the first byte after this segment in the gzip template file.
+	 */
+	size_t end;
+
+	/**
+	 * The uncompressed size of this segment in bytes.
+	 */
+	uint32_t size;
+
+	/**
+	 * The crc32 checksum of the uncompressed segment.
+	 */
+	uint32_t crc;
+
+	/**
+	 * The name of the template string following this segment.
+	 * NULL for the last segment.
+	 */
+	const char *name;
+};
+
+/**
+ * The data required to send a gzip template with its templates replaced.
+ */
+struct GzipTemplateData {
+	/**
+	 * The blocks of data to send, in order.
+	 * Each is a pointer to the first byte of the block, and its length.
+	 */
+	std::vector<std::pair<const uint8_t*, size_t>> blocks;
+
+	/**
+	 * The buffer containing the uncompressed blocks with the template replacements, and the gzip trailer.
+	 */
+	std::string dynamic;
+
+	/**
+	 * The total number of bytes in all blocks.
+	 */
+	size_t content_length = 0;
+
+	/**
+	 * The memory used by the blocks and the dynamic buffer, counted for the web server.
+	 */
+	mem::Allocation allocation { mem::WEB };
+};
+
+/**
+ * The values that can be requested from the state api.
+ * Each value is a bit in the field mask of a state request.
+ */
+enum StateField : uint8_t {
+	STATE_TEMPERATURE = 1,
+	STATE_HUMIDITY = 2,
+	STATE_SINCE_MEASUREMENT = 4,
+	STATE_SINCE_VALID = 8,
+	STATE_SINCE_STARTUP = 16
+};
+
+/**
+ * The output formats supported by the state api.
+ */
+enum StateFormat : uint8_t {
+	STATE_FORMAT_JSON, STATE_FORMAT_CSV, STATE_FORMAT_BINARY
+};
+
+/**
+ * The names of the state api fields, in the order of their bits in the field mask.
+ */
+static constexpr const char *STATE_FIELD_NAMES[] = { "temperature", "humidity",
+		"since_measurement_ms", "since_valid_ms", "since_startup_ms" };
+
+/**
+ * The number of fields supported by the state api.
+ */
+static constexpr size_t STATE_FIELD_COUNT = sizeof(STATE_FIELD_NAMES)
+		/ sizeof(STATE_FIELD_NAMES[0]);
+
+/**
+ * The field mask containing all the fields supported by the state api.
+ */
+static constexpr uint8_t STATE_ALL_FIELDS = (1 << STATE_FIELD_COUNT) - 1;
+
+/**
+ * The max length of a serialized state api response, in any format.
+ * The longest is a json object with all fields, with 20 characters per value.
+ */
+static constexpr size_t STATE_MAX_LEN = 2 + STATE_FIELD_COUNT * 45;
+
+/**
+ * The number of preallocated buffers for state api responses.
+ * Responses created while all of them are in use get a heap allocated buffer instead.
+ */
+static constexpr size_t STATE_BUFFER_COUNT = 2;
+
+/**
+ * A reference to one of the preallocated buffers for state api responses.
+ * A buffer is in use until the last reference to it is destroyed.
+ *
+ * This class is **NOT** thread safe, and should only be used from the web server task.
+ */
+class StateBuffer {
+private:
+	/**
+	 * The preallocated buffers.
+	 */
+	static uint8_t _buffers[STATE_BUFFER_COUNT][STATE_MAX_LEN];
+
+	/**
+	 * The number of references to each of the buffers.
+	 */
+	static uint8_t _references[STATE_BUFFER_COUNT];
+
+	/**
+	 * The index of the referenced buffer.
+	 * STATE_BUFFER_COUNT if all buffers were in use when this reference was created.
+	 */
+	const size_t _index;
+
+	/**
+	 * Finds a buffer without any references.
+	 *
+	 * @return	The index of the unused buffer, or STATE_BUFFER_COUNT if all are in use.
+	 */
+	static size_t findUnused();
+public:
+	/**
+	 * Creates a reference to a buffer that isn't in use.
+	 */
+	StateBuffer();
+
+	/**
+	 * Creates another reference to the same buffer.
+	 *
+	 * @param other	The reference to copy.
+	 */
+	StateBuffer(const StateBuffer &other);
+
+	/**
+	 * Destroys this reference, marking the buffer unused if it was the last one.
+	 */
+	~StateBuffer();
+
+	StateBuffer& operator=(const StateBuffer &other) = delete;
+
+	/**
+	 * Gets the referenced buffer, which is STATE_MAX_LEN bytes long.
+	 *
+	 * @return	The buffer, or NULL if all buffers were in use.
+	 */
+	uint8_t* get() const;
+};
+
 /**
  * The Cache-Control header value to send for pages that should not be cached.
  */
@@ -166,6 +345,12 @@ static constexpr char CACHE_CONTROL_NOCACHE[] = "no-store";
  */
 static constexpr char CACHE_CONTROL_CACHE[] = "public, no-cache";
 
+/**
+ * The earliest unix time that is considered a valid wall clock time.
+ * Used to check whether the system time was set, before sending headers containing dates.
+ */
+static constexpr time_t MIN_VALID_TIME = 1700000000;
+
 #if ENABLE_CONTENT_SECURITY_POLICY == 1
 /**
  * The Content-Security-Policy to send with html responses.
@@ -173,6 +358,20 @@ static constexpr char CACHE_CONTROL_CACHE[] = "public, no-cache";
 static constexpr char CSP_VALUE[] = "default-src 'self'";
 #endif
 
+/**
+ * The Link header value to send with the main page, to make the browser preload its resources.
+ */
+static constexpr char INDEX_PRELOAD_LINKS[] =
+		"</main.css>; rel=preload; as=style, </index.js>; rel=preload; as=script, </favicon.svg>; rel=preload; as=image";
+
+#if ENABLE_INLINE_WEB_BUNDLE == 1
+/**
+ * The Link header value to send with the inlined main page bundle, to make the browser preload the resources that aren't inlined.
+ */
+static constexpr char INDEX_BUNDLE_PRELOAD_LINKS[] =
+		"</favicon.svg>; rel=preload; as=image";
+#endif
+
 /**
  * The character to use as a template delimiter.
  */
@@ -187,6 +386,23 @@ extern AsyncWebServer server;
  * A map containing the registered request handler for each uri.
  */
 extern std::map<String, AsyncTrackingFallbackWebHandler*> handlers;
+
+/**
+ * The single flight helper sharing the template replacements of the main page between concurrent requests.
+ */
+extern SingleFlight<std::map<String, String>> index_renders;
+
+/**
+ * The single flight helper sharing the inlined main page bundle between concurrent requests.
+ */
+extern SingleFlight<GzipTemplateData> index_bundle_renders;
+
+/**
+ * The histogram of the time spent creating HTTP responses.
+ * Observed in microseconds, and exported in seconds.
+ * Doesn't include the time spent sending them.
+ */
+extern prom::HistogramFamily http_handler_duration;
 #else /* ENABLE_WEB_SERVER == 1 */
 namespace web {
 #endif
@@ -233,6 +449,92 @@ bool csvHeaderContains(const char *header, const char *value);
  */
 ResponseData getJson(AsyncWebServerRequest *request);
 
+/**
+ * Adds the caching headers for a response containing the current measurements.
+ *
+ * Allows caching the response until the next measurement could be available.
+ * For this the max-age is set to the min interval between measurements,
+ * and the Age header is set to the time since the last measurement request.
+ * If the system time is valid, an Expires header is added as well.
+ *
+ * Forbids caching if the next measurement could arrive in less than a second.
+ *
+ * @param response	The response to add the headers to.
+ */
+void addMeasurementCacheHeaders(AsyncWebServerResponse *response);
+
+/**
+ * The request handler for /api/state.
+ * Responds with the requested subset of the current measurements and timings.
+ *
+ * The fields to send can be selected using the comma separated "fields" parameter.
+ * If it is missing, all fields are sent.
+ * The format can be selected using the "format" parameter, which can be "json", "csv", or "binary".
+ * The default format is json.
+ *
+ * Responds with a 400 Bad Request, if a field or the format is unknown.
+ *
+ * @param request	The web request to handle.
+ * @return	The response to be sent to the client.
+ */
+ResponseData getState(AsyncWebServerRequest *request);
+
+/**
+ * Parses a comma separated list of state api field names to a field mask.
+ *
+ * @param fields	The field list to parse.
+ * @return	The field mask, or 0 if the list is empty or contains an unknown field.
+ */
+uint8_t parseStateFields(const char *fields);
+
+/**
+ * Writes the current values of the given fields to the given buffer.
+ *
+ * Temperature and humidity are the last valid measurements, in degrees celsius and percent.
+ * Timings are raw integers in milliseconds.
+ * In json unknown values are null, in csv they are empty.
+ *
+ * The binary format starts with a single byte containing the field mask.
+ * It is followed by the selected fields, in the order of their bits in the field mask.
+ * Temperature and humidity are little endian 32 bit floats, NAN if unknown.
+ * Timings are little endian signed 64 bit integers, -1 if unknown.
+ *
+ * @param fields	The field mask of the fields to write.
+ * @param format	The format to write the values in.
+ * @param buffer	The buffer to write to. Should be at least STATE_MAX_LEN bytes.
+ * @param max_len	The size of the buffer.
+ * @return	The number of bytes written to the buffer.
+ */
+size_t serializeState(const uint8_t fields, const StateFormat format,
+		uint8_t *buffer, const size_t max_len);
+
+/**
+ * An AwsResponseFiller copying a preallocated state buffer to the response.
+ *
+ * @param data		The buffer to send.
+ * @param len		The number of bytes in the buffer.
+ * @param buffer	The output buffer to write to.
+ * @param max_len	The max number of bytes to write to the output buffer.
+ * @param index		The number of bytes already written by this method.
+ * @return	The number of bytes written to the output buffer.
+ */
+size_t stateResponseFiller(const StateBuffer &data, const size_t len,
+		uint8_t *buffer, const size_t max_len, const size_t index);
+
+/**
+ * An AwsResponseFiller copying a buffer to the response.
+ *
+ * @param data		The buffer to send.
+ * @param len		The number of bytes in the buffer.
+ * @param buffer	The output buffer to write to.
+ * @param max_len	The max number of bytes to write to the output buffer.
+ * @param index		The number of bytes already written by this method.
+ * @return	The number of bytes written to the output buffer.
+ */
+size_t bufferResponseFiller(const std::shared_ptr<uint8_t> data,
+		const size_t len, uint8_t *buffer, const size_t max_len,
+		const size_t index);
+
 /**
  * An AwsResponseFiller decompressing a file from memory using uzlib.
  *
@@ -261,11 +563,24 @@ size_t decompressingResponseFiller(
  * @param index			The number of bytes already created by this method.
  * @return	The number of bytes written to the output buffer.
  */
-size_t replacingResponseFiller(const std::map<String, String> &replacements,
+size_t replacingResponseFiller(
+		const std::shared_ptr<const std::map<String, String>> replacements,
 		std::shared_ptr<int64_t> offset, const uint8_t *start,
 		const uint8_t *end, uint8_t *buffer, const size_t max_len,
 		const size_t index);
 
+/**
+ * An AwsResponseFiller copying the blocks of a gzip template response to the output buffer.
+ *
+ * @param data		The blocks of the response to send.
+ * @param buffer	The output buffer to write to.
+ * @param max_len	The max number of bytes to write to the output buffer.
+ * @param index		The number of bytes already created by this method.
+ * @return	The number of bytes written to the output buffer.
+ */
+size_t gzipTemplateResponseFiller(const std::shared_ptr<GzipTemplateData> data,
+		uint8_t *buffer, const size_t max_len, const size_t index);
+
 /**
  * An AwsResponseFiller doing absolutely nothing, used to avoid sending the content length of 0.
  *
@@ -399,7 +714,7 @@ ResponseData replacingRequestHandler(
  * This request handler automatically adds a Cache-Control header forbidding caching, since the page is dynamic.
  *
  * @param replacements	A map mapping a template string to be replaced,
- * 						to its replacement string.
+ * 						to its replacement string. Kept alive until the response is sent.
  * @param status_code	The HTTP response status code to send to the client.
  * @param content_type	The content type of the file to send.
  * @param start			A pointer to the first byte of the static file.
@@ -409,8 +724,65 @@ ResponseData replacingRequestHandler(
  * @return	The response to be sent to the client.
  */
 ResponseData replacingRequestHandler(
-		const std::map<String, String> replacements, const uint16_t status_code,
-		const String &content_type, const uint8_t *start, const uint8_t *end,
+		const std::shared_ptr<const std::map<String, String>> replacements,
+		const uint16_t status_code, const String &content_type,
+		const uint8_t *start, const uint8_t *end,
+		AsyncWebServerRequest *request);
+
+/**
+ * Creates the data required to send a gzip template generated by compress_web.py.
+ *
+ * Inserts the template replacements as uncompressed deflate blocks between the compressed segments.
+ * The gzip checksum is calculated from the precalculated segment checksums and the replacements.
+ *
+ * @param replacements	A map mapping a template string to be replaced,
+ * 						to a function returning its replacement value.
+ * @param start			A pointer to the first byte of the gzip template.
+ * @param segments		The segment table of the gzip template.
+ * @param segment_count	The number of segments in the segment table.
+ * @return	The blocks to send for the gzip template, or an empty pointer if it contains an unknown replacement.
+ */
+std::shared_ptr<GzipTemplateData> renderGzipTemplate(
+		const std::map<String, std::function<std::string()>> &replacements,
+		const uint8_t *start, const GzipTemplateSegment *segments,
+		const size_t segment_count);
+
+/**
+ * A web request handler for a rendered gzip template.
+ *
+ * The client has to accept gzip compressed responses, since the template can't be decompressed on the fly.
+ *
+ * Does not add a Content-Security-Policy, since templates with inlined scripts require their own.
+ * This request handler automatically adds a Cache-Control header forbidding caching, since the page is dynamic.
+ *
+ * @param data			The rendered gzip template to send.
+ * @param status_code	The HTTP response status code to send to the client.
+ * @param content_type	The content type of the uncompressed file.
+ * @param request		The request to handle.
+ * @return	The response to be sent to the client.
+ */
+ResponseData gzipTemplateRequestHandler(
+		const std::shared_ptr<GzipTemplateData> data,
+		const uint16_t status_code, const String &content_type,
+		AsyncWebServerRequest *request);
+
+/**
+ * The request handler for the main page.
+ *
+ * Sends the inlined main page bundle, if it is enabled and the client accepts gzip compressed responses.
+ * Otherwise sends the main page referencing the stylesheet and script.
+ *
+ * Concurrent requests share a single render of the page.
+ *
+ * Adds a Link header to make the browser preload the resources that aren't inlined.
+ *
+ * @param replacements	A map mapping a template string to be replaced,
+ * 						to a function returning its replacement value.
+ * @param request		The request to handle.
+ * @return	The response to be sent to the client.
+ */
+ResponseData indexHandler(
+		const std::map<String, std::function<std::string()>> &replacements,
 		AsyncWebServerRequest *request);
 
 /**
@@ -0,0 +1,363 @@
+/*
+ * profiler.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <alloc_profiler.h>
+#include <gzip_compressor.h>
+#include <prometheus_registry.h>
+#include <span_tracer.h>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * The size of the buffer outputs are read into, like the chunks of a HTTP response.
+ */
+const size_t CHUNK_SIZE = 512;
+
+/**
+ * Creates a fake call site address.
+ *
+ * @param index	The index of the fake call site.
+ * @return	A unique call site address.
+ */
+const void* site(const size_t index) {
+	return (const void*) (uintptr_t) (0x40080000 + index * 4);
+}
+
+/**
+ * Writes the allocation report, reading at most the given number of bytes at once.
+ *
+ * @param read_len	The max number of bytes to read from the writer at once.
+ * @return	The written report.
+ */
+std::string report(const size_t read_len = 1024) {
+	alloc::ReportWriter writer;
+	std::string output;
+	std::vector<uint8_t> buffer(read_len);
+	size_t len = 0;
+	while ((len = writer.read(buffer.data(), read_len)) > 0) {
+		output.append((const char*) buffer.data(), len);
+	}
+	TEST_ASSERT_TRUE(writer.done());
+	return output;
+}
+
+/**
+ * Resets all allocation counts.
+ */
+void setUp() {
+	alloc::reset();
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Tests counting allocations by call site.
+ */
+void test_sites() {
+	const alloc::Counts before = alloc::getTotal();
+	alloc::recordAllocation(site(0), 16);
+	alloc::recordAllocation(site(1), 100);
+	alloc::recordAllocation(site(0), 32);
+	alloc::recordAllocation(site(alloc::MAX_SITES), 8);
+	const alloc::Counts after = alloc::getTotal();
+
+	TEST_ASSERT_EQUAL_UINT32(4, after.allocations - before.allocations);
+	TEST_ASSERT_EQUAL_UINT32(156, after.bytes - before.bytes);
+	TEST_ASSERT_EQUAL_UINT32(2, alloc::getSite(site(0)).allocations);
+	TEST_ASSERT_EQUAL_UINT32(48, alloc::getSite(site(0)).bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, alloc::getSite(site(1)).allocations);
+	TEST_ASSERT_EQUAL_UINT32(100, alloc::getSite(site(1)).bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, alloc::getSite(site(alloc::MAX_SITES)).allocations);
+	TEST_ASSERT_EQUAL_UINT32(0, alloc::getSite(site(2)).allocations);
+}
+
+/**
+ * Tests attributing allocations to nested scopes.
+ */
+void test_scopes() {
+	static const char *const OUTER = "/outer";
+	static const char *const INNER = "/inner";
+	TEST_ASSERT_NULL(alloc::getCurrentScope());
+	alloc::recordAllocation(site(0), 1);
+	{
+		alloc::Scope outer(OUTER);
+		TEST_ASSERT_EQUAL_PTR(OUTER, alloc::getCurrentScope());
+		alloc::recordAllocation(site(0), 10);
+		{
+			alloc::Scope inner(INNER);
+			TEST_ASSERT_EQUAL_PTR(INNER, alloc::getCurrentScope());
+			alloc::recordAllocation(site(1), 20);
+			alloc::recordAllocation(site(1), 30);
+		}
+		TEST_ASSERT_EQUAL_PTR(OUTER, alloc::getCurrentScope());
+		alloc::recordAllocation(site(2), 40);
+	}
+	TEST_ASSERT_NULL(alloc::getCurrentScope());
+
+	TEST_ASSERT_EQUAL_UINT32(2, alloc::getScope(OUTER).allocations);
+	TEST_ASSERT_EQUAL_UINT32(50, alloc::getScope(OUTER).bytes);
+	TEST_ASSERT_EQUAL_UINT32(2, alloc::getScope(INNER).allocations);
+	TEST_ASSERT_EQUAL_UINT32(50, alloc::getScope(INNER).bytes);
+	TEST_ASSERT_EQUAL_UINT32(2, alloc::getSite(site(0)).allocations);
+}
+
+/**
+ * Tests that allocations from new call sites are only counted in the totals once the table is full.
+ */
+void test_full_table() {
+	for (size_t i = 0; i < alloc::MAX_SITES; i++) {
+		alloc::recordAllocation(site(i), i);
+	}
+	const alloc::Counts before = alloc::getTotal();
+	alloc::recordAllocation(site(alloc::MAX_SITES), 1000);
+	alloc::recordAllocation(site(5), 5);
+	const alloc::Counts after = alloc::getTotal();
+
+	TEST_ASSERT_EQUAL_UINT32(2, after.allocations - before.allocations);
+	TEST_ASSERT_EQUAL_UINT32(1005, after.bytes - before.bytes);
+	TEST_ASSERT_EQUAL_UINT32(0, alloc::getSite(site(alloc::MAX_SITES)).allocations);
+	TEST_ASSERT_EQUAL_UINT32(2, alloc::getSite(site(5)).allocations);
+	TEST_ASSERT_EQUAL_UINT32(10, alloc::getSite(site(5)).bytes);
+	TEST_ASSERT_EQUAL_UINT32(1, alloc::getSite(site(alloc::MAX_SITES - 1)).allocations);
+}
+
+/**
+ * Tests the plain text report.
+ */
+void test_report() {
+#if ENABLE_ALLOCATION_PROFILER == 1
+	TEST_IGNORE_MESSAGE("The report contains the allocations of the test itself.");
+#endif
+	{
+		alloc::Scope scope("/test");
+		alloc::recordAllocation(site(0), 12);
+	}
+	alloc::recordAllocation(site(0), 30);
+	alloc::recordFree();
+
+	char expected[256];
+	snprintf(expected, sizeof(expected),
+			"total allocations=2 bytes=42 frees=1\n"
+					"scope=/test allocations=1 bytes=12\n"
+					"site=0x%llx allocations=2 bytes=42\n",
+			(long long unsigned int) (uintptr_t) site(0));
+	TEST_ASSERT_EQUAL_STRING(expected, report().c_str());
+	TEST_ASSERT_EQUAL_STRING(expected, report(1).c_str());
+	TEST_ASSERT_EQUAL_STRING(expected, report(7).c_str());
+}
+
+/**
+ * Tests that allocations counted by multiple threads at once are never lost.
+ */
+void test_concurrent() {
+	static const char *const TAGS[] = { "0", "1", "2", "3" };
+	std::vector<std::thread> threads;
+	for (uint8_t t = 0; t < 4; t++) {
+		threads.emplace_back([t]() {
+			alloc::Scope scope(TAGS[t]);
+			for (size_t i = 0; i < 10000; i++) {
+				alloc::recordAllocation(site(i % 16), 2);
+			}
+		});
+	}
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	for (uint8_t t = 0; t < 4; t++) {
+		TEST_ASSERT_EQUAL_UINT32(10000, alloc::getScope(TAGS[t]).allocations);
+		TEST_ASSERT_EQUAL_UINT32(20000, alloc::getScope(TAGS[t]).bytes);
+	}
+	for (size_t i = 0; i < 16; i++) {
+		TEST_ASSERT_EQUAL_UINT32(2500, alloc::getSite(site(i)).allocations);
+	}
+}
+
+/**
+ * A set of metric families resembling the metrics of a thermometer.
+ */
+class ThermometerMetrics {
+public:
+	prom::ValueFamily temperature { "esptherm", "external_temperature",
+			"celsius", "The current measured external temperature in degrees celsius.",
+			"gauge", []() {
+				return 21.5;
+			} };
+	prom::ValueFamily humidity { "esptherm", "external_humidity", "percent",
+			"The current measured external relative humidity in percent.",
+			"gauge", []() {
+				return 45.25;
+			} };
+	prom::CounterFamily measurements { "esptherm", "sensor_measurements_total",
+			"", "The total number of finished sensor measurements by result.", {
+					"result" }, 2 };
+	prom::HistogramFamily duration { "esptherm", "http_handler_duration",
+			"seconds", "The time spent creating HTTP responses in seconds.", {
+					100, 500, 1000, 5000, 10000, 50000, 100000, 500000 },
+			1000000 };
+
+	/**
+	 * All the metric families of this set.
+	 */
+	std::vector<const prom::MetricFamily*> families { &temperature, &humidity,
+			&measurements, &duration };
+
+	/**
+	 * Creates the metric families, and gives them some values.
+	 */
+	ThermometerMetrics() {
+		measurements.get( { "valid" }).inc(1234);
+		measurements.get( { "invalid" }).inc(5);
+		for (uint32_t i = 0; i < 1000; i += 7) {
+			duration.get().observe(i * 300);
+		}
+	}
+};
+
+/**
+ * Reads the entire output of the given pull based writer, and discards it.
+ *
+ * @param writer	The writer to read.
+ * @return	The number of bytes written.
+ */
+template<typename W>
+size_t drain(W &writer) {
+	uint8_t buffer[CHUNK_SIZE];
+	size_t total = 0;
+	size_t len = 0;
+	while ((len = writer.read(buffer, CHUNK_SIZE)) > 0) {
+		total += len;
+	}
+	return total;
+}
+
+/**
+ * Checks that the allocations made in the given scope don't exceed the given budget.
+ *
+ * @param tag		The tag of the scope.
+ * @param budget	The max number of allocations.
+ */
+void check_budget(const char *tag, const uint32_t budget) {
+	const alloc::Counts counts = alloc::getScope(tag);
+	char message[128];
+	snprintf(message, sizeof(message), "%s: %u allocations, %u bytes.", tag,
+			(unsigned int) counts.allocations, (unsigned int) counts.bytes);
+	TEST_MESSAGE(message);
+	TEST_ASSERT_LESS_OR_EQUAL_UINT32_MESSAGE(budget, counts.allocations,
+			message);
+}
+
+/**
+ * Checks the allocation budget of a text format metrics scrape.
+ */
+void test_budget_text_scrape() {
+#if ENABLE_ALLOCATION_PROFILER == 1
+	ThermometerMetrics metrics;
+	{
+		alloc::Scope scope("text");
+		prom::ExpositionWriter writer(metrics.families, true);
+		TEST_ASSERT_GREATER_THAN_size_t(0, drain(writer));
+	}
+	check_budget("text", 0);
+#else
+	TEST_IGNORE_MESSAGE("Requires ENABLE_ALLOCATION_PROFILER.");
+#endif
+}
+
+/**
+ * Checks the allocation budget of a protobuf metrics scrape.
+ */
+void test_budget_protobuf_scrape() {
+#if ENABLE_ALLOCATION_PROFILER == 1
+	ThermometerMetrics metrics;
+	{
+		alloc::Scope scope("protobuf");
+		prom::ProtobufWriter writer(metrics.families);
+		TEST_ASSERT_GREATER_THAN_size_t(0, drain(writer));
+	}
+	check_budget("protobuf", 0);
+#else
+	TEST_IGNORE_MESSAGE("Requires ENABLE_ALLOCATION_PROFILER.");
+#endif
+}
+
+/**
+ * Checks the allocation budget of compressing the metrics for a push.
+ */
+void test_budget_compressed_push() {
+#if ENABLE_ALLOCATION_PROFILER == 1
+	ThermometerMetrics metrics;
+	{
+		alloc::Scope scope("push");
+		prom::ExpositionWriter writer(metrics.families);
+		gzip::gzip_compressor compressor(
+				[&writer](uint8_t *buffer, const size_t max_len) {
+					return writer.read(buffer, max_len);
+				});
+		TEST_ASSERT_GREATER_THAN_size_t(0, drain(compressor));
+	}
+	check_budget("push", 0);
+#else
+	TEST_IGNORE_MESSAGE("Requires ENABLE_ALLOCATION_PROFILER.");
+#endif
+}
+
+/**
+ * Checks the allocation budget of writing the recorded spans.
+ */
+void test_budget_trace() {
+#if ENABLE_ALLOCATION_PROFILER == 1
+	trace::Tracer tracer(64, []() {
+		return (uint64_t) 0;
+	});
+	for (uint64_t i = 0; i < 100; i++) {
+		tracer.record("span", i, i * 2);
+	}
+	{
+		alloc::Scope scope("trace");
+		trace::TraceWriter writer(tracer);
+		TEST_ASSERT_GREATER_THAN_size_t(0, drain(writer));
+	}
+	check_budget("trace", 0);
+#else
+	TEST_IGNORE_MESSAGE("Requires ENABLE_ALLOCATION_PROFILER.");
+#endif
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_sites);
+	RUN_TEST(test_scopes);
+	RUN_TEST(test_full_table);
+	RUN_TEST(test_report);
+	RUN_TEST(test_concurrent);
+	RUN_TEST(test_budget_text_scrape);
+	RUN_TEST(test_budget_protobuf_scrape);
+	RUN_TEST(test_budget_compressed_push);
+	RUN_TEST(test_budget_trace);
+
+	return UNITY_END();
+}
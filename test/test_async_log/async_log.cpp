@@ -0,0 +1,222 @@
+/*
+ * async_log.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <async_log.h>
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * The current time of the fake clock, in milliseconds.
+ */
+static uint32_t fake_time = 0;
+
+/**
+ * @return	The current time of the fake clock.
+ */
+uint32_t fake_clock() {
+	return fake_time;
+}
+
+/**
+ * Pops the next line from the given log.
+ *
+ * @param log		The log to pop the line from.
+ * @param max_len	The size of the buffer to format the line into.
+ * @return	The formatted line, or an empty string if the log is empty.
+ */
+std::string pop(logging::AsyncLog &log, const size_t max_len = 256) {
+	std::vector<char> buffer(max_len);
+	const size_t len = log.pop(buffer.data(), max_len);
+	TEST_ASSERT_LESS_THAN_size_t(max_len, len);
+	return std::string(buffer.data(), len);
+}
+
+/**
+ * Resets the fake clock.
+ */
+void setUp() {
+	fake_time = 0;
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Tests that formatted records match the output of snprintf.
+ */
+void test_format() {
+	logging::AsyncLog log(4, fake_clock, logging::LEVEL_VERBOSE);
+	fake_time = 1234;
+	const unsigned long long int big = 18446744073709551615ull;
+	TEST_ASSERT_TRUE(
+			log.log(logging::LEVEL_INFO, "main.cpp", 42, "loop",
+					"%d %u %5.2f %s %llu %c%%", -5, 7u, 3.14159, "text", big,
+					'c'));
+	TEST_ASSERT_TRUE(
+			log.log(logging::LEVEL_ERROR, "web.cpp", 7, "handle",
+					"Took %lluus + %luus.", 12345ull, 67ul));
+
+	char expected[256];
+	snprintf(expected, sizeof(expected),
+			"[  1234][I][main.cpp:42] loop(): %d %u %5.2f %s %llu %c%%\r\n",
+			-5, 7u, 3.14159, "text", big, 'c');
+	TEST_ASSERT_EQUAL_STRING(expected, pop(log).c_str());
+	TEST_ASSERT_EQUAL_STRING(
+			"[  1234][E][web.cpp:7] handle(): Took 12345us + 67us.\r\n",
+			pop(log).c_str());
+	TEST_ASSERT_EQUAL_STRING("", pop(log).c_str());
+}
+
+/**
+ * Tests that string arguments are copied, and don't have to live until the record is formatted.
+ */
+void test_string_copy() {
+	logging::AsyncLog log(4, fake_clock, logging::LEVEL_VERBOSE);
+	{
+		std::string url = "/api/state";
+		log.log(logging::LEVEL_DEBUG, "a.cpp", 1, "f", "Request to \"%s\".",
+				url.c_str());
+		url.assign(url.size(), 'x');
+	}
+	TEST_ASSERT_EQUAL_STRING(
+			"[     0][D][a.cpp:1] f(): Request to \"/api/state\".\r\n",
+			pop(log).c_str());
+
+	const std::string long_string(100, 'a');
+	log.log(logging::LEVEL_DEBUG, "a.cpp", 2, "f", "%s|%s", long_string.c_str(),
+			"b");
+	const std::string expected = "[     0][D][a.cpp:2] f(): "
+			+ std::string(logging::AsyncLog::MAX_STRING_LEN - 1, 'a')
+			+ "|\r\n";
+	TEST_ASSERT_EQUAL_STRING(expected.c_str(), pop(log).c_str());
+}
+
+/**
+ * Tests that missing arguments and unsupported specifiers are written as is, and long lines are truncated.
+ */
+void test_malformed() {
+	logging::AsyncLog log(4, fake_clock, logging::LEVEL_VERBOSE);
+	log.log(logging::LEVEL_WARN, "a.cpp", 3, "f", "%*d %d %s %", 5, 6);
+	TEST_ASSERT_EQUAL_STRING("[     0][W][a.cpp:3] f(): %*d 5 %s %\r\n",
+			pop(log).c_str());
+
+	log.log(logging::LEVEL_WARN, "a.cpp", 4, "f", "%s", "0123456789");
+	TEST_ASSERT_EQUAL_STRING("[     0][W][a.cpp:4] f(): 0123\r\n",
+			pop(log, 33).c_str());
+}
+
+/**
+ * Tests that messages above the current log level are skipped.
+ */
+void test_level() {
+	logging::AsyncLog log(4, fake_clock, logging::LEVEL_WARN);
+	TEST_ASSERT_FALSE(log.log(logging::LEVEL_INFO, "a.cpp", 1, "f", "info"));
+	TEST_ASSERT_TRUE(log.log(logging::LEVEL_WARN, "a.cpp", 2, "f", "warn"));
+	log.setLevel(logging::LEVEL_DEBUG);
+	TEST_ASSERT_EQUAL(logging::LEVEL_DEBUG, log.getLevel());
+	TEST_ASSERT_TRUE(log.log(logging::LEVEL_DEBUG, "a.cpp", 3, "f", "debug"));
+
+	TEST_ASSERT_EQUAL_STRING("[     0][W][a.cpp:2] f(): warn\r\n",
+			pop(log).c_str());
+	TEST_ASSERT_EQUAL_STRING("[     0][D][a.cpp:3] f(): debug\r\n",
+			pop(log).c_str());
+	TEST_ASSERT_EQUAL_UINT32(0, log.getDropped());
+}
+
+/**
+ * Tests that messages are dropped and counted when the ring buffer is full.
+ */
+void test_drop() {
+	logging::AsyncLog log(4, fake_clock, logging::LEVEL_VERBOSE);
+	for (int i = 0; i < 6; i++) {
+		TEST_ASSERT_EQUAL(i < 4,
+				log.log(logging::LEVEL_INFO, "a.cpp", 1, "f", "%d", i));
+	}
+	TEST_ASSERT_EQUAL_UINT32(2, log.getDropped());
+
+	TEST_ASSERT_EQUAL_STRING("[     0][I][a.cpp:1] f(): 0\r\n",
+			pop(log).c_str());
+	TEST_ASSERT_TRUE(log.log(logging::LEVEL_INFO, "a.cpp", 1, "f", "%d", 6));
+	for (int i : { 1, 2, 3, 6 }) {
+		char expected[64];
+		snprintf(expected, sizeof(expected), "[     0][I][a.cpp:1] f(): %d\r\n",
+				i);
+		TEST_ASSERT_EQUAL_STRING(expected, pop(log).c_str());
+	}
+	TEST_ASSERT_EQUAL_STRING("", pop(log).c_str());
+}
+
+/**
+ * Tests that messages logged by multiple threads at once are never torn or lost without being counted.
+ * Every message contains its thread twice, so mixed up records can be detected.
+ */
+void test_concurrent() {
+	logging::AsyncLog log(16, fake_clock, logging::LEVEL_VERBOSE);
+	const size_t MESSAGES = 20000;
+	std::atomic<uint8_t> finished { 0 };
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([&log, &finished, t, MESSAGES]() {
+			const std::string name(1, 'a' + t);
+			for (size_t i = 0; i < MESSAGES; i++) {
+				log.log(logging::LEVEL_INFO, "a.cpp", 1, "f", "%d %s", t,
+						name.c_str());
+			}
+			finished++;
+		});
+	}
+
+	size_t read = 0;
+	while (true) {
+		const bool done = finished.load() == threads.size();
+		std::string line;
+		while (!(line = pop(log)).empty()) {
+			const char thread = line[line.size() - 5];
+			TEST_ASSERT_EQUAL_CHAR(thread - '0' + 'a', line[line.size() - 3]);
+			read++;
+		}
+		if (done) {
+			break;
+		}
+	}
+
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+	TEST_ASSERT_EQUAL_size_t(4 * MESSAGES, read + log.getDropped());
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_format);
+	RUN_TEST(test_string_copy);
+	RUN_TEST(test_malformed);
+	RUN_TEST(test_level);
+	RUN_TEST(test_drop);
+	RUN_TEST(test_concurrent);
+
+	return UNITY_END();
+}
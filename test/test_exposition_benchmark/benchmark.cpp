@@ -0,0 +1,244 @@
+/*
+ * benchmark.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <prometheus_registry.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * The number of times to render the exposition for each measurement.
+ */
+const size_t RENDERS = 2000;
+
+/**
+ * The size of the buffer the exposition is read into, like the chunks of a HTTP response.
+ */
+const size_t CHUNK_SIZE = 512;
+
+/**
+ * A set of metric families resembling the metrics of a thermometer.
+ */
+class ThermometerMetrics {
+public:
+	prom::ValueFamily temperature { "esptherm", "external_temperature",
+			"celsius", "The current measured external temperature in degrees celsius.",
+			"gauge", []() {
+				return 21.5;
+			} };
+	prom::ValueFamily humidity { "esptherm", "external_humidity", "percent",
+			"The current measured external relative humidity in percent.",
+			"gauge", []() {
+				return 45.25;
+			} };
+	prom::ValueFamily heap { "process", "heap", "bytes",
+			"The amount of heap used on the ESP in bytes.", "gauge", []() {
+				return 123456.0;
+			} };
+	prom::InfoFamily build_info { "esptherm", "build_info",
+			"A constant 1 with compile time information as labels.",
+			"{esptherm_commit=\"0123456789abcdef\",mcu_type=\"esp32\","
+					"arduino_version=\"2.0.14\",sdk_version=\"v4.4.6\","
+					"cpp_std_version=\"gnu++11\"}" };
+	prom::CounterFamily measurements { "esptherm", "sensor_measurements_total",
+			"", "The total number of finished sensor measurements by result.", {
+					"result" }, 2 };
+	prom::CounterFamily flash_sent { "esptherm",
+			"flash_response_sent_bytes_total", "",
+			"The total number of static file bytes sent directly from flash." };
+	prom::CounterFamily flash_busy { "esptherm",
+			"flash_response_busy_seconds_total", "",
+			"The total CPU time spent sending static files from flash in seconds.",
+			{ }, 1, 1000000 };
+	prom::HistogramFamily duration { "esptherm", "http_handler_duration",
+			"seconds", "The time spent creating HTTP responses in seconds.", {
+					100, 500, 1000, 5000, 10000, 50000, 100000, 500000 },
+			1000000 };
+
+	/**
+	 * All the metric families of this set.
+	 */
+	std::vector<const prom::MetricFamily*> families { &temperature, &humidity,
+			&heap, &build_info, &measurements, &flash_sent, &flash_busy,
+			&duration };
+
+	/**
+	 * Creates the metric families, and gives them some values.
+	 *
+	 * @param prerender	Whether to pre-render the metadata lines of the metric families.
+	 */
+	ThermometerMetrics(const bool prerender) {
+		measurements.get( { "valid" }).inc(1234);
+		measurements.get( { "invalid" }).inc(5);
+		flash_sent.get().inc(987654);
+		flash_busy.get().inc(4321);
+		for (uint32_t i = 0; i < 1000; i += 7) {
+			duration.get().observe(i * 300);
+		}
+
+		if (prerender) {
+			for (const prom::MetricFamily *family : families) {
+				const_cast<prom::MetricFamily*>(family)->prerender();
+			}
+		}
+	}
+};
+
+/**
+ * Does nothing.
+ */
+void setUp() {
+
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Renders the entire exposition of the given metric families.
+ *
+ * @param families		The metric families to write.
+ * @param openmetrics	Whether to write the OpenMetrics format.
+ * @return	The written exposition.
+ */
+std::string render(const std::vector<const prom::MetricFamily*> &families,
+		const bool openmetrics) {
+	prom::ExpositionWriter writer(families, openmetrics);
+	std::string output;
+	uint8_t buffer[CHUNK_SIZE];
+	size_t len;
+	while ((len = writer.read(buffer, CHUNK_SIZE)) > 0) {
+		output.append((char*) buffer, len);
+	}
+	return output;
+}
+
+/**
+ * Measures the average time it takes to render the exposition of the given metric families.
+ *
+ * @param families		The metric families to write.
+ * @param openmetrics	Whether to write the OpenMetrics format.
+ * @return	The average render time in microseconds.
+ */
+double measure(const std::vector<const prom::MetricFamily*> &families,
+		const bool openmetrics) {
+	size_t total_len = 0;
+	const std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+	for (size_t i = 0; i < RENDERS; i++) {
+		prom::ExpositionWriter writer(families, openmetrics);
+		uint8_t buffer[CHUNK_SIZE];
+		size_t len;
+		while ((len = writer.read(buffer, CHUNK_SIZE)) > 0) {
+			total_len += len;
+		}
+	}
+	const std::chrono::steady_clock::time_point end =
+			std::chrono::steady_clock::now();
+	TEST_ASSERT_GREATER_THAN_size_t(0, total_len);
+	return std::chrono::duration<double, std::micro>(end - start).count()
+			/ RENDERS;
+}
+
+/**
+ * Compares the render time of the exposition with and without pre-rendered metadata lines.
+ */
+void benchmark_prerendered() {
+	ThermometerMetrics formatted(false);
+	ThermometerMetrics prerendered(true);
+
+	for (uint8_t openmetrics = 0; openmetrics < 2; openmetrics++) {
+		TEST_ASSERT_EQUAL_STRING(
+				render(formatted.families, openmetrics).c_str(),
+				render(prerendered.families, openmetrics).c_str());
+
+		const double formatted_time = measure(formatted.families,
+				openmetrics);
+		const double prerendered_time = measure(prerendered.families,
+				openmetrics);
+		char message[128];
+		snprintf(message, sizeof(message),
+				"%s render time: %.2fus formatted, %.2fus pre-rendered.",
+				openmetrics ? "OpenMetrics" : "Prometheus", formatted_time,
+				prerendered_time);
+		TEST_MESSAGE(message);
+	}
+}
+
+/**
+ * Measures the average time it takes to write the protobuf exposition of the given metric families.
+ *
+ * @param families	The metric families to write.
+ * @param size		Set to the length of a single exposition.
+ * @return	The average write time in microseconds.
+ */
+double measureProtobuf(const std::vector<const prom::MetricFamily*> &families,
+		size_t &size) {
+	size_t total_len = 0;
+	const std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+	for (size_t i = 0; i < RENDERS; i++) {
+		prom::ProtobufWriter writer(families);
+		uint8_t buffer[CHUNK_SIZE];
+		size_t len;
+		while ((len = writer.read(buffer, CHUNK_SIZE)) > 0) {
+			total_len += len;
+		}
+	}
+	const std::chrono::steady_clock::time_point end =
+			std::chrono::steady_clock::now();
+	TEST_ASSERT_GREATER_THAN_size_t(0, total_len);
+	size = total_len / RENDERS;
+	return std::chrono::duration<double, std::micro>(end - start).count()
+			/ RENDERS;
+}
+
+/**
+ * Compares the write time and size of the protobuf exposition to the pre-rendered text exposition.
+ */
+void benchmark_protobuf() {
+	ThermometerMetrics metrics(true);
+
+	const double text_time = measure(metrics.families, false);
+	const size_t text_size = render(metrics.families, false).size();
+	size_t protobuf_size = 0;
+	const double protobuf_time = measureProtobuf(metrics.families,
+			protobuf_size);
+	char message[128];
+	snprintf(message, sizeof(message),
+			"Prometheus text: %.2fus, %u bytes. Protobuf: %.2fus, %u bytes.",
+			text_time, (unsigned int) text_size, protobuf_time,
+			(unsigned int) protobuf_size);
+	TEST_MESSAGE(message);
+	TEST_ASSERT_LESS_THAN_size_t(text_size, protobuf_size);
+}
+
+/**
+ * The entrypoint running this benchmark.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(benchmark_prerendered);
+	RUN_TEST(benchmark_protobuf);
+
+	return UNITY_END();
+}
@@ -0,0 +1,175 @@
+/*
+ * fixed_point.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <utils.h>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+/**
+ * Rounds the given number to the nearest integer, with ties rounded away from zero.
+ *
+ * @param value	The number to round.
+ * @return	The rounded number.
+ */
+int32_t reference_round(const double value) {
+	return (int32_t) std::round(value);
+}
+
+/**
+ * Does nothing.
+ */
+void setUp() {
+
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Tests the conversion from celsius to fahrenheit over the range of all supported sensors.
+ */
+void test_fahrenheit() {
+	uint32_t mismatches = 0;
+	for (int32_t centi = -6000; centi <= 15000; centi++) {
+		// Exact, since centi * 9 is an integer.
+		const double expected = centi * 9 / 5.0 + 3200;
+		if (utils::centiCelsiusToFahrenheit(centi) != reference_round(expected)) {
+			mismatches++;
+		}
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+	TEST_ASSERT_EQUAL_INT32(3200, utils::centiCelsiusToFahrenheit(0));
+	TEST_ASSERT_EQUAL_INT32(21200, utils::centiCelsiusToFahrenheit(10000));
+	TEST_ASSERT_EQUAL_INT32(-4000, utils::centiCelsiusToFahrenheit(-4000));
+	TEST_ASSERT_EQUAL_INT32(utils::FIXED_UNKNOWN,
+			utils::centiCelsiusToFahrenheit(utils::FIXED_UNKNOWN));
+}
+
+/**
+ * Tests the conversion of every possible DS18B20 temperature, both as 1/16 °C and 1/128 °C.
+ */
+void test_binary() {
+	uint32_t mismatches = 0;
+	// The DS18B20 range is -55 °C to 125 °C.
+	for (int32_t raw = -55 * 16; raw <= 125 * 16; raw++) {
+		const int32_t expected = reference_round(raw * 100 / 16.0);
+		mismatches += utils::binaryToCenti(raw, 4) != expected;
+		mismatches += utils::binaryToCenti(raw * 8, 7) != expected;
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+	TEST_ASSERT_EQUAL_INT32(2156, utils::binaryToCenti(345, 4));
+	TEST_ASSERT_EQUAL_INT32(-1013, utils::binaryToCenti(-162, 4));
+	TEST_ASSERT_EQUAL_INT32(1200, utils::binaryToCenti(12, 0));
+}
+
+/**
+ * Tests the conversions between floats and hundredths.
+ */
+void test_float() {
+	uint32_t mismatches = 0;
+	for (int32_t centi = -100000; centi <= 100000; centi++) {
+		mismatches += utils::floatToCenti(centi / 100.0f) != centi;
+		mismatches += utils::centiToFloat(centi) != centi / 100.0f;
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+	TEST_ASSERT_EQUAL_INT32(utils::FIXED_UNKNOWN, utils::floatToCenti(NAN));
+	TEST_ASSERT_EQUAL_INT32(utils::FIXED_UNKNOWN, utils::floatToCenti(INFINITY));
+	TEST_ASSERT_EQUAL_INT32(utils::FIXED_UNKNOWN, utils::floatToCenti(-1e9f));
+	TEST_ASSERT_TRUE(std::isnan(utils::centiToFloat(utils::FIXED_UNKNOWN)));
+}
+
+/**
+ * Tests that untrimmed output matches printf, and trimmed output matches float_to_string.
+ */
+void test_chars() {
+	uint32_t mismatches = 0;
+	char buffer[utils::CENTI_CHARS_BUFFER_SIZE];
+	char expected[32];
+	for (int32_t centi = -100000; centi <= 100000; centi++) {
+		size_t len = utils::centi_to_chars(buffer, sizeof(buffer), centi, 2,
+				false);
+		snprintf(expected, sizeof(expected), "%d.%02d", (int) centi / 100,
+				(int) std::abs(centi % 100));
+		if (centi < 0 && centi > -100) {
+			snprintf(expected, sizeof(expected), "-0.%02d", (int) -centi);
+		}
+		mismatches += std::string(buffer, len) != expected;
+
+		if (centi >= 0) {
+			len = utils::centi_to_chars(buffer, sizeof(buffer), centi, 2, true);
+			mismatches += std::string(buffer, len)
+					!= utils::float_to_string(centi / 100.0f, 2);
+		}
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+/**
+ * Tests rounding to fewer decimal digits, special values, and truncation.
+ */
+void test_chars_special() {
+	TEST_ASSERT_EQUAL_STRING("21.5", utils::centi_to_string(2150, 2).c_str());
+	TEST_ASSERT_EQUAL_STRING("-21.53", utils::centi_to_string(-2153, 2).c_str());
+	TEST_ASSERT_EQUAL_STRING("21.6", utils::centi_to_string(2155, 1).c_str());
+	TEST_ASSERT_EQUAL_STRING("-21.6", utils::centi_to_string(-2155, 1).c_str());
+	TEST_ASSERT_EQUAL_STRING("22", utils::centi_to_string(2150, 0).c_str());
+	TEST_ASSERT_EQUAL_STRING("21", utils::centi_to_string(2149, 0).c_str());
+	TEST_ASSERT_EQUAL_STRING("1", utils::centi_to_string(99, 1).c_str());
+	TEST_ASSERT_EQUAL_STRING("0", utils::centi_to_string(-4, 1).c_str());
+	TEST_ASSERT_EQUAL_STRING("0", utils::centi_to_string(0, 2).c_str());
+	TEST_ASSERT_EQUAL_STRING("1.23", utils::centi_to_string(123, 5).c_str());
+	TEST_ASSERT_EQUAL_STRING("Unknown",
+			utils::centi_to_string(utils::FIXED_UNKNOWN, 2).c_str());
+	TEST_ASSERT_EQUAL_STRING("-21474836.47",
+			utils::centi_to_string(INT32_MIN + 1, 2).c_str());
+	TEST_ASSERT_EQUAL_STRING("21474836.47",
+			utils::centi_to_string(INT32_MAX, 2).c_str());
+
+	char buffer[8];
+	TEST_ASSERT_EQUAL_size_t(3,
+			utils::centi_to_chars(buffer, sizeof(buffer), -4, 1, false));
+	TEST_ASSERT_EQUAL_STRING("0.0", buffer);
+	TEST_ASSERT_EQUAL_size_t(4,
+			utils::centi_to_chars(buffer, sizeof(buffer), -5, 1, false));
+	TEST_ASSERT_EQUAL_STRING("-0.1", buffer);
+	TEST_ASSERT_EQUAL_size_t(7,
+			utils::centi_to_chars(buffer, sizeof(buffer), 123456, 2, false));
+	TEST_ASSERT_EQUAL_STRING("1234.56", buffer);
+	TEST_ASSERT_EQUAL_size_t(7,
+			utils::centi_to_chars(buffer, sizeof(buffer), -123456, 2, false));
+	TEST_ASSERT_EQUAL_STRING("-1234.5", buffer);
+	TEST_ASSERT_EQUAL_size_t(0,
+			utils::centi_to_chars(buffer, 0, -123456, 2, false));
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_fahrenheit);
+	RUN_TEST(test_binary);
+	RUN_TEST(test_float);
+	RUN_TEST(test_chars);
+	RUN_TEST(test_chars_special);
+
+	return UNITY_END();
+}
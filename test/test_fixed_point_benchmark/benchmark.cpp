@@ -0,0 +1,168 @@
+/*
+ * benchmark.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <utils.h>
+#include <chrono>
+#include <cstdio>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * The number of measurements to format per run.
+ */
+const size_t MEASUREMENTS = 200000;
+
+/**
+ * Gets the current value of the cycle counter, if the platform has one that can be read.
+ *
+ * @return	The current cycle count, or zero.
+ */
+uint64_t read_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Gets the raw DS18B20 temperature for the given measurement, in 1/128 °C like the DallasTemperature library returns it.
+ * Covers the entire sensor range of -55 °C to 125 °C.
+ *
+ * @param i	The index of the measurement.
+ * @return	The raw temperature.
+ */
+int32_t raw_temperature(const size_t i) {
+	return ((int32_t) (i * 7919 % 2881) - 880) * 8;
+}
+
+/**
+ * Gets the relative humidity for the given measurement, in hundredths of a percent.
+ *
+ * @param i	The index of the measurement.
+ * @return	The relative humidity.
+ */
+int32_t centi_humidity(const size_t i) {
+	return i * 104729 % 10001;
+}
+
+/**
+ * Formats a measurement the way the firmware did with floats.
+ * Writes the temperature in celsius and fahrenheit, and the humidity, like the serial output,
+ * and the temperature and humidity with two decimal digits, like the JSON endpoint.
+ *
+ * @param i	The index of the measurement to format.
+ * @return	The total length of the written strings.
+ */
+size_t format_float(const size_t i) {
+	char buffer[utils::FLOAT_CHARS_BUFFER_SIZE];
+	const float temperature = raw_temperature(i) * 0.0078125f;
+	const float humidity = centi_humidity(i) / 100.0f;
+	size_t len = utils::float_to_chars(buffer, sizeof(buffer), temperature, 2);
+	len += utils::float_to_chars(buffer, sizeof(buffer),
+			utils::celsiusToFahrenheit(temperature), 2);
+	len += utils::float_to_chars(buffer, sizeof(buffer), humidity, 2);
+	len += snprintf(buffer, sizeof(buffer), "%.2f", temperature);
+	len += snprintf(buffer, sizeof(buffer), "%.2f", humidity);
+	return len;
+}
+
+/**
+ * Formats a measurement using fixed point math only.
+ * Writes the same values as format_float, rounded in decimal instead of binary.
+ *
+ * @param i	The index of the measurement to format.
+ * @return	The total length of the written strings.
+ */
+size_t format_fixed(const size_t i) {
+	char buffer[utils::CENTI_CHARS_BUFFER_SIZE];
+	const int32_t temperature = utils::binaryToCenti(raw_temperature(i), 7);
+	const int32_t humidity = centi_humidity(i);
+	size_t len = utils::centi_to_chars(buffer, sizeof(buffer), temperature, 2,
+			true);
+	len += utils::centi_to_chars(buffer, sizeof(buffer),
+			utils::centiCelsiusToFahrenheit(temperature), 2, true);
+	len += utils::centi_to_chars(buffer, sizeof(buffer), humidity, 2, true);
+	len += utils::centi_to_chars(buffer, sizeof(buffer), temperature, 2, false);
+	len += utils::centi_to_chars(buffer, sizeof(buffer), humidity, 2, false);
+	return len;
+}
+
+/**
+ * Measures the time the given function takes to format MEASUREMENTS measurements.
+ *
+ * @param function	The function to measure.
+ * @param cycles	Set to the average number of cycles per measurement, or zero if unavailable.
+ * @return	The average time per measurement in nanoseconds.
+ */
+double measure(size_t (*function)(const size_t), double &cycles) {
+	size_t total_len = 0;
+	const std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+	const uint64_t start_cycles = read_cycles();
+	for (size_t i = 0; i < MEASUREMENTS; i++) {
+		total_len += function(i);
+	}
+	const uint64_t end_cycles = read_cycles();
+	const std::chrono::steady_clock::time_point end =
+			std::chrono::steady_clock::now();
+	TEST_ASSERT_GREATER_THAN_size_t(0, total_len);
+	cycles = (double) (end_cycles - start_cycles) / MEASUREMENTS;
+	return std::chrono::duration<double, std::nano>(end - start).count()
+			/ MEASUREMENTS;
+}
+
+/**
+ * Does nothing.
+ */
+void setUp() {
+
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Compares the time it takes to convert and format a measurement with floats and with fixed point numbers.
+ * The host has a FPU, so the difference is expected to be larger on a MCU without one, like the ESP8266.
+ */
+void benchmark_measurement() {
+	double float_cycles = 0;
+	double fixed_cycles = 0;
+	const double float_time = measure(format_float, float_cycles);
+	const double fixed_time = measure(format_fixed, fixed_cycles);
+
+	char message[128];
+	snprintf(message, sizeof(message),
+			"Per formatted measurement: float %.0f cycles (%.1fns), fixed point %.0f cycles (%.1fns).",
+			float_cycles, float_time, fixed_cycles, fixed_time);
+	TEST_MESSAGE(message);
+}
+
+/**
+ * The entrypoint running this benchmark.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(benchmark_measurement);
+
+	return UNITY_END();
+}
@@ -0,0 +1,180 @@
+/*
+ * benchmark.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <utils.h>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <string>
+
+/**
+ * The number of values to format per measurement.
+ */
+const size_t VALUES = 200000;
+
+/**
+ * The previous, stream based implementation of float_to_string.
+ *
+ * @param measurement		The floating point number to convert to a string.
+ * @param decimal_digits	The number of digits after the decimal dot to round to.
+ * @return	The converted string.
+ */
+std::string stream_float_to_string(const float measurement,
+		const uint8_t decimal_digits) {
+	if (std::isnan(measurement)) {
+		return "Unknown";
+	}
+
+	uint8_t precision = decimal_digits + 1;
+	if (measurement >= 10) {
+		precision++;
+	}
+	if (measurement >= 100) {
+		precision++;
+	}
+
+	std::ostringstream converter;
+	converter << std::setprecision(precision) << measurement;
+	return converter.str();
+}
+
+/**
+ * The previous, stream based implementation of timespan_to_string.
+ *
+ * @param time_ms	The timespan to convert to a string.
+ * @return	The converted string.
+ */
+std::string stream_timespan_to_string(const int64_t time_ms) {
+	if (time_ms < 0) {
+		return "Unknown";
+	}
+
+	std::ostringstream stream;
+	stream << std::internal << std::setfill('0') << std::setw(2);
+	stream << time_ms / 3600000 % 24 << ':';
+	stream << std::internal << std::setfill('0') << std::setw(2);
+	stream << time_ms / 60000 % 60 << ':';
+	stream << std::internal << std::setfill('0') << std::setw(2);
+	stream << time_ms / 1000 % 60 << '.';
+	stream << std::internal << std::setfill('0') << std::setw(3);
+	stream << time_ms % 1000;
+	return stream.str();
+}
+
+/**
+ * Gets the value to format in the given iteration.
+ * Covers temperatures and humidities between -40 and 160 with two decimal digits.
+ *
+ * @param i	The iteration to get the value for.
+ * @return	The value to format.
+ */
+float value(const size_t i) {
+	return (int32_t) (i * 7919 % 20000) / 100.0f - 40;
+}
+
+/**
+ * Measures the time the given function takes to format VALUES values.
+ *
+ * @param function	The function to measure.
+ * @return	The average time per value in nanoseconds.
+ */
+template<typename F>
+double measure(const F function) {
+	size_t total_len = 0;
+	const std::chrono::steady_clock::time_point start =
+			std::chrono::steady_clock::now();
+	for (size_t i = 0; i < VALUES; i++) {
+		total_len += function(i);
+	}
+	const std::chrono::steady_clock::time_point end =
+			std::chrono::steady_clock::now();
+	TEST_ASSERT_GREATER_THAN_size_t(0, total_len);
+	return std::chrono::duration<double, std::nano>(end - start).count()
+			/ VALUES;
+}
+
+/**
+ * Does nothing.
+ */
+void setUp() {
+
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Compares the time it takes to format measurements with the stream based implementation,
+ * the string wrapper, and the buffer based implementation.
+ */
+void benchmark_float() {
+	const double stream_time = measure([](const size_t i) {
+		return stream_float_to_string(value(i), 2).size();
+	});
+	const double string_time = measure([](const size_t i) {
+		return utils::float_to_string(value(i), 2).size();
+	});
+	const double chars_time = measure([](const size_t i) {
+		char buffer[utils::FLOAT_CHARS_BUFFER_SIZE];
+		return utils::float_to_chars(buffer, sizeof(buffer), value(i), 2);
+	});
+
+	char message[128];
+	snprintf(message, sizeof(message),
+			"Float format time: %.1fns stream, %.1fns string, %.1fns buffer.",
+			stream_time, string_time, chars_time);
+	TEST_MESSAGE(message);
+}
+
+/**
+ * Compares the time it takes to format timespans with the stream based implementation,
+ * the string wrapper, and the buffer based implementation.
+ */
+void benchmark_timespan() {
+	const double stream_time = measure([](const size_t i) {
+		return stream_timespan_to_string(i * 7919).size();
+	});
+	const double string_time = measure([](const size_t i) {
+		return utils::timespan_to_string(i * 7919).size();
+	});
+	const double chars_time = measure([](const size_t i) {
+		char buffer[utils::TIMESPAN_CHARS_BUFFER_SIZE];
+		return utils::timespan_to_chars(buffer, sizeof(buffer), i * 7919);
+	});
+
+	char message[128];
+	snprintf(message, sizeof(message),
+			"Timespan format time: %.1fns stream, %.1fns string, %.1fns buffer.",
+			stream_time, string_time, chars_time);
+	TEST_MESSAGE(message);
+}
+
+/**
+ * The entrypoint running this benchmark.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(benchmark_float);
+	RUN_TEST(benchmark_timespan);
+
+	return UNITY_END();
+}
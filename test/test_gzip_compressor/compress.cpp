@@ -0,0 +1,197 @@
+/*
+ * compress.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <gzip_compressor.h>
+#include <uzlib_gzip_wrapper.h>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Use a constant seed, to get reproducible results.
+ */
+const std::mt19937::result_type RANDOM_SEED = 1760745600;
+
+/**
+ * Compresses the given data, reading and writing at most the given number of bytes at once.
+ *
+ * @param data		The data to compress.
+ * @param read_len	The max number of bytes to give to the compressor at once.
+ * @param write_len	The max number of bytes to read from the compressor at once.
+ * @return	The gzip file created by the compressor.
+ */
+std::vector<uint8_t> compress(const std::string &data, const size_t read_len,
+		const size_t write_len) {
+	size_t read = 0;
+	gzip::gzip_compressor compressor(
+			[&data, &read, read_len](uint8_t *buffer, const size_t max_len) {
+				size_t len = data.size() - read;
+				len = len < max_len ? len : max_len;
+				len = len < read_len ? len : read_len;
+				memcpy(buffer, data.c_str() + read, len);
+				read += len;
+				return len;
+			});
+
+	std::vector<uint8_t> compressed;
+	std::vector<uint8_t> buffer(write_len);
+	size_t len = 0;
+	while ((len = compressor.read(buffer.data(), write_len)) > 0) {
+		compressed.insert(compressed.end(), buffer.begin(),
+				buffer.begin() + len);
+	}
+	TEST_ASSERT_TRUE(compressor.done());
+	TEST_ASSERT_EQUAL_UINT32(data.size(), compressor.getUncompressedSize());
+	TEST_ASSERT_EQUAL_UINT32(compressed.size(), compressor.getCompressedSize());
+	return compressed;
+}
+
+/**
+ * Decompresses the given gzip file, and checks that it matches the expected data.
+ *
+ * @param compressed	The gzip file to decompress.
+ * @param expected		The expected decompressed data.
+ */
+void check_decompressed(const std::vector<uint8_t> &compressed,
+		const std::string &expected) {
+	gzip::uzlib_ungzip_wrapper unzip(compressed.data(),
+			compressed.data() + compressed.size(), -10);
+	TEST_ASSERT_EQUAL_INT32(expected.size(), unzip.getDecompressedSize());
+
+	// One extra byte, to check that there is no more data.
+	std::vector<uint8_t> decompressed(expected.size() + 1);
+	TEST_ASSERT_EQUAL_size_t(expected.size(),
+			unzip.decompress(decompressed.data(), decompressed.size()));
+	TEST_ASSERT_TRUE(unzip.done());
+	if (!expected.empty()) {
+		TEST_ASSERT_EQUAL_MEMORY(expected.c_str(), decompressed.data(),
+				expected.size());
+	}
+}
+
+/**
+ * Creates a text exposition like string of the given length.
+ *
+ * @param len	The length of the string to create.
+ * @return	The created string.
+ */
+std::string create_exposition(const size_t len) {
+	std::mt19937 rng(RANDOM_SEED);
+	std::uniform_int_distribution<uint32_t> distribution(0, 100000);
+	std::string exposition;
+	for (size_t i = 0; exposition.size() < len; i++) {
+		exposition += "# HELP esptherm_metric_" + std::to_string(i % 16)
+				+ " The description of metric " + std::to_string(i % 16)
+				+ ".\n";
+		exposition += "# TYPE esptherm_metric_" + std::to_string(i % 16)
+				+ " gauge\n";
+		exposition += "esptherm_metric_" + std::to_string(i % 16)
+				+ "{sensor=\"dht22\"} " + std::to_string(distribution(rng))
+				+ "\n";
+	}
+	exposition.resize(len);
+	return exposition;
+}
+
+/**
+ * Does nothing.
+ */
+void setUp() {
+
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Tests compressing an empty input.
+ */
+void test_compress_empty() {
+	const std::vector<uint8_t> compressed = compress("", 1024, 1024);
+	// A 10 byte header, two bytes for the empty block, and an 8 byte trailer.
+	TEST_ASSERT_EQUAL_size_t(20, compressed.size());
+	check_decompressed(compressed, "");
+}
+
+/**
+ * Tests compressing a text exposition like input, that is smaller than the window.
+ */
+void test_compress_small() {
+	const std::string exposition = create_exposition(700);
+	const std::vector<uint8_t> compressed = compress(exposition, 1024, 1024);
+	TEST_ASSERT_LESS_THAN_size_t(exposition.size() / 2, compressed.size());
+	check_decompressed(compressed, exposition);
+}
+
+/**
+ * Tests compressing a text exposition like input, that is much larger than the window.
+ */
+void test_compress_large() {
+	const std::string exposition = create_exposition(100000);
+	const std::vector<uint8_t> compressed = compress(exposition, 512, 536);
+	TEST_ASSERT_LESS_THAN_size_t(exposition.size() / 3, compressed.size());
+	check_decompressed(compressed, exposition);
+}
+
+/**
+ * Tests compressing random data, which can't be compressed.
+ */
+void test_compress_random() {
+	std::mt19937 rng(RANDOM_SEED);
+	std::uniform_int_distribution<uint16_t> distribution(0, 255);
+	std::string data;
+	for (size_t i = 0; i < 10000; i++) {
+		data += (char) distribution(rng);
+	}
+
+	const std::vector<uint8_t> compressed = compress(data, 4096, 4096);
+	// Literals are at most 9 bits long.
+	TEST_ASSERT_LESS_THAN_size_t(data.size() * 9 / 8 + 20, compressed.size());
+	check_decompressed(compressed, data);
+}
+
+/**
+ * Tests that the output doesn't depend on how the input is given to the compressor,
+ * or how the output is read from it.
+ */
+void test_compress_split() {
+	const std::string exposition = create_exposition(5000);
+	const std::vector<uint8_t> expected = compress(exposition, 5000, 10000);
+	const std::vector<uint8_t> compressed = compress(exposition, 1, 1);
+	TEST_ASSERT_EQUAL_size_t(expected.size(), compressed.size());
+	TEST_ASSERT_EQUAL_MEMORY(expected.data(), compressed.data(),
+			expected.size());
+	check_decompressed(compress(exposition, 7, 3), exposition);
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_compress_empty);
+	RUN_TEST(test_compress_small);
+	RUN_TEST(test_compress_large);
+	RUN_TEST(test_compress_random);
+	RUN_TEST(test_compress_split);
+
+	return UNITY_END();
+}
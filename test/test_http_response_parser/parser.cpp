@@ -0,0 +1,189 @@
+/*
+ * parser.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <http_response_parser.h>
+#include <string>
+
+/**
+ * Parses a string as response data.
+ *
+ * @param parser	The parser to use.
+ * @param data		The response data to parse.
+ * @return	The number of bytes that were parsed.
+ */
+size_t parse(http::ResponseParser &parser, const std::string &data) {
+	return parser.parse((const uint8_t*) data.c_str(), data.size());
+}
+
+/**
+ * Does nothing.
+ */
+void setUp() {
+
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Tests parsing a response with a Content-Length, one byte at a time.
+ */
+void test_content_length() {
+	const std::string response = "HTTP/1.1 200 OK\r\n"
+			"content-LENGTH: 5\r\n"
+			"Content-Type: text/plain\r\n\r\n"
+			"Hello";
+	http::ResponseParser parser;
+	TEST_ASSERT_TRUE(parser.isIdle());
+	for (size_t i = 0; i < response.size(); i++) {
+		TEST_ASSERT_FALSE(parser.isComplete());
+		TEST_ASSERT_EQUAL_size_t(1,
+				parser.parse((const uint8_t*) response.c_str() + i, 1));
+		TEST_ASSERT_FALSE(parser.isIdle());
+	}
+	TEST_ASSERT_TRUE(parser.isComplete());
+	TEST_ASSERT_FALSE(parser.hasError());
+	TEST_ASSERT_EQUAL_UINT16(200, parser.getStatus());
+	TEST_ASSERT_TRUE(parser.isKeepAlive());
+}
+
+/**
+ * Tests parsing a response using chunked transfer encoding, with chunk extensions and a trailer.
+ */
+void test_chunked() {
+	const std::string headers = "HTTP/1.1 202 Accepted\r\n"
+			"Transfer-Encoding: chunked\r\n\r\n";
+	http::ResponseParser parser;
+	TEST_ASSERT_EQUAL_size_t(headers.size(), parse(parser, headers));
+	TEST_ASSERT_EQUAL_UINT16(202, parser.getStatus());
+	parse(parser, "5;ext=1\r\nHello\r\nA\r\n0123456789\r\n");
+	TEST_ASSERT_FALSE(parser.isComplete());
+	parse(parser, "0\r\nTrailer: value\r\n");
+	TEST_ASSERT_FALSE(parser.isComplete());
+	parse(parser, "\r\n");
+	TEST_ASSERT_TRUE(parser.isComplete());
+	TEST_ASSERT_TRUE(parser.isKeepAlive());
+}
+
+/**
+ * Tests parsing multiple responses received in a single buffer.
+ */
+void test_pipelined() {
+	const std::string first = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nOK";
+	const std::string second = "HTTP/1.1 204 No Content\r\n\r\n";
+	const std::string third =
+			"HTTP/1.1 400 Bad Request\r\nContent-Length: 3\r\nConnection: close\r\n\r\nBad";
+	const std::string data = first + second + third;
+	http::ResponseParser parser;
+
+	size_t pos = parse(parser, data);
+	TEST_ASSERT_EQUAL_size_t(first.size(), pos);
+	TEST_ASSERT_TRUE(parser.isComplete());
+	TEST_ASSERT_EQUAL_UINT16(200, parser.getStatus());
+
+	parser.reset();
+	TEST_ASSERT_TRUE(parser.isIdle());
+	pos += parse(parser, data.substr(pos));
+	TEST_ASSERT_EQUAL_size_t(first.size() + second.size(), pos);
+	TEST_ASSERT_TRUE(parser.isComplete());
+	TEST_ASSERT_EQUAL_UINT16(204, parser.getStatus());
+
+	parser.reset();
+	pos += parse(parser, data.substr(pos));
+	TEST_ASSERT_EQUAL_size_t(data.size(), pos);
+	TEST_ASSERT_TRUE(parser.isComplete());
+	TEST_ASSERT_EQUAL_UINT16(400, parser.getStatus());
+	TEST_ASSERT_FALSE(parser.isKeepAlive());
+}
+
+/**
+ * Tests responses whose body ends with the connection.
+ */
+void test_until_close() {
+	http::ResponseParser parser;
+	parse(parser, "HTTP/1.0 200 OK\r\n\r\nSome body");
+	TEST_ASSERT_FALSE(parser.isComplete());
+	TEST_ASSERT_FALSE(parser.isKeepAlive());
+	TEST_ASSERT_TRUE(parser.finish());
+	TEST_ASSERT_TRUE(parser.isComplete());
+
+	// Responses interrupted by the end of the connection are incomplete.
+	parser.reset();
+	parse(parser, "HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\nShort");
+	TEST_ASSERT_FALSE(parser.finish());
+	TEST_ASSERT_FALSE(parser.isComplete());
+}
+
+/**
+ * Tests that interim responses are skipped.
+ */
+void test_interim_response() {
+	http::ResponseParser parser;
+	parse(parser, "HTTP/1.1 100 Continue\r\n\r\n");
+	TEST_ASSERT_FALSE(parser.isComplete());
+	TEST_ASSERT_TRUE(parser.isIdle());
+	parse(parser, "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+	TEST_ASSERT_TRUE(parser.isComplete());
+	TEST_ASSERT_EQUAL_UINT16(200, parser.getStatus());
+}
+
+/**
+ * Tests that long header lines are truncated without affecting other headers.
+ */
+void test_long_header() {
+	http::ResponseParser parser;
+	std::string response = "HTTP/1.1 200 OK\r\nX-Long: ";
+	response.append(1000, 'x');
+	response += "\r\nContent-Length: 1\r\n\r\nA";
+	TEST_ASSERT_EQUAL_size_t(response.size(), parse(parser, response));
+	TEST_ASSERT_TRUE(parser.isComplete());
+}
+
+/**
+ * Tests that invalid responses are detected.
+ */
+void test_invalid() {
+	http::ResponseParser parser;
+	parse(parser, "SSH-2.0-OpenSSH\r\n");
+	TEST_ASSERT_TRUE(parser.hasError());
+	TEST_ASSERT_EQUAL_size_t(0, parse(parser, "HTTP/1.1 200 OK\r\n"));
+
+	parser.reset();
+	parse(parser,
+			"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\nnot hex\r\n");
+	TEST_ASSERT_TRUE(parser.hasError());
+	TEST_ASSERT_FALSE(parser.finish());
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_content_length);
+	RUN_TEST(test_chunked);
+	RUN_TEST(test_pipelined);
+	RUN_TEST(test_until_close);
+	RUN_TEST(test_interim_response);
+	RUN_TEST(test_long_header);
+	RUN_TEST(test_invalid);
+
+	return UNITY_END();
+}
@@ -0,0 +1,313 @@
+/*
+ * exposition.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <prometheus_exposition.h>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+/**
+ * The metric families written by the tests.
+ */
+std::vector<const prom::MetricFamily*> families;
+
+/**
+ * The expected Prometheus 0.0.4 output for the test metric families.
+ */
+const char EXPECTED_PROMETHEUS[] =
+		"# HELP test_temperature_celsius The temperature.\n"
+		"# TYPE test_temperature_celsius gauge\n"
+		"test_temperature_celsius 21.500\n"
+		"# HELP test_requests_total The number of requests.\n"
+		"# TYPE test_requests_total counter\n"
+		"test_requests_total 18446744073709551615\n"
+		"# HELP test_build_info The build info.\n"
+		"# TYPE test_build_info gauge\n"
+		"test_build_info{version=\"1.0\"} 1\n";
+
+/**
+ * The expected OpenMetrics output for the test metric families.
+ */
+const char EXPECTED_OPENMETRICS[] =
+		"# HELP test_temperature_celsius The temperature.\n"
+		"# TYPE test_temperature_celsius gauge\n"
+		"# UNIT test_temperature_celsius celsius\n"
+		"test_temperature_celsius 21.500\n"
+		"# HELP test_requests_total The number of requests.\n"
+		"# TYPE test_requests_total counter\n"
+		"test_requests_total 18446744073709551615\n"
+		"# HELP test_build_info The build info.\n"
+		"# TYPE test_build_info info\n"
+		"test_build_info{version=\"1.0\"} 1\n"
+		"# EOF\n";
+
+/**
+ * Creates the metric families used by the tests.
+ */
+void setUp() {
+	families.push_back(
+			new prom::ValueFamily("test", "temperature", "celsius",
+					"The temperature.", "gauge", []() {
+						return 21.5;
+					}));
+	families.push_back(
+			new prom::IntegerValueFamily("test", "requests_total", "",
+					"The number of requests.", "counter", []() {
+						return UINT64_MAX;
+					}));
+	families.push_back(
+			new prom::InfoFamily("test", "build_info", "The build info.",
+					"{version=\"1.0\"}"));
+}
+
+/**
+ * Destroys the metric families used by the tests.
+ */
+void tearDown() {
+	for (const prom::MetricFamily *family : families) {
+		delete family;
+	}
+	families.clear();
+}
+
+/**
+ * Writes the entire output of the given writer, reading at most chunk_size bytes at a time.
+ *
+ * @param writer		The writer to read from.
+ * @param chunk_size	The max number of bytes to read at once.
+ * @return	The entire output of the writer.
+ */
+std::string readAll(prom::ExpositionWriter &writer, const size_t chunk_size) {
+	std::string output;
+	uint8_t *buffer = new uint8_t[chunk_size];
+	size_t len;
+	while ((len = writer.read(buffer, chunk_size)) > 0) {
+		TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(chunk_size, len,
+				"Writer wrote more than the buffer size.");
+		output.append((char*) buffer, len);
+	}
+	delete[] buffer;
+	TEST_ASSERT_TRUE_MESSAGE(writer.done(),
+			"Writer returned zero before it was done.");
+	return output;
+}
+
+/**
+ * Tests writing the Prometheus 0.0.4 format in a single read.
+ */
+void test_write_prometheus() {
+	prom::ExpositionWriter writer(families);
+	TEST_ASSERT_EQUAL_STRING(EXPECTED_PROMETHEUS,
+			readAll(writer, 4096).c_str());
+}
+
+/**
+ * Tests writing the OpenMetrics format in a single read.
+ */
+void test_write_openmetrics() {
+	prom::ExpositionWriter writer(families, true);
+	TEST_ASSERT_EQUAL_STRING(EXPECTED_OPENMETRICS,
+			readAll(writer, 4096).c_str());
+}
+
+/**
+ * Tests that the output is the same no matter how small the chunks it is read in are.
+ */
+void test_write_chunked() {
+	for (size_t chunk_size = 1; chunk_size <= 64; chunk_size++) {
+		prom::ExpositionWriter prometheus(families);
+		TEST_ASSERT_EQUAL_STRING(EXPECTED_PROMETHEUS,
+				readAll(prometheus, chunk_size).c_str());
+		prom::ExpositionWriter openmetrics(families, true);
+		TEST_ASSERT_EQUAL_STRING(EXPECTED_OPENMETRICS,
+				readAll(openmetrics, chunk_size).c_str());
+	}
+}
+
+/**
+ * Tests that pre-rendering the metadata lines doesn't change the output.
+ */
+void test_write_prerendered() {
+	prom::ValueFamily temperature("test", "temperature", "celsius",
+			"The temperature.", "gauge", []() {
+				return 21.5;
+			});
+	prom::IntegerValueFamily requests("test", "requests_total", "",
+			"The number of requests.", "counter", []() {
+				return UINT64_MAX;
+			});
+	prom::InfoFamily build_info("test", "build_info", "The build info.",
+			"{version=\"1.0\"}");
+	temperature.prerender();
+	requests.prerender();
+	build_info.prerender();
+	const std::vector<const prom::MetricFamily*> prerendered { &temperature,
+			&requests, &build_info };
+
+	for (size_t chunk_size = 1; chunk_size <= 64; chunk_size += 7) {
+		prom::ExpositionWriter prometheus(prerendered);
+		TEST_ASSERT_EQUAL_STRING(EXPECTED_PROMETHEUS,
+				readAll(prometheus, chunk_size).c_str());
+		prom::ExpositionWriter openmetrics(prerendered, true);
+		TEST_ASSERT_EQUAL_STRING(EXPECTED_OPENMETRICS,
+				readAll(openmetrics, chunk_size).c_str());
+	}
+}
+
+/**
+ * Tests that NAN values are written as NAN.
+ */
+void test_write_nan() {
+	prom::ValueFamily family("", "nan", "", "Not a number.", "gauge", []() {
+		return NAN;
+	});
+	const std::vector<const prom::MetricFamily*> nan_families { &family };
+	prom::ExpositionWriter writer(nan_families);
+	TEST_ASSERT_EQUAL_STRING(
+			"# HELP nan Not a number.\n# TYPE nan gauge\nnan NAN\n",
+			readAll(writer, 16).c_str());
+}
+
+/**
+ * Tests that lines longer than the max line length are skipped, without affecting other lines.
+ */
+void test_skip_long_line() {
+	prom::InfoFamily family("test", "long_info", "Too long.",
+			"{value=\"" + std::string(prom::ExpositionWriter::MAX_LINE_LEN, 'a')
+					+ "\"}");
+	const std::vector<const prom::MetricFamily*> long_families { families[0],
+			&family, families[1], families[2] };
+	prom::ExpositionWriter writer(long_families);
+	const std::string output = readAll(writer, 100);
+
+	TEST_ASSERT_EQUAL_STRING((std::string(EXPECTED_PROMETHEUS).insert(
+			strlen("# HELP test_temperature_celsius The temperature.\n"
+					"# TYPE test_temperature_celsius gauge\n"
+					"test_temperature_celsius 21.500\n"),
+			"# HELP test_long_info Too long.\n# TYPE test_long_info gauge\n")).c_str(),
+			output.c_str());
+}
+
+/**
+ * Tests that writing no metric families produces no output, except for the OpenMetrics EOF marker.
+ */
+void test_write_empty() {
+	const std::vector<const prom::MetricFamily*> empty;
+	prom::ExpositionWriter prometheus(empty);
+	TEST_ASSERT_EQUAL_STRING("", readAll(prometheus, 16).c_str());
+	prom::ExpositionWriter openmetrics(empty, true);
+	TEST_ASSERT_EQUAL_STRING("# EOF\n", readAll(openmetrics, 16).c_str());
+}
+
+/**
+ * Tests that only the metric families with the given names are written, in their original order.
+ */
+void test_write_filtered() {
+	const std::vector<std::string> names { "test_build_info",
+			"test_temperature_celsius", "test_missing" };
+	for (size_t chunk_size = 1; chunk_size <= 64; chunk_size += 9) {
+		prom::ExpositionWriter prometheus(families, false, names);
+		TEST_ASSERT_EQUAL_STRING(
+				"# HELP test_temperature_celsius The temperature.\n"
+				"# TYPE test_temperature_celsius gauge\n"
+				"test_temperature_celsius 21.500\n"
+				"# HELP test_build_info The build info.\n"
+				"# TYPE test_build_info gauge\n"
+				"test_build_info{version=\"1.0\"} 1\n",
+				readAll(prometheus, chunk_size).c_str());
+	}
+
+	prom::ExpositionWriter openmetrics(families, true, { "test_requests_total" });
+	TEST_ASSERT_EQUAL_STRING(
+			"# HELP test_requests_total The number of requests.\n"
+			"# TYPE test_requests_total counter\n"
+			"test_requests_total 18446744073709551615\n"
+			"# EOF\n", readAll(openmetrics, 64).c_str());
+
+	// Partial names and names without the namespace don't match.
+	prom::ExpositionWriter none(families, true, { "test_temperature",
+			"requests_total" });
+	TEST_ASSERT_EQUAL_STRING("# EOF\n", readAll(none, 16).c_str());
+}
+
+/**
+ * Tests selecting the exposition format from Accept headers.
+ */
+void test_negotiate_format() {
+	// The Accept header sent by Prometheus with protobuf scraping enabled.
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_PROTOBUF,
+			prom::negotiateFormat(
+					"application/vnd.google.protobuf;proto=io.prometheus.client.MetricFamily;encoding=delimited;q=0.7,"
+							"application/openmetrics-text;version=1.0.0;q=0.5,"
+							"application/openmetrics-text;version=0.0.1;q=0.4,"
+							"text/plain;version=0.0.4;q=0.3,*/*;q=0.2"));
+	// The default Accept header sent by Prometheus.
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_OPENMETRICS,
+			prom::negotiateFormat(
+					"application/openmetrics-text;version=1.0.0,"
+							"application/openmetrics-text;version=0.0.1;q=0.75,"
+							"text/plain;version=0.0.4;q=0.5,*/*;q=0.1"));
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_PROTOBUF,
+			prom::negotiateFormat(
+					"Application/Vnd.Google.Protobuf ; proto=\"io.prometheus.client.MetricFamily\" ; encoding=delimited"));
+
+	// Protobuf requires the proto parameter, and the delimited encoding.
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_TEXT,
+			prom::negotiateFormat("application/vnd.google.protobuf"));
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_TEXT,
+			prom::negotiateFormat(
+					"application/vnd.google.protobuf;proto=io.prometheus.client.MetricFamily;encoding=text"));
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_OPENMETRICS,
+			prom::negotiateFormat(
+					"application/vnd.google.protobuf;encoding=delimited,application/openmetrics-text;q=0.1"));
+
+	// Higher q values win, and q=0 means not acceptable.
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_TEXT,
+			prom::negotiateFormat(
+					"application/openmetrics-text;q=0.5, text/plain;q=0.9"));
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_TEXT,
+			prom::negotiateFormat(
+					"application/vnd.google.protobuf;proto=io.prometheus.client.MetricFamily;q=0,text/plain"));
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_OPENMETRICS,
+			prom::negotiateFormat(
+					"text/plain;q=0.25,application/openmetrics-text;q=0.255"));
+	// Equal q values prefer the more specific format.
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_OPENMETRICS,
+			prom::negotiateFormat("text/plain,application/openmetrics-text"));
+
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_TEXT, prom::negotiateFormat(""));
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_TEXT, prom::negotiateFormat(NULL));
+	TEST_ASSERT_EQUAL_UINT8(prom::FORMAT_TEXT,
+			prom::negotiateFormat("application/json, ,;,"));
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_write_prometheus);
+	RUN_TEST(test_write_openmetrics);
+	RUN_TEST(test_write_chunked);
+	RUN_TEST(test_write_prerendered);
+	RUN_TEST(test_write_nan);
+	RUN_TEST(test_skip_long_line);
+	RUN_TEST(test_write_empty);
+	RUN_TEST(test_write_filtered);
+	RUN_TEST(test_negotiate_format);
+
+	return UNITY_END();
+}
@@ -0,0 +1,573 @@
+/*
+ * protobuf.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <prometheus_registry.h>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * The metric families written by the tests.
+ */
+std::vector<const prom::MetricFamily*> families;
+
+/**
+ * The expected output for the test metric families.
+ * Three length delimited MetricFamily messages.
+ */
+const uint8_t EXPECTED_PROTOBUF[] = {
+		// test_temperature_celsius, gauge, 21.5
+		0x44, 0x0A, 0x18, 't', 'e', 's', 't', '_', 't', 'e', 'm', 'p', 'e', 'r',
+		'a', 't', 'u', 'r', 'e', '_', 'c', 'e', 'l', 's', 'i', 'u', 's', 0x12,
+		0x10, 'T', 'h', 'e', ' ', 't', 'e', 'm', 'p', 'e', 'r', 'a', 't', 'u',
+		'r', 'e', '.', 0x18, 0x01, 0x2A, 0x07, 'c', 'e', 'l', 's', 'i', 'u',
+		's', 0x22, 0x0B, 0x12, 0x09, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80,
+		0x35, 0x40,
+		// test_requests_total, counter, 2^64
+		0x3D, 0x0A, 0x13, 't', 'e', 's', 't', '_', 'r', 'e', 'q', 'u', 'e',
+		's', 't', 's', '_', 't', 'o', 't', 'a', 'l', 0x12, 0x17, 'T', 'h', 'e',
+		' ', 'n', 'u', 'm', 'b', 'e', 'r', ' ', 'o', 'f', ' ', 'r', 'e', 'q',
+		'u', 'e', 's', 't', 's', '.', 0x18, 0x00, 0x22, 0x0B, 0x1A, 0x09, 0x09,
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0, 0x43,
+		// test_build_info, gauge, {version="1.0"} 1
+		0x41, 0x0A, 0x0F, 't', 'e', 's', 't', '_', 'b', 'u', 'i', 'l', 'd',
+		'_', 'i', 'n', 'f', 'o', 0x12, 0x0F, 'T', 'h', 'e', ' ', 'b', 'u', 'i',
+		'l', 'd', ' ', 'i', 'n', 'f', 'o', '.', 0x18, 0x01, 0x22, 0x1B, 0x0A,
+		0x0E, 0x0A, 0x07, 'v', 'e', 'r', 's', 'i', 'o', 'n', 0x12, 0x03, '1',
+		'.', '0', 0x12, 0x09, 0x09, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xF0,
+		0x3F };
+
+/**
+ * A single decoded histogram bucket.
+ */
+struct Bucket {
+	uint64_t cumulative_count = 0;
+	double upper_bound = 0;
+};
+
+/**
+ * A single decoded Metric message.
+ */
+struct Metric {
+	std::vector<std::pair<std::string, std::string>> labels;
+	/**
+	 * The field number of the value message. Gauge, counter, untyped, or histogram.
+	 */
+	uint32_t value_field = 0;
+	double value = 0;
+	int64_t timestamp = 0;
+	uint64_t sample_count = 0;
+	double sample_sum = 0;
+	std::vector<Bucket> buckets;
+};
+
+/**
+ * A single decoded MetricFamily message.
+ */
+struct Family {
+	std::string name;
+	std::string help;
+	std::string unit;
+	uint64_t type = 0;
+	std::vector<Metric> metrics;
+};
+
+/**
+ * A protobuf field read by readField.
+ */
+struct Field {
+	uint32_t number = 0;
+	uint8_t wire_type = 0;
+	uint64_t value = 0;
+	std::string bytes;
+};
+
+/**
+ * Reads a varint from the given data.
+ *
+ * @param data	The data to read from.
+ * @param pos	The position to start reading at. Set to the end of the varint.
+ * @return	The value of the varint.
+ */
+uint64_t readVarint(const std::string &data, size_t &pos) {
+	uint64_t value = 0;
+	for (uint8_t shift = 0; shift < 64; shift += 7) {
+		TEST_ASSERT_LESS_THAN_size_t_MESSAGE(data.size(), pos,
+				"Varint exceeds the message.");
+		const uint8_t byte = data[pos++];
+		value |= (uint64_t) (byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return value;
+		}
+	}
+	TEST_FAIL_MESSAGE("Varint is too long.");
+	return 0;
+}
+
+/**
+ * Reads a single field from the given message.
+ *
+ * @param data	The message to read from.
+ * @param pos	The position of the field. Set to the end of the field.
+ * @return	The read field.
+ */
+Field readField(const std::string &data, size_t &pos) {
+	Field field;
+	const uint64_t tag = readVarint(data, pos);
+	field.number = tag >> 3;
+	field.wire_type = tag & 7;
+	switch (field.wire_type) {
+	case 0:
+		field.value = readVarint(data, pos);
+		break;
+	case 1:
+		TEST_ASSERT_LESS_OR_EQUAL_size_t_MESSAGE(data.size(), pos + 8,
+				"Fixed64 field exceeds the message.");
+		for (uint8_t i = 0; i < 8; i++) {
+			field.value |= (uint64_t) (uint8_t) data[pos++] << (i * 8);
+		}
+		break;
+	case 2: {
+		const uint64_t len = readVarint(data, pos);
+		TEST_ASSERT_LESS_OR_EQUAL_size_t_MESSAGE(data.size(), pos + len,
+				"Length delimited field exceeds the message.");
+		field.bytes = data.substr(pos, len);
+		pos += len;
+		break;
+	}
+	default:
+		TEST_FAIL_MESSAGE("Unexpected wire type.");
+	}
+	return field;
+}
+
+/**
+ * Interprets the value of a fixed64 field as a double.
+ *
+ * @param field	The field to interpret.
+ * @return	The double value.
+ */
+double toDouble(const Field &field) {
+	TEST_ASSERT_EQUAL_UINT8(1, field.wire_type);
+	double value;
+	memcpy(&value, &field.value, sizeof(value));
+	return value;
+}
+
+/**
+ * Decodes a Histogram message.
+ *
+ * @param data		The encoded message.
+ * @param metric	The metric to store the histogram in.
+ */
+void decodeHistogram(const std::string &data, Metric &metric) {
+	size_t pos = 0;
+	while (pos < data.size()) {
+		const Field field = readField(data, pos);
+		if (field.number == 1) {
+			metric.sample_count = field.value;
+		} else if (field.number == 2) {
+			metric.sample_sum = toDouble(field);
+		} else if (field.number == 3) {
+			Bucket bucket;
+			size_t bucket_pos = 0;
+			while (bucket_pos < field.bytes.size()) {
+				const Field bucket_field = readField(field.bytes, bucket_pos);
+				if (bucket_field.number == 1) {
+					bucket.cumulative_count = bucket_field.value;
+				} else if (bucket_field.number == 2) {
+					bucket.upper_bound = toDouble(bucket_field);
+				}
+			}
+			metric.buckets.push_back(bucket);
+		}
+	}
+}
+
+/**
+ * Decodes a Metric message.
+ *
+ * @param data	The encoded message.
+ * @return	The decoded metric.
+ */
+Metric decodeMetric(const std::string &data) {
+	Metric metric;
+	size_t pos = 0;
+	while (pos < data.size()) {
+		const Field field = readField(data, pos);
+		if (field.number == 1) {
+			std::pair<std::string, std::string> label;
+			size_t label_pos = 0;
+			while (label_pos < field.bytes.size()) {
+				const Field label_field = readField(field.bytes, label_pos);
+				if (label_field.number == 1) {
+					label.first = label_field.bytes;
+				} else if (label_field.number == 2) {
+					label.second = label_field.bytes;
+				}
+			}
+			metric.labels.push_back(label);
+		} else if (field.number == 2 || field.number == 3
+				|| field.number == 5) {
+			TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, metric.value_field,
+					"Metric has multiple values.");
+			metric.value_field = field.number;
+			size_t value_pos = 0;
+			while (value_pos < field.bytes.size()) {
+				const Field value_field = readField(field.bytes, value_pos);
+				if (value_field.number == 1) {
+					metric.value = toDouble(value_field);
+				}
+			}
+		} else if (field.number == 6) {
+			metric.timestamp = (int64_t) field.value;
+		} else if (field.number == 7) {
+			TEST_ASSERT_EQUAL_UINT32_MESSAGE(0, metric.value_field,
+					"Metric has multiple values.");
+			metric.value_field = field.number;
+			decodeHistogram(field.bytes, metric);
+		}
+	}
+	return metric;
+}
+
+/**
+ * Decodes a stream of length delimited MetricFamily messages.
+ * Unknown fields are skipped, like a protobuf decoder would.
+ *
+ * @param data	The encoded messages.
+ * @return	The decoded metric families.
+ */
+std::vector<Family> decode(const std::string &data) {
+	std::vector<Family> decoded;
+	size_t pos = 0;
+	while (pos < data.size()) {
+		const uint64_t len = readVarint(data, pos);
+		TEST_ASSERT_LESS_OR_EQUAL_size_t_MESSAGE(data.size(), pos + len,
+				"Metric family exceeds the output.");
+		const std::string message = data.substr(pos, len);
+		pos += len;
+
+		Family family;
+		size_t family_pos = 0;
+		while (family_pos < message.size()) {
+			const Field field = readField(message, family_pos);
+			if (field.number == 1) {
+				family.name = field.bytes;
+			} else if (field.number == 2) {
+				family.help = field.bytes;
+			} else if (field.number == 3) {
+				family.type = field.value;
+			} else if (field.number == 4) {
+				family.metrics.push_back(decodeMetric(field.bytes));
+			} else if (field.number == 5) {
+				family.unit = field.bytes;
+			}
+		}
+		decoded.push_back(family);
+	}
+	return decoded;
+}
+
+/**
+ * Writes the entire output of the given writer, reading at most chunk_size bytes at a time.
+ *
+ * @param writer		The writer to read from.
+ * @param chunk_size	The max number of bytes to read at once.
+ * @return	The entire output of the writer.
+ */
+std::string readAll(prom::ProtobufWriter &writer, const size_t chunk_size) {
+	std::string output;
+	uint8_t *buffer = new uint8_t[chunk_size];
+	size_t len;
+	while ((len = writer.read(buffer, chunk_size)) > 0) {
+		TEST_ASSERT_LESS_OR_EQUAL_MESSAGE(chunk_size, len,
+				"Writer wrote more than the buffer size.");
+		output.append((char*) buffer, len);
+	}
+	delete[] buffer;
+	TEST_ASSERT_TRUE_MESSAGE(writer.done(),
+			"Writer returned zero before it was done.");
+	return output;
+}
+
+/**
+ * Creates the metric families used by the tests.
+ */
+void setUp() {
+	families.push_back(
+			new prom::ValueFamily("test", "temperature", "celsius",
+					"The temperature.", "gauge", []() {
+						return 21.5;
+					}));
+	families.push_back(
+			new prom::IntegerValueFamily("test", "requests_total", "",
+					"The number of requests.", "counter", []() {
+						return UINT64_MAX;
+					}));
+	families.push_back(
+			new prom::InfoFamily("test", "build_info", "The build info.",
+					"{version=\"1.0\"}"));
+}
+
+/**
+ * Destroys the metric families used by the tests.
+ */
+void tearDown() {
+	for (const prom::MetricFamily *family : families) {
+		delete family;
+	}
+	families.clear();
+}
+
+/**
+ * Tests that the output matches the golden output, no matter how small the chunks it is read in are.
+ */
+void test_write_golden() {
+	for (size_t chunk_size = 1; chunk_size <= 64; chunk_size++) {
+		prom::ProtobufWriter writer(families);
+		const std::string output = readAll(writer, chunk_size);
+		TEST_ASSERT_EQUAL_size_t(sizeof(EXPECTED_PROTOBUF), output.size());
+		TEST_ASSERT_EQUAL_MEMORY(EXPECTED_PROTOBUF, output.data(),
+				sizeof(EXPECTED_PROTOBUF));
+	}
+}
+
+/**
+ * Tests decoding the output for the basic metric families.
+ */
+void test_decode_values() {
+	prom::ProtobufWriter writer(families);
+	const std::vector<Family> decoded = decode(readAll(writer, 4096));
+	TEST_ASSERT_EQUAL_size_t(3, decoded.size());
+
+	TEST_ASSERT_EQUAL_STRING("test_temperature_celsius",
+			decoded[0].name.c_str());
+	TEST_ASSERT_EQUAL_STRING("The temperature.", decoded[0].help.c_str());
+	TEST_ASSERT_EQUAL_STRING("celsius", decoded[0].unit.c_str());
+	TEST_ASSERT_EQUAL_UINT64(prom::MetricEncoder::GAUGE, decoded[0].type);
+	TEST_ASSERT_EQUAL_size_t(1, decoded[0].metrics.size());
+	TEST_ASSERT_EQUAL_UINT32(2, decoded[0].metrics[0].value_field);
+	TEST_ASSERT_EQUAL_FLOAT(21.5, decoded[0].metrics[0].value);
+
+	TEST_ASSERT_EQUAL_STRING("test_requests_total", decoded[1].name.c_str());
+	TEST_ASSERT_EQUAL_UINT64(prom::MetricEncoder::COUNTER, decoded[1].type);
+	TEST_ASSERT_EQUAL_UINT32(3, decoded[1].metrics[0].value_field);
+	TEST_ASSERT_EQUAL_FLOAT(UINT64_MAX,
+			decoded[1].metrics[0].value);
+
+	TEST_ASSERT_EQUAL_STRING("test_build_info", decoded[2].name.c_str());
+	TEST_ASSERT_EQUAL_size_t(1, decoded[2].metrics[0].labels.size());
+	TEST_ASSERT_EQUAL_STRING("version",
+			decoded[2].metrics[0].labels[0].first.c_str());
+	TEST_ASSERT_EQUAL_STRING("1.0",
+			decoded[2].metrics[0].labels[0].second.c_str());
+	TEST_ASSERT_EQUAL_FLOAT(1, decoded[2].metrics[0].value);
+}
+
+/**
+ * Tests decoding series with labels, histograms, escaped info labels, and NAN values.
+ */
+void test_decode_registry() {
+	prom::CounterFamily counter("test", "results_total", "",
+			"The results.", { "result" }, 4, 1000);
+	counter.get( { "valid" }).inc(1500);
+	counter.get( { "invalid" }).inc(2);
+	prom::GaugeFamily gauge("test", "nan", "", "Not a number.");
+	gauge.get().set(NAN);
+	prom::HistogramFamily histogram("test", "duration", "seconds",
+			"The duration.", { 100, 1000 }, 1000);
+	histogram.get().observe(50);
+	histogram.get().observe(500);
+	histogram.get().observe(5000);
+	prom::InfoFamily info("test", "info", "Escaped.",
+			"{a=\"x\\\"y\",b=\"1\\\\2\\n\"}");
+	const std::vector<const prom::MetricFamily*> registry_families { &counter,
+			&gauge, &histogram, &info };
+
+	prom::ProtobufWriter writer(registry_families);
+	const std::vector<Family> decoded = decode(readAll(writer, 100));
+	TEST_ASSERT_EQUAL_size_t(4, decoded.size());
+
+	TEST_ASSERT_EQUAL_size_t(2, decoded[0].metrics.size());
+	TEST_ASSERT_EQUAL_STRING("result",
+			decoded[0].metrics[0].labels[0].first.c_str());
+	TEST_ASSERT_EQUAL_STRING("valid",
+			decoded[0].metrics[0].labels[0].second.c_str());
+	TEST_ASSERT_EQUAL_FLOAT(1.5, decoded[0].metrics[0].value);
+	TEST_ASSERT_EQUAL_STRING("invalid",
+			decoded[0].metrics[1].labels[0].second.c_str());
+	TEST_ASSERT_EQUAL_FLOAT(0.002, decoded[0].metrics[1].value);
+
+	TEST_ASSERT_TRUE(std::isnan(decoded[1].metrics[0].value));
+
+	TEST_ASSERT_EQUAL_UINT64(prom::MetricEncoder::HISTOGRAM, decoded[2].type);
+	const Metric &metric = decoded[2].metrics[0];
+	TEST_ASSERT_EQUAL_UINT32(7, metric.value_field);
+	TEST_ASSERT_EQUAL_UINT64(3, metric.sample_count);
+	TEST_ASSERT_EQUAL_FLOAT(5.55, metric.sample_sum);
+	TEST_ASSERT_EQUAL_size_t(2, metric.buckets.size());
+	TEST_ASSERT_EQUAL_UINT64(1, metric.buckets[0].cumulative_count);
+	TEST_ASSERT_EQUAL_FLOAT(0.1, metric.buckets[0].upper_bound);
+	TEST_ASSERT_EQUAL_UINT64(2, metric.buckets[1].cumulative_count);
+	TEST_ASSERT_EQUAL_FLOAT(1, metric.buckets[1].upper_bound);
+
+	TEST_ASSERT_EQUAL_size_t(2, decoded[3].metrics[0].labels.size());
+	TEST_ASSERT_EQUAL_STRING("x\"y",
+			decoded[3].metrics[0].labels[0].second.c_str());
+	TEST_ASSERT_EQUAL_STRING("1\\2\n",
+			decoded[3].metrics[0].labels[1].second.c_str());
+}
+
+/**
+ * Tests that backfilled samples are written with their timestamps.
+ */
+void test_decode_timestamps() {
+	prom::BackfillGaugeFamily backfill("test", "backfill", "", "Backfilled.",
+			4);
+	backfill.record(1760745600000, 1.25);
+	backfill.record(1760745660000, 2.5);
+	backfill.record(0, 5);
+	const std::vector<const prom::MetricFamily*> backfill_families {
+			&backfill };
+
+	prom::ProtobufWriter writer(backfill_families);
+	const std::vector<Family> decoded = decode(readAll(writer, 4096));
+	TEST_ASSERT_EQUAL_size_t(1, decoded.size());
+	TEST_ASSERT_EQUAL_size_t(3, decoded[0].metrics.size());
+	TEST_ASSERT_EQUAL_INT64(1760745600000, decoded[0].metrics[0].timestamp);
+	TEST_ASSERT_EQUAL_FLOAT(1.25, decoded[0].metrics[0].value);
+	TEST_ASSERT_EQUAL_INT64(1760745660000, decoded[0].metrics[1].timestamp);
+	TEST_ASSERT_EQUAL_INT64(0, decoded[0].metrics[2].timestamp);
+	TEST_ASSERT_EQUAL_FLOAT(5, decoded[0].metrics[2].value);
+}
+
+/**
+ * Tests that a metric family shrinking while it is written is padded to the length written before its metrics.
+ */
+void test_write_shrinking() {
+	prom::BackfillGaugeFamily backfill("test", "backfill", "", "Backfilled.",
+			8);
+	for (uint32_t i = 1; i <= 6; i++) {
+		backfill.record(1760745600000 + i * 60000, i);
+	}
+	const std::vector<const prom::MetricFamily*> backfill_families {
+			&backfill, families[0] };
+
+	prom::ProtobufWriter writer(backfill_families);
+	uint8_t byte;
+	// Reading the first byte calculates the length of the first metric family.
+	TEST_ASSERT_EQUAL_size_t(1, writer.read(&byte, 1));
+	backfill.acknowledge(4);
+	const std::string output = std::string(1, (char) byte)
+			+ readAll(writer, 7);
+
+	const std::vector<Family> decoded = decode(output);
+	TEST_ASSERT_EQUAL_size_t(2, decoded.size());
+	TEST_ASSERT_EQUAL_size_t(2, decoded[0].metrics.size());
+	TEST_ASSERT_EQUAL_FLOAT(5, decoded[0].metrics[0].value);
+	TEST_ASSERT_EQUAL_FLOAT(6, decoded[0].metrics[1].value);
+	TEST_ASSERT_EQUAL_STRING("test_temperature_celsius",
+			decoded[1].name.c_str());
+}
+
+/**
+ * Tests that a histogram whose counts grow while it is written isn't truncated.
+ */
+void test_write_growing() {
+	prom::HistogramFamily histogram("test", "duration", "seconds",
+			"The duration.", { 100, 1000 }, 1000);
+	histogram.get().observe(50);
+	const std::vector<const prom::MetricFamily*> histogram_families {
+			&histogram, families[0] };
+
+	prom::ProtobufWriter writer(histogram_families);
+	uint8_t byte;
+	// Reading the first byte calculates the length of the first metric family.
+	TEST_ASSERT_EQUAL_size_t(1, writer.read(&byte, 1));
+	for (uint32_t i = 0; i < 300; i++) {
+		histogram.get().observe(50);
+	}
+	const std::string output = std::string(1, (char) byte)
+			+ readAll(writer, 1);
+
+	const std::vector<Family> decoded = decode(output);
+	TEST_ASSERT_EQUAL_size_t(2, decoded.size());
+	TEST_ASSERT_EQUAL_size_t(1, decoded[0].metrics.size());
+	TEST_ASSERT_EQUAL_UINT64(301, decoded[0].metrics[0].sample_count);
+	TEST_ASSERT_EQUAL_size_t(2, decoded[0].metrics[0].buckets.size());
+	TEST_ASSERT_EQUAL_UINT64(301,
+			decoded[0].metrics[0].buckets[1].cumulative_count);
+	TEST_ASSERT_EQUAL_STRING("test_temperature_celsius",
+			decoded[1].name.c_str());
+}
+
+/**
+ * Tests that metrics that are too long, and metric families without metrics, are skipped.
+ */
+void test_write_skipped() {
+	prom::InfoFamily family("test", "long_info", "Too long.",
+			"{value=\"" + std::string(prom::ProtobufWriter::MAX_METRIC_LEN, 'a')
+					+ "\"}");
+	prom::CounterFamily empty("test", "empty_total", "", "No series.",
+			{ "label" });
+	const std::vector<const prom::MetricFamily*> skipped_families {
+			families[0], &family, &empty, families[1], families[2] };
+	prom::ProtobufWriter writer(skipped_families);
+	const std::string output = readAll(writer, 100);
+	TEST_ASSERT_EQUAL_size_t(sizeof(EXPECTED_PROTOBUF), output.size());
+	TEST_ASSERT_EQUAL_MEMORY(EXPECTED_PROTOBUF, output.data(),
+			sizeof(EXPECTED_PROTOBUF));
+}
+
+/**
+ * Tests that writing only some metric families by name skips the others.
+ */
+void test_write_filtered() {
+	prom::ProtobufWriter writer(families, { "test_build_info", "unknown" });
+	const std::vector<Family> decoded = decode(readAll(writer, 4096));
+	TEST_ASSERT_EQUAL_size_t(1, decoded.size());
+	TEST_ASSERT_EQUAL_STRING("test_build_info", decoded[0].name.c_str());
+}
+
+/**
+ * Tests that writing no metric families results in an empty output.
+ */
+void test_write_empty() {
+	const std::vector<const prom::MetricFamily*> empty;
+	prom::ProtobufWriter writer(empty);
+	TEST_ASSERT_EQUAL_size_t(0, readAll(writer, 4096).size());
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_write_golden);
+	RUN_TEST(test_decode_values);
+	RUN_TEST(test_decode_registry);
+	RUN_TEST(test_decode_timestamps);
+	RUN_TEST(test_write_shrinking);
+	RUN_TEST(test_write_growing);
+	RUN_TEST(test_write_skipped);
+	RUN_TEST(test_write_filtered);
+	RUN_TEST(test_write_empty);
+
+	return UNITY_END();
+}
@@ -0,0 +1,500 @@
+/*
+ * registry.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <prometheus_registry.h>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * The number of threads to use for the concurrency stress tests.
+ */
+const size_t STRESS_THREADS = 8;
+
+/**
+ * The number of increments done by each thread in the concurrency stress tests.
+ */
+const uint32_t STRESS_INCREMENTS = 200000;
+
+/**
+ * Writes the entire exposition of the given registry.
+ *
+ * @param registry		The registry to write.
+ * @param openmetrics	Whether to write the OpenMetrics format.
+ * @param consumer		The consumer to write the exposition for.
+ * @return	The written exposition.
+ */
+std::string write(const prom::Registry &registry, const bool openmetrics =
+		false, const uint8_t consumer = 0) {
+	prom::ExpositionWriter writer(registry.getFamilies(), openmetrics, { },
+			consumer);
+	std::string output;
+	uint8_t buffer[64];
+	size_t len;
+	while ((len = writer.read(buffer, sizeof(buffer))) > 0) {
+		output.append((char*) buffer, len);
+	}
+	return output;
+}
+
+/**
+ * Does nothing.
+ */
+void setUp() {
+
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Tests that counters correctly carry into their upper 32 bits.
+ */
+void test_counter_overflow() {
+	prom::Counter counter;
+	counter.inc(UINT32_MAX);
+	TEST_ASSERT_EQUAL_UINT64(UINT32_MAX, counter.get());
+	counter.inc(2);
+	TEST_ASSERT_EQUAL_UINT64((uint64_t ) UINT32_MAX + 2, counter.get());
+	for (size_t i = 0; i < 4; i++) {
+		counter.inc(UINT32_MAX);
+	}
+	TEST_ASSERT_EQUAL_UINT64((uint64_t ) UINT32_MAX * 5 + 2, counter.get());
+}
+
+/**
+ * Tests that concurrent increments of sharded and plain counters don't lose any updates.
+ */
+void test_counter_stress() {
+	prom::ShardedCounter sharded;
+	prom::Counter plain;
+	prom::CounterFamily family("test", "stress_total", "", "Stress test.", {
+			"thread" }, 2);
+	prom::Counter &even = family.get( { "even" });
+	prom::Counter &odd = family.get( { "odd" });
+
+	std::vector<size_t> shards(STRESS_THREADS);
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < STRESS_THREADS; i++) {
+		threads.emplace_back([&sharded, &plain, &even, &odd, &shards, i]() {
+			shards[i] = prom::getCounterShard();
+			for (uint32_t j = 0; j < STRESS_INCREMENTS; j++) {
+				sharded.inc();
+				plain.inc();
+				(i % 2 ? odd : even).inc(2);
+			}
+		});
+	}
+
+	// Reads racing with increments have to be monotonic.
+	uint64_t last = 0;
+	while (last < STRESS_THREADS * STRESS_INCREMENTS) {
+		const uint64_t value = sharded.get();
+		TEST_ASSERT_GREATER_OR_EQUAL_UINT64(last, value);
+		last = value;
+	}
+
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	for (const size_t shard : shards) {
+		TEST_ASSERT_LESS_THAN_size_t(PROM_COUNTER_SHARDS, shard);
+	}
+
+	TEST_ASSERT_EQUAL_UINT64(STRESS_THREADS * STRESS_INCREMENTS, sharded.get());
+	TEST_ASSERT_EQUAL_UINT64(STRESS_THREADS * STRESS_INCREMENTS, plain.get());
+	TEST_ASSERT_EQUAL_UINT64(STRESS_THREADS * STRESS_INCREMENTS, even.get());
+	TEST_ASSERT_EQUAL_UINT64(STRESS_THREADS * STRESS_INCREMENTS, odd.get());
+}
+
+/**
+ * Tests that reads racing with increments overflowing the lower half of a counter stay monotonic.
+ */
+void test_counter_carry() {
+	prom::Counter counter;
+	const uint32_t amount = 0x3FFFFFFF;
+	std::thread writer([&counter, amount]() {
+		for (uint32_t i = 0; i < STRESS_INCREMENTS; i++) {
+			counter.inc(amount);
+		}
+	});
+
+	const uint64_t total = (uint64_t) amount * STRESS_INCREMENTS;
+	uint64_t last = 0;
+	while (last < total) {
+		const uint64_t value = counter.get();
+		TEST_ASSERT_GREATER_OR_EQUAL_UINT64(last, value);
+		TEST_ASSERT_LESS_OR_EQUAL_UINT64(total, value);
+		last = value;
+	}
+
+	writer.join();
+	TEST_ASSERT_EQUAL_UINT64(total, counter.get());
+}
+
+/**
+ * Tests setting and adding to gauges.
+ */
+void test_gauge() {
+	prom::Gauge gauge;
+	TEST_ASSERT_EQUAL_FLOAT(0, gauge.get());
+	gauge.set(21.5);
+	TEST_ASSERT_EQUAL_FLOAT(21.5, gauge.get());
+	gauge.add(-1.25);
+	TEST_ASSERT_EQUAL_FLOAT(20.25, gauge.get());
+	gauge.set(NAN);
+	TEST_ASSERT_TRUE(std::isnan(gauge.get()));
+}
+
+/**
+ * Tests writing counters with and without labels, and with a scale.
+ */
+void test_write_counters() {
+	prom::Registry registry;
+	prom::CounterFamily requests("test", "requests_total", "",
+			"The number of requests.", { "method", "code" }, 4);
+	prom::CounterFamily busy("test", "busy_seconds_total", "",
+			"The busy time.", { }, 1, 1000000);
+	registry.add(requests);
+	registry.add(busy);
+	registry.add(requests);
+
+	requests.get( { "get", "200" }).inc(3);
+	requests.get( { "post", "404" }).inc();
+	requests.get( { "get", "200" }).inc();
+	busy.get().inc(1500);
+
+	TEST_ASSERT_EQUAL_size_t(2, registry.getFamilies().size());
+	TEST_ASSERT_EQUAL_size_t(2, requests.size());
+	TEST_ASSERT_EQUAL_STRING("# HELP test_requests_total The number of requests.\n"
+			"# TYPE test_requests_total counter\n"
+			"test_requests_total{method=\"get\",code=\"200\"} 4\n"
+			"test_requests_total{method=\"post\",code=\"404\"} 1\n"
+			"# HELP test_busy_seconds_total The busy time.\n"
+			"# TYPE test_busy_seconds_total counter\n"
+			"test_busy_seconds_total 0.001500\n", write(registry).c_str());
+}
+
+/**
+ * Tests that series beyond the max series count are not exported, and don't affect other series.
+ */
+void test_max_series() {
+	prom::Registry registry;
+	prom::GaugeFamily gauges("", "value", "", "A value.", { "id" }, 2, 1);
+	registry.add(gauges);
+
+	gauges.get( { "a" }).set(1);
+	gauges.get( { "b" }).set(2);
+	gauges.get( { "c" }).set(3);
+	gauges.get( { "d" }).set(4);
+	gauges.get( { "a", "b" }).set(5);
+
+	TEST_ASSERT_EQUAL_size_t(2, gauges.size());
+	TEST_ASSERT_EQUAL_STRING("# HELP value A value.\n"
+			"# TYPE value gauge\n"
+			"value{id=\"a\"} 1.0\n"
+			"value{id=\"b\"} 2.0\n", write(registry).c_str());
+}
+
+/**
+ * Tests that series table cells are assigned series in the order of their first use,
+ * and that only cells used once all series were assigned get the overflow series.
+ */
+void test_series_table() {
+	prom::SeriesTable<10, 3> table;
+	TEST_ASSERT_EQUAL_UINT8(0, table.getSeries(7));
+	TEST_ASSERT_EQUAL_UINT8(1, table.getSeries(2));
+	TEST_ASSERT_EQUAL_UINT8(0, table.getSeries(7));
+	TEST_ASSERT_EQUAL_UINT8(2, table.getSeries(9));
+	TEST_ASSERT_EQUAL_UINT8(3, table.getSeries(0));
+	TEST_ASSERT_EQUAL_UINT8(3, table.getSeries(4));
+	TEST_ASSERT_EQUAL_UINT8(1, table.getSeries(2));
+
+	uint16_t cell = 0;
+	TEST_ASSERT_TRUE(table.getCell(0, cell));
+	TEST_ASSERT_EQUAL_UINT16(7, cell);
+	TEST_ASSERT_TRUE(table.getCell(2, cell));
+	TEST_ASSERT_EQUAL_UINT16(9, cell);
+	TEST_ASSERT_FALSE(table.getCell(3, cell));
+}
+
+/**
+ * Tests that threads racing to use the same cells all get the series assigned to it,
+ * rather than the overflow series.
+ */
+void test_series_table_race() {
+	static const size_t CELLS = 250;
+	prom::SeriesTable<CELLS, CELLS> table;
+	std::vector<std::vector<uint8_t>> series(STRESS_THREADS,
+			std::vector<uint8_t>(CELLS));
+	std::atomic<bool> start { false };
+	std::vector<std::thread> threads;
+	for (size_t i = 0; i < STRESS_THREADS; i++) {
+		threads.emplace_back([&table, &series, &start, i]() {
+			while (!start.load()) {
+			}
+			for (size_t cell = 0; cell < CELLS; cell++) {
+				series[i][cell] = table.getSeries(cell);
+			}
+		});
+	}
+
+	start.store(true);
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+
+	std::vector<bool> assigned(CELLS);
+	for (size_t cell = 0; cell < CELLS; cell++) {
+		const uint8_t index = series[0][cell];
+		TEST_ASSERT_LESS_THAN_UINT8(CELLS, index);
+		TEST_ASSERT_FALSE(assigned[index]);
+		assigned[index] = true;
+		for (size_t i = 1; i < STRESS_THREADS; i++) {
+			TEST_ASSERT_EQUAL_UINT8(index, series[i][cell]);
+		}
+
+		uint16_t series_cell = 0;
+		TEST_ASSERT_TRUE(table.getCell(index, series_cell));
+		TEST_ASSERT_EQUAL_UINT16(cell, series_cell);
+	}
+}
+
+/**
+ * Tests that label values are escaped correctly.
+ */
+void test_label_escaping() {
+	prom::Registry registry;
+	prom::CounterFamily counter("", "escaped_total", "", "Escaped labels.",
+			{ "path" }, 1);
+	registry.add(counter);
+	counter.get( { "a\"b\\c\nd" }).inc();
+
+	TEST_ASSERT_EQUAL_STRING("# HELP escaped_total Escaped labels.\n"
+			"# TYPE escaped_total counter\n"
+			"escaped_total{path=\"a\\\"b\\\\c\\nd\"} 1\n",
+			write(registry).c_str());
+}
+
+/**
+ * Tests writing a histogram in the OpenMetrics format.
+ */
+void test_write_histogram() {
+	prom::Registry registry;
+	prom::HistogramFamily duration("test", "duration", "seconds",
+			"The duration.", { 1000, 10000, 100000 }, 1000000, { "path" }, 1);
+	registry.add(duration);
+
+	prom::Histogram &histogram = duration.get( { "/" });
+	histogram.observe(500);
+	histogram.observe(1000);
+	histogram.observe(50000);
+	histogram.observe(2000000);
+
+	TEST_ASSERT_EQUAL_STRING("# HELP test_duration_seconds The duration.\n"
+			"# TYPE test_duration_seconds histogram\n"
+			"# UNIT test_duration_seconds seconds\n"
+			"test_duration_seconds_bucket{path=\"/\",le=\"0.001\"} 2\n"
+			"test_duration_seconds_bucket{path=\"/\",le=\"0.01\"} 2\n"
+			"test_duration_seconds_bucket{path=\"/\",le=\"0.1\"} 3\n"
+			"test_duration_seconds_bucket{path=\"/\",le=\"+Inf\"} 4\n"
+			"test_duration_seconds_sum{path=\"/\"} 2.051500\n"
+			"test_duration_seconds_count{path=\"/\"} 4\n"
+			"# EOF\n", write(registry, true).c_str());
+}
+
+/**
+ * Tests writing timestamped samples since the last acknowledged sample.
+ */
+void test_backfill_gauge() {
+	prom::Registry registry;
+	prom::BackfillGaugeFamily gauge("test", "temperature", "celsius",
+			"The temperature.", 4, 1);
+	registry.add(gauge);
+	// Each slot is a 64 bit timestamp, a float, and a 32 bit sequence number.
+	TEST_ASSERT_EQUAL_size_t(4 * 16, gauge.getHistorySize());
+
+	TEST_ASSERT_EQUAL_STRING("# HELP test_temperature_celsius The temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n", write(registry).c_str());
+
+	gauge.record(1700000000000, 20.5);
+	gauge.record(1700000002000, 21);
+	const uint32_t sequence = gauge.record(1700000004500, NAN);
+	TEST_ASSERT_EQUAL_UINT32(3, sequence);
+	TEST_ASSERT_EQUAL_UINT32(3, gauge.getNewest());
+	TEST_ASSERT_EQUAL_STRING("# HELP test_temperature_celsius The temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n"
+			"test_temperature_celsius 20.5 1700000000000\n"
+			"test_temperature_celsius 21.0 1700000002000\n"
+			"test_temperature_celsius NAN 1700000004500\n",
+			write(registry).c_str());
+
+	gauge.acknowledge(2);
+	gauge.acknowledge(1);
+	TEST_ASSERT_EQUAL_STRING("# HELP test_temperature_celsius The temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n"
+			"# UNIT test_temperature_celsius celsius\n"
+			"test_temperature_celsius NAN 1700000004.500\n"
+			"# EOF\n", write(registry, true).c_str());
+
+	// The newest sample is written even if it was acknowledged.
+	gauge.acknowledge(3);
+	TEST_ASSERT_EQUAL_STRING("# HELP test_temperature_celsius The temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n"
+			"test_temperature_celsius NAN 1700000004500\n",
+			write(registry).c_str());
+
+	// Samples beyond the capacity replace the oldest ones.
+	for (uint32_t i = 0; i < 6; i++) {
+		gauge.record(i < 5 ? 1700000010000 + i * 1000 : 0, 22 + i);
+	}
+	TEST_ASSERT_EQUAL_STRING("# HELP test_temperature_celsius The temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n"
+			"test_temperature_celsius 24.0 1700000012000\n"
+			"test_temperature_celsius 25.0 1700000013000\n"
+			"test_temperature_celsius 26.0 1700000014000\n"
+			"test_temperature_celsius 27.0\n", write(registry).c_str());
+}
+
+/**
+ * Tests that each consumer receives the samples it didn't acknowledge, no matter what other consumers acknowledged.
+ */
+void test_backfill_consumers() {
+	prom::Registry registry;
+	prom::BackfillGaugeFamily gauge("test", "temperature", "celsius",
+			"The temperature.", 4, 1);
+	registry.add(gauge);
+	gauge.record(1700000000000, 20);
+	gauge.record(1700000001000, 21);
+	gauge.acknowledge(2, 0);
+	gauge.acknowledge(2, prom::BackfillGaugeFamily::MAX_CONSUMERS);
+	gauge.record(1700000002000, 22);
+
+	TEST_ASSERT_EQUAL_STRING("# HELP test_temperature_celsius The temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n"
+			"test_temperature_celsius 22.0 1700000002000\n",
+			write(registry, false, 0).c_str());
+	TEST_ASSERT_EQUAL_STRING("# HELP test_temperature_celsius The temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n"
+			"test_temperature_celsius 20.0 1700000000000\n"
+			"test_temperature_celsius 21.0 1700000001000\n"
+			"test_temperature_celsius 22.0 1700000002000\n",
+			write(registry, false, 1).c_str());
+
+	// Consumers without a cursor only receive the newest sample.
+	TEST_ASSERT_EQUAL_STRING("# HELP test_temperature_celsius The temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n"
+			"test_temperature_celsius 22.0 1700000002000\n",
+			write(registry, false, prom::BackfillGaugeFamily::MAX_CONSUMERS).c_str());
+
+	// A reset consumer receives the entire history again.
+	TEST_ASSERT_EQUAL_UINT32(2, gauge.getAcknowledged(0));
+	TEST_ASSERT_EQUAL_UINT32(0,
+			gauge.getAcknowledged(prom::BackfillGaugeFamily::MAX_CONSUMERS));
+	gauge.resetConsumer(0);
+	TEST_ASSERT_EQUAL_UINT32(0, gauge.getAcknowledged(0));
+	TEST_ASSERT_EQUAL_STRING(write(registry, false, 1).c_str(),
+			write(registry, false, 0).c_str());
+}
+
+/**
+ * Tests that only the newest sample without a timestamp is kept and written.
+ */
+void test_backfill_untimestamped() {
+	prom::Registry registry;
+	prom::BackfillGaugeFamily gauge("test", "temperature", "celsius",
+			"The temperature.", 4, 1);
+	registry.add(gauge);
+
+	TEST_ASSERT_EQUAL_UINT32(1, gauge.record(0, 20));
+	TEST_ASSERT_EQUAL_UINT32(2, gauge.record(0, 21));
+	TEST_ASSERT_EQUAL_STRING("# HELP test_temperature_celsius The temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n"
+			"test_temperature_celsius 21.0\n", write(registry).c_str());
+
+	TEST_ASSERT_EQUAL_UINT32(3, gauge.record(1700000000000, 22));
+	TEST_ASSERT_EQUAL_STRING("# HELP test_temperature_celsius The temperature.\n"
+			"# TYPE test_temperature_celsius gauge\n"
+			"test_temperature_celsius 22.0 1700000000000\n",
+			write(registry).c_str());
+}
+
+/**
+ * Tests that samples overwritten while they are being written are skipped, rather than written torn.
+ */
+void test_backfill_stress() {
+	prom::Registry registry;
+	prom::BackfillGaugeFamily gauge("test", "temperature", "celsius",
+			"The temperature.", 4, 0);
+	registry.add(gauge);
+
+	std::thread recorder([&gauge]() {
+		for (uint32_t i = 1; i <= STRESS_INCREMENTS; i++) {
+			gauge.record(1700000000000 + i, i % 1000);
+		}
+	});
+
+	uint32_t mismatches = 0;
+	uint32_t samples = 0;
+	while (gauge.getNewest() < STRESS_INCREMENTS) {
+		const std::string output = write(registry, false, 0);
+		size_t pos = 0;
+		while ((pos = output.find("\ntest_", pos)) != std::string::npos) {
+			unsigned int value;
+			long long unsigned int timestamp;
+			pos++;
+			if (sscanf(output.c_str() + pos, "%*s %u %llu", &value, &timestamp)
+					!= 2 || (timestamp - 1700000000000) % 1000 != value) {
+				mismatches++;
+			}
+			samples++;
+		}
+	}
+	recorder.join();
+
+	TEST_ASSERT_GREATER_THAN_UINT32(0, samples);
+	TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_counter_overflow);
+	RUN_TEST(test_counter_stress);
+	RUN_TEST(test_counter_carry);
+	RUN_TEST(test_gauge);
+	RUN_TEST(test_write_counters);
+	RUN_TEST(test_max_series);
+	RUN_TEST(test_series_table);
+	RUN_TEST(test_series_table_race);
+	RUN_TEST(test_label_escaping);
+	RUN_TEST(test_write_histogram);
+	RUN_TEST(test_backfill_gauge);
+	RUN_TEST(test_backfill_consumers);
+	RUN_TEST(test_backfill_untimestamped);
+	RUN_TEST(test_backfill_stress);
+
+	return UNITY_END();
+}
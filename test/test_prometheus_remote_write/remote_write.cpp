@@ -0,0 +1,455 @@
+/*
+ * remote_write.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <prometheus_registry.h>
+#include <prometheus_remote_write.h>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * A single sample decoded from a WriteRequest.
+ */
+struct DecodedSample {
+	std::vector<std::pair<std::string, std::string>> labels;
+	double value;
+	int64_t timestamp;
+};
+
+/**
+ * A stand-in for a remote write receiver, decoding the requests a sender creates.
+ */
+class Receiver {
+private:
+	/**
+	 * Reads a varint from the given data.
+	 *
+	 * @param data	The data to read from.
+	 * @param pos	The position to read at. Set to the end of the varint.
+	 * @return	The read value.
+	 */
+	static uint64_t readVarint(const std::string &data, size_t &pos) {
+		uint64_t value = 0;
+		uint8_t shift = 0;
+		while (pos < data.size()) {
+			const uint8_t byte = data[pos++];
+			value |= (uint64_t) (byte & 0x7F) << shift;
+			shift += 7;
+			if (!(byte & 0x80)) {
+				break;
+			}
+		}
+		return value;
+	}
+
+	/**
+	 * Reads a length delimited protobuf field.
+	 *
+	 * @param data	The data to read from.
+	 * @param pos	The position of the length. Set to the end of the field.
+	 * @return	The content of the field.
+	 */
+	static std::string readBytes(const std::string &data, size_t &pos) {
+		const size_t len = readVarint(data, pos);
+		TEST_ASSERT_LESS_OR_EQUAL_size_t(data.size(), pos + len);
+		const std::string bytes = data.substr(pos, len);
+		pos += len;
+		return bytes;
+	}
+public:
+	/**
+	 * The HTTP status code to respond with.
+	 */
+	uint16_t status = 204;
+
+	/**
+	 * The samples of all accepted requests.
+	 */
+	std::vector<DecodedSample> samples;
+
+	/**
+	 * Decompresses snappy compressed data.
+	 *
+	 * @param compressed	The compressed data.
+	 * @return	The decompressed data.
+	 */
+	static std::string decompress(const std::string &compressed) {
+		size_t pos = 0;
+		const size_t len = readVarint(compressed, pos);
+		std::string output;
+		while (pos < compressed.size()) {
+			const uint8_t tag = compressed[pos++];
+			size_t element_len;
+			size_t offset = 0;
+			switch (tag & 3) {
+			case 0:
+				element_len = tag >> 2;
+				if (element_len >= 60) {
+					const uint8_t bytes = element_len - 59;
+					element_len = 0;
+					for (uint8_t i = 0; i < bytes; i++) {
+						element_len |= (size_t) (uint8_t) compressed[pos++]
+								<< (i * 8);
+					}
+				}
+				element_len++;
+				TEST_ASSERT_LESS_OR_EQUAL_size_t(compressed.size(),
+						pos + element_len);
+				output.append(compressed, pos, element_len);
+				pos += element_len;
+				continue;
+			case 1:
+				element_len = 4 + ((tag >> 2) & 7);
+				offset = (size_t) (tag >> 5) << 8 | (uint8_t) compressed[pos++];
+				break;
+			case 2:
+				element_len = (tag >> 2) + 1;
+				offset = (uint8_t) compressed[pos]
+						| (size_t) (uint8_t) compressed[pos + 1] << 8;
+				pos += 2;
+				break;
+			default:
+				TEST_FAIL_MESSAGE("Unexpected four byte offset copy.");
+				return output;
+			}
+
+			TEST_ASSERT_NOT_EQUAL(0, offset);
+			TEST_ASSERT_LESS_OR_EQUAL_size_t(output.size(), offset);
+			for (size_t i = 0; i < element_len; i++) {
+				output += output[output.size() - offset];
+			}
+		}
+		TEST_ASSERT_EQUAL_size_t(len, output.size());
+		return output;
+	}
+
+	/**
+	 * Decodes a protobuf encoded WriteRequest.
+	 *
+	 * @param request	The encoded WriteRequest.
+	 * @return	The samples of the request.
+	 */
+	static std::vector<DecodedSample> decode(const std::string &request) {
+		std::vector<DecodedSample> samples;
+		size_t pos = 0;
+		while (pos < request.size()) {
+			TEST_ASSERT_EQUAL_UINT8(0x0A, request[pos++]);
+			const std::string series = readBytes(request, pos);
+			DecodedSample sample;
+			size_t series_pos = 0;
+			while (series_pos < series.size()) {
+				const uint8_t tag = series[series_pos++];
+				const std::string field = readBytes(series, series_pos);
+				size_t field_pos = 0;
+				if (tag == 0x0A) {
+					TEST_ASSERT_EQUAL_UINT8(0x0A, field[field_pos++]);
+					const std::string name = readBytes(field, field_pos);
+					TEST_ASSERT_EQUAL_UINT8(0x12, field[field_pos++]);
+					const std::string value = readBytes(field, field_pos);
+					sample.labels.push_back(std::make_pair(name, value));
+				} else {
+					TEST_ASSERT_EQUAL_UINT8(0x12, tag);
+					TEST_ASSERT_EQUAL_UINT8(0x09, field[field_pos++]);
+					uint64_t bits = 0;
+					for (uint8_t i = 0; i < 8; i++) {
+						bits |= (uint64_t) (uint8_t) field[field_pos++]
+								<< (i * 8);
+					}
+					memcpy(&sample.value, &bits, sizeof(bits));
+					TEST_ASSERT_EQUAL_UINT8(0x10, field[field_pos++]);
+					sample.timestamp = readVarint(field, field_pos);
+				}
+			}
+			samples.push_back(sample);
+		}
+		return samples;
+	}
+
+	/**
+	 * Handles a HTTP request, and stores its samples if it is accepted.
+	 *
+	 * @param request	The raw HTTP request.
+	 * @param len		The length of the request.
+	 * @return	The HTTP status code of the response.
+	 */
+	uint16_t handle(const uint8_t *request, const size_t len) {
+		const std::string raw((const char*) request, len);
+		const size_t header_end = raw.find("\r\n\r\n");
+		TEST_ASSERT_NOT_EQUAL(std::string::npos, header_end);
+		const std::string header = raw.substr(0, header_end + 2);
+		TEST_ASSERT_EQUAL_size_t(0, header.find("POST /api/v1/write HTTP/1.1\r\n"));
+		TEST_ASSERT_NOT_EQUAL(std::string::npos, header.find("\r\nHost: receiver\r\n"));
+		TEST_ASSERT_NOT_EQUAL(std::string::npos,
+				header.find("\r\nContent-Encoding: snappy\r\n"));
+		TEST_ASSERT_NOT_EQUAL(std::string::npos,
+				header.find("\r\nContent-Type: application/x-protobuf\r\n"));
+		TEST_ASSERT_NOT_EQUAL(std::string::npos,
+				header.find("\r\nX-Prometheus-Remote-Write-Version: 0.1.0\r\n"));
+
+		const size_t length_start = header.find("\r\nContent-Length: ");
+		TEST_ASSERT_NOT_EQUAL(std::string::npos, length_start);
+		const size_t body_len = strtoul(header.c_str() + length_start + 18,
+				NULL, 10);
+		TEST_ASSERT_EQUAL_size_t(raw.size() - header_end - 4, body_len);
+
+		if (status >= 200 && status < 300) {
+			const std::vector<DecodedSample> decoded = decode(
+					decompress(raw.substr(header_end + 4)));
+			samples.insert(samples.end(), decoded.begin(), decoded.end());
+		}
+		return status;
+	}
+};
+
+/**
+ * Does nothing.
+ */
+void setUp() {
+
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Compresses the given data, and checks that decompressing it returns the original data.
+ *
+ * @param data	The data to compress.
+ * @return	The compressed length.
+ */
+size_t checkRoundTrip(const std::string &data) {
+	snappy::Compressor compressor;
+	std::vector<uint8_t> output(snappy::getMaxCompressedLength(data.size()));
+	const size_t len = compressor.compress((const uint8_t*) data.data(),
+			data.size(), output.data(), output.size());
+	TEST_ASSERT_GREATER_THAN_size_t(0, len);
+	TEST_ASSERT_TRUE(
+			Receiver::decompress(std::string((char*) output.data(), len)) == data);
+	return len;
+}
+
+/**
+ * Tests compressing empty, short, repetitive, random, and multi block inputs.
+ */
+void test_snappy_round_trip() {
+	checkRoundTrip("");
+	checkRoundTrip("short");
+	checkRoundTrip("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa");
+
+	std::string repetitive;
+	for (size_t i = 0; i < 500; i++) {
+		repetitive += "esptherm_temperature_celsius{sensor=\"dht22\"} 21.5\n";
+	}
+	TEST_ASSERT_LESS_THAN_size_t(repetitive.size() / 10,
+			checkRoundTrip(repetitive));
+
+	std::string random;
+	uint32_t state = 12345;
+	for (size_t i = 0; i < 150000; i++) {
+		state = state * 1103515245 + 12345;
+		random += (char) (state >> 16);
+		if (i % 1000 < 100) {
+			random += repetitive[i % repetitive.size()];
+		}
+	}
+	checkRoundTrip(random);
+}
+
+/**
+ * Tests that compressing into a buffer that may be too small fails.
+ */
+void test_snappy_buffer_too_small() {
+	snappy::Compressor compressor;
+	uint8_t input[100] { 0 };
+	uint8_t output[100];
+	TEST_ASSERT_EQUAL_size_t(0,
+			compressor.compress(input, sizeof(input), output, sizeof(output)));
+}
+
+/**
+ * Tests parsing and encoding sample lines.
+ */
+void test_encode_samples() {
+	prom::WriteRequestBuffer buffer(1024);
+	const char *lines[] = { "# HELP test_value A value.",
+			"test_value 21.5",
+			"test_total{path=\"/a\\\"b\\\\c\\nd\",method=\"GET\"} 3 1700000001000",
+			"test_value NAN", "test_value +Inf", "invalid" };
+	for (const char *line : lines) {
+		TEST_ASSERT_TRUE(buffer.addSample(line, strlen(line), 1700000000000));
+	}
+	TEST_ASSERT_EQUAL_size_t(4, buffer.getSampleCount());
+
+	const std::vector<DecodedSample> samples = Receiver::decode(
+			std::string((const char*) buffer.data(), buffer.size()));
+	TEST_ASSERT_EQUAL_size_t(4, samples.size());
+
+	TEST_ASSERT_EQUAL_size_t(1, samples[0].labels.size());
+	TEST_ASSERT_EQUAL_STRING("__name__", samples[0].labels[0].first.c_str());
+	TEST_ASSERT_EQUAL_STRING("test_value", samples[0].labels[0].second.c_str());
+	TEST_ASSERT_EQUAL_FLOAT(21.5, samples[0].value);
+	TEST_ASSERT_EQUAL_INT64(1700000000000, samples[0].timestamp);
+
+	// Labels have to be sorted by name.
+	TEST_ASSERT_EQUAL_size_t(3, samples[1].labels.size());
+	TEST_ASSERT_EQUAL_STRING("__name__", samples[1].labels[0].first.c_str());
+	TEST_ASSERT_EQUAL_STRING("method", samples[1].labels[1].first.c_str());
+	TEST_ASSERT_EQUAL_STRING("GET", samples[1].labels[1].second.c_str());
+	TEST_ASSERT_EQUAL_STRING("path", samples[1].labels[2].first.c_str());
+	TEST_ASSERT_EQUAL_STRING("/a\"b\\c\nd", samples[1].labels[2].second.c_str());
+	TEST_ASSERT_EQUAL_FLOAT(3, samples[1].value);
+	TEST_ASSERT_EQUAL_INT64(1700000001000, samples[1].timestamp);
+
+	TEST_ASSERT_TRUE(std::isnan(samples[2].value));
+	TEST_ASSERT_TRUE(std::isinf(samples[3].value));
+
+	buffer.remove(3);
+	TEST_ASSERT_EQUAL_size_t(1, buffer.getSampleCount());
+	const std::vector<DecodedSample> remaining = Receiver::decode(
+			std::string((const char*) buffer.data(), buffer.size()));
+	TEST_ASSERT_EQUAL_size_t(1, remaining.size());
+	TEST_ASSERT_TRUE(std::isinf(remaining[0].value));
+}
+
+/**
+ * Tests that samples that don't fit into the buffer are dropped.
+ */
+void test_buffer_full() {
+	prom::Registry registry;
+	prom::CounterFamily counter("test", "requests_total", "", "Requests.", {
+			"id" }, 16);
+	registry.add(counter);
+	const char *ids[] = { "0", "1", "2", "3", "4", "5", "6", "7", "8", "9" };
+	for (const char *id : ids) {
+		counter.get( { id }).inc();
+	}
+
+	prom::WriteRequestBuffer buffer(200);
+	const size_t dropped = buffer.addExposition(registry.getFamilies(), 1);
+	TEST_ASSERT_GREATER_THAN_size_t(0, dropped);
+	TEST_ASSERT_EQUAL_size_t(10, buffer.getSampleCount() + dropped);
+	TEST_ASSERT_LESS_OR_EQUAL_size_t(200, buffer.size());
+	TEST_ASSERT_EQUAL_size_t(buffer.getSampleCount(),
+			Receiver::decode(std::string((const char*) buffer.data(), buffer.size())).size());
+}
+
+/**
+ * Tests the exponential backoff.
+ */
+void test_backoff() {
+	prom::Backoff backoff(1000, 5000);
+	TEST_ASSERT_EQUAL_UINT32(1000, backoff.next());
+	TEST_ASSERT_EQUAL_UINT32(2000, backoff.next());
+	TEST_ASSERT_EQUAL_UINT32(4000, backoff.next());
+	TEST_ASSERT_EQUAL_UINT32(5000, backoff.next());
+	TEST_ASSERT_EQUAL_UINT32(5000, backoff.next());
+	backoff.reset();
+	TEST_ASSERT_EQUAL_UINT32(1000, backoff.next());
+}
+
+/**
+ * Tests sending batches to a receiver, including retries and rejected requests.
+ */
+void test_sender() {
+	prom::Registry registry;
+	prom::GaugeFamily temperature("test", "temperature", "celsius",
+			"The temperature.", { }, 1, 1);
+	prom::HistogramFamily duration("test", "duration", "seconds",
+			"The duration.", { 1000, 10000 }, 1000000);
+	registry.add(temperature);
+	registry.add(duration);
+	duration.get().observe(5000);
+
+	Receiver receiver;
+	prom::RemoteWriteSender sender("receiver", "/api/v1/write", "test", 4096,
+			10000, 1000, 4000);
+	TEST_ASSERT_FALSE(sender.isReady(0));
+
+	temperature.get().set(20);
+	TEST_ASSERT_EQUAL_size_t(0, sender.collect(registry.getFamilies(), 1000));
+	TEST_ASSERT_EQUAL_size_t(6, sender.getPendingSamples());
+	TEST_ASSERT_TRUE(sender.isReady(10000));
+
+	// The first attempt fails, and new samples are collected while it is in flight.
+	size_t len;
+	const uint8_t *request = sender.prepareRequest(10000, len);
+	TEST_ASSERT_NOT_NULL(request);
+	TEST_ASSERT_TRUE(sender.isInFlight());
+	TEST_ASSERT_NULL(sender.prepareRequest(10000, len));
+	temperature.get().set(21);
+	sender.collect(registry.getFamilies(), 2000);
+	TEST_ASSERT_EQUAL_size_t(12, sender.getPendingSamples());
+	TEST_ASSERT_EQUAL_size_t(6, sender.getInFlightSamples());
+	receiver.status = 503;
+	TEST_ASSERT_EQUAL(prom::RemoteWriteSender::RETRY,
+			sender.finishRequest(receiver.handle(request, len), 10000));
+	TEST_ASSERT_FALSE(sender.isReady(10999));
+	TEST_ASSERT_TRUE(sender.isReady(21000));
+
+	// The retry contains all buffered samples.
+	request = sender.prepareRequest(21000, len);
+	receiver.status = 204;
+	TEST_ASSERT_EQUAL(prom::RemoteWriteSender::SUCCESS,
+			sender.finishRequest(receiver.handle(request, len), 21000));
+	TEST_ASSERT_EQUAL_size_t(0, sender.getPendingSamples());
+	TEST_ASSERT_EQUAL_size_t(12, receiver.samples.size());
+	TEST_ASSERT_EQUAL_STRING("test_temperature_celsius",
+			receiver.samples[0].labels[0].second.c_str());
+	TEST_ASSERT_EQUAL_FLOAT(20, receiver.samples[0].value);
+	TEST_ASSERT_EQUAL_INT64(1000, receiver.samples[0].timestamp);
+	TEST_ASSERT_EQUAL_STRING("le", receiver.samples[1].labels[1].first.c_str());
+	TEST_ASSERT_EQUAL_STRING("0.001", receiver.samples[1].labels[1].second.c_str());
+	TEST_ASSERT_EQUAL_FLOAT(21, receiver.samples[6].value);
+	TEST_ASSERT_EQUAL_INT64(2000, receiver.samples[6].timestamp);
+
+	// Rejected samples are dropped.
+	sender.collect(registry.getFamilies(), 3000);
+	TEST_ASSERT_FALSE(sender.isReady(30999));
+	request = sender.prepareRequest(31000, len);
+	receiver.status = 400;
+	TEST_ASSERT_EQUAL(prom::RemoteWriteSender::REJECTED,
+			sender.finishRequest(receiver.handle(request, len), 31000));
+	TEST_ASSERT_EQUAL_size_t(0, sender.getPendingSamples());
+	TEST_ASSERT_EQUAL_size_t(12, receiver.samples.size());
+
+	// Connection failures are retried.
+	sender.collect(registry.getFamilies(), 4000);
+	request = sender.prepareRequest(41000, len);
+	TEST_ASSERT_EQUAL(prom::RemoteWriteSender::RETRY,
+			sender.finishRequest(0, 41000));
+	TEST_ASSERT_EQUAL_size_t(6, sender.getPendingSamples());
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_snappy_round_trip);
+	RUN_TEST(test_snappy_buffer_too_small);
+	RUN_TEST(test_encode_samples);
+	RUN_TEST(test_buffer_full);
+	RUN_TEST(test_backoff);
+	RUN_TEST(test_sender);
+
+	return UNITY_END();
+}
@@ -0,0 +1,159 @@
+/*
+ * seqlock.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <seqlock.h>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+/**
+ * A value similar to a measurement snapshot, with fields that all depend on a single counter.
+ * Has an odd size, so the last word is only partially used.
+ */
+struct Value {
+	float temperature;
+	float humidity;
+	int64_t timestamp;
+	uint32_t generation;
+	bool valid;
+	uint8_t padding[3];
+	uint16_t check;
+	uint8_t end;
+
+	/**
+	 * Creates the value for the given counter.
+	 *
+	 * @param counter	The counter to derive the fields from.
+	 */
+	explicit Value(const uint32_t counter = 0) :
+			temperature(counter % 10000 / 100.0f), humidity(
+					counter % 10000 / 50.0f), timestamp(
+					(int64_t) counter * 2000 - 1), generation(counter), valid(
+					counter % 2 == 0), padding { 0, 0, 0 }, check(
+					(uint16_t) ~counter), end(counter % 251) {
+
+	}
+
+	/**
+	 * Checks whether all fields of this value match its generation.
+	 *
+	 * @return	True if this value wasn't torn.
+	 */
+	bool consistent() const {
+		const Value expected(generation);
+		return temperature == expected.temperature
+				&& humidity == expected.humidity
+				&& timestamp == expected.timestamp && valid == expected.valid
+				&& check == expected.check && end == expected.end;
+	}
+};
+
+/**
+ * Does nothing.
+ */
+void setUp() {
+
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Tests that written values are read back unchanged.
+ */
+void test_read_write() {
+	utils::SeqLock<Value> lock;
+	TEST_ASSERT_EQUAL_UINT32(0, lock.getGeneration());
+	TEST_ASSERT_EQUAL_UINT32(0, lock.read().generation);
+	TEST_ASSERT_TRUE(lock.read().consistent());
+
+	for (uint32_t i = 1; i < 5; i++) {
+		lock.write(Value(i * 7));
+		TEST_ASSERT_EQUAL_UINT32(i, lock.getGeneration());
+		const Value value = lock.read();
+		TEST_ASSERT_EQUAL_UINT32(i * 7, value.generation);
+		TEST_ASSERT_TRUE(value.consistent());
+	}
+
+	utils::SeqLock<float> nan_lock(NAN);
+	TEST_ASSERT_TRUE(std::isnan(nan_lock.read()));
+	nan_lock.write(21.5f);
+	TEST_ASSERT_EQUAL_FLOAT(21.5f, nan_lock.read());
+}
+
+/**
+ * Tests that readers never see a torn value, or a value older than one they saw before,
+ * while a writer continuously replaces the value.
+ */
+void test_torture() {
+	utils::SeqLock<Value> lock;
+	std::atomic<bool> done { false };
+	std::atomic<uint32_t> torn { 0 };
+	std::atomic<uint32_t> backwards { 0 };
+	std::atomic<uint64_t> reads { 0 };
+	const uint32_t writes = 200000;
+
+	std::vector<std::thread> readers;
+	for (size_t i = 0; i < 4; i++) {
+		readers.push_back(std::thread([&]() {
+			uint32_t last = 0;
+			uint64_t count = 0;
+			while (!done.load(std::memory_order_relaxed)) {
+				const Value value = lock.read();
+				if (!value.consistent()) {
+					torn++;
+				}
+				if (value.generation < last) {
+					backwards++;
+				}
+				last = value.generation;
+				count++;
+			}
+			reads += count;
+		}));
+	}
+
+	for (uint32_t i = 1; i <= writes; i++) {
+		lock.write(Value(i));
+	}
+	done = true;
+
+	for (std::thread &reader : readers) {
+		reader.join();
+	}
+
+	TEST_ASSERT_EQUAL_UINT32(0, torn.load());
+	TEST_ASSERT_EQUAL_UINT32(0, backwards.load());
+	TEST_ASSERT_GREATER_THAN(0, reads.load());
+	TEST_ASSERT_EQUAL_UINT32(writes, lock.getGeneration());
+	TEST_ASSERT_EQUAL_UINT32(writes, lock.read().generation);
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_read_write);
+	RUN_TEST(test_torture);
+
+	return UNITY_END();
+}
@@ -0,0 +1,200 @@
+/*
+ * shared_stream.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <shared_stream.h>
+#include <memory>
+#include <string>
+
+/**
+ * The length of the test stream.
+ */
+const size_t STREAM_LEN = 1000;
+
+/**
+ * The number of bytes the test streams retain for new readers.
+ */
+const size_t RETAIN = 100;
+
+/**
+ * A source producing STREAM_LEN bytes, and counting the bytes it produced.
+ */
+struct CountingSource {
+	/**
+	 * The number of bytes produced so far.
+	 */
+	std::shared_ptr<size_t> produced = std::make_shared<size_t>(0);
+
+	/**
+	 * Writes the next bytes of the test stream.
+	 *
+	 * @param buffer	The buffer to write to.
+	 * @param max_len	The max number of bytes to write.
+	 * @return	The number of bytes written.
+	 */
+	size_t operator()(uint8_t *buffer, const size_t max_len) {
+		size_t len = 0;
+		while (len < max_len && *produced < STREAM_LEN) {
+			buffer[len++] = 'a' + *produced % 26;
+			(*produced)++;
+		}
+		return len;
+	}
+};
+
+/**
+ * Creates the expected content of the test stream.
+ *
+ * @return	The STREAM_LEN bytes the test source produces.
+ */
+std::string expected() {
+	std::string result;
+	for (size_t i = 0; i < STREAM_LEN; i++) {
+		result += (char) ('a' + i % 26);
+	}
+	return result;
+}
+
+/**
+ * Reads the entire remaining stream using the given reader.
+ *
+ * @param reader		The reader to read from.
+ * @param chunk_size	The max number of bytes to read at once.
+ * @return	The bytes that were read.
+ */
+std::string readAll(utils::SharedStream::Reader &reader,
+		const size_t chunk_size) {
+	std::string result;
+	uint8_t buffer[64];
+	size_t len;
+	while ((len = reader.read(buffer, chunk_size)) > 0) {
+		result.append((const char*) buffer, len);
+	}
+	return result;
+}
+
+/**
+ * Does nothing.
+ */
+void setUp() {
+
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Tests that a single reader gets the entire stream, and the buffer stays small.
+ */
+void test_single_reader() {
+	CountingSource source;
+	std::shared_ptr<utils::SharedStream> stream = std::make_shared<
+			utils::SharedStream>(source, RETAIN);
+	utils::SharedStream::Reader reader(stream);
+	TEST_ASSERT_FALSE(reader.done());
+
+	std::string result;
+	uint8_t buffer[64];
+	size_t len;
+	while ((len = reader.read(buffer, 37)) > 0) {
+		result.append((const char*) buffer, len);
+		TEST_ASSERT_LESS_OR_EQUAL_size_t(RETAIN + 37,
+				stream->getBufferedSize());
+	}
+
+	TEST_ASSERT_EQUAL_STRING(expected().c_str(), result.c_str());
+	TEST_ASSERT_TRUE(reader.done());
+	TEST_ASSERT_EQUAL_size_t(STREAM_LEN, *source.produced);
+	TEST_ASSERT_FALSE(stream->joinable());
+}
+
+/**
+ * Tests that readers joining before the retain limit was exceeded get the entire stream,
+ * while it is only produced once.
+ */
+void test_join() {
+	CountingSource source;
+	std::shared_ptr<utils::SharedStream> stream = std::make_shared<
+			utils::SharedStream>(source, RETAIN);
+	utils::SharedStream::Reader first(stream);
+	uint8_t buffer[64];
+	TEST_ASSERT_EQUAL_size_t(60, first.read(buffer, 60));
+	TEST_ASSERT_EQUAL_size_t(60, first.read(buffer, 60));
+	TEST_ASSERT_TRUE(stream->joinable());
+
+	utils::SharedStream::Reader second(stream);
+	TEST_ASSERT_EQUAL_size_t(60, first.read(buffer, 60));
+	TEST_ASSERT_FALSE(stream->joinable());
+
+	const std::string second_result = readAll(second, 13);
+	const std::string first_result = std::string(expected(), 0, 180)
+			+ readAll(first, 64);
+	TEST_ASSERT_EQUAL_STRING(expected().c_str(), second_result.c_str());
+	TEST_ASSERT_EQUAL_STRING(expected().c_str(), first_result.c_str());
+	TEST_ASSERT_EQUAL_size_t(STREAM_LEN, *source.produced);
+}
+
+/**
+ * Tests that the bytes a reader that left didn't read yet can be dropped.
+ */
+void test_leave() {
+	CountingSource source;
+	std::shared_ptr<utils::SharedStream> stream = std::make_shared<
+			utils::SharedStream>(source, 0);
+	utils::SharedStream::Reader first(stream);
+	uint8_t buffer[64];
+	{
+		utils::SharedStream::Reader second(stream);
+		TEST_ASSERT_EQUAL_size_t(50, first.read(buffer, 50));
+		TEST_ASSERT_EQUAL_size_t(50, first.read(buffer, 50));
+		TEST_ASSERT_EQUAL_size_t(100, stream->getBufferedSize());
+	}
+
+	TEST_ASSERT_EQUAL_size_t(50, first.read(buffer, 50));
+	TEST_ASSERT_EQUAL_size_t(50, stream->getBufferedSize());
+}
+
+/**
+ * Tests that a stream that fits into the retain limit stays joinable after it was read completely.
+ */
+void test_complete_joinable() {
+	CountingSource source;
+	std::shared_ptr<utils::SharedStream> stream = std::make_shared<
+			utils::SharedStream>(source, STREAM_LEN * 2);
+	utils::SharedStream::Reader first(stream);
+	TEST_ASSERT_EQUAL_STRING(expected().c_str(), readAll(first, 64).c_str());
+	TEST_ASSERT_TRUE(stream->joinable());
+
+	utils::SharedStream::Reader second(stream);
+	TEST_ASSERT_EQUAL_STRING(expected().c_str(), readAll(second, 64).c_str());
+	TEST_ASSERT_EQUAL_size_t(STREAM_LEN, *source.produced);
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_single_reader);
+	RUN_TEST(test_join);
+	RUN_TEST(test_leave);
+	RUN_TEST(test_complete_joinable);
+
+	return UNITY_END();
+}
@@ -0,0 +1,193 @@
+/*
+ * tracer.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <span_tracer.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * The current time of the fake clock, in microseconds.
+ */
+static uint64_t fake_time = 0;
+
+/**
+ * @return	The current time of the fake clock.
+ */
+uint64_t fake_clock() {
+	return fake_time;
+}
+
+/**
+ * @return	A thread id unique to the calling thread.
+ */
+uint32_t thread_id() {
+	static std::atomic<uint32_t> next { 1 };
+	thread_local uint32_t id = next++;
+	return id;
+}
+
+/**
+ * Writes all spans of the given tracer, reading at most the given number of bytes at once.
+ *
+ * @param tracer	The tracer to write.
+ * @param read_len	The max number of bytes to read from the writer at once.
+ * @return	The written trace event JSON.
+ */
+std::string write(const trace::Tracer &tracer, const size_t read_len = 1024) {
+	trace::TraceWriter writer(tracer);
+	std::string output;
+	std::vector<uint8_t> buffer(read_len);
+	size_t len = 0;
+	while ((len = writer.read(buffer.data(), read_len)) > 0) {
+		output.append((const char*) buffer.data(), len);
+	}
+	TEST_ASSERT_TRUE(writer.done());
+	return output;
+}
+
+/**
+ * Resets the fake clock.
+ */
+void setUp() {
+	fake_time = 0;
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Tests writing a tracer without spans.
+ */
+void test_empty() {
+	trace::Tracer tracer(4, fake_clock);
+	TEST_ASSERT_EQUAL_UINT32(0, tracer.getNewest());
+	TEST_ASSERT_EQUAL_STRING("{\"traceEvents\":[],\"displayTimeUnit\":\"ms\"}",
+			write(tracer).c_str());
+}
+
+/**
+ * Tests recording spans using the Span class, including nested spans.
+ */
+void test_spans() {
+	trace::Tracer tracer(8, fake_clock);
+	fake_time = 1000;
+	{
+		trace::Span outer(tracer, "outer");
+		fake_time = 1250;
+		{
+			trace::Span inner(tracer, "in\"ner");
+			fake_time = 1300;
+		}
+		fake_time = 2000;
+	}
+
+	TEST_ASSERT_EQUAL_UINT32(2, tracer.getNewest());
+	TEST_ASSERT_EQUAL_STRING("{\"traceEvents\":["
+			"{\"name\":\"in\\\"ner\",\"ph\":\"X\",\"ts\":1250,\"dur\":50,\"pid\":1,\"tid\":0},"
+			"{\"name\":\"outer\",\"ph\":\"X\",\"ts\":1000,\"dur\":1000,\"pid\":1,\"tid\":0}"
+			"],\"displayTimeUnit\":\"ms\"}", write(tracer).c_str());
+}
+
+/**
+ * Tests that the oldest spans are replaced once the ring buffer is full.
+ */
+void test_overwrite() {
+	trace::Tracer tracer(3, fake_clock);
+	for (uint64_t i = 0; i < 5; i++) {
+		tracer.record("span", i * 10, i * 10 + i);
+	}
+
+	TEST_ASSERT_EQUAL_UINT32(5, tracer.getNewest());
+	TEST_ASSERT_EQUAL_UINT32(3, tracer.getOldest());
+	trace::Event event;
+	TEST_ASSERT_FALSE(tracer.getEvent(2, event));
+	TEST_ASSERT_TRUE(tracer.getEvent(3, event));
+	TEST_ASSERT_EQUAL_UINT32(2, event.duration);
+	TEST_ASSERT_EQUAL_STRING("{\"traceEvents\":["
+			"{\"name\":\"span\",\"ph\":\"X\",\"ts\":20,\"dur\":2,\"pid\":1,\"tid\":0},"
+			"{\"name\":\"span\",\"ph\":\"X\",\"ts\":30,\"dur\":3,\"pid\":1,\"tid\":0},"
+			"{\"name\":\"span\",\"ph\":\"X\",\"ts\":40,\"dur\":4,\"pid\":1,\"tid\":0}"
+			"],\"displayTimeUnit\":\"ms\"}", write(tracer).c_str());
+}
+
+/**
+ * Tests that the output doesn't depend on how it is read from the writer.
+ */
+void test_split_reads() {
+	trace::Tracer tracer(16, fake_clock);
+	for (uint64_t i = 0; i < 16; i++) {
+		tracer.record("split", 1000000000000 + i * 1000, 1000000000000 + i * 1500);
+	}
+	const std::string expected = write(tracer);
+	TEST_ASSERT_EQUAL_STRING(expected.c_str(), write(tracer, 1).c_str());
+	TEST_ASSERT_EQUAL_STRING(expected.c_str(), write(tracer, 7).c_str());
+}
+
+/**
+ * Tests that spans recorded by multiple threads at once are never read torn.
+ * Every span has a duration matching its name, so mixed up spans can be detected.
+ */
+void test_concurrent() {
+	static const char *const NAMES[] = { "0", "1", "2", "3" };
+	trace::Tracer tracer(64, fake_clock, thread_id);
+	std::atomic<bool> stop { false };
+	std::vector<std::thread> threads;
+	for (uint8_t t = 0; t < 4; t++) {
+		threads.emplace_back([&tracer, &stop, t]() {
+			while (!stop.load()) {
+				tracer.record(NAMES[t], 0, t);
+			}
+		});
+	}
+
+	size_t read = 0;
+	while (read < 100000) {
+		const uint32_t newest = tracer.getNewest();
+		for (uint32_t i = tracer.getOldest(); i <= newest; i++) {
+			trace::Event event;
+			if (tracer.getEvent(i, event)) {
+				TEST_ASSERT_EQUAL_UINT32(event.name[0] - '0', event.duration);
+				TEST_ASSERT_NOT_EQUAL(0, event.thread);
+				read++;
+			}
+		}
+	}
+
+	stop.store(true);
+	for (std::thread &thread : threads) {
+		thread.join();
+	}
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_empty);
+	RUN_TEST(test_spans);
+	RUN_TEST(test_overwrite);
+	RUN_TEST(test_split_reads);
+	RUN_TEST(test_concurrent);
+
+	return UNITY_END();
+}
@@ -0,0 +1,180 @@
+/*
+ * tokenized_log.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <tokenized_log.h>
+#include <utils.h>
+#include <string>
+#include <vector>
+
+/**
+ * The frames written by the last calls to logTokenized.
+ */
+static std::vector<std::vector<uint8_t>> written;
+
+/**
+ * Stores a written frame.
+ *
+ * @param data	The frame to store.
+ * @param len	The length of the frame.
+ */
+void store_frame(const uint8_t *data, const size_t len) {
+	written.push_back(std::vector<uint8_t>(data, data + len));
+}
+
+/**
+ * Creates the expected header of a frame with the given length, token 0x12345678, line 300, and timestamp 0x01020304.
+ *
+ * @param len	The length of the arguments of the frame.
+ * @return	The expected header.
+ */
+std::vector<uint8_t> header(const uint8_t len) {
+	return std::vector<uint8_t> { logging::TOKEN_FRAME_START,
+			(uint8_t) (10 + len), 0x78, 0x56, 0x34, 0x12, 0x2C, 0x01, 0x04,
+			0x03, 0x02, 0x01 };
+}
+
+/**
+ * Checks that a frame matches the expected header and arguments.
+ *
+ * @param args	The expected encoded arguments.
+ * @param frame	The frame to check.
+ */
+void check_frame(const std::vector<uint8_t> &args,
+		const logging::TokenFrame &frame) {
+	std::vector<uint8_t> expected = header(args.size());
+	expected.insert(expected.end(), args.begin(), args.end());
+	TEST_ASSERT_EQUAL_size_t(expected.size(), frame.size());
+	TEST_ASSERT_EQUAL_MEMORY(expected.data(), frame.data(), expected.size());
+}
+
+/**
+ * Removes the stored frames.
+ */
+void setUp() {
+	written.clear();
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Tests that the token hash matches known FNV-1a values, and is a constant expression.
+ */
+void test_hash() {
+	TEST_ASSERT_EQUAL_HEX32(0x811C9DC5, CONST_EXPR_VALUE(logging::hashString("")));
+	TEST_ASSERT_EQUAL_HEX32(0xE40C292C, CONST_EXPR_VALUE(logging::hashString("a")));
+	TEST_ASSERT_EQUAL_HEX32(0xBF9CF968,
+			CONST_EXPR_VALUE(logging::hashString("foobar")));
+	TEST_ASSERT_EQUAL_HEX32(logging::hashString("E|main.cpp|Test %d"),
+			CONST_EXPR_VALUE(logging::hashToken("E|", "main.cpp", "|Test %d")));
+	TEST_ASSERT_NOT_EQUAL(logging::hashToken("E|", "main.cpp", "|Test"),
+			logging::hashToken("W|", "main.cpp", "|Test"));
+}
+
+/**
+ * Tests the encoding of integer, floating point, and pointer arguments.
+ */
+void test_numbers() {
+	check_frame( { }, logging::TokenFrame(0x12345678, 300, 0x01020304));
+	check_frame( { logging::TokenFrame::INT, 0x54, logging::TokenFrame::INT,
+			0x03 }, logging::TokenFrame(0x12345678, 300, 0x01020304, 42, -2));
+	check_frame( { logging::TokenFrame::UINT, 0xAC, 0x02,
+			logging::TokenFrame::UINT, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F },
+			logging::TokenFrame(0x12345678, 300, 0x01020304, 300u,
+					(uint32_t) 0xFFFFFFFF));
+	check_frame( { logging::TokenFrame::INT, 0x01, logging::TokenFrame::INT,
+			0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 },
+			logging::TokenFrame(0x12345678, 300, 0x01020304, (int8_t) -1,
+					INT64_MIN));
+	check_frame( { logging::TokenFrame::DOUBLE, 0x00, 0x00, 0x00, 0x00, 0x00,
+			0x00, 0xF8, 0x3F }, logging::TokenFrame(0x12345678, 300, 0x01020304,
+			1.5f));
+	check_frame( { logging::TokenFrame::INT, 0xC2, 0x01 },
+			logging::TokenFrame(0x12345678, 300, 0x01020304, (signed char) 'a'));
+
+	int value = 0;
+	const logging::TokenFrame frame(0x12345678, 300, 0x01020304, &value);
+	TEST_ASSERT_EQUAL_UINT8(logging::TokenFrame::POINTER, frame.data()[12]);
+}
+
+/**
+ * Tests the encoding of string arguments, and the truncation of frames that don't fit.
+ */
+void test_strings() {
+	check_frame( { logging::TokenFrame::STRING, 3, 'a', 'b', 'c',
+			logging::TokenFrame::STRING, 0 },
+			logging::TokenFrame(0x12345678, 300, 0x01020304, "abc",
+					(const char*) NULL));
+
+	// The string is truncated to the remaining space, and the following argument is left out.
+	const std::string long_string(200, 'x');
+	std::vector<uint8_t> expected_args { logging::TokenFrame::STRING,
+			logging::TokenFrame::MAX_FRAME_LEN - 14 };
+	expected_args.insert(expected_args.end(),
+			logging::TokenFrame::MAX_FRAME_LEN - 14, 'x');
+	check_frame(expected_args,
+			logging::TokenFrame(0x12345678, 300, 0x01020304,
+					long_string.c_str(), 5));
+
+	// An argument that doesn't fit stops all following arguments, even if they would fit.
+	expected_args.assign( { logging::TokenFrame::STRING,
+			logging::TokenFrame::MAX_FRAME_LEN - 22 });
+	expected_args.insert(expected_args.end(),
+			logging::TokenFrame::MAX_FRAME_LEN - 22, 'y');
+	const std::string fill(logging::TokenFrame::MAX_FRAME_LEN - 22, 'y');
+	check_frame(expected_args,
+			logging::TokenFrame(0x12345678, 300, 0x01020304, fill.c_str(), 1.0,
+					1));
+}
+
+/**
+ * Tests that logTokenized writes its frames to the configured output.
+ */
+void test_output() {
+	logging::setTokenOutput(store_frame);
+	logging::logTokenized(0xAABBCCDD, 7, 1u, "a");
+	logging::logTokenized(0x11223344, 8);
+	logging::setTokenOutput(NULL);
+
+	TEST_ASSERT_EQUAL_size_t(2, written.size());
+	TEST_ASSERT_EQUAL_size_t(17, written[0].size());
+	TEST_ASSERT_EQUAL_UINT8(logging::TOKEN_FRAME_START, written[0][0]);
+	TEST_ASSERT_EQUAL_UINT8(15, written[0][1]);
+	TEST_ASSERT_EQUAL_UINT8(0xDD, written[0][2]);
+	TEST_ASSERT_EQUAL_UINT8(7, written[0][6]);
+	const std::vector<uint8_t> args { logging::TokenFrame::UINT, 1,
+			logging::TokenFrame::STRING, 1, 'a' };
+	TEST_ASSERT_EQUAL_MEMORY(args.data(), written[0].data() + 12, args.size());
+	TEST_ASSERT_EQUAL_size_t(12, written[1].size());
+	TEST_ASSERT_EQUAL_UINT8(0x44, written[1][2]);
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_hash);
+	RUN_TEST(test_numbers);
+	RUN_TEST(test_strings);
+	RUN_TEST(test_output);
+
+	return UNITY_END();
+}
@@ -0,0 +1,242 @@
+/*
+ * format.cpp
+ *
+ *  Created on: Oct 18, 2026
+ *
+ * Copyright (C) 2026 ToMe25.
+ * This project is licensed under the MIT License.
+ * The MIT license can be found in the project root and at https://opensource.org/licenses/MIT.
+ */
+
+#include <unity.h>
+#include <utils.h>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * The stream based implementation float_to_chars has to match.
+ *
+ * @param measurement		The floating point number to convert to a string.
+ * @param decimal_digits	The number of digits after the decimal dot to round to.
+ * @return	The expected string.
+ */
+std::string reference_float_to_string(const float measurement,
+		const uint8_t decimal_digits) {
+	if (std::isnan(measurement)) {
+		return "Unknown";
+	}
+
+	uint8_t precision = decimal_digits + 1;
+	if (measurement >= 10) {
+		precision++;
+	}
+	if (measurement >= 100) {
+		precision++;
+	}
+
+	std::ostringstream converter;
+	converter << std::setprecision(precision) << measurement;
+	return converter.str();
+}
+
+/**
+ * The stream based implementation timespan_to_chars has to match.
+ *
+ * @param time_ms	The timespan to convert to a string.
+ * @return	The expected string.
+ */
+std::string reference_timespan_to_string(const int64_t time_ms) {
+	if (time_ms < 0) {
+		return "Unknown";
+	}
+
+	std::ostringstream stream;
+	stream << std::internal << std::setfill('0') << std::setw(2);
+	stream << time_ms / 3600000 % 24 << ':';
+	stream << std::internal << std::setfill('0') << std::setw(2);
+	stream << time_ms / 60000 % 60 << ':';
+	stream << std::internal << std::setfill('0') << std::setw(2);
+	stream << time_ms / 1000 % 60 << '.';
+	stream << std::internal << std::setfill('0') << std::setw(3);
+	stream << time_ms % 1000;
+	return stream.str();
+}
+
+/**
+ * Checks that float_to_chars and float_to_string write the same string as the reference implementation.
+ *
+ * @param measurement		The number to write.
+ * @param decimal_digits	The number of digits after the decimal dot.
+ * @return	True if both match the reference.
+ */
+bool check_float(const float measurement, const uint8_t decimal_digits) {
+	const std::string expected = reference_float_to_string(measurement,
+			decimal_digits);
+	char buffer[64];
+	const size_t len = utils::float_to_chars(buffer, sizeof(buffer),
+			measurement, decimal_digits);
+	if (expected != std::string(buffer, len) || strlen(buffer) != len
+			|| expected != utils::float_to_string(measurement, decimal_digits)) {
+		char message[128];
+		snprintf(message, sizeof(message),
+				"%.9g with %u digits: expected \"%s\", got \"%s\".",
+				measurement, decimal_digits, expected.c_str(), buffer);
+		TEST_MESSAGE(message);
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Does nothing.
+ */
+void setUp() {
+
+}
+
+/**
+ * Does nothing.
+ */
+void tearDown() {
+
+}
+
+/**
+ * Tests every thousandth between -60 and 150, and the floats next to them,
+ * with the number of decimal digits used by the project.
+ */
+void test_float_sensor_range() {
+	uint32_t mismatches = 0;
+	for (uint8_t digits = 0; digits <= 3; digits++) {
+		for (int32_t i = -60000; i <= 150000; i++) {
+			const float value = i / 1000.0f;
+			mismatches += !check_float(value, digits);
+			mismatches += !check_float(std::nextafter(value, -INFINITY),
+					digits);
+			mismatches += !check_float(std::nextafter(value, INFINITY),
+					digits);
+		}
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+/**
+ * Tests special values, exact rounding ties, carries, and values that need the snprintf fallback.
+ */
+void test_float_special() {
+	const float values[] = { NAN, -NAN, INFINITY, -INFINITY, 0.0f, -0.0f,
+			0.125f, 0.375f, 2.5f, 3.5f, 0.5f, 9.995f, 9.9999f, 99.995f,
+			99.9999f, 999.95f, 999.99994f, 1234.5678f, 65535.0f, 123456.0f,
+			1e-4f, 1e-5f, 0.00012345f, 1e-10f, 1e20f, -1e20f, 3.4028235e38f,
+			1e-45f, 1.17549435e-38f, 16777216.0f, 16777215.0f, 8388608.5f };
+	uint32_t mismatches = 0;
+	for (const float value : values) {
+		for (uint8_t digits = 0; digits <= 20; digits++) {
+			mismatches += !check_float(value, digits);
+		}
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+/**
+ * Tests random bit patterns, covering the entire float range.
+ */
+void test_float_random() {
+	std::mt19937 random(25);
+	uint32_t mismatches = 0;
+	for (uint32_t i = 0; i < 200000; i++) {
+		const uint32_t bits = random();
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		mismatches += !check_float(value, random() % 8);
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+}
+
+/**
+ * Tests that output that doesn't fit is truncated, and still null terminated.
+ */
+void test_float_truncation() {
+	char buffer[5];
+	TEST_ASSERT_EQUAL_size_t(4,
+			utils::float_to_chars(buffer, sizeof(buffer), 21.53f, 2));
+	TEST_ASSERT_EQUAL_STRING("21.5", buffer);
+	TEST_ASSERT_EQUAL_size_t(4,
+			utils::float_to_chars(buffer, sizeof(buffer), NAN, 2));
+	TEST_ASSERT_EQUAL_STRING("Unkn", buffer);
+	TEST_ASSERT_EQUAL_size_t(4,
+			utils::float_to_chars(buffer, sizeof(buffer), 1e-30f, 2));
+	TEST_ASSERT_EQUAL_STRING("1e-3", buffer);
+	TEST_ASSERT_EQUAL_size_t(0, utils::float_to_chars(buffer, 0, 21.53f, 2));
+	TEST_ASSERT_EQUAL_size_t(0, utils::float_to_chars(buffer, 0, 1e-30f, 2));
+
+	// The documented buffer size is enough for the longest output with 10 decimal digits.
+	char large_buffer[utils::FLOAT_CHARS_BUFFER_SIZE];
+	TEST_ASSERT_EQUAL_size_t(18,
+			utils::float_to_chars(large_buffer, sizeof(large_buffer),
+					3.4028235e38f, 10));
+	TEST_ASSERT_EQUAL_size_t(17,
+			utils::float_to_chars(large_buffer, sizeof(large_buffer),
+					-1.17549435e-38f, 10));
+}
+
+/**
+ * Tests every millisecond of the first five minutes, every second of the first two days,
+ * random timespans, and some edge cases.
+ */
+void test_timespan() {
+	std::vector<int64_t> values { -1, -1000, INT64_MIN, INT64_MAX, 86399999,
+			86400000, 359999999, 360000000 };
+	for (int64_t i = 0; i < 300000; i++) {
+		values.push_back(i);
+	}
+	for (int64_t i = 0; i < 2 * 86400; i++) {
+		values.push_back(i * 1000 + i % 1000);
+	}
+	std::mt19937_64 random(25);
+	for (uint32_t i = 0; i < 100000; i++) {
+		values.push_back(random() >> (random() % 64));
+	}
+
+	uint32_t mismatches = 0;
+	for (const int64_t value : values) {
+		const std::string expected = reference_timespan_to_string(value);
+		char buffer[utils::TIMESPAN_CHARS_BUFFER_SIZE];
+		const size_t len = utils::timespan_to_chars(buffer, sizeof(buffer),
+				value);
+		if (expected != std::string(buffer, len)
+				|| expected != utils::timespan_to_string(value)) {
+			mismatches++;
+		}
+	}
+	TEST_ASSERT_EQUAL_UINT32(0, mismatches);
+
+	char buffer[6];
+	TEST_ASSERT_EQUAL_size_t(5,
+			utils::timespan_to_chars(buffer, sizeof(buffer), 3723004));
+	TEST_ASSERT_EQUAL_STRING("01:02", buffer);
+}
+
+/**
+ * The entrypoint running this test file.
+ *
+ * @param argc	The number of arguments.
+ * @param argv	The given argument strings.
+ * @return	The program exit code.
+ */
+int main(int argc, char **argv) {
+	UNITY_BEGIN();
+
+	RUN_TEST(test_float_sensor_range);
+	RUN_TEST(test_float_special);
+	RUN_TEST(test_float_random);
+	RUN_TEST(test_float_truncation);
+	RUN_TEST(test_timespan);
+
+	return UNITY_END();
+}
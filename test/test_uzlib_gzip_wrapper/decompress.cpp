@@ -478,6 +478,35 @@ void test_decompress_large_wsize() {
 	delete[] decompressed;
 }
 
+/**
+ * Test combining the crc32 checksums of two blocks of data.
+ */
+void test_crc32_combine() {
+	// The size of the random data to calculate checksums for.
+	const size_t DATA_SIZE = 4096;
+
+	std::mt19937 rand(RANDOM_SEED);
+	std::uniform_int_distribution<size_t> dist(0, RANDOM_CHARS_LEN - 1);
+	uint8_t *data = new uint8_t[DATA_SIZE];
+	for (size_t i = 0; i < DATA_SIZE; i++) {
+		data[i] = RANDOM_CHARS[dist(rand)];
+	}
+
+	const uint32_t full_crc = ~uzlib_crc32(data, DATA_SIZE, ~0);
+	const size_t splits[] = { 0, 1, 7, 512, 1023, DATA_SIZE - 1, DATA_SIZE };
+	for (const size_t split : splits) {
+		const uint32_t crc1 = ~uzlib_crc32(data, split, ~0);
+		const uint32_t crc2 = ~uzlib_crc32(data + split, DATA_SIZE - split, ~0);
+		char message[50];
+		snprintf(message, 50, "Combined checksum of split at %lu is wrong.",
+				split);
+		TEST_ASSERT_EQUAL_HEX32_MESSAGE(full_crc,
+				gzip::crc32_combine(crc1, crc2, DATA_SIZE - split), message);
+	}
+
+	delete[] data;
+}
+
 /**
  * The entrypoint running this test file.
  *
@@ -492,6 +521,7 @@ int main(int argc, char **argv) {
 	RUN_TEST(test_decompress_large);
 	RUN_TEST(test_decompress_streaming);
 	RUN_TEST(test_decompress_large_wsize);
+	RUN_TEST(test_crc32_combine);
 
 	return UNITY_END();
 }